@@ -0,0 +1,1012 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/api/converterpix.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "converterpix.h"
+
+#include <resource_lib.h>
+#include <model/model.h>
+#include <model/animation.h>
+#include <texture/texture_object.h>
+
+#include <fs/file.h>
+#include <fs/sysfilesystem.h>
+#include <fs/uberfilesystem.h>
+#include <fs/sinkfilesystem.h>
+#include <fs/output_sink.h>
+#include <fs/fingerprint_sink.h>
+#include <fs/file_watcher.h>
+#include <fs/memory_file.h>
+#include <fs/read_ahead.h>
+#include <fs/staging_filesystem.h>
+#include <fs/prefetcher.h>
+
+#include <api/dependency_index.h>
+
+#include <utils/thread_pool.h>
+#include <utils/process_pool.h>
+#include <utils/pipeline.h>
+#include <utils/job_allocator.h>
+#include <utils/metrics.h>
+
+#include <cityhash/city.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace
+{
+	const u32 WATCH_QUIET_MS = 100;	// changes closer to each other are converted together
+
+	/**
+	 * @brief: Returns the files of the model itself, the model is converted again when any of them changes
+	 */
+	Array<String> modelFiles(const String &model)
+	{
+		return { model + ".pmc", model + ".pmd", model + ".pmg", model + ".ppd" };
+	}
+
+	bool wildcardMatch(const char *pattern, const char *name)
+	{
+		for (; *pattern; ++pattern, ++name)
+		{
+			if (*pattern == '*')
+			{
+				for (const char *rest = name;; ++rest)
+				{
+					if (wildcardMatch(pattern + 1, rest))
+						return true;
+					if (!*rest)
+						return false;
+				}
+			}
+			if (!*name || (*pattern != '?' && *pattern != *name))
+			{
+				return false;
+			}
+		}
+		return !*name;
+	}
+}
+
+ConverterPIX::ConverterPIX()
+	: m_resourceLibrary(std::make_unique<ResourceLibrary>())
+{
+}
+
+ConverterPIX::~ConverterPIX()
+{
+	m_manifest = nullptr;
+	setOutputSink(nullptr);
+	unmountAll();
+}
+
+bool ConverterPIX::mount(const String &path)
+{
+	FileSystem *fs = ufsMount(path, true, m_priority++);
+	if (!fs)
+	{
+		return false;
+	}
+	m_mounted.push_back(fs);
+	return true;
+}
+
+bool ConverterPIX::mount(const Array<String> &paths)
+{
+	bool result = true;
+	Array<String> roots;
+	for (String path : paths)
+	{
+		backslashesToSlashes(path);
+		const size_t slash = path.rfind('/');
+		const String name = path.substr(slash == String::npos ? 0 : slash + 1);
+		if (name.find_first_of("*?") == String::npos)
+		{
+			roots.push_back(path);
+			continue;
+		}
+
+		const String dir = slash == String::npos ? "." : path.substr(0, slash);
+		auto files = getSFS()->readDir(dir, false, false);
+		Array<String> matched;
+		if (files)
+		{
+			for (const auto &f : *files)
+			{
+				if (wildcardMatch(name.c_str(), f.GetPath().c_str()))
+				{
+					matched.push_back(dir + "/" + f.GetPath());
+				}
+			}
+		}
+		if (matched.empty())
+		{
+			warning("system", path, "No file matches the pattern!");
+			result = false;
+		}
+		std::sort(matched.begin(), matched.end());
+		roots.insert(roots.end(), matched.begin(), matched.end());
+	}
+
+	for (FileSystem *fs : ufsMountAll(roots, m_priority))
+	{
+		if (fs)
+		{
+			m_mounted.push_back(fs);
+		}
+		else
+		{
+			result = false;
+		}
+	}
+	m_priority += static_cast<int>(roots.size());
+	return result;
+}
+
+void ConverterPIX::unmountAll()
+{
+	for (FileSystem *fs : m_mounted)
+	{
+		ufsUnmount(fs);
+	}
+	m_mounted.clear();
+}
+
+bool ConverterPIX::verify(size_t threads)
+{
+	ThreadPool pool(threads);
+
+	bool result = true;
+	for (FileSystem *fs : m_mounted)
+	{
+		result = fs->verify(pool) && result;
+	}
+	return result;
+}
+
+void ConverterPIX::setExportPath(const String &path)
+{
+	m_exportPath = path;
+	if (m_directorySink)
+	{
+		updateOutput();
+	}
+}
+
+void ConverterPIX::setOutputSink(OutputSink *sink)
+{
+	m_outputSink = sink;
+	updateOutput();
+}
+
+void ConverterPIX::setFingerprintManifest(FingerprintManifest *manifest)
+{
+	m_manifest = manifest;
+	updateOutput();
+}
+
+void ConverterPIX::setMetrics(Metrics *metrics)
+{
+	m_metrics = metrics;
+}
+
+void ConverterPIX::setWorkerProcesses(size_t count)
+{
+	m_workerProcesses = count;
+}
+
+void ConverterPIX::setPipeline(const Array<size_t> &workers)
+{
+	assert(workers.empty() || workers.size() == PIPELINE_STAGES);
+	m_pipeline = workers;
+}
+
+void ConverterPIX::setPrefetchBudget(size_t bytes)
+{
+	getPrefetcher()->setBudget(bytes);
+}
+
+void ConverterPIX::setShard(size_t index, size_t count)
+{
+	assert(count > 0 && index < count);
+	m_shardIndex = index;
+	m_shardCount = count;
+}
+
+size_t ConverterPIX::shardOf(const String &path, size_t count)
+{
+	// CityHash64 does not depend on platform, so every node assigns the same shards
+	return count > 1 ? static_cast<size_t>(CityHash64(path.data(), path.size()) % count) : 0;
+}
+
+void ConverterPIX::updateOutput()
+{
+	if (m_sinkFileSystem && getOFS() == m_sinkFileSystem.get())
+	{
+		setOFS(nullptr);
+	}
+	m_sinkFileSystem.reset();
+	m_fingerprintSink.reset();
+	m_directorySink.reset();
+
+	OutputSink *sink = m_outputSink;
+	if (m_manifest)
+	{
+		// files are fingerprinted on their way to the sink or to the export directory
+		if (!sink)
+		{
+			m_directorySink = std::make_unique<DirectoryOutputSink>(m_exportPath);
+			sink = m_directorySink.get();
+		}
+		m_fingerprintSink = std::make_unique<FingerprintOutputSink>(m_manifest, sink);
+		sink = m_fingerprintSink.get();
+	}
+
+	if (sink)
+	{
+		m_sinkFileSystem = std::make_unique<SinkFileSystem>(sink);
+		setOFS(m_sinkFileSystem.get());
+	}
+}
+
+String ConverterPIX::exportPath() const
+{
+	return m_sinkFileSystem ? "" : m_exportPath;
+}
+
+bool ConverterPIX::convertModel(String modelPath, const Array<String> &animations, bool convertTextures)
+{
+	backslashesToSlashes(modelPath);
+	auto model = std::make_shared<Model>();
+	if (!model->load(modelPath))
+	{
+		printf("Failed to load: %s\n", modelPath.c_str());
+		return false;
+	}
+	model->saveToMidFormat(exportPath(), convertTextures);
+
+	Array<String> anims = animations;
+	for (size_t i = 0; i < anims.size(); ++i)
+	{
+		if (anims[i] == "*")
+		{
+			auto files = getUFS()->readDir(model->fileDirectory(), true, false);
+			if (!files)
+			{
+				continue;
+			}
+
+			// remove files with no .pma extension
+			files->erase(
+				std::remove_if(files->begin(), files->end(),
+					[](const FileSystem::Entry &s) {
+						return s.IsDirectory() || s.GetPath().substr(s.GetPath().rfind('.')) != ".pma";
+					}
+				), files->end()
+			);
+
+			// remove extensions
+			std::for_each(files->begin(), files->end(),
+				[&](FileSystem::Entry &s) {
+					s.SetPath(s.GetPath().substr(0, s.GetPath().rfind('.')));
+				}
+			);
+
+			for (const auto &f : (*files))
+			{
+				anims.push_back(f.GetPath());
+			}
+			continue;
+		}
+		backslashesToSlashes(anims[i]);
+		Animation anim;
+		if (!anim.load(model, anims[i]))
+		{
+			printf("Failed to load: %s\n", anims[i].c_str());
+		}
+		else
+		{
+			anim.saveToPia(exportPath());
+		}
+	}
+	return true;
+}
+
+bool ConverterPIX::checkRoundTrip(String modelPath)
+{
+	backslashesToSlashes(modelPath);
+	Model model;
+	if (!model.load(modelPath))
+	{
+		printf("Failed to load: %s\n", modelPath.c_str());
+		return false;
+	}
+
+	MemoryOutputSink memory;
+	{
+		SinkFileSystem sink(&memory);
+		FileSystem *const previous = getOFS();
+		setOFS(&sink);
+		const bool saved = model.saveToPim("");
+		setOFS(previous);
+		if (!saved)
+		{
+			return false;
+		}
+	}
+
+	const String pimPath = model.filePath() + ".pim";
+	const Array<u8> *pim = memory.find(pimPath);
+	if (!pim)
+	{
+		error("roundtrip", pimPath, "The pim has not been written!");
+		return false;
+	}
+	return model.checkPim(pimPath, reinterpret_cast<const char *>(pim->data()), pim->size());
+}
+
+bool ConverterPIX::convertTextureObject(String tobjPath)
+{
+	backslashesToSlashes(tobjPath);
+	TextureObject tobj;
+	if (!tobj.load(tobjPath))
+	{
+		return false;
+	}
+	if (!tobj.saveToMidFormats(exportPath()))
+	{
+		return false;
+	}
+	printf("%s: tobj: yes\n", tobjPath.substr(directory(tobjPath).length() + 1).c_str());
+	return true;
+}
+
+bool ConverterPIX::convertBase(const String &basepath, size_t threads)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	auto files = getSFS()->readDir(basepath, true, true);
+	if (!files)
+	{
+		printf("No files to convert!\n");
+		return false;
+	}
+
+	Array<String> jobs;
+	for (const auto &f : *files)
+	{
+		if (f.IsDirectory())
+			continue;
+
+		const String extension = f.GetPath().substr(f.GetPath().rfind('.'));
+		if (extension == ".pmg" || extension == ".tobj")
+		{
+			jobs.push_back(f.GetPath().substr(basepath.length()));
+		}
+	}
+	files.reset();
+
+	// the digest of all jobs tells whether the shards were made from the same inputs
+	std::sort(jobs.begin(), jobs.end());
+	String joined;
+	for (const auto &job : jobs)
+	{
+		joined += job + '\n';
+	}
+	const String digest = fmt::sprintf("%016llx", CityHash64(joined.data(), joined.size()));
+	joined.clear();
+
+	// texture objects of other shards are still read, they may use textures owned by this shard
+	struct Job
+	{
+		const String *m_path;
+		bool m_owned;
+	};
+	Array<Job> work;
+	size_t owned = 0;
+	for (const auto &job : jobs)
+	{
+		const bool own = shardOf(job, m_shardCount) == m_shardIndex;
+		if (own || (m_shardCount > 1 && job.substr(job.rfind('.')) == ".tobj"))
+		{
+			work.push_back({ &job, own });
+		}
+		owned += own ? 1 : 0;
+	}
+
+	const String shard = fmt::sprintf("%u/%u", m_shardIndex, m_shardCount);
+	if (m_manifest)
+	{
+		if (m_shardCount > 1)
+		{
+			m_manifest->setHeader("shard", shard);
+		}
+		m_manifest->setHeader("jobs", std::to_string(owned));
+		m_manifest->setHeader("jobs-total", std::to_string(jobs.size()));
+		m_manifest->setHeader("jobs-digest", digest);
+	}
+	if (m_metrics)
+	{
+		m_metrics->set("shard", shard);
+		m_metrics->set("jobs", static_cast<u64>(owned));
+		m_metrics->set("jobs_total", static_cast<u64>(jobs.size()));
+	}
+
+	const TextureObject::TextureFilter ownedTexture = [this](const String &path) {
+		return shardOf(path, m_shardCount) == m_shardIndex;
+	};
+	const TextureObject::TextureFilter textureFilter = m_shardCount > 1 ? ownedTexture : TextureObject::TextureFilter();
+	auto count = [this](const char *name) {
+		if (m_metrics)
+		{
+			m_metrics->add(name);
+		}
+	};
+
+	// returns the counter of the outcome
+	const unsigned size = static_cast<unsigned>(work.size());
+	auto convert = [&](const Job &job, unsigned i, bool progress) -> const char *
+	{
+		const String &filename = *job.m_path;
+		const String extension = filename.substr(filename.rfind('.'));
+		if (extension == ".pmg")
+		{
+			const String modelPath = filename.substr(0, filename.length() - 4);
+			JobArena arena; // the geometry of the model is released at once with the job
+			Model model;
+			if (!model.load(modelPath))
+			{
+				printf("Failed to load: %s\n", modelPath.c_str());
+				return "models_failed";
+			}
+			if (progress)
+			{
+				printf("[%u/%u = %u%%]: ", i, size, (unsigned)(100.f * i / size));
+			}
+			model.saveToMidFormat(exportPath(), false);
+			return "models_converted";
+		}
+		else if (job.m_owned)
+		{
+			TextureObject tobj;
+			const bool converted = tobj.load(filename) && tobj.saveToMidFormats(exportPath(), textureFilter);
+			if (progress)
+			{
+				printf("[%u/%u = %u%%]: ", i, size, (unsigned)(100.f * i / size));
+			}
+			printf("%s: tobj: %s\n", filename.substr(directory(filename).length() + 1).c_str(), converted ? "ok" : "failed");
+			return converted ? "tobjs_converted" : "tobjs_failed";
+		}
+		else
+		{
+			TextureObject tobj;
+			if (tobj.load(filename))
+			{
+				tobj.copyTextures(exportPath(), ownedTexture);
+			}
+			return "tobjs_scanned";
+		}
+	};
+
+	bool processes = m_workerProcesses > 0;
+	if (processes && (m_outputSink || !ProcessPool::supported()))
+	{
+		warning("converter", "", m_outputSink
+			? "Single archive cannot be written by worker processes, converting in threads!"
+			: "Worker processes are not supported on this system, converting in threads!");
+		processes = false;
+	}
+
+	if (processes && !m_pipeline.empty())
+	{
+		warning("converter", "", "The pipeline is not used by the worker processes!");
+	}
+
+	if (processes)
+	{
+		// every worker sends back the outcome and the fingerprints of the files it has written,
+		// the manifest and the metrics of the worker itself are lost with the process
+		FingerprintManifest *const manifest = m_manifest;
+		Array<String> crashed;
+		ProcessPool pool(m_workerProcesses);
+		const bool finished = pool.run(work.size(),
+			[&](size_t i) {
+				FingerprintManifest written;
+				if (manifest)
+				{
+					setFingerprintManifest(&written);
+				}
+				String result = convert(work[i], static_cast<unsigned>(i), false);
+				if (manifest)
+				{
+					setFingerprintManifest(manifest);
+					MemoryFile file;
+					written.save(&file);
+					result += '\n';
+					result.append(reinterpret_cast<const char *>(file.contents().data()), file.contents().size());
+				}
+				return result;
+			},
+			[&](size_t i, const String &result) {
+				const size_t end = std::min(result.find('\n'), result.size());
+				count(result.substr(0, end).c_str());
+				if (manifest && end < result.size())
+				{
+					MemoryFile file(Array<u8>(result.begin() + end + 1, result.end()));
+					FingerprintManifest written;
+					if (written.load(*work[i].m_path, &file))
+					{
+						manifest->update(written);
+					}
+				}
+			},
+			[&](size_t i, const String &reason) {
+				error_f("converter", *work[i].m_path, "Worker process has been terminated (%s), the file is skipped!", reason);
+				crashed.push_back(*work[i].m_path);
+				count("jobs_crashed");
+			}
+		);
+
+		if (!crashed.empty())
+		{
+			std::sort(crashed.begin(), crashed.end());
+			printf("\n%u files terminated the worker processes:\n", static_cast<unsigned>(crashed.size()));
+			String joined;
+			for (const auto &path : crashed)
+			{
+				printf("  %s\n", path.c_str());
+				joined += (joined.empty() ? "" : " ") + path;
+			}
+			if (m_metrics)
+			{
+				m_metrics->set("crashed", joined);
+			}
+		}
+		if (!finished)
+		{
+			error("converter", basepath, "Unable to convert the base in worker processes!");
+			return false;
+		}
+	}
+	else if (!m_pipeline.empty())
+	{
+		// the same steps as convert(), split where a job can wait in a queue for the next stage
+		struct Staged
+		{
+			ReadAhead m_input;						// the files of the job read by the fetch stage
+			UniquePtr<JobArena> m_arena;			// the geometry of the model, passed between threads
+			UniquePtr<Model> m_model;
+			UniquePtr<TextureObject> m_tobj;
+			UniquePtr<StagingFileSystem> m_output;	// the formatted files waiting for the write stage
+			const char *m_outcome = nullptr;
+		};
+		Array<UniquePtr<Staged>> staged(work.size());
+		FileSystem *const output = getOFS();
+		const String root = exportPath();
+		auto modelPath = [&](size_t i) -> String {
+			const String &filename = *work[i].m_path;
+			return filename.substr(filename.rfind('.')) == ".pmg" ? filename.substr(0, filename.length() - 4) : String();
+		};
+		auto finish = [&](size_t i, const char *outcome) {
+			count(outcome);
+			staged[i].reset();
+			return false;
+		};
+
+		Pipeline pipeline;
+		pipeline.addStage("fetch", m_pipeline[0], [&](size_t i) {
+			auto job = std::make_unique<Staged>();
+			const String model = modelPath(i);
+			if (!model.empty())
+			{
+				job->m_input.fetch({ model + ".pmd", model + ".pmg", model + ".ppd", model + ".pmc" });
+			}
+			else
+			{
+				job->m_input.fetch({ *work[i].m_path });
+			}
+			staged[i] = std::move(job);
+			return true;
+		});
+		pipeline.addStage("decode", m_pipeline[1], [&](size_t i) {
+			Staged &job = *staged[i];
+			ReadAhead::Scope input(job.m_input);
+			const String model = modelPath(i);
+			if (!model.empty())
+			{
+				job.m_arena = std::make_unique<JobArena>(false);
+				JobArena::Scope arena(*job.m_arena);
+				job.m_model = std::make_unique<Model>();
+				if (!job.m_model->load(model))
+				{
+					printf("Failed to load: %s\n", model.c_str());
+					return finish(i, "models_failed");
+				}
+				return true;
+			}
+
+			const String &filename = *work[i].m_path;
+			job.m_tobj = std::make_unique<TextureObject>();
+			if (!job.m_tobj->load(filename))
+			{
+				if (work[i].m_owned)
+				{
+					printf("%s: tobj: failed\n", filename.substr(directory(filename).length() + 1).c_str());
+					return finish(i, "tobjs_failed");
+				}
+				return finish(i, "tobjs_scanned");
+			}
+			return true;
+		});
+		pipeline.addStage("format", m_pipeline[2], [&](size_t i) {
+			Staged &job = *staged[i];
+			job.m_output = std::make_unique<StagingFileSystem>(output, root);
+			setThreadOFS(job.m_output.get());
+			if (job.m_model)
+			{
+				JobArena::Scope arena(*job.m_arena);
+				job.m_model->saveToMidFormat("", false);
+				job.m_model.reset();
+				job.m_outcome = "models_converted";
+			}
+			else if (work[i].m_owned)
+			{
+				const String &filename = *work[i].m_path;
+				const bool converted = job.m_tobj->saveToMidFormats("", textureFilter);
+				printf("%s: tobj: %s\n", filename.substr(directory(filename).length() + 1).c_str(), converted ? "ok" : "failed");
+				job.m_outcome = converted ? "tobjs_converted" : "tobjs_failed";
+			}
+			else
+			{
+				job.m_tobj->copyTextures("", ownedTexture);
+				job.m_outcome = "tobjs_scanned";
+			}
+			setThreadOFS(nullptr);
+			job.m_tobj.reset();
+			job.m_arena.reset();
+			return true;
+		});
+		pipeline.addStage("write", m_pipeline[3], [&](size_t i) {
+			staged[i]->m_output->flush();
+			return finish(i, staged[i]->m_outcome);
+		});
+		pipeline.run(work.size());
+		pipeline.report(m_metrics);
+	}
+	else if (threads == 1)
+	{
+		for (unsigned i = 0; i < size; ++i)
+		{
+			count(convert(work[i], i, true));
+		}
+	}
+	else
+	{
+		// the lines printed by the workers are interleaved, so there is no progress prefix
+		ThreadPool pool(threads);
+		std::atomic<size_t> next(0);
+		for (size_t worker = 0; worker < pool.size(); ++worker)
+		{
+			pool.submit([&]() {
+				for (size_t i = next++; i < work.size(); i = next++)
+				{
+					count(convert(work[i], static_cast<unsigned>(i), false));
+				}
+			});
+		}
+		pool.wait();
+	}
+
+	if (getPrefetcher()->enabled())
+	{
+		getPrefetcher()->clear();
+		getPrefetcher()->report(m_metrics);
+	}
+	if (m_metrics)
+	{
+		m_metrics->set("seconds", std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+		if (m_manifest)
+		{
+			m_metrics->set("files", static_cast<u64>(m_manifest->size()));
+			m_metrics->set("bytes", m_manifest->totalSize());
+		}
+	}
+	printf("\nBase converted: %s\n", m_exportPath.c_str());
+	return true;
+}
+
+bool ConverterPIX::watch(size_t threads)
+{
+	FileWatcher watcher;
+	size_t watched = 0;
+	Array<String> models;
+	for (FileSystem *fs : m_mounted)
+	{
+		auto sysfs = dynamic_cast<SysFileSystem *>(fs);
+		if (!sysfs)
+		{
+			continue;
+		}
+		if (!watcher.watch(sysfs->root()))
+		{
+			return false;
+		}
+		++watched;
+
+		auto files = sysfs->readDir("/", true, true);
+		if (!files)
+		{
+			continue;
+		}
+		for (const auto &f : *files)
+		{
+			const String &path = f.GetPath();
+			if (!f.IsDirectory() && path.length() > 4 && path.substr(path.length() - 4) == ".pmg")
+			{
+				models.push_back(path.substr(0, path.length() - 4));
+			}
+		}
+	}
+	if (watched == 0)
+	{
+		error("watch", "", "No directory is mounted, the archives cannot be watched!");
+		return false;
+	}
+	std::sort(models.begin(), models.end());
+	models.erase(std::unique(models.begin(), models.end()), models.end());
+
+	ThreadPool pool(threads);
+	DependencyIndex index;
+
+	// models which fail to load are indexed with their own files, so they are converted once fixed
+	const auto startTime = std::chrono::steady_clock::now();
+	Array<Array<String>> dependencies(models.size());
+	pool.parallelFor(models.size(), [&](size_t i) {
+		JobArena arena;
+		Model model;
+		dependencies[i] = model.load(models[i]) ? model.dependencies() : modelFiles(models[i]);
+	});
+	for (size_t i = 0; i < models.size(); ++i)
+	{
+		index.update(models[i], dependencies[i]);
+	}
+	info_f("watch", "", "%u models reading %u files indexed in %.2f s, waiting for changes...",
+		index.models(), index.files(), std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+
+	Array<String> changed;
+	while (watcher.wait(changed, WATCH_QUIET_MS))
+	{
+		changed.erase(
+			std::remove_if(changed.begin(), changed.end(),
+				[](const String &path) {
+					static const char *const extensions[] = { ".pmg", ".pmd", ".pmc", ".ppd", ".mat", ".tobj", ".dds" };
+					const size_t dot = path.rfind('.');
+					return dot == String::npos || std::none_of(std::begin(extensions), std::end(extensions),
+						[&](const char *extension) { return path.compare(dot, String::npos, extension) == 0; });
+				}
+			), changed.end()
+		);
+		if (changed.empty())
+		{
+			continue;
+		}
+		const auto batchStart = std::chrono::steady_clock::now();
+
+		ResourceLibrary::Get()->release(changed);
+		getUFS()->refresh();
+
+		Array<String> affected;
+		Array<String> tobjs;
+		Array<String> textures;
+		for (const auto &path : changed)
+		{
+			const String extension = path.substr(path.rfind('.'));
+			index.affected(path, affected);
+			if (extension == ".tobj")
+			{
+				tobjs.push_back(path);
+			}
+			else if (extension == ".dds")
+			{
+				// textures are copied only when missing in the export directory
+				if (!m_sinkFileSystem)
+				{
+					::remove((m_exportPath + path).c_str());
+					textures.push_back(path);
+				}
+			}
+			else if (extension != ".mat")
+			{
+				const String model = path.substr(0, path.length() - 4);
+				if (getUFS()->exists(model + ".pmg"))
+				{
+					affected.push_back(model);
+				}
+			}
+		}
+		std::sort(affected.begin(), affected.end());
+		affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+		// the models whose geometry has been deleted are dropped without the load errors
+		Array<Array<String>> files(affected.size());
+		pool.parallelFor(affected.size(), [&](size_t i) {
+			JobArena arena;
+			Model model;
+			if (getUFS()->exists(affected[i] + ".pmg") && model.load(affected[i]))
+			{
+				model.saveToMidFormat(exportPath(), true);
+				files[i] = model.dependencies();
+			}
+		});
+		size_t converted = 0;
+		for (size_t i = 0; i < affected.size(); ++i)
+		{
+			if (!files[i].empty())
+			{
+				index.update(affected[i], files[i]);
+				++converted;
+			}
+			else if (getUFS()->exists(affected[i] + ".pmg"))
+			{
+				index.update(affected[i], modelFiles(affected[i]));
+			}
+			else
+			{
+				index.remove(affected[i]);
+			}
+		}
+
+		// texture objects used by the models have been written with them
+		size_t textureObjects = 0;
+		for (const auto &tobj : tobjs)
+		{
+			Array<String> users;
+			index.affected(tobj, users);
+			if (users.empty() && getUFS()->exists(tobj))
+			{
+				convertTextureObject(tobj);
+				++textureObjects;
+			}
+		}
+
+		// the textures not copied back by the above, used by models failing to load or by unconverted texture objects
+		size_t copied = 0;
+		for (const auto &texture : textures)
+		{
+			if (getOFS()->exists(exportPath() + texture) || !getUFS()->exists(texture))
+			{
+				continue;
+			}
+			auto input = getUFS()->open(texture, FileSystem::read | FileSystem::binary);
+			auto output = getOFS()->open(exportPath() + texture, FileSystem::write | FileSystem::binary);
+			if (input && output && copyFile(input.get(), output.get()))
+			{
+				++copied;
+			}
+			else
+			{
+				error("watch", texture, "Unable to copy the texture into the export directory!");
+			}
+		}
+
+		info_f("watch", "", "%u changed files, %u models and %u texture objects converted, %u textures copied in %.0f ms",
+			changed.size(), converted, textureObjects, copied,
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - batchStart).count());
+	}
+	return false;
+}
+
+bool ConverterPIX::mergeManifests(const Array<String> &paths, FingerprintManifest &result)
+{
+	if (paths.empty())
+	{
+		error("merge", "", "No manifests to merge!");
+		return false;
+	}
+
+	bool valid = true;
+	Array<bool> present;
+	u64 jobs = 0;
+	String version, jobsTotal, jobsDigest;
+	for (const auto &path : paths)
+	{
+		auto file = getSFS()->open(path, FileSystem::read | FileSystem::binary);
+		if (!file)
+		{
+			error_f("merge", path, "Unable to open manifest to read (%s)!", strerror(errno));
+			return false;
+		}
+		FingerprintManifest manifest;
+		if (!manifest.load(path, file.get()))
+		{
+			return false;
+		}
+
+		unsigned index = 0, count = 0;
+		if (sscanf(manifest.header("shard").c_str(), "%u/%u", &index, &count) != 2 || count == 0 || index >= count)
+		{
+			error("merge", path, "The manifest has not been written by a shard!");
+			return false;
+		}
+
+		if (present.empty())
+		{
+			present.resize(count, false);
+			version = manifest.header("version");
+			jobsTotal = manifest.header("jobs-total");
+			jobsDigest = manifest.header("jobs-digest");
+		}
+		else if (present.size() != count)
+		{
+			error_f("merge", path, "The manifest is shard of %u, expected %u shards!", count, present.size());
+			return false;
+		}
+		else if (manifest.header("jobs-total") != jobsTotal || manifest.header("jobs-digest") != jobsDigest)
+		{
+			error("merge", path, "The shard has been converted from different files than the others!");
+			valid = false;
+		}
+		else if (manifest.header("version") != version)
+		{
+			error_f("merge", path, "The shard has been converted by different version (%s, expected %s)!", manifest.header("version"), version);
+			valid = false;
+		}
+
+		if (present[index])
+		{
+			error_f("merge", path, "Shard %u/%u is present more than once!", index, count);
+			valid = false;
+		}
+		present[index] = true;
+		jobs += strtoull(manifest.header("jobs").c_str(), nullptr, 10);
+
+		valid = result.merge(path, manifest) && valid;
+	}
+
+	for (size_t i = 0; i < present.size(); ++i)
+	{
+		if (!present[i])
+		{
+			error_f("merge", "", "Shard %u/%u is missing!", i, present.size());
+			valid = false;
+		}
+	}
+	if (valid && std::to_string(jobs) != jobsTotal)
+	{
+		error_f("merge", "", "The shards converted %llu jobs of %s!", jobs, jobsTotal);
+		valid = false;
+	}
+
+	// the same headers as written by the conversion without shards
+	if (!version.empty())
+	{
+		result.setHeader("version", version);
+	}
+	result.setHeader("jobs", jobsTotal);
+	result.setHeader("jobs-total", jobsTotal);
+	result.setHeader("jobs-digest", jobsDigest);
+	return valid;
+}
+
+/* eof */
@@ -0,0 +1,248 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/api/converterpix.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Public interface of the converter library.
+ *
+ * Mounts the game bases and converts models, animations and texture objects.
+ * Converted files are written into the export directory or, when the sink is set,
+ * delivered as in-memory buffers to the OutputSink.
+ *
+ * Only one instance should exist at a time, because mounted file systems,
+ * the output file system and the resource library are process wide.
+ */
+class ConverterPIX
+{
+public:
+	static const size_t PIPELINE_STAGES = 4;	// fetch, decode, format, write
+
+public:
+	ConverterPIX();
+	ConverterPIX(const ConverterPIX &) = delete;
+	ConverterPIX(ConverterPIX &&) = delete;
+	~ConverterPIX();
+
+	ConverterPIX &operator=(const ConverterPIX &) = delete;
+	ConverterPIX &operator=(ConverterPIX &&) = delete;
+
+	/**
+	 * @brief: Mounts directory or archive (zip, scs) on top of already mounted bases
+	 *
+	 * @param[in] path The path of the directory or archive file
+	 * @return @c True if the base has been mounted
+	 */
+	bool mount(const String &path);
+
+	/**
+	 * @brief: Opens the directories and archives concurrently and mounts them in one step
+	 *
+	 * The file name may contain the wildcards * and ?, e.g. "C:/ets2/dlc_*.scs", the matching
+	 * files are mounted in the order of their names.
+	 *
+	 * @param[in] paths The paths in the order of increasing priority, on top of already mounted bases
+	 * @return @c True if every path has been mounted and every pattern matched some file
+	 */
+	bool mount(const Array<String> &paths);
+
+	/**
+	 * @brief: Unmounts all of the bases mounted by this instance
+	 */
+	void unmountAll();
+
+	/**
+	 * @brief: Checks checksums of all entries of the mounted archives
+	 *
+	 * @param[in] threads The number of verification threads, 0 means one per hardware thread
+	 * @return @c True if no damaged entry has been found
+	 */
+	bool verify(size_t threads = 0);
+
+	/**
+	 * @brief: Sets directory into which the converted files are written
+	 *
+	 * Ignored while the output sink is set.
+	 */
+	void setExportPath(const String &path);
+
+	/**
+	 * @brief: Redirects converted files into the sink
+	 *
+	 * @param[in] sink The sink which receives files, or nullptr to write into the export path again
+	 */
+	void setOutputSink(OutputSink *sink);
+
+	/**
+	 * @brief: Fingerprints every converted file into the manifest
+	 *
+	 * The files are still written into the export path or the output sink.
+	 *
+	 * @param[in] manifest The manifest which receives fingerprints, or nullptr to stop fingerprinting
+	 */
+	void setFingerprintManifest(FingerprintManifest *manifest);
+
+	/**
+	 * @brief: Collects counters of the conversion (jobs, failures, time, written files)
+	 *
+	 * @param[in] metrics The metrics to fill, or nullptr to stop collecting
+	 */
+	void setMetrics(Metrics *metrics);
+
+	/**
+	 * @brief: Makes convertBase() convert the jobs in worker processes forked from this one
+	 *
+	 * The workers inherit the mounted bases, so they start without opening them again.
+	 * A worker crashed by a broken file is replaced, the file is reported and skipped.
+	 * Not available on Windows and with the output sink, convertBase() uses threads then.
+	 *
+	 * @param[in] count The number of worker processes, 0 disables them
+	 */
+	void setWorkerProcesses(size_t count);
+
+	/**
+	 * @brief: Makes convertBase() pass the jobs through the stages fetch, decode, format and write
+	 *
+	 * Every stage has its own threads and hands the jobs to the next one through bounded queue,
+	 * so reading the archives and writing the files overlap with decoding and formatting of other
+	 * jobs. The metrics get the time and the queue depth of every stage (pipeline_<stage>_*).
+	 * Not combined with the worker processes, which take precedence.
+	 *
+	 * @param[in] workers The number of threads of each of the PIPELINE_STAGES stages, empty disables the pipeline
+	 */
+	void setPipeline(const Array<size_t> &workers);
+
+	/**
+	 * @brief: Makes the loaders read the materials, texture objects and textures they are going to need in the background
+	 *
+	 * The metrics of convertBase() get the hit rate of the prefetched files (prefetch_*).
+	 *
+	 * @param[in] bytes The memory for the files read in advance, 0 disables prefetching
+	 */
+	void setPrefetchBudget(size_t bytes);
+
+	/**
+	 * @brief: Restricts convertBase() to the models and texture objects of one shard
+	 *
+	 * Every path belongs to the shard selected by stable hash of the path, so shards never overlap.
+	 * Textures shared by texture objects are copied only by the shard owning the texture path.
+	 *
+	 * @param[in] index The index of the shard, less than count
+	 * @param[in] count The number of shards, 1 disables sharding
+	 */
+	void setShard(size_t index, size_t count);
+
+	/**
+	 * @brief: Returns the shard owning the path
+	 */
+	static size_t shardOf(const String &path, size_t count);
+
+	/**
+	 * @brief: Combines manifests written by all shards of one base conversion
+	 *
+	 * Fails if any shard is missing or present twice, if the shards were made from different
+	 * inputs, or if any file has been written by more than one shard.
+	 *
+	 * @param[in] paths The paths of the shard manifests
+	 * @param[out] result The manifest equal to the manifest of the conversion without shards
+	 * @return @c True if the shards cover the whole base exactly once
+	 */
+	static bool mergeManifests(const Array<String> &paths, FingerprintManifest &result);
+
+	/**
+	 * @brief: Converts single model with its textures and animations
+	 *
+	 * @param[in] modelPath The path of the model without extension (relative to base)
+	 * @param[in] animations The animations to convert, "*" selects every animation from the model directory
+	 * @param[in] convertTextures Whether texture objects used by the model should be converted
+	 * @return @c True if the model has been loaded and exported
+	 */
+	bool convertModel(String modelPath, const Array<String> &animations = Array<String>(), bool convertTextures = true);
+
+	/**
+	 * @brief: Writes the model into pim in memory, parses it back and compares the streams
+	 *
+	 * Nothing is written into the export path or the output sink.
+	 *
+	 * @param[in] modelPath The path of the model without extension (relative to base)
+	 * @return @c True if the parsed streams are equal to the loaded pieces
+	 */
+	bool checkRoundTrip(String modelPath);
+
+	/**
+	 * @brief: Converts single texture object with its textures
+	 *
+	 * @param[in] tobjPath The path of the tobj file (relative to base)
+	 * @return @c True if the texture object has been loaded and exported
+	 */
+	bool convertTextureObject(String tobjPath);
+
+	/**
+	 * @brief: Converts every model and texture object found in the base directory
+	 *
+	 * When the fingerprint manifest is set, the numbers of jobs are stored in its header.
+	 *
+	 * @param[in] basepath The path of the base directory
+	 * @param[in] threads The number of conversion threads, 0 means one per hardware thread
+	 * @return @c True if there was anything to convert
+	 */
+	bool convertBase(const String &basepath, size_t threads = 1);
+
+	/**
+	 * @brief: Converts the models again whenever the files they read change
+	 *
+	 * Only the mounted directories are watched, the archives do not change. The models found
+	 * in the directories are loaded once to index the files they read, then every batch of
+	 * changed .pmg, .pmd, .pmc, .ppd, .mat, .tobj and .dds files reconverts just the models
+	 * reading them. The texture objects stay cached between the batches unless they change.
+	 *
+	 * @param[in] threads The number of conversion threads, 0 means one per hardware thread
+	 * @return @c False if there is nothing to watch or the changes cannot be read, otherwise never returns
+	 */
+	bool watch(size_t threads = 0);
+
+	/**
+	 * @brief: Returns the export path prepended to the paths of converted files
+	 */
+	String exportPath() const;
+
+private:
+	void updateOutput();
+
+private:
+	UniquePtr<ResourceLibrary> m_resourceLibrary;
+	UniquePtr<SinkFileSystem> m_sinkFileSystem;
+	UniquePtr<OutputSink> m_directorySink;
+	UniquePtr<OutputSink> m_fingerprintSink;
+	OutputSink *m_outputSink = nullptr;
+	FingerprintManifest *m_manifest = nullptr;
+	Metrics *m_metrics = nullptr;
+	size_t m_workerProcesses = 0;
+	Array<size_t> m_pipeline;
+	size_t m_shardIndex = 0;
+	size_t m_shardCount = 1;
+	Array<FileSystem *> m_mounted;
+	String m_exportPath;
+	int m_priority = 1;
+};
+
+/* eof */
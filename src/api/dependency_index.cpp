@@ -0,0 +1,65 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/api/dependency_index.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "dependency_index.h"
+
+void DependencyIndex::update(const String &model, const Array<String> &files)
+{
+	remove(model);
+	m_files[model] = files;
+	for (const auto &file : files)
+	{
+		m_models[file].push_back(model);
+	}
+}
+
+void DependencyIndex::remove(const String &model)
+{
+	const auto it = m_files.find(model);
+	if (it == m_files.end())
+	{
+		return;
+	}
+	for (const auto &file : it->second)
+	{
+		auto &models = m_models[file];
+		models.erase(std::remove(models.begin(), models.end(), model), models.end());
+		if (models.empty())
+		{
+			m_models.erase(file);
+		}
+	}
+	m_files.erase(it);
+}
+
+void DependencyIndex::affected(const String &file, Array<String> &models) const
+{
+	const auto it = m_models.find(file);
+	if (it != m_models.end())
+	{
+		models.insert(models.end(), it->second.begin(), it->second.end());
+	}
+}
+
+/* eof */
@@ -0,0 +1,63 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/api/dependency_index.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Reverse dependencies of the models, tells which models read the changed file.
+ *
+ * Every model is stored with the files read by its conversion (geometry, descriptor,
+ * materials, texture objects and textures), see Model::dependencies().
+ */
+class DependencyIndex
+{
+public:
+	/**
+	 * @brief: Replaces the files read by the model
+	 *
+	 * @param[in] model The path of the model without extension
+	 * @param[in] files The files read by the conversion of the model
+	 */
+	void update(const String &model, const Array<String> &files);
+
+	/**
+	 * @brief: Forgets the model, e.g. when its geometry has been deleted
+	 */
+	void remove(const String &model);
+
+	/**
+	 * @brief: Adds the models reading the file to the result
+	 *
+	 * @param[in] file The path of the file relative to the base
+	 * @param[in,out] models The models, may contain duplicates
+	 */
+	void affected(const String &file, Array<String> &models) const;
+
+	inline size_t models() const { return m_files.size(); }
+	inline size_t files() const { return m_models.size(); }
+
+private:
+	UnorderedMap<String, Array<String>> m_files;	// model -> files
+	UnorderedMap<String, Array<String>> m_models;	// file -> models
+};
+
+/* eof */
@@ -0,0 +1,683 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/api/inventory.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "inventory.h"
+
+#include <fs/file.h>
+#include <fs/uberfilesystem.h>
+#include <utils/thread_pool.h>
+#include <utils/json.h>
+#include <texture/texture_object.h>
+
+#include <structs/pmg_0x13.h>
+#include <structs/pmg_0x14.h>
+#include <structs/pmg_0x15.h>
+#include <structs/pmd.h>
+#include <structs/pma_0x03.h>
+#include <structs/pma_0x04.h>
+#include <structs/pmc.h>
+#include <structs/ppd_0x15.h>
+#include <structs/ppd_0x16.h>
+#include <structs/ppd_0x17.h>
+#include <structs/tobj.h>
+#include <structs/dds.h>
+
+#include <atomic>
+
+namespace
+{
+	const size_t WRITE_CHUNK = 1024 * 1024;
+	const u64 MAX_TOBJ_SIZE = 64 * 1024;
+
+	const struct
+	{
+		const char *m_extension;
+		Inventory::Kind m_kind;
+	} KINDS[] = {
+		{ ".pmg", Inventory::MODEL },
+		{ ".pmd", Inventory::DESCRIPTOR },
+		{ ".pma", Inventory::ANIMATION },
+		{ ".pmc", Inventory::COLLISION },
+		{ ".ppd", Inventory::PREFAB },
+		{ ".tobj", Inventory::TEXTURE_OBJECT },
+		{ ".dds", Inventory::TEXTURE },
+	};
+
+
+	String csvField(const String &value)
+	{
+		if (value.find_first_of(",\"\r\n") == String::npos)
+		{
+			return value;
+		}
+		String result = "\"";
+		for (const char c : value)
+		{
+			result += c == '"' ? "\"\"" : String(1, c);
+		}
+		return result + "\"";
+	}
+
+	bool flush(File *file, String &buffer, bool force)
+	{
+		if (!force && buffer.size() < WRITE_CHUNK)
+		{
+			return true;
+		}
+		const bool result = file->write(buffer.data(), sizeof(char), buffer.size()) == buffer.size();
+		buffer.clear();
+		return result;
+	}
+
+	template < typename T >
+	bool readHeader(File *file, Inventory::Asset &asset, T &header, u64 offset = 0)
+	{
+		if (offset + sizeof(T) > asset.m_size || !file->blockRead(&header, offset, sizeof(T)))
+		{
+			asset.m_error = "Truncated header";
+			return false;
+		}
+		return true;
+	}
+
+	template < typename Header, typename Piece >
+	void readModel(File *file, Inventory::Asset &asset, i32 Header::*piecesOffset)
+	{
+		Header header;
+		if (!readHeader(file, asset, header))
+		{
+			return;
+		}
+		const u64 offset = static_cast<u32>(header.*piecesOffset);
+		const u64 size = static_cast<u64>(static_cast<u32>(header.m_piece_count)) * sizeof(Piece);
+		if (header.m_piece_count < 0 || header.m_bone_count < 0 || offset + size > asset.m_size)
+		{
+			asset.m_error = "Invalid piece table";
+			return;
+		}
+		asset.m_pieces = static_cast<u32>(header.m_piece_count);
+		asset.m_bones = static_cast<u32>(header.m_bone_count);
+
+		Array<Piece> pieces(asset.m_pieces);
+		if (!pieces.empty() && !file->blockRead(pieces.data(), offset, size))
+		{
+			asset.m_error = "Unable to read piece table";
+			return;
+		}
+		for (const Piece &piece : pieces)
+		{
+			asset.m_vertices += static_cast<u32>(piece.m_verts);
+			asset.m_triangles += static_cast<u32>(piece.m_edges) / 3;
+		}
+	}
+
+	template < typename Header >
+	void readAnimation(File *file, Inventory::Asset &asset)
+	{
+		Header header;
+		if (readHeader(file, asset, header))
+		{
+			asset.m_frames = header.m_frames;
+			asset.m_bones = header.m_bones;
+			asset.m_length = header.m_anim_length;
+		}
+	}
+
+	String versionName(u32 version)
+	{
+		return fmt::sprintf("0x%02x", version);
+	}
+}
+
+const size_t Inventory::LARGEST_COUNT;
+
+bool Inventory::scan(const String &directory, size_t threads)
+{
+	auto files = getUFS()->readDir(directory, true, true);
+	if (!files)
+	{
+		return false;
+	}
+
+	m_assets.clear();
+	for (const auto &f : *files)
+	{
+		if (f.IsDirectory())
+			continue;
+
+		const String &path = f.GetPath();
+		const size_t dot = path.rfind('.');
+		if (dot == String::npos)
+			continue;
+
+		const String extension = path.substr(dot);
+		for (const auto &kind : KINDS)
+		{
+			if (extension == kind.m_extension)
+			{
+				m_assets.emplace_back();
+				m_assets.back().m_path = path;
+				m_assets.back().m_kind = kind.m_kind;
+				break;
+			}
+		}
+	}
+	files.reset();
+
+	std::sort(m_assets.begin(), m_assets.end(), [](const Asset &a, const Asset &b) {
+		return a.m_path < b.m_path;
+	});
+
+	// every worker fills distinct assets, so no locking is needed
+	if (threads == 1)
+	{
+		for (auto &asset : m_assets)
+		{
+			scanAsset(asset);
+		}
+	}
+	else
+	{
+		ThreadPool pool(threads);
+		std::atomic<size_t> next(0);
+		for (size_t worker = 0; worker < pool.size(); ++worker)
+		{
+			pool.submit([&]() {
+				for (size_t i = next++; i < m_assets.size(); i = next++)
+				{
+					scanAsset(m_assets[i]);
+				}
+			});
+		}
+		pool.wait();
+	}
+	return true;
+}
+
+void Inventory::scanAsset(Asset &asset)
+{
+	auto file = getUFS()->open(asset.m_path, FileSystem::read | FileSystem::binary);
+	if (!file)
+	{
+		asset.m_error = "Unable to open";
+		return;
+	}
+	asset.m_size = file->size();
+
+	switch (asset.m_kind)
+	{
+		case MODEL:				scanModel(file.get(), asset);			break;
+		case DESCRIPTOR:		scanDescriptor(file.get(), asset);		break;
+		case ANIMATION:			scanAnimation(file.get(), asset);		break;
+		case COLLISION:			scanCollision(file.get(), asset);		break;
+		case PREFAB:			scanPrefab(file.get(), asset);			break;
+		case TEXTURE_OBJECT:	scanTextureObject(file.get(), asset);	break;
+		case TEXTURE:			scanTexture(file.get(), asset);			break;
+		default: break;
+	}
+}
+
+void Inventory::scanModel(File *file, Asset &asset)
+{
+	u8 version = 0;
+	if (!readHeader(file, asset, version))
+	{
+		return;
+	}
+	asset.m_version = version;
+
+	switch (version)
+	{
+		case prism::pmg_0x13::pmg_header_t::SUPPORTED_VERSION:
+		{
+			using namespace prism::pmg_0x13;
+			readModel<pmg_header_t, pmg_piece_t>(file, asset, &pmg_header_t::m_piece_offset);
+		} break;
+		case prism::pmg_0x14::pmg_header_t::SUPPORTED_VERSION:
+		{
+			using namespace prism::pmg_0x14;
+			readModel<pmg_header_t, pmg_piece_t>(file, asset, &pmg_header_t::m_pieces_offset);
+		} break;
+		case prism::pmg_0x15::pmg_header_t::SUPPORTED_VERSION:
+		{
+			using namespace prism::pmg_0x15;
+			readModel<pmg_header_t, pmg_piece_t>(file, asset, &pmg_header_t::m_pieces_offset);
+		} break;
+		default:
+		{
+			asset.m_error = "Unsupported version";
+		}
+	}
+}
+
+void Inventory::scanDescriptor(File *file, Asset &asset)
+{
+	prism::pmd_header_t header;
+	if (!readHeader(file, asset, header))
+	{
+		return;
+	}
+	asset.m_version = header.m_version;
+	if (header.m_version != prism::pmd_header_t::SUPPORTED_VERSION)
+	{
+		asset.m_error = "Unsupported version";
+		return;
+	}
+	asset.m_pieces = header.m_piece_count;
+	asset.m_looks = header.m_look_count;
+	asset.m_variants = header.m_variant_count;
+	asset.m_materials = header.m_material_count;
+}
+
+void Inventory::scanAnimation(File *file, Asset &asset)
+{
+	u32 version = 0;
+	if (!readHeader(file, asset, version))
+	{
+		return;
+	}
+	asset.m_version = version;
+
+	switch (version)
+	{
+		case prism::pma_0x03::pma_header_t::SUPPORTED_VERSION:
+		{
+			readAnimation<prism::pma_0x03::pma_header_t>(file, asset);
+		} break;
+		case prism::pma_0x04::pma_header_t::SUPPORTED_VERSION:
+		{
+			readAnimation<prism::pma_0x04::pma_header_t>(file, asset);
+		} break;
+		default:
+		{
+			asset.m_error = "Unsupported version";
+		}
+	}
+}
+
+void Inventory::scanCollision(File *file, Asset &asset)
+{
+	prism::pmc_header_t header;
+	if (!readHeader(file, asset, header))
+	{
+		return;
+	}
+	asset.m_version = header.m_version;
+	if (header.m_version != prism::pmc_header_t::SUPPORTED_VERSION)
+	{
+		asset.m_error = "Unsupported version";
+		return;
+	}
+	asset.m_pieces = header.m_piece_count;
+	asset.m_looks = header.m_look_count;
+	asset.m_variants = header.m_variant_count;
+	asset.m_materials = header.m_material_count;
+}
+
+void Inventory::scanPrefab(File *file, Asset &asset)
+{
+	// the node count is at the same offset in all of the versions
+	prism::ppd_0x15::ppd_header_t header;
+	if (!readHeader(file, asset, header))
+	{
+		return;
+	}
+	asset.m_version = header.m_version;
+	if (header.m_version != prism::ppd_0x15::ppd_header_t::SUPPORTED_VERSION
+		&& header.m_version != prism::ppd_0x16::ppd_header_t::SUPPORTED_VERSION
+		&& header.m_version != prism::ppd_0x17::ppd_header_t::SUPPORTED_VERSION)
+	{
+		asset.m_error = "Unsupported version";
+		return;
+	}
+	asset.m_nodes = header.m_node_count;
+}
+
+void Inventory::scanTextureObject(File *file, Asset &asset)
+{
+	const size_t size = static_cast<size_t>(std::min(asset.m_size, MAX_TOBJ_SIZE));
+	if (size < sizeof(prism::tobj_header_t))
+	{
+		asset.m_error = "Truncated header";
+		return;
+	}
+	UniquePtr<u8[]> buffer(new u8[size]);
+	if (!file->blockRead(buffer.get(), 0, size))
+	{
+		asset.m_error = "Truncated header";
+		return;
+	}
+
+	const auto *const header = reinterpret_cast<const prism::tobj_header_t *>(buffer.get());
+	asset.m_version = header->m_version;
+	if (header->m_version != prism::tobj_header_t::SUPPORTED_MAGIC)
+	{
+		asset.m_error = "Unsupported version";
+		return;
+	}
+
+	const u32 textures = header->m_type == TextureObject::_CUBE_MAP ? 6 : 1;	// cube map has 6 faces
+	size_t offset = sizeof(prism::tobj_header_t);
+	for (u32 i = 0; i < textures; ++i)
+	{
+		if (offset + sizeof(prism::tobj_texture_t) > size)
+		{
+			asset.m_error = "Truncated texture list";
+			return;
+		}
+		const auto *const texture = reinterpret_cast<const prism::tobj_texture_t *>(buffer.get() + offset);
+		offset += sizeof(prism::tobj_texture_t);
+		if (offset + texture->m_length > size)
+		{
+			asset.m_error = "Truncated texture list";
+			return;
+		}
+
+		const String name(reinterpret_cast<const char *>(buffer.get() + offset), texture->m_length);
+		offset += texture->m_length;
+
+		const String path = !name.empty() && name[0] == '/' ? name : directory(asset.m_path) + "/" + name;
+		if (!getUFS()->exists(path))
+		{
+			asset.m_missing.push_back(path);
+		}
+	}
+}
+
+void Inventory::scanTexture(File *file, Asset &asset)
+{
+	struct
+	{
+		u32 m_magic;
+		dds::header m_header;
+	} header;
+	if (!readHeader(file, asset, header))
+	{
+		return;
+	}
+	if (header.m_magic != dds::MAGIC)
+	{
+		asset.m_error = "Invalid magic";
+		return;
+	}
+
+	asset.m_width = header.m_header.m_width;
+	asset.m_height = header.m_header.m_height;
+	asset.m_mipmaps = header.m_header.m_mip_map_count;
+
+	const dds::pixel_format &format = header.m_header.m_pixel_format;
+	if (format.m_flags & dds::PF_FOUR_CC)
+	{
+		asset.m_format = dds::uint2s(format.m_four_cc);
+	}
+	else if (const auto *named = dds::recognize_pixel_format(&format))
+	{
+		asset.m_format = named->m_name;
+	}
+	else
+	{
+		asset.m_format = fmt::sprintf("%ubpp", format.m_rgb_bit_count);
+	}
+}
+
+size_t Inventory::count(Kind kind) const
+{
+	return static_cast<size_t>(std::count_if(m_assets.begin(), m_assets.end(), [kind](const Asset &asset) {
+		return asset.m_kind == kind;
+	}));
+}
+
+size_t Inventory::errors() const
+{
+	return static_cast<size_t>(std::count_if(m_assets.begin(), m_assets.end(), [](const Asset &asset) {
+		return !asset.m_error.empty();
+	}));
+}
+
+size_t Inventory::missingTextures() const
+{
+	size_t result = 0;
+	for (const auto &asset : m_assets)
+	{
+		result += asset.m_missing.size();
+	}
+	return result;
+}
+
+const char *Inventory::kindName(Kind kind)
+{
+	switch (kind)
+	{
+		case MODEL:				return "model";
+		case DESCRIPTOR:		return "descriptor";
+		case ANIMATION:			return "animation";
+		case COLLISION:			return "collision";
+		case PREFAB:			return "prefab";
+		case TEXTURE_OBJECT:	return "tobj";
+		case TEXTURE:			return "texture";
+		default:				return "unknown";
+	}
+}
+
+bool Inventory::saveJson(File *file) const
+{
+	u64 bytes = 0;
+	u64 kinds[KIND_COUNT] = {};
+	Map<u32, u64> modelVersions;
+	Map<u32, u64> animationVersions;
+	Map<String, u64> textureFormats;
+	u64 pieces = 0, vertices = 0, triangles = 0, bones = 0, frames = 0;
+	Array<const Asset *> largest, largestModels;
+	for (const auto &asset : m_assets)
+	{
+		bytes += asset.m_size;
+		++kinds[asset.m_kind];
+		largest.push_back(&asset);
+		if (!asset.m_error.empty())
+		{
+			continue;
+		}
+		switch (asset.m_kind)
+		{
+			case MODEL:
+			{
+				++modelVersions[asset.m_version];
+				pieces += asset.m_pieces;
+				vertices += asset.m_vertices;
+				triangles += asset.m_triangles;
+				bones += asset.m_bones;
+				largestModels.push_back(&asset);
+			} break;
+			case ANIMATION:
+			{
+				++animationVersions[asset.m_version];
+				frames += asset.m_frames;
+			} break;
+			case TEXTURE:
+			{
+				++textureFormats[asset.m_format];
+			} break;
+			default: break;
+		}
+	}
+
+	const auto top = [](Array<const Asset *> &assets, u64 Asset::*member) {
+		const size_t n = std::min(assets.size(), LARGEST_COUNT);
+		std::partial_sort(assets.begin(), assets.begin() + n, assets.end(), [member](const Asset *a, const Asset *b) {
+			return a->*member != b->*member ? a->*member > b->*member : a->m_path < b->m_path;
+		});
+		assets.resize(n);
+	};
+	top(largest, &Asset::m_size);
+	top(largestModels, &Asset::m_vertices);
+
+	String buffer = "{" SEOL;
+	buffer += fmt::sprintf("\t\"assets\": %u," SEOL, m_assets.size());
+	buffer += fmt::sprintf("\t\"bytes\": %llu," SEOL, bytes);
+	buffer += fmt::sprintf("\t\"errors\": %u," SEOL, errors());
+	buffer += "\t\"kinds\": {";
+	for (u32 i = 0; i < KIND_COUNT; ++i)
+	{
+		buffer += fmt::sprintf("%s \"%s\": %llu", i ? "," : "", kindName(static_cast<Kind>(i)), kinds[i]);
+	}
+	buffer += " }," SEOL;
+
+	const auto counts = [](const char *name, const Map<u32, u64> &values) {
+		String result = fmt::sprintf("\t\t\"%s\": {", name);
+		for (auto it = values.cbegin(); it != values.cend(); ++it)
+		{
+			result += fmt::sprintf("%s \"%s\": %llu", it == values.cbegin() ? "" : ",", versionName(it->first), it->second);
+		}
+		return result + " }," SEOL;
+	};
+
+	buffer += "\t\"models\": {" SEOL;
+	buffer += counts("versions", modelVersions);
+	buffer += fmt::sprintf("\t\t\"pieces\": %llu," SEOL, pieces);
+	buffer += fmt::sprintf("\t\t\"vertices\": %llu," SEOL, vertices);
+	buffer += fmt::sprintf("\t\t\"triangles\": %llu," SEOL, triangles);
+	buffer += fmt::sprintf("\t\t\"bones\": %llu" SEOL, bones);
+	buffer += "\t}," SEOL;
+
+	buffer += "\t\"animations\": {" SEOL;
+	buffer += counts("versions", animationVersions);
+	buffer += fmt::sprintf("\t\t\"frames\": %llu" SEOL, frames);
+	buffer += "\t}," SEOL;
+
+	buffer += "\t\"texture_formats\": {";
+	for (auto it = textureFormats.cbegin(); it != textureFormats.cend(); ++it)
+	{
+		buffer += fmt::sprintf("%s %s: %llu", it == textureFormats.cbegin() ? "" : ",", json::quote(it->first), it->second);
+	}
+	buffer += " }," SEOL;
+
+	buffer += "\t\"missing_textures\": [";
+	bool first = true;
+	for (const auto &asset : m_assets)
+	{
+		for (const auto &missing : asset.m_missing)
+		{
+			buffer += fmt::sprintf("%s" SEOL "\t\t{ \"tobj\": %s, \"texture\": %s }", first ? "" : ",", json::quote(asset.m_path), json::quote(missing));
+			first = false;
+		}
+	}
+	buffer += first ? "]," SEOL : SEOL "\t]," SEOL;
+
+	buffer += "\t\"largest\": [";
+	for (size_t i = 0; i < largest.size(); ++i)
+	{
+		buffer += fmt::sprintf("%s" SEOL "\t\t{ \"path\": %s, \"size\": %llu }", i ? "," : "", json::quote(largest[i]->m_path), largest[i]->m_size);
+	}
+	buffer += largest.empty() ? "]," SEOL : SEOL "\t]," SEOL;
+
+	buffer += "\t\"largest_models\": [";
+	for (size_t i = 0; i < largestModels.size(); ++i)
+	{
+		buffer += fmt::sprintf("%s" SEOL "\t\t{ \"path\": %s, \"vertices\": %llu, \"triangles\": %llu }",
+			i ? "," : "", json::quote(largestModels[i]->m_path), largestModels[i]->m_vertices, largestModels[i]->m_triangles);
+	}
+	buffer += largestModels.empty() ? "]," SEOL : SEOL "\t]," SEOL;
+
+	// one asset per line, only the fields of its kind
+	buffer += "\t\"items\": [";
+	for (size_t i = 0; i < m_assets.size(); ++i)
+	{
+		const Asset &asset = m_assets[i];
+		buffer += fmt::sprintf("%s" SEOL "\t\t{ \"path\": %s, \"kind\": \"%s\", \"size\": %llu",
+			i ? "," : "", json::quote(asset.m_path), kindName(asset.m_kind), asset.m_size);
+		if (asset.m_version)
+		{
+			buffer += fmt::sprintf(", \"version\": \"%s\"", versionName(asset.m_version));
+		}
+		switch (asset.m_kind)
+		{
+			case MODEL:
+			{
+				buffer += fmt::sprintf(", \"pieces\": %u, \"bones\": %u, \"vertices\": %llu, \"triangles\": %llu",
+					asset.m_pieces, asset.m_bones, asset.m_vertices, asset.m_triangles);
+			} break;
+			case DESCRIPTOR:
+			case COLLISION:
+			{
+				buffer += fmt::sprintf(", \"pieces\": %u, \"looks\": %u, \"variants\": %u, \"materials\": %u",
+					asset.m_pieces, asset.m_looks, asset.m_variants, asset.m_materials);
+			} break;
+			case ANIMATION:
+			{
+				buffer += fmt::sprintf(", \"frames\": %u, \"bones\": %u, \"length\": %.3f", asset.m_frames, asset.m_bones, asset.m_length);
+			} break;
+			case PREFAB:
+			{
+				buffer += fmt::sprintf(", \"nodes\": %u", asset.m_nodes);
+			} break;
+			case TEXTURE:
+			{
+				buffer += fmt::sprintf(", \"width\": %u, \"height\": %u, \"mipmaps\": %u, \"format\": %s",
+					asset.m_width, asset.m_height, asset.m_mipmaps, json::quote(asset.m_format));
+			} break;
+			default: break;
+		}
+		if (!asset.m_missing.empty())
+		{
+			buffer += fmt::sprintf(", \"missing\": %u", asset.m_missing.size());
+		}
+		if (!asset.m_error.empty())
+		{
+			buffer += fmt::sprintf(", \"error\": %s", json::quote(asset.m_error));
+		}
+		buffer += " }";
+		if (!flush(file, buffer, false))
+		{
+			return false;
+		}
+	}
+	buffer += m_assets.empty() ? "]" SEOL : SEOL "\t]" SEOL;
+	buffer += "}" SEOL;
+	return flush(file, buffer, true);
+}
+
+bool Inventory::saveCsv(File *file) const
+{
+	String buffer = "path,kind,size,version,pieces,bones,vertices,triangles,looks,variants,materials,frames,length,nodes,width,height,mipmaps,format,missing,error" SEOL;
+	for (const auto &asset : m_assets)
+	{
+		String missing;
+		for (const auto &texture : asset.m_missing)
+		{
+			missing += (missing.empty() ? "" : ";") + texture;
+		}
+		buffer += fmt::sprintf("%s,%s,%llu,%s,%u,%u,%llu,%llu,%u,%u,%u,%u,%.3f,%u,%u,%u,%u,%s,%s,%s" SEOL,
+			csvField(asset.m_path), kindName(asset.m_kind), asset.m_size, asset.m_version ? versionName(asset.m_version) : "",
+			asset.m_pieces, asset.m_bones, asset.m_vertices, asset.m_triangles, asset.m_looks, asset.m_variants, asset.m_materials,
+			asset.m_frames, asset.m_length, asset.m_nodes, asset.m_width, asset.m_height, asset.m_mipmaps,
+			csvField(asset.m_format), csvField(missing), csvField(asset.m_error));
+		if (!flush(file, buffer, false))
+		{
+			return false;
+		}
+	}
+	return flush(file, buffer, true);
+}
+
+/* eof */
@@ -0,0 +1,114 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/api/inventory.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Inventory of the mounted bases built from the file headers only.
+ *
+ * Geometry, animation frames and texture data are never read, so a whole base
+ * is scanned in a few seconds. The report is written as JSON (summary and assets)
+ * or as CSV (one line per asset).
+ */
+class Inventory
+{
+public:
+	enum Kind : u8
+	{
+		MODEL,			// pmg
+		DESCRIPTOR,		// pmd
+		ANIMATION,		// pma
+		COLLISION,		// pmc
+		PREFAB,			// ppd
+		TEXTURE_OBJECT,	// tobj
+		TEXTURE,		// dds
+		KIND_COUNT
+	};
+
+	struct Asset
+	{
+		String m_path;
+		Kind m_kind;
+		u64 m_size = 0;
+		u32 m_version = 0;
+		u32 m_pieces = 0;		// pmg, pmd, pmc
+		u32 m_bones = 0;		// pmg, pma
+		u64 m_vertices = 0;		// pmg
+		u64 m_triangles = 0;	// pmg
+		u32 m_looks = 0;		// pmd, pmc
+		u32 m_variants = 0;		// pmd, pmc
+		u32 m_materials = 0;	// pmd, pmc
+		u32 m_frames = 0;		// pma
+		float m_length = 0.f;	// pma
+		u32 m_nodes = 0;		// ppd
+		u32 m_width = 0;		// dds
+		u32 m_height = 0;		// dds
+		u32 m_mipmaps = 0;		// dds
+		String m_format;		// dds
+		Array<String> m_missing;	// tobj, textures which do not exist
+		String m_error;
+	};
+
+public:
+	/**
+	 * @brief: Reads headers of all assets in the directory of the mounted filesystems
+	 *
+	 * @param[in] directory The directory to scan recursively, e.g. "/"
+	 * @param[in] threads The number of threads, 0 means one per hardware thread
+	 * @return @c True if the directory exists
+	 */
+	bool scan(const String &directory, size_t threads = 0);
+
+	/**
+	 * @brief: Writes the report
+	 *
+	 * @param[in] file The file to write
+	 * @return @c True if the whole report has been written
+	 */
+	bool saveJson(File *file) const;
+	bool saveCsv(File *file) const;
+
+	inline const Array<Asset> &assets() const { return m_assets; }
+	size_t count(Kind kind) const;
+	size_t errors() const;
+	size_t missingTextures() const;
+
+	static const char *kindName(Kind kind);
+
+public:
+	static const size_t LARGEST_COUNT = 20;	// the number of largest assets in the JSON summary
+
+private:
+	static void scanAsset(Asset &asset);
+	static void scanModel(File *file, Asset &asset);
+	static void scanDescriptor(File *file, Asset &asset);
+	static void scanAnimation(File *file, Asset &asset);
+	static void scanCollision(File *file, Asset &asset);
+	static void scanPrefab(File *file, Asset &asset);
+	static void scanTextureObject(File *file, Asset &asset);
+	static void scanTexture(File *file, Asset &asset);
+
+private:
+	Array<Asset> m_assets;	// sorted by path
+};
+
+/* eof */
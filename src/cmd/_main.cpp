@@ -22,16 +22,21 @@
 
 #include <prerequisites.h>
 
-#include <resource_lib.h>
-#include <model/model.h>
-#include <model/animation.h>
-#include <texture/texture_object.h>
-#include <texture/texture.h>
+#include <api/converterpix.h>
+
+#include <config.h>
 
 #include <structs/dds.h>
 #include <fs/file.h>
 #include <fs/sysfilesystem.h>
 #include <fs/uberfilesystem.h>
+#include <fs/zip_sink.h>
+#include <fs/tar_sink.h>
+#include <fs/hashfs_packer.h>
+#include <fs/fingerprint_sink.h>
+#include <utils/metrics.h>
+#include <utils/thread_pool.h>
+#include <api/inventory.h>
 
 #include <chrono>
 
@@ -42,8 +47,40 @@ void print_help()
 		   "  -m <model_path>      - turns into single model mode and specifies model path (relative to base)\n"
 		   "  -t <tobj_path>       - turns into single tobj mode and specifies tobj path (relative to base)\n"
 		   "  -d <dds_path>        - turns into single dds mode and prints debug info (absolute path)\n"
-		   "  -b <base_path>       - specify base path\n"
+		   "  -b <base_path>       - specify base path, may be given several times (* and ? select several archives)\n"
 		   "  -e <export_path>     - specify export path\n"
+		   "                         (<name>.zip or <name>.tar writes single archive, - writes tar stream to stdout)\n"
+		   "  -store               - store files in zip archive without compression\n"
+		   "  -pack <dir> <out>    - packs directory into HashFS archive (.scs)\n"
+		   "  -verify              - checks CRC of every entry in the mounted archives\n"
+		   "  -verify_on_read      - checks CRC of archive entries while converting\n"
+		   "  -glb                 - writes models as binary glTF (.glb) with skin and skeleton instead of pim and pis\n"
+		   "  -decode_textures <tga|png>\n"
+		   "                       - writes decoded copy of every exported dds next to it\n"
+		   "  -precise_doubles     - writes real numbers (materials, prefabs, pix values) with the shortest text\n"
+		   "                         reading back the same value, instead of 6 decimals\n"
+		   "  -reduce_keyframes <tolerance>\n"
+		   "                       - drops animation keyframes which are reproduced within the tolerance by\n"
+		   "                         interpolating the kept ones (constant and linearly moving bones)\n"
+		   "  -roundtrip <model>   - writes pim of the model into memory, parses it back and compares with the model\n"
+		   "  -j <threads>         - number of threads converting the whole base (0 = one per CPU, default 1)\n"
+		   "  -workers <count>     - converts the whole base in worker processes (0 = one per CPU), a worker crashed\n"
+		   "                         by a broken file is restarted and the file is reported\n"
+		   "  -pipeline <fetch,decode,format,write>\n"
+		   "                       - converts the whole base in stages connected by queues, with the given number\n"
+		   "                         of threads each (0 = one per CPU), the metrics show the busy and waiting stages\n"
+		   "  -prefetch <MiB>      - reads materials, texture objects and textures the loaders will need in the background,\n"
+		   "                         keeping at most the given amount of them in memory\n"
+		   "  -scan <report>       - reads only headers of the assets and writes inventory of the base\n"
+		   "                         (<name>.csv writes one line per asset, otherwise JSON; -j defaults to one per CPU)\n"
+		   "  -watch               - converts the models again whenever their files change in the mounted directories\n"
+		   "                         (-j defaults to one per CPU)\n"
+		   "  -fingerprint <file>  - writes manifest with hashes of all converted files\n"
+		   "  -compare <file>      - reports converted files which differ from the manifest\n"
+		   "  -shard <i/N>         - converts only shard i (0 <= i < N) of the whole base\n"
+		   "  -metrics <file>      - writes counters of the conversion (or of the merge) as JSON\n"
+		   "  -merge_manifests <out> <manifests...>\n"
+		   "                       - checks that the shard manifests cover the base and combines them\n"
 		   "\n"
 		   " Usage:\n"
 		   "  converter_pix -b C:\\ets2_base -m /vehicle/truck/man_tgx/interior/anim s_wheel\n"
@@ -55,6 +92,26 @@ void print_help()
 		   "    ^ will convert whole base, it will export it into: <base_path>_exp (C:\\ets2_base_exp in this example).\n"
 		   "    ^ you can also specify export path using the -e parameter.\n"
 		   "\n"
+		   "  converter_pix -pack C:\\ets2_base_exp C:\\mod.scs\n"
+		   "    ^ will pack the directory into HashFS archive, use -store to disable compression.\n"
+		   "\n"
+		   "  converter_pix -j 0 -fingerprint C:\\new.txt -compare C:\\old.txt C:\\ets2_base\n"
+		   "    ^ will convert whole base in parallel and list files which changed since old.txt was written.\n"
+		   "\n"
+		   "  converter_pix -shard 0/2 -fingerprint C:\\s0.txt C:\\ets2_base\n"
+		   "  converter_pix -shard 1/2 -fingerprint C:\\s1.txt C:\\ets2_base\n"
+		   "  converter_pix -merge_manifests C:\\all.txt C:\\s0.txt C:\\s1.txt\n"
+		   "    ^ will convert whole base in two processes (or on two machines) and check that nothing is missing.\n"
+		   "\n"
+		   "  converter_pix -b C:\\ets2\\base.scs -b C:\\ets2\\dlc_*.scs -b C:\\mods\\my_mod.zip -listdir /\n"
+		   "    ^ will open all of the archives at once, the later -b takes precedence (quote the * on Linux).\n"
+		   "\n"
+		   "  converter_pix -b C:\\ets2_base -b C:\\ets2_dlc -scan C:\\inventory.json\n"
+		   "    ^ will list models, animations and textures of the mounted bases with their counts, without converting them.\n"
+		   "\n"
+		   "  converter_pix -b C:\\ets2_base -b C:\\my_mod -e C:\\my_mod_exp -watch\n"
+		   "    ^ will convert every model of my_mod again as soon as its geometry, materials or textures are saved.\n"
+		   "\n"
 		   "  converter_pix -b C:\\ets2_base -t /material/environment/vehicle_reflection.tobj\n"
 		   "    ^ will convert tobj file and copy texture to export path.\n"
 		   "\n"
@@ -71,10 +128,7 @@ void print_help()
 	);
 }
 
-bool convertSingleModel(String filepath, String exportpath, Array<String> optionalArgs);
-bool convertWholeBase(String basepath, String exportpath);
-
-int main(int argc, char *argv[])
+void print_banner()
 {
 	printf("\n"
 		   " ******************************************\n"
@@ -83,15 +137,19 @@ int main(int argc, char *argv[])
 		   " ******************************************\n"
 		   "\n"
 	);
+}
 
+int main(int argc, char *argv[])
+{
 	if (argc < 2)
 	{
+		print_banner();
 		printf("Not enough parameters.\n");
 		print_help();
 		return 1;
 	}
 
-	auto resLib = std::make_unique<ResourceLibrary>();
+	ConverterPIX converter;
 
 	Array<String> basepath;
 	String exportpath;
@@ -106,11 +164,27 @@ int main(int argc, char *argv[])
 		SHOW_FILE,
 		EXTRACT_FILE,
 		EXTRACT_DIRECTORY,
-		LIST_DIR
+		LIST_DIR,
+		PACK_ARCHIVE,
+		VERIFY_ARCHIVES,
+		ROUND_TRIP,
+		MERGE_MANIFESTS,
+		SCAN,
+		WATCH
 	} mode = DIRECTORY_LIST;
 
 	String *parameter = nullptr;
 	Array<String> optionalArgs;
+	bool storeArchive = false;
+	String threads;
+	String workers;
+	String pipeline;
+	String prefetch;
+	String keyframeTolerance;
+	String fingerprintPath;
+	String comparePath;
+	String shard;
+	String metricsPath;
 
 	for (int i = 1; i < argc; ++i)
 	{
@@ -123,6 +197,7 @@ int main(int argc, char *argv[])
 		}
 		if (arg == "-h")
 		{
+			print_banner();
 			print_help();
 			return 0;
 		}
@@ -145,6 +220,10 @@ int main(int argc, char *argv[])
 		{
 			parameter = &exportpath;
 		}
+		else if (arg == "-store")
+		{
+			storeArchive = true;
+		}
 		else if (arg == "-d")
 		{
 			mode = DEBUG_DDS;
@@ -171,6 +250,86 @@ int main(int argc, char *argv[])
 			listdir_r = true;
 			parameter = &path;
 		}
+		else if (arg == "-pack")
+		{
+			mode = PACK_ARCHIVE;
+			parameter = &path;
+		}
+		else if (arg == "-verify")
+		{
+			mode = VERIFY_ARCHIVES;
+		}
+		else if (arg == "-roundtrip")
+		{
+			mode = ROUND_TRIP;
+			parameter = &path;
+		}
+		else if (arg == "-j")
+		{
+			parameter = &threads;
+		}
+		else if (arg == "-workers")
+		{
+			parameter = &workers;
+		}
+		else if (arg == "-pipeline")
+		{
+			parameter = &pipeline;
+		}
+		else if (arg == "-prefetch")
+		{
+			parameter = &prefetch;
+		}
+		else if (arg == "-fingerprint")
+		{
+			parameter = &fingerprintPath;
+		}
+		else if (arg == "-compare")
+		{
+			parameter = &comparePath;
+		}
+		else if (arg == "-shard")
+		{
+			parameter = &shard;
+		}
+		else if (arg == "-metrics")
+		{
+			parameter = &metricsPath;
+		}
+		else if (arg == "-merge_manifests")
+		{
+			mode = MERGE_MANIFESTS;
+			parameter = &path;
+		}
+		else if (arg == "-scan")
+		{
+			mode = SCAN;
+			parameter = &path;
+		}
+		else if (arg == "-watch")
+		{
+			mode = WATCH;
+		}
+		else if (arg == "-verify_on_read")
+		{
+			Config::s_verifyOnRead = true;
+		}
+		else if (arg == "-glb")
+		{
+			Config::s_glb = true;
+		}
+		else if (arg == "-precise_doubles")
+		{
+			Config::s_preciseDoubles = true;
+		}
+		else if (arg == "-decode_textures")
+		{
+			parameter = &Config::s_decodeTextures;
+		}
+		else if (arg == "-reduce_keyframes")
+		{
+			parameter = &keyframeTolerance;
+		}
 		else if (arg == "-show_f")
 		{
 			mode = SHOW_FILE;
@@ -182,16 +341,129 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	for (const auto &base : basepath)
+	// the archive has to be opened before anything is printed, because it may take over stdout
+	UniquePtr<OutputSink> archive;
+	if (exportpath == "-")
 	{
-		static int priority = 1;
-		ufsMount(base, true, priority++);
+		auto output = getSFS()->openStdout();
+		if (!output)
+		{
+			print_banner();
+			error_f("system", exportpath, "Unable to open stdout to write (%s)!", strerror(errno));
+			return 1;
+		}
+		archive = std::make_unique<TarOutputSink>(std::move(output));
+	}
+	else if (exportpath.length() > 4 && exportpath.substr(exportpath.length() - 4) == ".zip")
+	{
+		auto output = getSFS()->open(exportpath, FileSystem::write | FileSystem::binary);
+		if (!output)
+		{
+			print_banner();
+			error_f("system", exportpath, "Unable to open archive to write (%s)!", strerror(errno));
+			return 1;
+		}
+		archive = std::make_unique<ZipOutputSink>(std::move(output), !storeArchive);
+	}
+	else if (exportpath.length() > 4 && exportpath.substr(exportpath.length() - 4) == ".tar")
+	{
+		auto output = getSFS()->open(exportpath, FileSystem::write | FileSystem::binary);
+		if (!output)
+		{
+			print_banner();
+			error_f("system", exportpath, "Unable to open archive to write (%s)!", strerror(errno));
+			return 1;
+		}
+		archive = std::make_unique<TarOutputSink>(std::move(output));
 	}
 
+	print_banner();
+
+	if (archive)
+	{
+		converter.setOutputSink(archive.get());
+	}
+
+	FingerprintManifest manifest;
+	FingerprintManifest reference;
+	if (!comparePath.empty())
+	{
+		auto file = getSFS()->open(comparePath, FileSystem::read | FileSystem::binary);
+		if (!file)
+		{
+			error_f("system", comparePath, "Unable to open manifest to read (%s)!", strerror(errno));
+			return 1;
+		}
+		if (!reference.load(comparePath, file.get()))
+		{
+			return 1;
+		}
+	}
+	if (!fingerprintPath.empty() || !comparePath.empty())
+	{
+		manifest.setHeader("version", STRING_VERSION);
+		converter.setFingerprintManifest(&manifest);
+	}
+
+	Metrics metrics;
+	if (!metricsPath.empty())
+	{
+		converter.setMetrics(&metrics);
+	}
+	if (!Config::s_decodeTextures.empty() && Config::s_decodeTextures != "tga" && Config::s_decodeTextures != "png")
+	{
+		error("system", Config::s_decodeTextures, "Invalid decoded texture format, expected tga or png!");
+		return 1;
+	}
+	if (!keyframeTolerance.empty())
+	{
+		char *end = nullptr;
+		Config::s_keyframeTolerance = strtof(keyframeTolerance.c_str(), &end);
+		if (*end != '\0' || !(Config::s_keyframeTolerance >= 0.f))
+		{
+			error("system", keyframeTolerance, "Invalid keyframe tolerance, expected non-negative number!");
+			return 1;
+		}
+	}
+	if (!shard.empty())
+	{
+		unsigned index = 0, count = 0;
+		if (sscanf(shard.c_str(), "%u/%u", &index, &count) != 2 || count == 0 || index >= count)
+		{
+			error("system", shard, "Invalid shard, expected i/N where 0 <= i < N!");
+			return 1;
+		}
+		converter.setShard(index, count);
+	}
+	if (!workers.empty())
+	{
+		// -workers 0 starts one worker per CPU, setWorkerProcesses(0) would disable them
+		const size_t count = static_cast<size_t>(strtoul(workers.c_str(), nullptr, 10));
+		converter.setWorkerProcesses(count == 0 ? ThreadPool::defaultThreadCount() : count);
+	}
+	if (!pipeline.empty())
+	{
+		unsigned fetch = 0, decode = 0, format = 0, write = 0;
+		if (sscanf(pipeline.c_str(), "%u,%u,%u,%u", &fetch, &decode, &format, &write) != 4)
+		{
+			error("system", pipeline, "Invalid pipeline, expected threads of the stages fetch,decode,format,write!");
+			return 1;
+		}
+		converter.setPipeline({ fetch, decode, format, write });
+	}
+	if (!prefetch.empty())
+	{
+		converter.setPrefetchBudget(static_cast<size_t>(strtoull(prefetch.c_str(), nullptr, 10)) << 20);
+	}
+
+	converter.mount(basepath);
+
 	long long startTime =
 		std::chrono::duration_cast<std::chrono::milliseconds>
 		(std::chrono::system_clock::now().time_since_epoch()).count();
 
+	bool mergeFailed = false;
+
 	switch (mode)
 	{
 		case SINGLE_MODEL:
@@ -205,7 +477,8 @@ int main(int argc, char *argv[])
 			{
 				exportpath = basepath.back() + "_exp";
 			}
-			convertSingleModel(path, exportpath, optionalArgs);
+			converter.setExportPath(exportpath);
+			converter.convertModel(path, optionalArgs);
 		} break;
 		case DIRECTORY_LIST:
 		{
@@ -217,14 +490,14 @@ int main(int argc, char *argv[])
 			if (basepath.empty())
 			{
 				basepath.push_back(optionalArgs[0]);
-				static int priority = 1;
-				ufsMount(basepath[0], true, priority++);
+				converter.mount(basepath[0]);
 			}
 			if (exportpath.empty())
 			{
 				exportpath = basepath[0] + "_exp";
 			}
-			convertWholeBase(basepath[0], exportpath);
+			converter.setExportPath(exportpath);
+			converter.convertBase(basepath[0], threads.empty() ? 1 : static_cast<size_t>(strtoul(threads.c_str(), nullptr, 10)));
 		} break;
 		case SINGLE_TOBJ:
 		{
@@ -237,13 +510,8 @@ int main(int argc, char *argv[])
 			{
 				exportpath = basepath[0] + "_exp";
 			}
-			backslashesToSlashes(path);
-			TextureObject tobj;
-			if (tobj.load(path))
-			{
-				tobj.saveToMidFormats(exportpath);
-				printf("%s: tobj: yes\n", path.substr(directory(path).length() + 1).c_str());
-			}
+			converter.setExportPath(exportpath);
+			converter.convertTextureObject(path);
 		} break;
 		case DEBUG_DDS:
 		{
@@ -263,17 +531,18 @@ int main(int argc, char *argv[])
 			{
 				exportpath = basepath[0] + "_exp";
 			}
+			converter.setExportPath(exportpath);
 			auto file = getUFS()->open(path, FileSystem::read | FileSystem::binary);
 			if (file)
 			{
-				auto output = getSFS()->open(exportpath + path, FileSystem::write | FileSystem::binary);
+				auto output = getOFS()->open(converter.exportPath() + path, FileSystem::write | FileSystem::binary);
 				if (output)
 				{
 					copyFile(file.get(), output.get());
 				}
 				else
 				{
-					printf("Unable to open file to write: %s\n", (exportpath + path).c_str());
+					printf("Unable to open file to write: %s\n", (converter.exportPath() + path).c_str());
 				}
 			}
 			else
@@ -313,6 +582,7 @@ int main(int argc, char *argv[])
 			{
 				exportpath = basepath[0] + "_exp";
 			}
+			converter.setExportPath(exportpath);
 			auto files = getUFS()->readDir(path, true, true);
 			if (!files)
 			{
@@ -329,14 +599,14 @@ int main(int argc, char *argv[])
 				auto file = getUFS()->open(f.GetPath(), FileSystem::read | FileSystem::binary);
 				if (file)
 				{
-					auto output = getSFS()->open(exportpath + f.GetPath(), FileSystem::write | FileSystem::binary);
+					auto output = getOFS()->open(converter.exportPath() + f.GetPath(), FileSystem::write | FileSystem::binary);
 					if (output)
 					{
 						copyFile(file.get(), output.get());
 					}
 					else
 					{
-						printf("Unable to open file to write: %s\n", (exportpath + f.GetPath()).c_str());
+						printf("Unable to open file to write: %s\n", (converter.exportPath() + f.GetPath()).c_str());
 					}
 				}
 				else
@@ -366,130 +636,198 @@ int main(int argc, char *argv[])
 
 			printf("-- done --\n");
 		} break;
-	}
-
-	long long endTime =
-		std::chrono::duration_cast<std::chrono::milliseconds>
-		(std::chrono::system_clock::now().time_since_epoch()).count();
-
-	//printf("Time : %llums\n", endTime - startTime);
-
-	return 0;
-}
-
-bool convertSingleModel(String filepath, String exportpath, Array<String> optionalArgs)
-{
-	backslashesToSlashes(filepath);
-	auto model = std::make_shared<Model>();
-	if (!model->load(filepath))
-	{
-		printf("Failed to load: %s\n", filepath.c_str());
-		return false;
-	}
-	model->saveToMidFormat(exportpath, true);
-	for (size_t i = 0; i < optionalArgs.size(); ++i)
-	{
-		if (optionalArgs[i] == "*")
+		case PACK_ARCHIVE:
 		{
-			auto files = getUFS()->readDir(model->fileDirectory(), true, false);
-
-			// remove files with no .pma extension
-			files->erase(
-				std::remove_if(files->begin(), files->end(),
-					[](const FileSystem::Entry &s) {
-						return s.IsDirectory() || s.GetPath().substr(s.GetPath().rfind('.')) != ".pma";
-					}
-				), files->end()
-			);
-
-			// remove extensions
-			std::for_each(files->begin(), files->end(),
-				[&](FileSystem::Entry &s) {
-					s.SetPath(s.GetPath().substr(0, s.GetPath().rfind('.')));
-				}
-			);
+			if (path.empty() || optionalArgs.empty())
+			{
+				error("system", "", "Not specified directory or output archive!");
+				return 1;
+			}
+			const String &archivePath = optionalArgs[0];
+			SysFileSystem source(removeSlashAtEnd(path));
+			if (!source.dirExists("/"))
+			{
+				error("system", path, "Directory does not exist!");
+				return 1;
+			}
+			auto output = getSFS()->open(archivePath, FileSystem::write | FileSystem::binary);
+			if (!output)
+			{
+				error_f("system", archivePath, "Unable to open archive to write (%s)!", strerror(errno));
+				return 1;
+			}
+			HashFsPacker packer(!storeArchive);
+			if (!packer.pack(&source, "/", output.get()))
+			{
+				error("system", archivePath, "Failed to pack the archive!");
+				return 1;
+			}
+			printf("Packed: %s\n", archivePath.c_str());
+		} break;
+		case VERIFY_ARCHIVES:
+		{
+			if (basepath.empty())
+			{
+				error("system", "", "Not specified base path!");
+				return 1;
+			}
+			if (!converter.verify())
+			{
+				return 1;
+			}
+		} break;
+		case ROUND_TRIP:
+		{
+			if (basepath.empty())
+			{
+				error("system", "", "Not specified base path!");
+				return 1;
+			}
+			if (!converter.checkRoundTrip(path))
+			{
+				return 1;
+			}
+		} break;
+		case SCAN:
+		{
+			if (basepath.empty())
+			{
+				error("system", "", "Not specified base path!");
+				return 1;
+			}
+			const auto scanStart = std::chrono::steady_clock::now();
+			Inventory inventory;
+			if (!inventory.scan("/", threads.empty() ? 0 : static_cast<size_t>(strtoul(threads.c_str(), nullptr, 10))))
+			{
+				error("scan", "/", "No files to scan!");
+				return 1;
+			}
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scanStart).count();
 
-			for (const auto &f : (*files))
+			auto file = getSFS()->open(path, FileSystem::write | FileSystem::binary);
+			const bool csv = path.size() >= 4 && path.substr(path.size() - 4) == ".csv";
+			if (!file || !(csv ? inventory.saveCsv(file.get()) : inventory.saveJson(file.get())))
 			{
-				optionalArgs.push_back(f.GetPath());
+				error_f("system", path, "Unable to write the report (%s)!", strerror(errno));
+				return 1;
 			}
-			continue;
-		}
-		backslashesToSlashes(optionalArgs[i]);
-		Animation anim;
-		if (!anim.load(model, optionalArgs[i]))
+			metrics.set("assets", static_cast<u64>(inventory.assets().size()));
+			metrics.set("errors", static_cast<u64>(inventory.errors()));
+			metrics.set("missing_textures", static_cast<u64>(inventory.missingTextures()));
+			metrics.set("seconds", seconds);
+			info_f("scan", path, "%u assets scanned in %.2f s, %u errors, %u missing textures",
+				inventory.assets().size(), seconds, inventory.errors(), inventory.missingTextures());
+		} break;
+		case WATCH:
 		{
-			printf("Failed to load: %s\n", optionalArgs[i].c_str());
-		}
-		else
+			if (basepath.empty())
+			{
+				error("system", "", "Not specified base path!");
+				return 1;
+			}
+			if (archive)
+			{
+				error("system", exportpath, "The changes cannot be watched while writing into archive!");
+				return 1;
+			}
+			if (exportpath.empty())
+			{
+				exportpath = basepath.back() + "_exp";
+			}
+			converter.setExportPath(exportpath);
+			if (!converter.watch(threads.empty() ? 0 : static_cast<size_t>(strtoul(threads.c_str(), nullptr, 10))))
+			{
+				return 1;
+			}
+		} break;
+		case MERGE_MANIFESTS:
 		{
-			anim.saveToPia(exportpath);
-		}
+			FingerprintManifest merged;
+			const bool valid = ConverterPIX::mergeManifests(optionalArgs, merged);
+			auto file = getSFS()->open(path, FileSystem::write | FileSystem::binary);
+			if (!file || !merged.save(file.get()))
+			{
+				error_f("system", path, "Unable to write the manifest (%s)!", strerror(errno));
+				return 1;
+			}
+			metrics.set("shards", static_cast<u64>(optionalArgs.size()));
+			metrics.set("files", static_cast<u64>(merged.size()));
+			metrics.set("bytes", merged.totalSize());
+			metrics.set("valid", String(valid ? "yes" : "no"));
+			info_f("merge", path, "%u manifests merged, %u files%s", optionalArgs.size(), merged.size(), valid ? "" : " (incomplete)");
+			if (!valid)
+			{
+				mergeFailed = true;
+			}
+		} break;
 	}
-	return true;
-}
 
-bool convertWholeBase(String basepath, String exportpath)
-{
-	auto files = getSFS()->readDir(basepath, true, true);
-	if (!files)
+	converter.setMetrics(nullptr);
+	if (!metricsPath.empty())
 	{
-		printf("No files to convert!\n");
-		return false;
+		auto file = getSFS()->open(metricsPath, FileSystem::write | FileSystem::binary);
+		if (!file || !metrics.save(file.get()))
+		{
+			error_f("system", metricsPath, "Unable to write the metrics (%s)!", strerror(errno));
+			return 1;
+		}
 	}
-
-	int size = 0;
-	for (const auto &f : *files)
+	if (mergeFailed)
 	{
-		if (f.IsDirectory())
-			continue;
+		return 1;
+	}
 
-		const String extension = f.GetPath().substr(f.GetPath().rfind('.'));
-		if (extension == ".pmg" || extension == ".tobj")
+	converter.setFingerprintManifest(nullptr);
+	if (!fingerprintPath.empty())
+	{
+		auto file = getSFS()->open(fingerprintPath, FileSystem::write | FileSystem::binary);
+		if (!file || !manifest.save(file.get()))
 		{
-			++size;
+			error_f("system", fingerprintPath, "Unable to write the manifest (%s)!", strerror(errno));
+			return 1;
 		}
 	}
 
-	int i = 0;
-	for (const auto &f : *files)
+	if (archive)
 	{
-		if (f.IsDirectory())
-			continue;
+		converter.setOutputSink(nullptr);
+		if (!archive->finish())
+		{
+			error("system", exportpath, "Failed to write the archive!");
+			return 1;
+		}
+	}
 
-		const String filename = f.GetPath().substr(basepath.length());
-		const String extension = f.GetPath().substr(f.GetPath().rfind('.'));
-		if (extension == ".pmg")
+	if (!comparePath.empty())
+	{
+		const auto difference = manifest.compare(reference);
+		for (const auto &path : difference.m_changed)
 		{
-			const String modelPath = filename.substr(0, filename.length() - 4);
-			Model model;
-			if (!model.load(modelPath))
-			{
-				printf("Failed to load: %s\n", modelPath.c_str());
-			}
-			else
-			{
-				printf("[%u/%u = %u%%]: ", i, size, (unsigned)(100.f * i / size));
-				model.saveToMidFormat(exportpath, false);
-			}
-			++i;
+			printf("changed: %s\n", path.c_str());
 		}
-		else if (extension == ".tobj")
+		for (const auto &path : difference.m_added)
 		{
-			printf("[%u/%u = %u%%]: ", i, size, (unsigned)(100.f * i / size));
-			printf("%s: tobj: ", filename.substr(directory(filename).length() + 1).c_str());
-
-			TextureObject tobj;
-			if (tobj.load(filename))
-			{
-				tobj.saveToMidFormats(exportpath);
-				printf("ok\n");
-			}
-			++i;
+			printf("added: %s\n", path.c_str());
+		}
+		for (const auto &path : difference.m_removed)
+		{
+			printf("removed: %s\n", path.c_str());
+		}
+		info_f("fingerprint", comparePath, "%u changed, %u added, %u removed (%u files converted)",
+			difference.m_changed.size(), difference.m_added.size(), difference.m_removed.size(), manifest.size());
+		if (!difference.empty())
+		{
+			return 1;
 		}
 	}
-	printf("\nBase converted: %s\n", exportpath.c_str());
-	return false;
+
+	long long endTime =
+		std::chrono::duration_cast<std::chrono::milliseconds>
+		(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	//printf("Time : %llums\n", endTime - startTime);
+
+	return 0;
 }
 
 /* eof */
@@ -25,5 +25,10 @@
 #include "config.h"
 
 bool Config::s_verbose = false;
+bool Config::s_verifyOnRead = false;
+bool Config::s_glb = false;
+String Config::s_decodeTextures;
+bool Config::s_preciseDoubles = false;
+float Config::s_keyframeTolerance = 0.f;
 
 /* eof */
@@ -26,6 +26,11 @@ class Config
 {
 public:
 	static bool s_verbose; /* TODO: To implement */
+	static bool s_verifyOnRead; /* compare checksums of archive entries which are read as a whole */
+	static bool s_glb; /* models are written as binary glTF instead of pim and pis */
+	static String s_decodeTextures; /* "tga" or "png" - writes decoded copy of every exported dds, empty disables */
+	static bool s_preciseDoubles; /* real numbers are written as the shortest text reading back the same value instead of "%f" */
+	static float s_keyframeTolerance; /* pia keyframes reproduced within this error by interpolating the kept ones are dropped, 0 keeps all */
 };
 
 /* eof */
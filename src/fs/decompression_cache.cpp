@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/decompression_cache.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "decompression_cache.h"
+
+SharedPtr<const InflateIndex::Checkpoint> InflateIndex::find(uint64_t offset) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_checkpoints.upper_bound(offset);
+	if (it == m_checkpoints.begin())
+	{
+		return SharedPtr<const Checkpoint>();
+	}
+	return (--it)->second;
+}
+
+bool InflateIndex::needsCheckpoint(uint64_t offset) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto next = m_checkpoints.lower_bound(offset);
+	if (next != m_checkpoints.end() && next->first - offset < SPAN)
+	{
+		return false;
+	}
+	if (next != m_checkpoints.begin() && offset - std::prev(next)->first < SPAN)
+	{
+		return false;
+	}
+	return offset >= SPAN; // the beginning of the stream does not need any checkpoint
+}
+
+void InflateIndex::insert(SharedPtr<const Checkpoint> checkpoint)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_checkpoints.emplace(checkpoint->m_output, std::move(checkpoint));
+}
+
+size_t InflateIndex::memoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t result = 0;
+	for (const auto &checkpoint : m_checkpoints)
+	{
+		result += sizeof(Checkpoint) + checkpoint.second->m_window.size();
+	}
+	return result;
+}
+
+SharedPtr<InflateIndex> DecompressionCache::index(const FileSystem *archive, uint64_t offset)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	SharedPtr<InflateIndex> &result = m_indexes[std::make_pair(archive, offset)];
+	if (!result)
+	{
+		result = std::make_shared<InflateIndex>();
+	}
+	return result;
+}
+
+void DecompressionCache::remove(const FileSystem *archive)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_indexes.lower_bound(std::make_pair(archive, uint64_t(0)));
+	while (it != m_indexes.end() && it->first.first == archive)
+	{
+		it = m_indexes.erase(it);
+	}
+}
+
+DecompressionCache *getDecompressionCache()
+{
+	static DecompressionCache cache;
+	return &cache;
+}
+
+/* eof */
@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/decompression_cache.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <mutex>
+
+/**
+ * @brief: Access points into a deflate stream (zran style).
+ *
+ * Each checkpoint holds the state needed to resume inflating at a block boundary:
+ * the compressed and uncompressed offsets, the bits left over from the previous byte
+ * and the 32 KiB window of data preceding it. Checkpoints are added while the stream
+ * is being inflated, so the index grows with every pass over the entry.
+ */
+class InflateIndex
+{
+public:
+	static constexpr uint64_t SPAN = 1024 * 1024;	// minimal distance between checkpoints
+	static constexpr size_t WINDOW_SIZE = 32768;
+
+	struct Checkpoint
+	{
+		uint64_t m_output;	// offset in the uncompressed data
+		uint64_t m_input;	// offset of the first full byte in the compressed data
+		int m_bits;			// number of bits taken from the byte preceding m_input
+		u8 m_byte;			// the byte preceding m_input, valid only when m_bits != 0
+		Array<u8> m_window;	// uncompressed data preceding the checkpoint
+	};
+
+public:
+	/**
+	 * @brief: Finds the closest checkpoint at or before the offset
+	 *
+	 * @param[in] offset The offset in the uncompressed data
+	 * @return @c The checkpoint or nullptr when inflating has to start at the beginning
+	 */
+	SharedPtr<const Checkpoint> find(uint64_t offset) const;
+
+	/**
+	 * @brief: Checks whether there is no checkpoint close to the offset
+	 */
+	bool needsCheckpoint(uint64_t offset) const;
+
+	void insert(SharedPtr<const Checkpoint> checkpoint);
+
+	size_t memoryUsage() const;
+
+private:
+	mutable std::mutex m_mutex;
+	Map<uint64_t, SharedPtr<const Checkpoint>> m_checkpoints;
+};
+
+/**
+ * @brief: Process wide cache of the state shared between readers of compressed archive entries.
+ *
+ * Entries are identified by their archive and the offset of their data. Archives have to
+ * release their entries with remove() before they are destroyed.
+ */
+class DecompressionCache
+{
+public:
+	/**
+	 * @brief: Returns the inflate index of the entry, creating an empty one on the first request
+	 *
+	 * @param[in] archive The filesystem which contains the entry
+	 * @param[in] offset The offset of the compressed data in the archive
+	 */
+	SharedPtr<InflateIndex> index(const FileSystem *archive, uint64_t offset);
+
+	/**
+	 * @brief: Drops everything cached for the archive
+	 */
+	void remove(const FileSystem *archive);
+
+private:
+	std::mutex m_mutex;
+	Map<Pair<const FileSystem *, uint64_t>, SharedPtr<InflateIndex>> m_indexes;
+};
+
+DecompressionCache *getDecompressionCache();
+
+/* eof */
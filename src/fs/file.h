@@ -48,7 +48,7 @@ public:
 	virtual uint64_t tell() const = 0;
 	virtual void flush() = 0;
 
-	bool blockRead(void *buffer, uint64_t offset, uint64_t size);
+	virtual bool blockRead(void *buffer, uint64_t offset, uint64_t size);
 
 	File &operator<<(bool val);
 	File &operator<<(short val);
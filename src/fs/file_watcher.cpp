@@ -0,0 +1,331 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/file_watcher.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "file_watcher.h"
+
+#include "sysfilesystem.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+	const DWORD WATCH_FILTER = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+	const size_t WATCH_BUFFER = 64 * 1024;
+#else
+	const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_CREATE | IN_ONLYDIR;
+#endif
+}
+
+#ifdef _WIN32
+
+FileWatcher::FileWatcher()
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	for (auto &root : m_roots)
+	{
+		CancelIo(root->m_directory);
+		CloseHandle(root->m_directory);
+		CloseHandle(root->m_overlapped.hEvent);
+	}
+}
+
+bool FileWatcher::watch(const String &root)
+{
+	auto entry = std::make_unique<Root>();
+	entry->m_path = removeSlashAtEnd(root);
+	entry->m_directory = CreateFileA(entry->m_path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+	if (entry->m_directory == INVALID_HANDLE_VALUE)
+	{
+		error_f("watch", root, "Unable to open the directory (error %u)!", GetLastError());
+		return false;
+	}
+	entry->m_overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	entry->m_buffer.resize(WATCH_BUFFER);
+	if (!read(*entry))
+	{
+		CloseHandle(entry->m_directory);
+		CloseHandle(entry->m_overlapped.hEvent);
+		return false;
+	}
+	m_roots.push_back(std::move(entry));
+	return true;
+}
+
+bool FileWatcher::read(Root &root)
+{
+	ResetEvent(root.m_overlapped.hEvent);
+	if (!ReadDirectoryChangesW(root.m_directory, root.m_buffer.data(), static_cast<DWORD>(root.m_buffer.size()), TRUE,
+		WATCH_FILTER, nullptr, &root.m_overlapped, nullptr))
+	{
+		error_f("watch", root.m_path, "Unable to read the changes (error %u)!", GetLastError());
+		return false;
+	}
+	return true;
+}
+
+void FileWatcher::collect(Root &root, DWORD size, Array<String> &paths)
+{
+	if (size == 0)
+	{
+		warning("watch", root.m_path, "Too many changes at once, some of them have been lost!");
+		return;
+	}
+	for (const u8 *data = root.m_buffer.data();;)
+	{
+		const auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(data);
+		const int length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+		String name(static_cast<size_t>(WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, nullptr, 0, nullptr, nullptr)), '\0');
+		WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, &name[0], static_cast<int>(name.size()), nullptr, nullptr);
+		backslashesToSlashes(name);
+		paths.push_back("/" + name);
+
+		if (info->NextEntryOffset == 0)
+		{
+			break;
+		}
+		data += info->NextEntryOffset;
+	}
+}
+
+bool FileWatcher::wait(Array<String> &paths, u32 quietMs)
+{
+	paths.clear();
+	if (m_roots.empty())
+	{
+		return false;
+	}
+
+	Array<HANDLE> events;
+	for (const auto &root : m_roots)
+	{
+		events.push_back(root->m_overlapped.hEvent);
+	}
+
+	DWORD timeout = INFINITE;
+	for (;;)
+	{
+		const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(events.size()), events.data(), FALSE, timeout);
+		if (result == WAIT_TIMEOUT)
+		{
+			break;
+		}
+		if (result >= WAIT_OBJECT_0 + events.size())
+		{
+			error_f("watch", "", "Unable to wait for the changes (error %u)!", GetLastError());
+			return false;
+		}
+
+		Root &root = *m_roots[result - WAIT_OBJECT_0];
+		DWORD size = 0;
+		if (!GetOverlappedResult(root.m_directory, &root.m_overlapped, &size, FALSE))
+		{
+			error_f("watch", root.m_path, "Unable to read the changes (error %u)!", GetLastError());
+			return false;
+		}
+		collect(root, size, paths);
+		if (!read(root))
+		{
+			return false;
+		}
+		timeout = paths.empty() ? INFINITE : quietMs;
+	}
+
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+	return true;
+}
+
+#else
+
+FileWatcher::FileWatcher()
+	: m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (m_fd != -1)
+	{
+		::close(m_fd);
+	}
+}
+
+bool FileWatcher::watch(const String &root)
+{
+	if (m_fd == -1)
+	{
+		error_f("watch", root, "Unable to initialize inotify (%s)!", strerror(errno));
+		return false;
+	}
+	if (!addDirectory(removeSlashAtEnd(root), "", nullptr))
+	{
+		error_f("watch", root, "Unable to watch the directory (%s)!", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+bool FileWatcher::addDirectory(const String &root, const String &directory, Array<String> *created)
+{
+	const int wd = inotify_add_watch(m_fd, (root + directory).c_str(), WATCH_MASK);
+	if (wd == -1)
+	{
+		return false;
+	}
+	m_directories[wd] = { root, directory };
+
+	// the files of the directory created (or moved in) since the last read are reported as changed
+	SysFileSystem fs(root);
+	auto entries = fs.readDir(directory.empty() ? "/" : directory, true, false);
+	if (!entries)
+	{
+		return true;
+	}
+	for (const auto &entry : *entries)
+	{
+		if (entry.IsDirectory())
+		{
+			if (!addDirectory(root, entry.GetPath(), created))
+			{
+				warning_f("watch", root + entry.GetPath(), "Unable to watch the directory (%s)!", strerror(errno));
+			}
+		}
+		else if (created)
+		{
+			created->push_back(entry.GetPath());
+		}
+	}
+	return true;
+}
+
+bool FileWatcher::collect(Array<String> &paths)
+{
+	alignas(inotify_event) char buffer[16 * 1024];
+	for (;;)
+	{
+		const ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+		if (length == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if (errno == EAGAIN)
+			{
+				return true;
+			}
+			error_f("watch", "", "Unable to read the changes (%s)!", strerror(errno));
+			return false;
+		}
+
+		for (const char *data = buffer; data < buffer + length;)
+		{
+			const auto event = reinterpret_cast<const inotify_event *>(data);
+			data += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				warning("watch", "", "Too many changes at once, some of them have been lost!");
+				continue;
+			}
+			if (event->mask & IN_IGNORED)
+			{
+				m_directories.erase(event->wd);
+				continue;
+			}
+			const auto directory = m_directories.find(event->wd);
+			if (directory == m_directories.end() || event->len == 0)
+			{
+				continue;
+			}
+
+			const String root = directory->second.first;
+			const String path = directory->second.second + "/" + event->name;
+			if (event->mask & IN_ISDIR)
+			{
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+				{
+					if (!addDirectory(root, path, &paths))
+					{
+						warning_f("watch", root + path, "Unable to watch the directory (%s)!", strerror(errno));
+					}
+				}
+			}
+			else if (!(event->mask & IN_CREATE)) // created files are reported when they are closed
+			{
+				paths.push_back(path);
+			}
+		}
+	}
+}
+
+bool FileWatcher::wait(Array<String> &paths, u32 quietMs)
+{
+	paths.clear();
+	if (m_fd == -1)
+	{
+		return false;
+	}
+
+	pollfd fd = { m_fd, POLLIN, 0 };
+	int timeout = -1;
+	for (;;)
+	{
+		const int ready = ::poll(&fd, 1, timeout);
+		if (ready == -1)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			error_f("watch", "", "Unable to wait for the changes (%s)!", strerror(errno));
+			return false;
+		}
+		if (ready == 0)
+		{
+			break;
+		}
+		if (!collect(paths))
+		{
+			return false;
+		}
+		timeout = paths.empty() ? -1 : static_cast<int>(quietMs);
+	}
+
+	std::sort(paths.begin(), paths.end());
+	paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+	return true;
+}
+
+#endif
+
+/* eof */
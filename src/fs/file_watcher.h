@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/file_watcher.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Reports files changed in the directories of the system file system.
+ *
+ * Uses inotify on Linux (one watch per directory, new directories are added as they appear)
+ * and ReadDirectoryChangesW on Windows. The changed paths are relative to the watched
+ * directory, so they are the paths of the mounted base (ex. "/model/truck.pmg").
+ */
+class FileWatcher
+{
+public:
+	FileWatcher();
+	FileWatcher(const FileWatcher &) = delete;
+	FileWatcher(FileWatcher &&) = delete;
+	~FileWatcher();
+
+	FileWatcher &operator=(const FileWatcher &) = delete;
+	FileWatcher &operator=(FileWatcher &&) = delete;
+
+	/**
+	 * @brief: Starts watching the directory and all of its subdirectories
+	 *
+	 * @param[in] root The path of the directory in the system file system
+	 * @return @c True if the directory is watched
+	 */
+	bool watch(const String &root);
+
+	/**
+	 * @brief: Waits for changes and returns them in one batch
+	 *
+	 * The batch is closed when nothing changes for the quiet time, so the files saved
+	 * together by an editor (or by the export of a whole model) are reported together.
+	 *
+	 * @param[out] paths The sorted paths of created, modified, moved and deleted files
+	 * @param[in] quietMs The time without changes closing the batch, in milliseconds
+	 * @return @c False if the changes cannot be read anymore
+	 */
+	bool wait(Array<String> &paths, u32 quietMs);
+
+private:
+#ifdef _WIN32
+	struct Root
+	{
+		String m_path;
+		HANDLE m_directory = INVALID_HANDLE_VALUE;
+		OVERLAPPED m_overlapped = {};
+		Array<u8> m_buffer;
+	};
+
+	bool read(Root &root);
+	void collect(Root &root, DWORD size, Array<String> &paths);
+
+	Array<UniquePtr<Root>> m_roots;
+#else
+	bool addDirectory(const String &root, const String &directory, Array<String> *created);
+	bool collect(Array<String> &paths);
+
+	int m_fd = -1;
+	UnorderedMap<int, Pair<String, String>> m_directories; // watch -> root, directory relative to root
+#endif
+};
+
+/* eof */
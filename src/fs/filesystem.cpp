@@ -31,6 +31,8 @@
 
 #include "file.h"
 
+#include <utils/thread_pool.h>
+
 FileSystem::FileSystem()
 {
 }
@@ -39,6 +41,44 @@ FileSystem::~FileSystem()
 {
 }
 
+UniquePtr<File> FileSystem::open(PathId path, FsOpenMode mode)
+{
+	return open(getPaths()->string(path), mode);
+}
+
+bool FileSystem::exists(PathId path)
+{
+	return path.valid() && exists(getPaths()->string(path));
+}
+
+bool FileSystem::claim(const String &filename)
+{
+	return !exists(filename);
+}
+
+bool FileSystem::fileSize(PathId path, u64 &size)
+{
+	UniquePtr<File> file = open(path, FileSystem::read | FileSystem::binary);
+	if (!file)
+	{
+		return false;
+	}
+	size = file->size();
+	return true;
+}
+
+bool FileSystem::verify(ThreadPool &pool)
+{
+	return true;
+}
+
+FileSystem::AsyncRead FileSystem::readWholeAsync(PathId path)
+{
+	return getIoPool()->submit([this, path]() {
+		return readWhole(open(path, FileSystem::read | FileSystem::binary));
+	});
+}
+
 SysFileSystem *getSFS()
 {
 	static SysFileSystem fs("");
@@ -51,33 +91,111 @@ UberFileSystem *getUFS()
 	return &fs;
 }
 
-FileSystem *ufsMount(const String &root, scs_bool readOnly, int priority)
+static const size_t IO_THREADS = 8;	// the reads wait for the disk, their inflating takes a core each
+
+static FileSystem *s_outputFileSystem = nullptr;
+static thread_local FileSystem *s_threadOutputFileSystem = nullptr;
+
+FileSystem *getOFS()
 {
-	if (getSFS()->dirExists(root))
+	if (s_threadOutputFileSystem)
 	{
-		String rootdirectory = makeSlashAtEnd(root);
-		auto fs = std::make_unique<SysFileSystem>(rootdirectory.substr(0, rootdirectory.length() - 1));
-		return getUFS()->mount(std::move(fs), priority);
+		return s_threadOutputFileSystem;
 	}
-	else if(getSFS()->exists(root))
+	return s_outputFileSystem ? s_outputFileSystem : getSFS();
+}
+
+void setOFS(FileSystem *fs)
+{
+	s_outputFileSystem = fs;
+}
+
+void setThreadOFS(FileSystem *fs)
+{
+	s_threadOutputFileSystem = fs;
+}
+
+ThreadPool *getIoPool()
+{
+	static ThreadPool pool(IO_THREADS);
+	return &pool;
+}
+
+FileSystem::AsyncRead readyRead(UniquePtr<Array<u8>> contents)
+{
+	std::promise<UniquePtr<Array<u8>>> promise;
+	promise.set_value(std::move(contents));
+	return promise.get_future();
+}
+
+UniquePtr<Array<u8>> readWhole(UniquePtr<File> file)
+{
+	if (!file)
+	{
+		return UniquePtr<Array<u8>>();
+	}
+
+	const uint64_t size = file->size() - file->tell();
+	auto contents = std::make_unique<Array<u8>>(static_cast<size_t>(size));
+	if (size > 0 && file->read(contents->data(), sizeof(u8), size) != size)
+	{
+		return UniquePtr<Array<u8>>();
+	}
+	return contents;
+}
+
+namespace
+{
+	const size_t MOUNT_THREADS = 16;	// opening archives is mostly waiting for the disk
+
+	UniquePtr<FileSystem> ufsOpen(const String &root)
 	{
-		auto rootfile = getSFS()->open(root, FileSystem::read | FileSystem::binary);
-		char sig[4];
-		rootfile->blockRead(&sig, 0, sizeof(sig));
-		rootfile.reset();
-		if (sig[0] == 'P' && sig[1] == 'K') // zip
+		if (getSFS()->dirExists(root))
 		{
-			auto fs = std::make_unique<ZipFileSystem>(root);
-			return getUFS()->mount(std::move(fs), priority);
+			String rootdirectory = makeSlashAtEnd(root);
+			return std::make_unique<SysFileSystem>(rootdirectory.substr(0, rootdirectory.length() - 1));
 		}
-		else if (sig[0] == 'S' && sig[1] == 'C' && sig[2] == 'S' && sig[3] == '#') // scs#
+		else if (getSFS()->exists(root))
 		{
-			auto fs = std::make_unique<HashFileSystem>(root);
-			return getUFS()->mount(std::move(fs), priority);
+			auto rootfile = getSFS()->open(root, FileSystem::read | FileSystem::binary);
+			char sig[4];
+			rootfile->blockRead(&sig, 0, sizeof(sig));
+			rootfile.reset();
+			if (sig[0] == 'P' && sig[1] == 'K') // zip
+			{
+				return std::make_unique<ZipFileSystem>(root);
+			}
+			else if (sig[0] == 'S' && sig[1] == 'C' && sig[2] == 'S' && sig[3] == '#') // scs#
+			{
+				return std::make_unique<HashFileSystem>(root);
+			}
 		}
+		warning("system", root, "Unknown filesystem type!");
+		return UniquePtr<FileSystem>();
+	}
+}
+
+FileSystem *ufsMount(const String &root, scs_bool readOnly, int priority)
+{
+	auto fs = ufsOpen(root);
+	return fs ? getUFS()->mount(std::move(fs), priority) : nullptr;
+}
+
+Array<FileSystem *> ufsMountAll(const Array<String> &roots, int priority)
+{
+	Array<UniquePtr<FileSystem>> filesystems(roots.size());
+	if (roots.size() > 1)
+	{
+		ThreadPool pool(std::min(roots.size(), MOUNT_THREADS));
+		pool.parallelFor(roots.size(), [&](size_t i) {
+			filesystems[i] = ufsOpen(roots[i]);
+		});
+	}
+	else if (roots.size() == 1)
+	{
+		filesystems[0] = ufsOpen(roots[0]);
 	}
-	warning("system", root, "Unknown filesystem type!");
-	return nullptr;
+	return getUFS()->mount(std::move(filesystems), priority);
 }
 
 void ufsUnmount(FileSystem *fs)
@@ -22,11 +22,20 @@
 
 #pragma once
 
+#include <utils/path_table.h>
+
+#include <future>
+
 class FileSystem
 {
 public:
 	class Entry;
 
+	/**
+	 * @brief: Receives the contents of the file read by readWholeAsync(), nullptr if the file could not be read
+	 */
+	using AsyncRead = std::future<UniquePtr<Array<u8>>>;
+
 	enum FsOpenMode
 	{
 		OpenModeNone = 0
@@ -54,6 +63,63 @@ public:
 	virtual bool exists(const String &filename) = 0;
 	virtual bool dirExists(const String &dirpath) = 0;
 	virtual UniquePtr<List<Entry>> readDir(const String &path, bool absolutePaths, bool recursive) = 0;
+
+	/**
+	 * @brief: Opens the file by the interned path
+	 *
+	 * The archives look the path up by the hash computed when it was interned,
+	 * the other file systems open the path as string.
+	 */
+	virtual UniquePtr<File> open(PathId path, FsOpenMode mode);
+
+	/**
+	 * @brief: Checks if the file of the interned path exists, see open(PathId)
+	 */
+	virtual bool exists(PathId path);
+
+	/**
+	 * @brief: Reserves the path for the caller which is going to write the file
+	 *
+	 * The exporters writing a shared file only once (textures) claim it, so of the jobs
+	 * racing for the path only one writes it. This implementation checks exists() only,
+	 * the output file systems claim the path atomically.
+	 *
+	 * @return @c True if the caller should write the file, false if it exists or has been claimed
+	 */
+	virtual bool claim(const String &filename);
+
+	/**
+	 * @brief: Gets the size of the file of the interned path without reading it
+	 *
+	 * The archives take the size from the entry, the system file system stats the file.
+	 * This implementation opens the file.
+	 *
+	 * @param[in] path The interned path of the file
+	 * @param[out] size The size of the file (uncompressed), set when true is returned
+	 * @return @c True if the file exists
+	 */
+	virtual bool fileSize(PathId path, u64 &size);
+
+	/**
+	 * @brief: Reads the whole file on the I/O threads (see getIoPool())
+	 *
+	 * Several reads may be issued at once and waited for together, so the loader of a model
+	 * does not wait for its files one by one. This implementation opens and reads the file
+	 * on the I/O thread, the archives find the entry at once and read its data by single
+	 * positional read, inflated on the I/O thread.
+	 *
+	 * @param[in] path The interned path of the file
+	 * @return @c The future receiving the contents
+	 */
+	virtual AsyncRead readWholeAsync(PathId path);
+
+	/**
+	 * @brief: Checks the stored checksums of all of the entries, mismatches are reported as errors
+	 *
+	 * @param[in] pool The pool used to verify the entries in parallel
+	 * @return @c False if any of the entries is damaged, true if all of them match or there is nothing to verify
+	 */
+	virtual bool verify(ThreadPool &pool);
 };
 
 class FileSystem::Entry
@@ -93,7 +159,61 @@ constexpr FileSystem::FsOpenMode operator|(const FileSystem::FsOpenMode t, const
 SysFileSystem *getSFS();
 UberFileSystem *getUFS();
 
+/**
+ * @brief: Returns the process wide pool of the threads executing FileSystem::readWholeAsync()
+ *
+ * The threads are started on the first use and are not inherited by the processes forked later
+ * (ProcessPool), so the supervisor should not read asynchronously before the workers are forked.
+ */
+ThreadPool *getIoPool();
+
+/**
+ * @brief: Returns the future which has already received the contents
+ */
+FileSystem::AsyncRead readyRead(UniquePtr<Array<u8>> contents);
+
+/**
+ * @brief: Reads the rest of the file into memory
+ *
+ * @param[in] file The file to read, may be null
+ * @return @c The contents or nullptr if the file is null or could not be read completely
+ */
+UniquePtr<Array<u8>> readWhole(UniquePtr<File> file);
+
+/**
+ * @brief: Returns the file system used by the exporters to write converted files
+ *
+ * @return @c The file system set for the thread by setThreadOFS(), then the one set by setOFS(),
+ *            or the system file system when none is set
+ */
+FileSystem *getOFS();
+
+/**
+ * @brief: Redirects all of the exporters output into the given file system
+ *
+ * @param[in] fs The output file system or nullptr to restore the system file system
+ */
+void setOFS(FileSystem *fs);
+
+/**
+ * @brief: Redirects the output of the exporters running on the calling thread only
+ *
+ * @param[in] fs The output file system of the thread or nullptr to restore the one of setOFS()
+ */
+void setThreadOFS(FileSystem *fs);
+
 FileSystem *ufsMount(const String &root, scs_bool readOnly, int priority);
+
+/**
+ * @brief: Opens the directories and archives concurrently, then mounts all of them at once
+ *
+ * The archive tables are read in parallel, so the mount takes as long as the slowest archive.
+ *
+ * @param[in] roots The paths of the directories and archives in the order of increasing priority
+ * @param[in] priority The priority of the first path, the next paths get the following priorities
+ * @return @c The mounted file systems in the order of roots, nullptr for the roots which could not be opened
+ */
+Array<FileSystem *> ufsMountAll(const Array<String> &roots, int priority);
 void ufsUnmount(FileSystem *fs);
 
 /* eof */
@@ -0,0 +1,289 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/fingerprint_sink.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "fingerprint_sink.h"
+
+#include <fs/file.h>
+#include <cityhash/city.h>
+
+namespace
+{
+	const size_t WRITE_CHUNK = 1024 * 1024;
+
+	bool parseHex64(const char *s, u64 &value)
+	{
+		value = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			const char c = s[i];
+			u64 nibble;
+			if (c >= '0' && c <= '9') nibble = c - '0';
+			else if (c >= 'a' && c <= 'f') nibble = c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F') nibble = c - 'A' + 10;
+			else return false;
+			value = (value << 4) | nibble;
+		}
+		return true;
+	}
+}
+
+auto FingerprintManifest::compute(const void *data, size_t size) -> Fingerprint
+{
+	const uint128 hash = CityHash128(static_cast<const char *>(data), size);
+	Fingerprint result;
+	result.m_low = Uint128Low64(hash);
+	result.m_high = Uint128High64(hash);
+	result.m_size = size;
+	return result;
+}
+
+void FingerprintManifest::insert(const String &path, const Fingerprint &fingerprint)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_fingerprints[path] = fingerprint;
+}
+
+bool FingerprintManifest::save(File *file) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// sorted, so manifests of the same output are byte identical
+	Array<const std::pair<const String, Fingerprint> *> entries;
+	entries.reserve(m_fingerprints.size());
+	for (const auto &entry : m_fingerprints)
+	{
+		entries.push_back(&entry);
+	}
+	std::sort(entries.begin(), entries.end(),
+		[](const std::pair<const String, Fingerprint> *a, const std::pair<const String, Fingerprint> *b) {
+			return a->first < b->first;
+		}
+	);
+
+	String buffer = "# ConverterPIX fingerprint manifest" SEOL;
+	buffer += "# hash: cityhash128" SEOL;
+	buffer += fmt::sprintf("# count: %u" SEOL, entries.size());
+	for (const auto &header : m_header)
+	{
+		buffer += fmt::sprintf("# %s: %s" SEOL, header.first, header.second);
+	}
+
+	for (const auto *entry : entries)
+	{
+		buffer += fmt::sprintf("%016llx%016llx %llu %s" SEOL, entry->second.m_high, entry->second.m_low, entry->second.m_size, entry->first);
+		if (buffer.size() >= WRITE_CHUNK)
+		{
+			if (file->write(buffer.data(), sizeof(char), buffer.size()) != buffer.size())
+			{
+				return false;
+			}
+			buffer.clear();
+		}
+	}
+	return file->write(buffer.data(), sizeof(char), buffer.size()) == buffer.size();
+}
+
+bool FingerprintManifest::load(const String &name, File *file)
+{
+	const uint64_t size = file->size();
+	String data(static_cast<size_t>(size), '\0');
+	if (!file->blockRead(&data[0], 0, size))
+	{
+		error("fingerprint", name, "Unable to read the manifest!");
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t line = 0;
+	for (size_t begin = 0; begin < data.size(); )
+	{
+		size_t end = data.find('\n', begin);
+		if (end == String::npos)
+		{
+			end = data.size();
+		}
+		++line;
+
+		const char *const text = data.data() + begin;
+		const size_t length = end - begin - (end > begin && data[end - 1] == '\r' ? 1 : 0);
+		begin = end + 1;
+
+		if (length == 0)
+		{
+			continue;
+		}
+		if (text[0] == '#')
+		{
+			const char *const colon = static_cast<const char *>(memchr(text, ':', length));
+			if (colon && length > 2 && text[1] == ' ')
+			{
+				const String key(text + 2, colon);
+				const String value(colon + (colon + 1 < text + length && colon[1] == ' ' ? 2 : 1), text + length);
+				if (key != "hash" && key != "count")
+				{
+					m_header[key] = value;
+				}
+			}
+			continue;
+		}
+
+		// <hash> <size> <path>
+		Fingerprint fingerprint;
+		const char *cursor = text + 33;
+		const char *const lineEnd = text + length;
+		if (length < 36 || text[32] != ' ' || !parseHex64(text, fingerprint.m_high) || !parseHex64(text + 16, fingerprint.m_low))
+		{
+			error_f("fingerprint", name, "Line %u is malformed!", line);
+			return false;
+		}
+		for (; cursor < lineEnd && *cursor >= '0' && *cursor <= '9'; ++cursor)
+		{
+			fingerprint.m_size = fingerprint.m_size * 10 + (*cursor - '0');
+		}
+		if (cursor == text + 33 || cursor + 1 >= lineEnd || *cursor != ' ')
+		{
+			error_f("fingerprint", name, "Line %u is malformed!", line);
+			return false;
+		}
+		m_fingerprints[String(cursor + 1, lineEnd)] = fingerprint;
+	}
+	return true;
+}
+
+auto FingerprintManifest::compare(const FingerprintManifest &reference) const -> Difference
+{
+	std::lock(m_mutex, reference.m_mutex);
+	std::lock_guard<std::mutex> lock(m_mutex, std::adopt_lock);
+	std::lock_guard<std::mutex> referenceLock(reference.m_mutex, std::adopt_lock);
+
+	Difference result;
+	for (const auto &entry : m_fingerprints)
+	{
+		const auto it = reference.m_fingerprints.find(entry.first);
+		if (it == reference.m_fingerprints.end())
+		{
+			result.m_added.push_back(entry.first);
+		}
+		else if (it->second != entry.second)
+		{
+			result.m_changed.push_back(entry.first);
+		}
+	}
+	for (const auto &entry : reference.m_fingerprints)
+	{
+		if (m_fingerprints.find(entry.first) == m_fingerprints.end())
+		{
+			result.m_removed.push_back(entry.first);
+		}
+	}
+
+	std::sort(result.m_changed.begin(), result.m_changed.end());
+	std::sort(result.m_added.begin(), result.m_added.end());
+	std::sort(result.m_removed.begin(), result.m_removed.end());
+	return result;
+}
+
+bool FingerprintManifest::merge(const String &name, const FingerprintManifest &other)
+{
+	std::lock(m_mutex, other.m_mutex);
+	std::lock_guard<std::mutex> lock(m_mutex, std::adopt_lock);
+	std::lock_guard<std::mutex> otherLock(other.m_mutex, std::adopt_lock);
+
+	Array<String> overlapping;
+	for (const auto &entry : other.m_fingerprints)
+	{
+		if (!m_fingerprints.emplace(entry.first, entry.second).second)
+		{
+			overlapping.push_back(entry.first);
+		}
+	}
+
+	std::sort(overlapping.begin(), overlapping.end());
+	for (const auto &path : overlapping)
+	{
+		error_f("fingerprint", name, "%s is already present in another manifest!", path);
+	}
+	return overlapping.empty();
+}
+
+void FingerprintManifest::update(const FingerprintManifest &other)
+{
+	std::lock(m_mutex, other.m_mutex);
+	std::lock_guard<std::mutex> lock(m_mutex, std::adopt_lock);
+	std::lock_guard<std::mutex> otherLock(other.m_mutex, std::adopt_lock);
+
+	for (const auto &entry : other.m_fingerprints)
+	{
+		m_fingerprints[entry.first] = entry.second;
+	}
+}
+
+size_t FingerprintManifest::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_fingerprints.size();
+}
+
+u64 FingerprintManifest::totalSize() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	u64 result = 0;
+	for (const auto &entry : m_fingerprints)
+	{
+		result += entry.second.m_size;
+	}
+	return result;
+}
+
+void FingerprintManifest::setHeader(const String &key, const String &value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_header[key] = value;
+}
+
+String FingerprintManifest::header(const String &key) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const auto it = m_header.find(key);
+	return it != m_header.end() ? it->second : String();
+}
+
+FingerprintOutputSink::FingerprintOutputSink(FingerprintManifest *manifest, OutputSink *next)
+	: m_manifest(manifest)
+	, m_next(next)
+{
+}
+
+bool FingerprintOutputSink::receive(const String &path, const void *data, size_t size)
+{
+	m_manifest->insert(path, FingerprintManifest::compute(data, size));
+	return m_next ? m_next->receive(path, data, size) : true;
+}
+
+bool FingerprintOutputSink::finish()
+{
+	return m_next ? m_next->finish() : true;
+}
+
+/* eof */
@@ -0,0 +1,144 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/fingerprint_sink.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "output_sink.h"
+
+/**
+ * @brief: Set of output fingerprints (CityHash128 and size of every output file).
+ *
+ * The manifest is a text file with the fingerprints sorted by path:
+ *   # key: value                 header lines
+ *   <32 hex digits> <size> <path>
+ */
+class FingerprintManifest
+{
+public:
+	struct Fingerprint
+	{
+		u64 m_low = 0;
+		u64 m_high = 0;
+		u64 m_size = 0;
+
+		bool operator==(const Fingerprint &rhs) const { return m_low == rhs.m_low && m_high == rhs.m_high && m_size == rhs.m_size; }
+		bool operator!=(const Fingerprint &rhs) const { return !(*this == rhs); }
+	};
+
+	/**
+	 * @brief: Result of comparison with the reference manifest
+	 */
+	struct Difference
+	{
+		Array<String> m_changed;
+		Array<String> m_added;		// present only in this manifest
+		Array<String> m_removed;	// present only in the reference manifest
+
+		bool empty() const { return m_changed.empty() && m_added.empty() && m_removed.empty(); }
+	};
+
+public:
+	/**
+	 * @brief: Computes fingerprint of the data
+	 */
+	static Fingerprint compute(const void *data, size_t size);
+
+	/**
+	 * @brief: Adds or replaces the fingerprint of the path, may be called concurrently
+	 */
+	void insert(const String &path, const Fingerprint &fingerprint);
+
+	/**
+	 * @brief: Writes the manifest
+	 *
+	 * @param[in] file The file to write
+	 * @return @c True if the whole manifest has been written
+	 */
+	bool save(File *file) const;
+
+	/**
+	 * @brief: Reads the manifest written by save()
+	 *
+	 * @param[in] name The name used in error messages
+	 * @param[in] file The file to read
+	 * @return @c True if the manifest has been read without errors
+	 */
+	bool load(const String &name, File *file);
+
+	/**
+	 * @brief: Compares this manifest with the reference one
+	 */
+	Difference compare(const FingerprintManifest &reference) const;
+
+	/**
+	 * @brief: Adds fingerprints of the other manifest, the paths must not be present yet
+	 *
+	 * @param[in] name The name of the other manifest used in error messages
+	 * @param[in] other The manifest to add
+	 * @return @c True if none of the paths was already present
+	 */
+	bool merge(const String &name, const FingerprintManifest &other);
+
+	/**
+	 * @brief: Adds or replaces the fingerprints of the other manifest
+	 */
+	void update(const FingerprintManifest &other);
+
+	size_t size() const;
+	u64 totalSize() const;	// sum of sizes of all files
+
+	/**
+	 * @brief: Sets header value written by save()
+	 */
+	void setHeader(const String &key, const String &value);
+	String header(const String &key) const;
+
+private:
+	mutable std::mutex m_mutex;
+	UnorderedMap<String, Fingerprint> m_fingerprints;
+	Map<String, String> m_header;
+};
+
+/**
+ * @brief: Fingerprints every received file and forwards it to the next sink (if any).
+ *
+ * Files are hashed from the buffers handed to the sink when they are closed,
+ * so they are never read back.
+ */
+class FingerprintOutputSink : public OutputSink
+{
+public:
+	/**
+	 * @param[in] manifest The manifest which receives the fingerprints
+	 * @param[in] next The sink which stores the files, or nullptr to drop them
+	 */
+	FingerprintOutputSink(FingerprintManifest *manifest, OutputSink *next = nullptr);
+
+	virtual bool receive(const String &path, const void *data, size_t size) override;
+	virtual bool finish() override;
+
+private:
+	FingerprintManifest *m_manifest;
+	OutputSink *m_next;
+};
+
+/* eof */
@@ -27,8 +27,13 @@
 #include "sysfilesystem.h"
 #include "file.h"
 #include "hashfs_file.h"
+#include "decompression_cache.h"
+#include "inflate_reader.h"
+
+#include <config.h>
 
 #include <utils/string_tokenizer.h>
+#include <utils/thread_pool.h>
 
 HashFileSystem::HashFileSystem(const String &root)
 {
@@ -44,6 +49,7 @@ HashFileSystem::HashFileSystem(const String &root)
 
 HashFileSystem::~HashFileSystem()
 {
+	getDecompressionCache()->remove(this);
 }
 
 String HashFileSystem::root() const
@@ -58,21 +64,64 @@ String HashFileSystem::name() const
 
 UniquePtr<File> HashFileSystem::open(const String &filename, FsOpenMode mode)
 {
-	using namespace prism;
+	return openEntry(filename, findEntry(filename));
+}
 
-	hashfs_entry_t *const entry = findEntry(filename);
-	if (!entry)
+UniquePtr<File> HashFileSystem::open(PathId path, FsOpenMode mode)
+{
+	if (m_header.m_salt != 0)
 	{
-		return UniquePtr<File>();
+		return open(getPaths()->string(path), mode);
 	}
 
+	prism::hashfs_entry_t *const entry = findEntry(getPaths()->hash(path));
+	return entry ? openEntry(getPaths()->string(path), entry) : UniquePtr<File>();
+}
+
+FileSystem::AsyncRead HashFileSystem::readWholeAsync(PathId path)
+{
+	using namespace prism;
+
+	const hashfs_entry_t *const entry = m_header.m_salt == 0 ? findEntry(getPaths()->hash(path)) : findEntry(getPaths()->string(path));
+	if (!isFile(entry))
+	{
+		return readyRead(UniquePtr<Array<u8>>());
+	}
 	if (entry->m_flags & HASHFS_ENCRYPTED)
 	{
-		error("hashfs", filename, "Encrypted files are not supported!");
-		return UniquePtr<File>();
+		error("hashfs", getPaths()->string(path), "Encrypted files are not supported!");
+		return readyRead(UniquePtr<Array<u8>>());
 	}
 
-	return std::make_unique<HashFsFile>(filename, this, entry);
+	return getIoPool()->submit([this, path, entry]() {
+		const String filename = getPaths()->string(path);
+		auto contents = std::make_unique<Array<u8>>(static_cast<size_t>(entry->m_size));
+		if (entry->m_flags & HASHFS_COMPRESSED)
+		{
+			Array<u8> compressed(static_cast<size_t>(entry->m_compressed_size));
+			if (!ioRead(compressed.data(), compressed.size(), entry->m_offset)
+			 || !InflateReader::inflateWhole(filename, compressed.data(), compressed.size(), contents->data(), contents->size(), MAX_WBITS))
+			{
+				error("hashfs", filename, "Unable to read the entry!");
+				return UniquePtr<Array<u8>>();
+			}
+		}
+		else if (!ioRead(contents->data(), contents->size(), entry->m_offset))
+		{
+			error("hashfs", filename, "Unable to read the entry!");
+			return UniquePtr<Array<u8>>();
+		}
+
+		if (Config::s_verifyOnRead)
+		{
+			const u32 crc = Crc32::compute(contents->data(), contents->size());
+			if (crc != entry->m_crc)
+			{
+				error_f("hashfs", filename, "CRC mismatch (stored: %08X, computed: %08X)!", entry->m_crc, crc);
+			}
+		}
+		return contents;
+	});
 }
 
 bool HashFileSystem::mkdir(const String &directory)
@@ -87,24 +136,37 @@ bool HashFileSystem::rmdir(const String &directory)
 
 bool HashFileSystem::exists(const String &filename)
 {
-	using namespace prism;
-
 	if (filename.empty())
 	{
 		return false;
 	}
 
-	hashfs_entry_t *const entry = findEntry(filename);
-	if (!entry)
+	return isFile(findEntry(filename));
+}
+
+bool HashFileSystem::exists(PathId path)
+{
+	if (!path.valid())
 	{
 		return false;
 	}
 
-	if (entry->m_flags & HASHFS_DIR)
+	return isFile(m_header.m_salt == 0 ? findEntry(getPaths()->hash(path)) : findEntry(getPaths()->string(path)));
+}
+
+bool HashFileSystem::fileSize(PathId path, u64 &size)
+{
+	if (!path.valid())
 	{
 		return false;
 	}
 
+	const prism::hashfs_entry_t *const entry = m_header.m_salt == 0 ? findEntry(getPaths()->hash(path)) : findEntry(getPaths()->string(path));
+	if (!isFile(entry))
+	{
+		return false;
+	}
+	size = entry->m_size;
 	return true;
 }
 
@@ -216,8 +278,59 @@ auto HashFileSystem::readDir(const String &path, bool absolutePaths, bool recurs
 	return result;
 }
 
+bool HashFileSystem::verify(ThreadPool &pool)
+{
+	using namespace prism;
+
+	// the archive stores only hashes, so the names are recovered from the directory listings where possible
+	Map<u64, String> names;
+	if (findEntry("/"))
+	{
+		auto files = readDir("/", true, true);
+		if (files)
+		{
+			for (const auto &file : *files)
+			{
+				names[hashPath(file.GetPath(), m_header.m_salt)] = file.GetPath();
+			}
+		}
+	}
+
+	Array<std::future<bool>> results;
+	results.reserve(m_entries.size());
+	for (const hashfs_entry_t &entry : m_entries)
+	{
+		if (entry.m_flags & HASHFS_ENCRYPTED)
+		{
+			continue;
+		}
+
+		auto name = names.find(entry.m_hash);
+		const String path = name != names.end() ? name->second : fmt::sprintf("<%016llX>", entry.m_hash);
+		results.push_back(pool.submit([this, path, &entry]() {
+			HashFsFile file(m_rootFilename + ":" + path, this, &entry);
+			return file.verify();
+		}));
+	}
+
+	size_t damaged = 0;
+	for (auto &result : results)
+	{
+		damaged += result.get() ? 0 : 1;
+	}
+
+	if (damaged > 0)
+	{
+		error_f("hashfs", m_rootFilename, "Verification failed, %u of %u entries are damaged!", damaged, results.size());
+		return false;
+	}
+	info_f("hashfs", m_rootFilename, "Verified %u entries", results.size());
+	return true;
+}
+
 bool HashFileSystem::ioRead(void *const buffer, uint64_t bytes, uint64_t offset)
 {
+	std::lock_guard<std::mutex> lock(m_ioMutex);
 	return m_root->blockRead(buffer, offset, bytes);
 }
 
@@ -237,7 +350,7 @@ bool HashFileSystem::readHashFS()
 		return false;
 	}
 
-	if (m_header.m_hash_method != MAKEFOURCC('C', 'I', 'T', 'Y'))
+	if (m_header.m_hash_method != hashfs_header_t::HASH_METHOD_CITY)
 	{
 		error_f("hashfs", m_rootFilename, "Unsupported hash method (%08X)", m_header.m_hash_method);
 		return false;
@@ -259,27 +372,54 @@ bool HashFileSystem::readHashFS()
 	return true;
 }
 
-prism::hashfs_entry_t *HashFileSystem::findEntry(const String &path)
+u64 HashFileSystem::hashPath(const String &path, u16 salt)
+{
+	const char *const relative = path.empty() ? "" : path.c_str() + 1;
+	if (salt != 0)
+	{
+		const String salted = fmt::sprintf("%u%s", salt, relative);
+		return prism::city_hash_64(salted.c_str(), salted.length());
+	}
+	return prism::city_hash_64(relative, strlen(relative));
+}
+
+UniquePtr<File> HashFileSystem::openEntry(const String &filename, prism::hashfs_entry_t *entry)
 {
 	using namespace prism;
 
-	if (m_entries.empty())
+	if (!entry)
 	{
-		return nullptr;
+		return UniquePtr<File>();
 	}
 
-	String pathToFind;
-	if (m_header.m_salt != 0)
+	if (entry->m_flags & HASHFS_ENCRYPTED)
 	{
-		pathToFind = fmt::sprintf("%u%s", m_header.m_salt, (path.c_str() + 1));
+		error("hashfs", filename, "Encrypted files are not supported!");
+		return UniquePtr<File>();
 	}
-	else
+
+	return std::make_unique<HashFsFile>(filename, this, entry);
+}
+
+bool HashFileSystem::isFile(const prism::hashfs_entry_t *entry)
+{
+	return entry && !(entry->m_flags & prism::HASHFS_DIR);
+}
+
+prism::hashfs_entry_t *HashFileSystem::findEntry(const String &path)
+{
+	return findEntry(hashPath(path, m_header.m_salt));
+}
+
+prism::hashfs_entry_t *HashFileSystem::findEntry(u64 hash)
+{
+	using namespace prism;
+
+	if (m_entries.empty())
 	{
-		pathToFind = path.c_str() + 1;
+		return nullptr;
 	}
 
-	const u64 hash = city_hash_64(pathToFind.c_str(), pathToFind.length());
-
 	for (s64 index, l = 0, r = m_entries.size() - 1; l <= r;) // binary search
 	{
 		index = l + (r - l) / 2;
@@ -26,6 +26,8 @@
 
 #include <structs/hashfs.h>
 
+#include <mutex>
+
 class HashFileSystem : public FileSystem
 {
 public:
@@ -40,24 +42,42 @@ public:
 	virtual String root() const override;
 	virtual String name() const override;
 	virtual UniquePtr<File> open(const String &filename, FsOpenMode mode) override;
+	virtual UniquePtr<File> open(PathId path, FsOpenMode mode) override;
 	virtual bool mkdir(const String &directory) override;
 	virtual bool rmdir(const String &directory) override;
 	virtual bool exists(const String &filename) override;
+	virtual bool exists(PathId path) override;
+	virtual bool fileSize(PathId path, u64 &size) override;
+	virtual AsyncRead readWholeAsync(PathId path) override;
 	virtual bool dirExists(const String &dirpath) override;
 	virtual UniquePtr<List<Entry>> readDir(const String &path, bool absolutePaths, bool recursive) override;
+	virtual bool verify(ThreadPool &pool) override;
 
 	bool ioRead(void *const buffer, uint64_t bytes, uint64_t offset);
 
+	/**
+	 * @brief: Computes the hash under which the entry is stored in the archive
+	 *
+	 * @param[in] path The absolute path of the entry (ex. "/def/world" or "/" for the root directory)
+	 * @param[in] salt The salt of the archive
+	 * @return @c The hash of the path
+	 */
+	static u64 hashPath(const String &path, u16 salt);
+
 private:
 	String m_rootFilename;
 	UniquePtr<File> m_root;
+	std::mutex m_ioMutex;
 
 	prism::hashfs_header_t m_header;
 	Array<prism::hashfs_entry_t> m_entries;
 
 private:
 	bool readHashFS();
+	UniquePtr<File> openEntry(const String &filename, prism::hashfs_entry_t *entry);
+	static bool isFile(const prism::hashfs_entry_t *entry);
 	prism::hashfs_entry_t *findEntry(const String &path);
+	prism::hashfs_entry_t *findEntry(u64 hash);
 };
 
 /* eof */
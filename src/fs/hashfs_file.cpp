@@ -26,28 +26,34 @@
 
 #include "hashfilesystem.h"
 
+#include "inflate_reader.h"
+
+#include <config.h>
+
 HashFsFile::HashFsFile(const String &filepath, HashFileSystem *filesystem, const prism::hashfs_entry_t *header)
 	: m_filepath(filepath)
 	, m_filesystem(filesystem)
 	, m_header(header)
 	, m_position(0)
+	, m_verify(Config::s_verifyOnRead)
 {
 	using namespace prism;
 
 	if (m_header->m_flags & HASHFS_COMPRESSED)
 	{
-		inflateInitialize();
+		const uint64_t offset = m_header->m_offset;
+		m_inflate = std::make_unique<InflateReader>(m_filepath,
+			[filesystem, offset](void *buffer, uint64_t bytes, uint64_t position) {
+				return filesystem->ioRead(buffer, bytes, offset + position);
+			},
+			m_header->m_compressed_size, m_header->m_size, MAX_WBITS,
+			m_header->m_size > InflateIndex::SPAN ? getDecompressionCache()->index(filesystem, offset) : SharedPtr<InflateIndex>()
+		);
 	}
 }
 
 HashFsFile::~HashFsFile()
 {
-	using namespace prism;
-
-	if (m_header->m_flags & HASHFS_COMPRESSED)
-	{
-		inflateDestroy();
-	}
 }
 
 uint64_t HashFsFile::write(const void *buffer, uint64_t elementSize, uint64_t elementCount)
@@ -57,72 +63,25 @@ uint64_t HashFsFile::write(const void *buffer, uint64_t elementSize, uint64_t el
 
 uint64_t HashFsFile::read(void *buffer, uint64_t elementSize, uint64_t elementCount)
 {
-	using namespace prism;
-
-	if (!(m_header->m_flags & HASHFS_COMPRESSED))
+	if (m_position >= m_header->m_size)
 	{
-		if (m_position >= m_header->m_size)
-		{
-			return 0;
-		}
+		return 0;
+	}
 
-		if (m_filesystem->ioRead(buffer, elementSize * elementCount, m_header->m_offset + m_position))
-		{
-			uint64_t result = std::min(elementSize * elementCount, m_header->m_size - m_position);
-			m_position += elementSize * elementCount;
-			if (m_position > m_header->m_size)
-			{
-				m_position = m_header->m_size;
-			}
-			return result;
-		}
-		else
-		{
-			return 0;
-		}
+	const uint64_t bytes = std::min(elementSize * elementCount, m_header->m_size - m_position);
+	uint64_t result = 0;
+	if (m_inflate)
+	{
+		result = m_inflate->read(buffer, bytes, m_position);
 	}
-	else
+	else if (m_filesystem->ioRead(buffer, bytes, m_header->m_offset + m_position))
 	{
-		const uint64_t chunk = 1024 * 4;
-		uint8_t inbuffer[chunk];
-		uint64_t bufferOffset = 0;
-
-		while (m_position < m_header->m_compressed_size && bufferOffset < (elementSize * elementCount))
-		{
-			uint64_t left = m_header->m_compressed_size - m_position;
-			uint64_t bytes = std::min(chunk, left);
-			if (bytes == 0) {
-				break;
-			}
-
-			if (!m_filesystem->ioRead(inbuffer, bytes, (size_t)(m_header->m_offset + m_position)))
-			{
-				error("hashfs", m_filepath, "Unable to read from filesystem file");
-				return 0;
-			}
-
-			m_stream.avail_in = static_cast<unsigned int>(bytes);
-			m_stream.next_in = inbuffer;
-
-			m_stream.avail_out = static_cast<unsigned int>((elementSize * elementCount) - bufferOffset);
-			m_stream.next_out = (uint8_t *)buffer + bufferOffset;
-
-			int ret = inflate(&m_stream, Z_NO_FLUSH);
-			assert(ret != Z_STREAM_ERROR);
-
-			if (ret != Z_OK && ret != Z_STREAM_END)
-			{
-				error_f("hashfs", m_filepath, "zLib error: %s", zError(ret));
-				return 0;
-			}
-
-			uint64_t wroteToBuffer = ((elementSize * elementCount) - bufferOffset) - m_stream.avail_out;
-			bufferOffset += wroteToBuffer;
-			assert(bufferOffset <= (elementSize * elementCount));
-			m_position += (bytes - m_stream.avail_in);
-		}
-		return bufferOffset;
+		result = bytes;
 	}
+
+	verifyRead(buffer, m_position, result);
+	m_position += result;
+	return result;
 }
 
 uint64_t HashFsFile::size()
@@ -132,35 +91,19 @@ uint64_t HashFsFile::size()
 
 bool HashFsFile::seek(uint64_t offset, Attrib attr)
 {
-	if (m_header->m_flags & prism::HASHFS_COMPRESSED)
+	if (attr == SeekSet)
 	{
-		if (offset == 0 && attr == SeekSet)
-		{
-			if (m_position != 0)
-			{
-				inflateDestroy();
-				inflateInitialize();
-			}
-			return true;
-		}
-		return false; // random access is not allowed
+		m_position = offset;
 	}
-	else
+	else if (attr == SeekCur)
 	{
-		if (attr == SeekSet)
-		{
-			m_position = offset;
-		}
-		else if (attr == SeekCur)
-		{
-			m_position += offset;
-		}
-		else if (attr == SeekEnd)
-		{
-			m_position = size() - offset;
-		}
-		return true;
+		m_position += offset;
+	}
+	else if (attr == SeekEnd)
+	{
+		m_position = size() - offset;
 	}
+	return true;
 }
 
 void HashFsFile::rewind()
@@ -177,23 +120,62 @@ void HashFsFile::flush()
 {
 }
 
-void HashFsFile::inflateInitialize()
+bool HashFsFile::verify()
 {
-	m_stream.zalloc = Z_NULL;
-	m_stream.zfree = Z_NULL;
-	m_stream.opaque = Z_NULL;
-	m_stream.avail_in = 0;
-	m_stream.next_in = Z_NULL;
-	if (inflateInit(&m_stream) != Z_OK)
+	const bool verifyOnRead = m_verify;
+	m_verify = false;
+
+	Crc32 crc;
+	Array<u8> buffer(64 * 1024);
+	uint64_t total = 0;
+	for (uint64_t bytes; (bytes = read(buffer.data(), 1, buffer.size())) > 0; total += bytes)
 	{
-		error("hashfs", "", "Failed to inflate init");
-		return;
+		crc.update(buffer.data(), static_cast<size_t>(bytes));
 	}
+	m_verify = verifyOnRead;
+
+	if (total != m_header->m_size)
+	{
+		error_f("hashfs", m_filepath, "Unable to read the whole entry (%llu of %llu bytes)!", total, m_header->m_size);
+		return false;
+	}
+	if (crc.value() != m_header->m_crc)
+	{
+		error_f("hashfs", m_filepath, "CRC mismatch (stored: %08X, computed: %08X)!", m_header->m_crc, crc.value());
+		return false;
+	}
+	return true;
 }
 
-void HashFsFile::inflateDestroy()
+void HashFsFile::verifyRead(const void *buffer, uint64_t offset, uint64_t bytes)
 {
-	inflateEnd(&m_stream);
+	if (!m_verify)
+	{
+		return;
+	}
+
+	if (offset == 0)
+	{
+		m_crc.reset();
+		m_crcOffset = 0;
+	}
+	else if (offset != m_crcOffset)
+	{
+		m_crcOffset = UINT64_MAX; // random access, the checksum cannot be computed
+		return;
+	}
+
+	m_crc.update(buffer, static_cast<size_t>(bytes));
+	m_crcOffset += bytes;
+
+	if (m_crcOffset == m_header->m_size)
+	{
+		m_crcOffset = UINT64_MAX;
+		if (m_crc.value() != m_header->m_crc)
+		{
+			error_f("hashfs", m_filepath, "CRC mismatch (stored: %08X, computed: %08X)!", m_header->m_crc, m_crc.value());
+		}
+	}
 }
 
 /* eof */
@@ -0,0 +1,315 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/hashfs_packer.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "hashfs_packer.h"
+
+#include "file.h"
+#include "filesystem.h"
+#include "hashfilesystem.h"
+
+#include <utils/thread_pool.h>
+
+#include <deque>
+#include <map>
+#include <set>
+
+namespace
+{
+	const size_t MAX_PENDING_BYTES = 256 * 1024 * 1024;
+	const size_t PENDING_ENTRIES_PER_THREAD = 4;
+}
+
+HashFsPacker::HashFsPacker(bool compress, u16 salt, size_t threads)
+	: m_pool(std::make_unique<ThreadPool>(threads))
+	, m_compress(compress)
+	, m_salt(salt)
+{
+}
+
+HashFsPacker::~HashFsPacker()
+{
+}
+
+bool HashFsPacker::pack(FileSystem *source, const String &root, File *output)
+{
+	using namespace prism;
+
+	Array<Item> items;
+	if (!collect(source, root, items))
+	{
+		return false;
+	}
+
+	// the hashes have to be unique, otherwise some of the entries would be unreachable
+	Array<hashfs_entry_t> entries;
+	entries.reserve(items.size());
+	{
+		std::map<u64, const String *> hashes;
+		for (const Item &item : items)
+		{
+			const u64 hash = HashFileSystem::hashPath(item.m_path, m_salt);
+			auto it = hashes.emplace(hash, &item.m_path);
+			if (!it.second)
+			{
+				error_f("hashfs", item.m_path, "Hash collision with: %s", *it.first->second);
+				return false;
+			}
+		}
+	}
+
+	hashfs_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.m_magic = hashfs_header_t::MAGIC;
+	header.m_version = hashfs_header_t::SUPPORTED_VERSION;
+	header.m_salt = m_salt;
+	header.m_hash_method = hashfs_header_t::HASH_METHOD_CITY;
+	header.m_entries_count = static_cast<u32>(items.size());
+	header.m_start_offset = sizeof(hashfs_header_t);
+
+	// the entry table is placed right after the header and filled in at the end,
+	// so the data can be streamed without knowing the final offsets up front
+	const Array<hashfs_entry_t> placeholder(items.size(), hashfs_entry_t());
+	if (!ioWrite(output, &header, sizeof(header))
+	 || !ioWrite(output, placeholder.data(), placeholder.size() * sizeof(hashfs_entry_t)))
+	{
+		return false;
+	}
+	u64 offset = sizeof(hashfs_header_t) + placeholder.size() * sizeof(hashfs_entry_t);
+
+	struct Pending
+	{
+		const Item *m_item;
+		size_t m_size;
+		std::future<Payload> m_payload;
+	};
+	std::deque<Pending> pending;
+	size_t pendingBytes = 0;
+	bool failed = false;
+
+	auto writeFront = [&]() -> bool
+	{
+		Pending front = std::move(pending.front());
+		pending.pop_front();
+		pendingBytes -= front.m_size;
+
+		Payload payload = front.m_payload.get();
+		if (failed)
+		{
+			return false;
+		}
+		payload.m_entry.m_hash = HashFileSystem::hashPath(front.m_item->m_path, m_salt);
+		payload.m_entry.m_offset = offset;
+		if (!ioWrite(output, payload.m_data.data(), payload.m_data.size()))
+		{
+			return false;
+		}
+		offset += payload.m_data.size();
+		entries.push_back(payload.m_entry);
+		return true;
+	};
+
+	const size_t maxPendingEntries = m_pool->size() * PENDING_ENTRIES_PER_THREAD;
+	for (const Item &item : items)
+	{
+		while (!pending.empty() && (pending.size() >= maxPendingEntries || pendingBytes >= MAX_PENDING_BYTES))
+		{
+			failed = !writeFront() || failed;
+		}
+		if (failed)
+		{
+			break;
+		}
+
+		Array<u8> data;
+		if (item.m_directory)
+		{
+			data.assign(item.m_listing.begin(), item.m_listing.end());
+		}
+		else
+		{
+			auto file = source->open(item.m_sourcePath, FileSystem::read | FileSystem::binary);
+			if (!file)
+			{
+				error("hashfs", item.m_sourcePath, "Unable to open file to read!");
+				failed = true;
+				break;
+			}
+			const u64 size = file->size();
+			if (size >= std::numeric_limits<u32>::max())
+			{
+				error("hashfs", item.m_sourcePath, "File is too large to be stored in the archive!");
+				failed = true;
+				break;
+			}
+			data.resize(static_cast<size_t>(size));
+			if (size > 0 && !file->blockRead(data.data(), 0, size))
+			{
+				error("hashfs", item.m_sourcePath, "Unable to read file!");
+				failed = true;
+				break;
+			}
+		}
+
+		const size_t size = data.size();
+		const bool isDirectory = item.m_directory;
+		Pending next;
+		next.m_item = &item;
+		next.m_size = size;
+		next.m_payload = m_pool->submit([this, isDirectory, data = std::move(data)]() mutable {
+			return process(std::move(data), isDirectory);
+		});
+		pending.push_back(std::move(next));
+		pendingBytes += size;
+	}
+
+	while (!pending.empty())
+	{
+		failed = !writeFront() || failed;
+	}
+	if (failed)
+	{
+		return false;
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const hashfs_entry_t &a, const hashfs_entry_t &b) {
+		return a.m_hash < b.m_hash;
+	});
+
+	if (!output->seek(header.m_start_offset, File::SeekSet)
+	 || !ioWrite(output, entries.data(), entries.size() * sizeof(hashfs_entry_t)))
+	{
+		return false;
+	}
+	output->flush();
+	return true;
+}
+
+bool HashFsPacker::collect(FileSystem *source, const String &root, Array<Item> &items)
+{
+	const String prefix = trimSlashesAtEnd(root);
+	auto files = source->readDir(prefix.empty() ? "/" : prefix, true, true);
+	if (!files)
+	{
+		error("hashfs", root, "Unable to read directory!");
+		return false;
+	}
+
+	// directory path -> sorted names of its children, subdirectories are marked with '*'
+	std::map<String, std::set<String>> directories;
+	directories["/"];
+
+	std::map<String, String> sources;
+	for (const auto &file : *files)
+	{
+		String path = file.GetPath().substr(prefix.length());
+		backslashesToSlashes(path);
+		if (path.empty() || path[0] != '/')
+		{
+			path = "/" + path;
+		}
+
+		const String parent = directory(path);
+		const String name = path.substr(path.rfind('/') + 1);
+		if (file.IsDirectory())
+		{
+			directories[parent.empty() ? "/" : parent].insert("*" + name);
+			directories[path];
+		}
+		else
+		{
+			directories[parent.empty() ? "/" : parent].insert(name);
+			sources[path] = file.GetPath();
+		}
+	}
+
+	items.reserve(directories.size() + sources.size());
+	for (const auto &dir : directories)
+	{
+		Item item;
+		item.m_path = dir.first;
+		item.m_directory = true;
+		for (const String &name : dir.second)
+		{
+			item.m_listing += name;
+			item.m_listing += '\n';
+		}
+		if (!item.m_listing.empty())
+		{
+			item.m_listing.pop_back();
+		}
+		items.push_back(std::move(item));
+	}
+	for (const auto &file : sources)
+	{
+		Item item;
+		item.m_path = file.first;
+		item.m_sourcePath = file.second;
+		item.m_directory = false;
+		items.push_back(std::move(item));
+	}
+	return true;
+}
+
+auto HashFsPacker::process(Array<u8> &&data, bool directory) -> Payload
+{
+	using namespace prism;
+
+	Payload payload;
+	memset(&payload.m_entry, 0, sizeof(payload.m_entry));
+	payload.m_entry.m_flags = directory ? HASHFS_DIR : HASHFS_VERIFY;
+	payload.m_entry.m_crc = static_cast<u32>(crc32(crc32(0, Z_NULL, 0), data.data(), static_cast<uInt>(data.size())));
+	payload.m_entry.m_size = static_cast<u32>(data.size());
+	payload.m_entry.m_compressed_size = static_cast<u32>(data.size());
+
+	if (m_compress && !data.empty())
+	{
+		// HashFsFile reads the entries using inflateInit, so the zlib wrapper is kept
+		uLongf compressedSize = compressBound(static_cast<uLong>(data.size()));
+		Array<u8> compressed(compressedSize);
+		if (compress2(compressed.data(), &compressedSize, data.data(), static_cast<uLong>(data.size()), Z_DEFAULT_COMPRESSION) == Z_OK
+		 && compressedSize < data.size())
+		{
+			compressed.resize(compressedSize);
+			payload.m_entry.m_flags |= HASHFS_COMPRESSED;
+			payload.m_entry.m_compressed_size = static_cast<u32>(compressedSize);
+			payload.m_data = std::move(compressed);
+			return payload;
+		}
+	}
+
+	payload.m_data = std::move(data);
+	return payload;
+}
+
+bool HashFsPacker::ioWrite(File *output, const void *buffer, size_t size)
+{
+	if (size > 0 && output->write(buffer, 1, size) != size)
+	{
+		error_f("hashfs", "", "Unable to write into the archive (%s)!", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+/* eof */
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/hashfs_packer.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <structs/hashfs.h>
+
+class ThreadPool;
+
+/**
+ * @brief: Creates HashFS (.scs) archives readable by HashFileSystem.
+ *
+ * Files are read sequentially from the source filesystem, compressed in parallel
+ * on the internal thread pool and written to the archive in the order of reading,
+ * so only a bounded window of entries is kept in memory at once.
+ */
+class HashFsPacker
+{
+public:
+	/**
+	 * @param[in] compress Whether entries should be compressed
+	 * @param[in] salt The salt prepended to every path before hashing
+	 * @param[in] threads The number of compression threads, 0 means one per hardware thread
+	 */
+	HashFsPacker(bool compress = true, u16 salt = 0, size_t threads = 0);
+	HashFsPacker(const HashFsPacker &) = delete;
+	HashFsPacker(HashFsPacker &&) = delete;
+	~HashFsPacker();
+
+	HashFsPacker &operator=(const HashFsPacker &) = delete;
+	HashFsPacker &operator=(HashFsPacker &&) = delete;
+
+	/**
+	 * @brief: Packs the whole directory tree into the archive
+	 *
+	 * @param[in] source The filesystem to read files from
+	 * @param[in] root The directory in the source filesystem which becomes the root of the archive
+	 * @param[in] output The archive file opened for writing
+	 * @return @c True if the archive has been written successfully
+	 */
+	bool pack(FileSystem *source, const String &root, File *output);
+
+private:
+	struct Item
+	{
+		String m_path;			// path inside the archive, "/" for the root
+		String m_sourcePath;	// path in the source filesystem, empty for directories
+		String m_listing;		// contents of the directory entry
+		bool m_directory;
+	};
+
+	struct Payload
+	{
+		Array<u8> m_data;
+		prism::hashfs_entry_t m_entry;
+	};
+
+private:
+	bool collect(FileSystem *source, const String &root, Array<Item> &items);
+	Payload process(Array<u8> &&data, bool directory);
+	bool ioWrite(File *output, const void *buffer, size_t size);
+
+private:
+	UniquePtr<ThreadPool> m_pool;
+	bool m_compress;
+	u16 m_salt;
+};
+
+/* eof */
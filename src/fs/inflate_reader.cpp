@@ -0,0 +1,289 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/inflate_reader.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "inflate_reader.h"
+
+namespace
+{
+	const size_t INPUT_CHUNK = 16 * 1024;
+	const size_t SKIP_CHUNK = 16 * 1024;
+}
+
+InflateReader::InflateReader(const String &name, Input input, uint64_t compressedSize, uint64_t size, int windowBits, SharedPtr<InflateIndex> index)
+	: m_name(name)
+	, m_input(std::move(input))
+	, m_compressedSize(compressedSize)
+	, m_size(size)
+	, m_windowBits(windowBits)
+	, m_index(std::move(index))
+	, m_inputBuffer(INPUT_CHUNK)
+{
+	memset(&m_stream, 0, sizeof(m_stream));
+}
+
+InflateReader::~InflateReader()
+{
+	if (m_initialized)
+	{
+		inflateEnd(&m_stream);
+	}
+}
+
+uint64_t InflateReader::read(void *buffer, uint64_t bytes, uint64_t offset)
+{
+	if (m_failed || offset >= m_size)
+	{
+		return 0;
+	}
+
+	if (!position(offset))
+	{
+		return 0;
+	}
+	return inflateInto(static_cast<u8 *>(buffer), std::min(bytes, m_size - offset));
+}
+
+bool InflateReader::inflateWhole(const String &name, const u8 *input, uint64_t compressedSize, u8 *output, uint64_t size, int windowBits)
+{
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, windowBits) != Z_OK)
+	{
+		error("inflate", name, "Failed to inflate init");
+		return false;
+	}
+
+	// the sizes of zlib are 32-bit, so the large entries are passed in parts
+	const uint64_t part = std::numeric_limits<uInt>::max();
+	uint64_t consumed = 0;
+	uint64_t produced = 0;
+	int ret = Z_OK;
+	while (ret == Z_OK)
+	{
+		stream.next_in = const_cast<u8 *>(input + consumed);
+		stream.avail_in = static_cast<uInt>(std::min(compressedSize - consumed, part));
+		stream.next_out = output + produced;
+		stream.avail_out = static_cast<uInt>(std::min(size - produced, part));
+		const uInt availIn = stream.avail_in;
+		const uInt availOut = stream.avail_out;
+		ret = inflate(&stream, Z_NO_FLUSH);
+		consumed += availIn - stream.avail_in;
+		produced += availOut - stream.avail_out;
+		if (ret == Z_OK && availIn == stream.avail_in && availOut == stream.avail_out)
+		{
+			ret = Z_BUF_ERROR; // no progress, the data is truncated or longer than expected
+		}
+	}
+	inflateEnd(&stream);
+
+	if (ret != Z_STREAM_END)
+	{
+		error_f("inflate", name, "zLib error: %s", zError(ret));
+		return false;
+	}
+	if (produced != size)
+	{
+		error_f("inflate", name, "Unexpected size of inflated data (%llu of %llu bytes)", produced, size);
+		return false;
+	}
+	return true;
+}
+
+bool InflateReader::restart()
+{
+	if (m_initialized)
+	{
+		inflateEnd(&m_stream);
+		m_initialized = false;
+	}
+
+	memset(&m_stream, 0, sizeof(m_stream));
+	if (inflateInit2(&m_stream, m_windowBits) != Z_OK)
+	{
+		error("inflate", m_name, "Failed to inflate init");
+		m_failed = true;
+		return false;
+	}
+	m_initialized = true;
+	m_finished = false;
+	m_inputOffset = 0;
+	m_outputOffset = 0;
+	return true;
+}
+
+bool InflateReader::resume(const InflateIndex::Checkpoint &checkpoint)
+{
+	if (m_initialized)
+	{
+		inflateEnd(&m_stream);
+		m_initialized = false;
+	}
+
+	// the checkpoints are at deflate block boundaries, so the zlib header (if any) is already behind
+	memset(&m_stream, 0, sizeof(m_stream));
+	if (inflateInit2(&m_stream, -MAX_WBITS) != Z_OK)
+	{
+		error("inflate", m_name, "Failed to inflate init");
+		m_failed = true;
+		return false;
+	}
+	m_initialized = true;
+
+	if ((checkpoint.m_bits != 0 && inflatePrime(&m_stream, checkpoint.m_bits, checkpoint.m_byte >> (8 - checkpoint.m_bits)) != Z_OK)
+	 || inflateSetDictionary(&m_stream, checkpoint.m_window.data(), static_cast<uInt>(checkpoint.m_window.size())) != Z_OK)
+	{
+		error("inflate", m_name, "Failed to resume inflating at checkpoint");
+		m_failed = true;
+		return false;
+	}
+	m_finished = false;
+	m_inputOffset = checkpoint.m_input;
+	m_outputOffset = checkpoint.m_output;
+	return true;
+}
+
+bool InflateReader::position(uint64_t offset)
+{
+	const bool backward = !m_initialized || offset < m_outputOffset;
+	if (backward || offset - m_outputOffset > InflateIndex::SPAN)
+	{
+		SharedPtr<const InflateIndex::Checkpoint> checkpoint;
+		if (m_index)
+		{
+			checkpoint = m_index->find(offset);
+		}
+
+		if (checkpoint && (backward || checkpoint->m_output > m_outputOffset))
+		{
+			if (!resume(*checkpoint))
+			{
+				return false;
+			}
+		}
+		else if (backward && !restart())
+		{
+			return false;
+		}
+	}
+
+	// inflate and discard the data up to the offset, checkpoints are recorded on the way
+	if (m_outputOffset < offset && m_skipBuffer.empty())
+	{
+		m_skipBuffer.resize(SKIP_CHUNK);
+	}
+	while (m_outputOffset < offset)
+	{
+		if (inflateInto(nullptr, offset - m_outputOffset) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64_t InflateReader::inflateInto(u8 *buffer, uint64_t bytes)
+{
+	uint64_t produced = 0;
+	while (produced < bytes && !m_finished && !m_failed)
+	{
+		if (m_stream.avail_in == 0)
+		{
+			const uint64_t chunk = std::min<uint64_t>(m_compressedSize - m_inputOffset, m_inputBuffer.size());
+			if (chunk == 0)
+			{
+				error("inflate", m_name, "Unexpected end of compressed data");
+				m_failed = true;
+				break;
+			}
+			if (!m_input(m_inputBuffer.data(), chunk, m_inputOffset))
+			{
+				error("inflate", m_name, "Unable to read from filesystem file");
+				m_failed = true;
+				break;
+			}
+			m_inputOffset += chunk;
+			m_stream.next_in = m_inputBuffer.data();
+			m_stream.avail_in = static_cast<uInt>(chunk);
+		}
+
+		const uint64_t space = std::min<uint64_t>(bytes - produced, buffer ? std::numeric_limits<uInt>::max() : m_skipBuffer.size());
+		m_stream.next_out = buffer ? buffer + produced : m_skipBuffer.data();
+		m_stream.avail_out = static_cast<uInt>(space);
+
+		// Z_BLOCK stops at the block boundaries, where checkpoints can be taken
+		const int ret = inflate(&m_stream, Z_BLOCK);
+		const uint64_t written = space - m_stream.avail_out;
+		produced += written;
+		m_outputOffset += written;
+
+		if (ret == Z_STREAM_END)
+		{
+			m_finished = true;
+			break;
+		}
+		if (ret != Z_OK && ret != Z_BUF_ERROR)
+		{
+			error_f("inflate", m_name, "zLib error: %s", zError(ret));
+			m_failed = true;
+			break;
+		}
+
+		if (m_index && (m_stream.data_type & 128) && !(m_stream.data_type & 64) && m_index->needsCheckpoint(m_outputOffset))
+		{
+			addCheckpoint();
+		}
+	}
+	return produced;
+}
+
+void InflateReader::addCheckpoint()
+{
+	auto checkpoint = std::make_shared<InflateIndex::Checkpoint>();
+	checkpoint->m_output = m_outputOffset;
+	checkpoint->m_input = m_inputOffset - m_stream.avail_in;
+	checkpoint->m_bits = m_stream.data_type & 7;
+	checkpoint->m_byte = 0;
+	if (checkpoint->m_bits != 0)
+	{
+		if (m_stream.next_in > m_inputBuffer.data())
+		{
+			checkpoint->m_byte = m_stream.next_in[-1];
+		}
+		else if (!m_input(&checkpoint->m_byte, 1, checkpoint->m_input - 1))
+		{
+			return;
+		}
+	}
+
+	uInt length = InflateIndex::WINDOW_SIZE;
+	checkpoint->m_window.resize(length);
+	if (inflateGetDictionary(&m_stream, checkpoint->m_window.data(), &length) != Z_OK)
+	{
+		return;
+	}
+	checkpoint->m_window.resize(length);
+	m_index->insert(std::move(checkpoint));
+}
+
+/* eof */
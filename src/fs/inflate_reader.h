@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/inflate_reader.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "decompression_cache.h"
+
+#include <functional>
+
+/**
+ * @brief: Reads deflated archive entry at arbitrary offsets.
+ *
+ * Reading forward continues the current stream. Seeking backward, or far ahead,
+ * resumes from the closest checkpoint of the entry's InflateIndex, which is filled
+ * in as the entry is being read.
+ */
+class InflateReader
+{
+public:
+	using Input = std::function<bool(void *buffer, uint64_t bytes, uint64_t offset)>;
+
+public:
+	/**
+	 * @param[in] name The name used in error messages
+	 * @param[in] input The function reading compressed data of the entry (offsets relative to the entry)
+	 * @param[in] compressedSize The size of the compressed data
+	 * @param[in] size The size of the uncompressed data
+	 * @param[in] windowBits The window bits passed to inflateInit2 (MAX_WBITS for zlib, -MAX_WBITS for raw deflate)
+	 * @param[in] index The index shared by readers of this entry, may be null
+	 */
+	InflateReader(const String &name, Input input, uint64_t compressedSize, uint64_t size, int windowBits, SharedPtr<InflateIndex> index);
+	InflateReader(const InflateReader &) = delete;
+	InflateReader(InflateReader &&) = delete;
+	~InflateReader();
+
+	InflateReader &operator=(const InflateReader &) = delete;
+	InflateReader &operator=(InflateReader &&) = delete;
+
+	/**
+	 * @brief: Reads the uncompressed data
+	 *
+	 * @param[out] buffer The buffer to fill
+	 * @param[in] bytes The number of bytes to read
+	 * @param[in] offset The offset in the uncompressed data
+	 * @return @c The number of bytes read
+	 */
+	uint64_t read(void *buffer, uint64_t bytes, uint64_t offset);
+
+	/**
+	 * @brief: Inflates the whole entry read into memory at once
+	 *
+	 * @param[in] name The name used in error messages
+	 * @param[in] input The compressed data
+	 * @param[in] compressedSize The size of the compressed data
+	 * @param[out] output The buffer of the uncompressed data
+	 * @param[in] size The size of the uncompressed data
+	 * @param[in] windowBits The window bits passed to inflateInit2
+	 * @return @c True if the stream has been inflated to exactly size bytes
+	 */
+	static bool inflateWhole(const String &name, const u8 *input, uint64_t compressedSize, u8 *output, uint64_t size, int windowBits);
+
+private:
+	bool restart();
+	bool resume(const InflateIndex::Checkpoint &checkpoint);
+	bool position(uint64_t offset);
+	uint64_t inflateInto(u8 *buffer, uint64_t bytes);
+	void addCheckpoint();
+
+private:
+	String m_name;
+	Input m_input;
+	uint64_t m_compressedSize;
+	uint64_t m_size;
+	int m_windowBits;
+	SharedPtr<InflateIndex> m_index;
+
+	z_stream m_stream;
+	bool m_initialized = false;
+	bool m_failed = false;
+	bool m_finished = false;
+
+	Array<u8> m_inputBuffer;
+	Array<u8> m_skipBuffer;
+	uint64_t m_inputOffset = 0;		// offset of the data following the input buffer
+	uint64_t m_outputOffset = 0;	// offset of the next byte produced by the stream
+};
+
+/* eof */
@@ -0,0 +1,114 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/memory_file.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "memory_file.h"
+
+MemoryFile::MemoryFile()
+{
+}
+
+MemoryFile::MemoryFile(Array<u8> &&contents)
+	: m_contents(std::move(contents))
+{
+}
+
+MemoryFile::~MemoryFile()
+{
+}
+
+uint64_t MemoryFile::write(const void *buffer, uint64_t elementSize, uint64_t elementCount)
+{
+	const uint64_t bytes = elementSize * elementCount;
+	if (bytes == 0)
+	{
+		return 0;
+	}
+
+	const uint64_t end = m_position + bytes;
+	if (end > m_contents.size())
+	{
+		if (end > m_contents.capacity())
+		{
+			m_contents.reserve(static_cast<size_t>(std::max<uint64_t>(end, m_contents.capacity() * 2)));
+		}
+		m_contents.resize(static_cast<size_t>(end));
+	}
+	memcpy(m_contents.data() + m_position, buffer, static_cast<size_t>(bytes));
+	m_position = end;
+	return elementCount;
+}
+
+uint64_t MemoryFile::read(void *buffer, uint64_t elementSize, uint64_t elementCount)
+{
+	if (elementSize == 0 || m_position >= m_contents.size())
+	{
+		return 0;
+	}
+
+	const uint64_t available = (m_contents.size() - m_position) / elementSize;
+	const uint64_t count = std::min(available, elementCount);
+	memcpy(buffer, m_contents.data() + m_position, static_cast<size_t>(count * elementSize));
+	m_position += count * elementSize;
+	return count;
+}
+
+uint64_t MemoryFile::size()
+{
+	return m_contents.size();
+}
+
+bool MemoryFile::seek(uint64_t offset, Attrib attr)
+{
+	int64_t base = 0;
+	switch (attr)
+	{
+		case SeekSet: base = 0; break;
+		case SeekCur: base = static_cast<int64_t>(m_position); break;
+		case SeekEnd: base = static_cast<int64_t>(m_contents.size()); break;
+	}
+
+	const int64_t position = base + static_cast<int64_t>(offset);
+	if (position < 0)
+	{
+		return false;
+	}
+	m_position = static_cast<uint64_t>(position);
+	return true;
+}
+
+void MemoryFile::rewind()
+{
+	m_position = 0;
+}
+
+uint64_t MemoryFile::tell() const
+{
+	return m_position;
+}
+
+void MemoryFile::flush()
+{
+}
+
+/* eof */
@@ -0,0 +1,57 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/memory_file.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "file.h"
+
+/**
+ * @brief: File which keeps its whole contents in memory.
+ */
+class MemoryFile : public File
+{
+public:
+	MemoryFile();
+	MemoryFile(Array<u8> &&contents);
+	MemoryFile(const MemoryFile &) = delete;
+	MemoryFile(MemoryFile &&) = delete;
+	virtual ~MemoryFile();
+
+	MemoryFile &operator=(const MemoryFile &) = delete;
+	MemoryFile &operator=(MemoryFile &&) = delete;
+
+	virtual uint64_t write(const void *buffer, uint64_t elementSize, uint64_t elementCount) override;
+	virtual uint64_t read(void *buffer, uint64_t elementSize, uint64_t elementCount) override;
+	virtual uint64_t size() override;
+	virtual bool seek(uint64_t offset, Attrib attr) override;
+	virtual void rewind() override;
+	virtual uint64_t tell() const override;
+	virtual void flush() override;
+
+	inline const Array<u8> &contents() const { return m_contents; }
+
+protected:
+	Array<u8> m_contents;
+	uint64_t m_position = 0;
+};
+
+/* eof */
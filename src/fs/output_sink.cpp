@@ -0,0 +1,94 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/output_sink.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "output_sink.h"
+
+#include <fs/file.h>
+#include <fs/sysfilesystem.h>
+
+OutputSink::OutputSink()
+{
+}
+
+OutputSink::~OutputSink()
+{
+}
+
+bool OutputSink::finish()
+{
+	return true;
+}
+
+bool MemoryOutputSink::receive(const String &path, const void *data, size_t size)
+{
+	const u8 *const bytes = static_cast<const u8 *>(data);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_files[path].assign(bytes, bytes + size);
+	return true;
+}
+
+const Array<u8> *MemoryOutputSink::find(const String &path) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const auto it = m_files.find(path);
+	return it != m_files.end() ? &it->second : nullptr;
+}
+
+Map<String, Array<u8>> MemoryOutputSink::release()
+{
+	Map<String, Array<u8>> result;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	result.swap(m_files);
+	return result;
+}
+
+DirectoryOutputSink::DirectoryOutputSink(const String &root)
+	: m_root(root)
+{
+}
+
+bool DirectoryOutputSink::receive(const String &path, const void *data, size_t size)
+{
+	auto file = getSFS()->open(m_root + path, FileSystem::write | FileSystem::binary);
+	if (!file)
+	{
+		error_f("system", m_root + path, "Unable to open file to write (%s)!", strerror(errno));
+		return false;
+	}
+	return file->write(data, sizeof(u8), size) == size;
+}
+
+CallbackOutputSink::CallbackOutputSink(Callback callback)
+	: m_callback(callback)
+{
+}
+
+bool CallbackOutputSink::receive(const String &path, const void *data, size_t size)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_callback ? m_callback(path, data, size) : false;
+}
+
+/* eof */
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/output_sink.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+
+/**
+ * @brief: Receives converted files as complete in-memory buffers.
+ *
+ * Sinks are installed through SinkFileSystem (see getOFS()/setOFS()), so every
+ * exporter that writes through the output filesystem ends up here instead of
+ * on disk. receive() may be called concurrently from several threads.
+ */
+class OutputSink
+{
+public:
+	OutputSink();
+	OutputSink(const OutputSink &) = delete;
+	OutputSink(OutputSink &&) = delete;
+	virtual ~OutputSink();
+
+	OutputSink &operator=(const OutputSink &) = delete;
+	OutputSink &operator=(OutputSink &&) = delete;
+
+	/**
+	 * @brief: Called once for every closed output file
+	 *
+	 * @param[in] path The path of the file relative to the export root (starts with /)
+	 * @param[in] data The contents of the file
+	 * @param[in] size The size of the contents in bytes
+	 * @return @c True if the file has been accepted
+	 */
+	virtual bool receive(const String &path, const void *data, size_t size) = 0;
+
+	/**
+	 * @brief: Called when no more files will be delivered
+	 *
+	 * @return @c True if all of the received files have been stored successfully
+	 */
+	virtual bool finish();
+};
+
+/**
+ * @brief: Keeps every received file in memory.
+ */
+class MemoryOutputSink : public OutputSink
+{
+public:
+	virtual bool receive(const String &path, const void *data, size_t size) override;
+
+	/**
+	 * @brief: Returns contents of previously received file or nullptr if there is no such file
+	 */
+	const Array<u8> *find(const String &path) const;
+
+	/**
+	 * @brief: Moves all of received files out of the sink
+	 */
+	Map<String, Array<u8>> release();
+
+private:
+	mutable std::mutex m_mutex;
+	Map<String, Array<u8>> m_files;
+};
+
+/**
+ * @brief: Writes every received file into the directory.
+ */
+class DirectoryOutputSink : public OutputSink
+{
+public:
+	DirectoryOutputSink(const String &root);
+
+	virtual bool receive(const String &path, const void *data, size_t size) override;
+
+private:
+	String m_root;
+};
+
+/**
+ * @brief: Forwards every received file to the user function.
+ */
+class CallbackOutputSink : public OutputSink
+{
+public:
+	using Callback = std::function<bool(const String &path, const void *data, size_t size)>;
+
+public:
+	CallbackOutputSink(Callback callback);
+
+	virtual bool receive(const String &path, const void *data, size_t size) override;
+
+private:
+	std::mutex m_mutex;
+	Callback m_callback;
+};
+
+/* eof */
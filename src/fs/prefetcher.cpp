@@ -0,0 +1,152 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/prefetcher.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "prefetcher.h"
+
+#include "uberfilesystem.h"
+#include "memory_file.h"
+
+#include <utils/metrics.h>
+
+Prefetcher::Prefetcher()
+{
+}
+
+Prefetcher::~Prefetcher()
+{
+	clear();
+}
+
+void Prefetcher::setBudget(size_t bytes)
+{
+	m_budget = bytes;
+	if (bytes == 0)
+	{
+		clear();
+	}
+}
+
+void Prefetcher::hint(const String &path)
+{
+	if (!enabled())
+	{
+		return;
+	}
+
+	const PathId id = getPaths()->intern(path);
+	u64 size = 0;
+	if (!getUFS()->fileSize(id, size))
+	{
+		return; // the loader reports the missing file
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_pending.find(id) != m_pending.end())
+	{
+		return;
+	}
+	++m_hints;
+
+	// the budget is reserved before the read, so the files in flight are counted too
+	if (m_bytes + size > m_budget)
+	{
+		++m_refused;
+		return;
+	}
+
+	m_entries.emplace_back();
+	Entry &entry = m_entries.back();
+	entry.m_path = id;
+	entry.m_size = static_cast<size_t>(size);
+	entry.m_read = getUFS()->readWholeAsync(id);
+	m_pending[id] = std::prev(m_entries.end());
+	m_bytes += entry.m_size;
+}
+
+UniquePtr<File> Prefetcher::take(PathId path)
+{
+	Entry entry;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_pending.find(path);
+		if (it == m_pending.end())
+		{
+			return UniquePtr<File>();
+		}
+		entry = std::move(*it->second);
+		m_entries.erase(it->second);
+		m_pending.erase(it);
+		m_bytes -= entry.m_size; // owned by the loader from now on
+		if (entry.m_read.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++m_waits;
+		}
+		++m_hits;
+	}
+
+	// reading the file again would take longer than waiting for the read in progress
+	UniquePtr<Array<u8>> contents = entry.m_read.get();
+	if (!contents)
+	{
+		return UniquePtr<File>(); // opened by the layers, which report the error
+	}
+	return std::make_unique<MemoryFile>(std::move(*contents));
+}
+
+void Prefetcher::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (Entry &entry : m_entries)
+	{
+		entry.m_read.wait(); // the read uses the mounted file system, which may be unmounted next
+	}
+	m_unused += m_entries.size();
+	m_entries.clear();
+	m_pending.clear();
+	m_bytes = 0;
+}
+
+void Prefetcher::report(Metrics *metrics) const
+{
+	if (!metrics)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	metrics->set("prefetch_hints", m_hints);
+	metrics->set("prefetch_hits", m_hits);
+	metrics->set("prefetch_waits", m_waits);
+	metrics->set("prefetch_refused", m_refused);
+	metrics->set("prefetch_unused", m_unused + m_entries.size());
+	metrics->set("prefetch_hit_rate", m_hints ? static_cast<double>(m_hits) / m_hints : 0.0);
+}
+
+Prefetcher *getPrefetcher()
+{
+	static Prefetcher prefetcher;
+	return &prefetcher;
+}
+
+/* eof */
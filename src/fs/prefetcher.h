@@ -0,0 +1,112 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/prefetcher.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "filesystem.h"
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * @brief: Reads the files the loaders are going to open soon, in the background.
+ *
+ * The loaders post hints with the paths they know will follow (materials of the model
+ * descriptor, texture objects of the material, textures to be copied). Every hinted file
+ * is read whole and inflated on the I/O threads (FileSystem::readWholeAsync()) and kept
+ * decompressed until getUFS() opens it, then it is served from memory. The size of the file
+ * (FileSystem::fileSize()) is reserved from the memory budget when the hint is posted and
+ * returned when the file is taken, the hints which would exceed the budget are refused,
+ * the loader then reads the file as usual.
+ */
+class Prefetcher
+{
+public:
+	Prefetcher();
+	Prefetcher(const Prefetcher &) = delete;
+	Prefetcher(Prefetcher &&) = delete;
+	~Prefetcher();
+
+	Prefetcher &operator=(const Prefetcher &) = delete;
+	Prefetcher &operator=(Prefetcher &&) = delete;
+
+	/**
+	 * @brief: Sets the memory available for the prefetched files
+	 *
+	 * @param[in] bytes The budget in bytes, 0 disables prefetching and drops the pending hints
+	 */
+	void setBudget(size_t bytes);
+
+	inline bool enabled() const { return m_budget.load(std::memory_order_relaxed) != 0; }
+
+	/**
+	 * @brief: Starts reading the file unless it is already pending, ignored when disabled
+	 *
+	 * Refused when the file does not exist or its size does not fit into the rest of the budget.
+	 */
+	void hint(const String &path);
+
+	/**
+	 * @brief: Takes the prefetched file, waits for it if it is still being read
+	 *
+	 * @return @c The file or nullptr if it has not been hinted (or has been refused)
+	 */
+	UniquePtr<File> take(PathId path);
+
+	/**
+	 * @brief: Drops the hints which have not been taken, they are counted as unused
+	 *
+	 * Waits for the reads in progress, so the file systems may be unmounted afterwards.
+	 */
+	void clear();
+
+	/**
+	 * @brief: Sets the counters as prefetch_<name> (hints, hits, waits, refused, unused, hit_rate)
+	 */
+	void report(Metrics *metrics) const;
+
+private:
+	struct Entry
+	{
+		PathId m_path;
+		FileSystem::AsyncRead m_read;
+		size_t m_size = 0;		// reserved from the budget
+	};
+
+private:
+	std::atomic<size_t> m_budget{ 0 };
+
+	mutable std::mutex m_mutex;
+	List<Entry> m_entries;
+	Map<PathId, List<Entry>::iterator> m_pending;
+	size_t m_bytes = 0;			// reserved by the pending hints
+
+	u64 m_hints = 0;
+	u64 m_hits = 0;
+	u64 m_waits = 0;			// hits still being read when taken
+	u64 m_refused = 0;			// over the budget
+	u64 m_unused = 0;
+};
+
+Prefetcher *getPrefetcher();
+
+/* eof */
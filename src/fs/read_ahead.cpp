@@ -0,0 +1,121 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/read_ahead.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "read_ahead.h"
+
+#include "memory_file.h"
+#include "uberfilesystem.h"
+
+namespace
+{
+	thread_local ReadAhead *s_readAhead = nullptr;
+}
+
+ReadAhead::Scope::Scope(ReadAhead &files)
+	: m_previous(s_readAhead)
+{
+	s_readAhead = &files;
+}
+
+ReadAhead::Scope::~Scope()
+{
+	s_readAhead = m_previous;
+}
+
+ReadAhead::ReadAhead()
+{
+}
+
+ReadAhead::~ReadAhead()
+{
+}
+
+size_t ReadAhead::fetch(const Array<String> &paths)
+{
+	Array<Pair<PathId, FileSystem::AsyncRead>> reads;
+	reads.reserve(paths.size());
+	for (const auto &path : paths)
+	{
+		const PathId id = getPaths()->intern(path);
+		reads.push_back({ id, getUFS()->readWholeAsync(id) });
+	}
+
+	size_t bytes = 0;
+	for (auto &read : reads)
+	{
+		// the files not read are opened again when needed, so the error is reported by the reader
+		if (UniquePtr<Array<u8>> contents = read.second.get())
+		{
+			bytes += contents->size();
+			m_files.push_back({ read.first, std::move(*contents) });
+		}
+	}
+	return bytes;
+}
+
+UniquePtr<File> ReadAhead::open(PathId path)
+{
+	for (auto it = m_files.begin(); it != m_files.end(); ++it)
+	{
+		if (it->first == path)
+		{
+			auto file = std::make_unique<MemoryFile>(std::move(it->second));
+			m_files.erase(it);
+			return file;
+		}
+	}
+	return UniquePtr<File>();
+}
+
+bool ReadAhead::contains(PathId path) const
+{
+	for (const auto &file : m_files)
+	{
+		if (file.first == path)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ReadAhead::size(PathId path, u64 &size) const
+{
+	for (const auto &file : m_files)
+	{
+		if (file.first == path)
+		{
+			size = file.second.size();
+			return true;
+		}
+	}
+	return false;
+}
+
+ReadAhead *ReadAhead::current()
+{
+	return s_readAhead;
+}
+
+/* eof */
@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/read_ahead.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "file.h"
+
+#include <utils/path_table.h>
+
+/**
+ * @brief: Input files of one job read in advance, opened by getUFS() on the thread bound to them.
+ *
+ * The fetch stage of the conversion reads (and inflates) the files of the job, the decode stage
+ * binds them to its thread by Scope, so loading the job does not wait for the archives. The files
+ * not read in advance are opened from the mounted file systems as usual.
+ */
+class ReadAhead
+{
+public:
+	/**
+	 * @brief: Binds the files to the current thread while the scope is alive
+	 */
+	class Scope
+	{
+	public:
+		Scope(ReadAhead &files);
+		Scope(const Scope &) = delete;
+		~Scope();
+
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		ReadAhead *m_previous;
+	};
+
+public:
+	ReadAhead();
+	ReadAhead(const ReadAhead &) = delete;
+	ReadAhead(ReadAhead &&) = delete;
+	~ReadAhead();
+
+	ReadAhead &operator=(const ReadAhead &) = delete;
+	ReadAhead &operator=(ReadAhead &&) = delete;
+
+	/**
+	 * @brief: Reads the files from getUFS(), all of them at once (FileSystem::readWholeAsync())
+	 *
+	 * @param[in] paths The paths of the files, the missing ones are skipped
+	 * @return @c The number of bytes read
+	 */
+	size_t fetch(const Array<String> &paths);
+
+	/**
+	 * @brief: Opens the file read in advance, its contents are moved into the returned file
+	 *
+	 * @return @c The file or nullptr if it has not been read (or has been opened already)
+	 */
+	UniquePtr<File> open(PathId path);
+
+	bool contains(PathId path) const;
+
+	/**
+	 * @brief: Gets the size of the file read in advance, the file stays to be opened
+	 *
+	 * @return @c True if the file has been read (and not opened yet)
+	 */
+	bool size(PathId path, u64 &size) const;
+
+	/**
+	 * @brief: Returns the files bound to the current thread, or nullptr
+	 */
+	static ReadAhead *current();
+
+private:
+	Array<Pair<PathId, Array<u8>>> m_files;	// a few files per job
+};
+
+/* eof */
@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/sinkfilesystem.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "sinkfilesystem.h"
+
+#include "sinkfs_file.h"
+#include "output_sink.h"
+
+static String normalizePath(const String &filename)
+{
+	String result = filename;
+	backslashesToSlashes(result);
+	if (result.empty() || result[0] != '/')
+	{
+		result.insert(result.begin(), '/');
+	}
+	return result;
+}
+
+SinkFileSystem::SinkFileSystem(OutputSink *sink)
+	: m_sink(sink)
+{
+}
+
+SinkFileSystem::~SinkFileSystem()
+{
+}
+
+String SinkFileSystem::root() const
+{
+	return "";
+}
+
+String SinkFileSystem::name() const
+{
+	return "sinkfs";
+}
+
+UniquePtr<File> SinkFileSystem::open(const String &filename, FsOpenMode mode)
+{
+	if (!(mode & write) || (mode & (read | append | update)))
+	{
+		error_f("sinkfs", filename, "Unsupported open mode: 0x%x! Only writing is allowed.", (unsigned)mode);
+		return UniquePtr<File>();
+	}
+
+	const String path = normalizePath(filename);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_claimed.insert(path);
+	}
+	return std::make_unique<SinkFsFile>(path, this);
+}
+
+bool SinkFileSystem::mkdir(const String &directory)
+{
+	return true;
+}
+
+bool SinkFileSystem::rmdir(const String &directory)
+{
+	return false;
+}
+
+bool SinkFileSystem::exists(const String &filename)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_claimed.find(normalizePath(filename)) != m_claimed.end();
+}
+
+bool SinkFileSystem::claim(const String &filename)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_claimed.insert(normalizePath(filename)).second;
+}
+
+bool SinkFileSystem::dirExists(const String &dirpath)
+{
+	return false;
+}
+
+UniquePtr<List<FileSystem::Entry>> SinkFileSystem::readDir(const String &path, bool absolutePaths, bool recursive)
+{
+	return UniquePtr<List<Entry>>();
+}
+
+void SinkFileSystem::commit(const String &filename, const Array<u8> &contents)
+{
+	if (!m_sink->receive(filename, contents.data(), contents.size()))
+	{
+		error("sinkfs", filename, "Output sink rejected the file!");
+	}
+}
+
+/* eof */
@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/sinkfilesystem.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "filesystem.h"
+
+#include <mutex>
+#include <unordered_set>
+
+/**
+ * @brief: Write-only file system which delivers closed files to the OutputSink.
+ *
+ * Files opened for writing are buffered in memory and passed to the sink as a whole
+ * when they are destroyed. Reading is not supported. A file exists from the moment it
+ * is opened for writing or claimed, not only when it has been delivered.
+ */
+class SinkFileSystem : public FileSystem
+{
+public:
+	SinkFileSystem(OutputSink *sink);
+	virtual ~SinkFileSystem();
+
+	virtual String root() const override;
+	virtual String name() const override;
+	virtual UniquePtr<File> open(const String &filename, FsOpenMode mode) override;
+	virtual bool mkdir(const String &directory) override;
+	virtual bool rmdir(const String &directory) override;
+	virtual bool exists(const String &filename) override;
+	virtual bool claim(const String &filename) override;
+	virtual bool dirExists(const String &dirpath) override;
+	virtual UniquePtr<List<Entry>> readDir(const String &path, bool absolutePaths, bool recursive) override;
+
+	inline OutputSink *sink() const { return m_sink; }
+
+private:
+	void commit(const String &filename, const Array<u8> &contents);
+
+private:
+	OutputSink *m_sink;
+
+	std::mutex m_mutex;
+	std::unordered_set<String> m_claimed;	// opened for writing or claimed
+
+	friend class SinkFsFile;
+};
+
+/* eof */
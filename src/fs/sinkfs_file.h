@@ -0,0 +1,43 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/sinkfs_file.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "memory_file.h"
+
+class SinkFsFile : public MemoryFile
+{
+public:
+	SinkFsFile(const String &filepath, SinkFileSystem *filesystem);
+	SinkFsFile(const SinkFsFile &) = delete;
+	SinkFsFile(SinkFsFile &&) = delete;
+	virtual ~SinkFsFile();
+
+	SinkFsFile &operator=(const SinkFsFile &) = delete;
+	SinkFsFile &operator=(SinkFsFile &&) = delete;
+
+private:
+	String m_filepath;
+	SinkFileSystem *m_filesystem;
+};
+
+/* eof */
@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/staging_filesystem.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "staging_filesystem.h"
+
+#include "file.h"
+
+StagingFileSystem::StagingFileSystem(FileSystem *target, const String &root)
+	: SinkFileSystem(&m_staged) // the sink is only stored by the base
+	, m_target(target)
+	, m_root(root)
+{
+}
+
+StagingFileSystem::~StagingFileSystem()
+{
+}
+
+String StagingFileSystem::name() const
+{
+	return "stagingfs";
+}
+
+bool StagingFileSystem::exists(const String &filename)
+{
+	return SinkFileSystem::exists(filename) || m_target->exists(m_root + filename);
+}
+
+bool StagingFileSystem::claim(const String &filename)
+{
+	return SinkFileSystem::claim(filename) && m_target->claim(m_root + filename);
+}
+
+bool StagingFileSystem::flush()
+{
+	bool result = true;
+	for (const auto &staged : m_staged.release())
+	{
+		const String path = m_root + staged.first;
+		auto file = m_target->open(path, FileSystem::write | FileSystem::binary);
+		if (!file)
+		{
+			error_f("stagingfs", path, "Unable to open file for writing (%s)!", strerror(errno));
+			result = false;
+			continue;
+		}
+		if (!staged.second.empty() && file->write(staged.second.data(), sizeof(u8), staged.second.size()) != staged.second.size())
+		{
+			error("stagingfs", path, "Unable to write the file!");
+			result = false;
+		}
+	}
+	return result;
+}
+
+/* eof */
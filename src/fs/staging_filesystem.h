@@ -0,0 +1,63 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/staging_filesystem.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "sinkfilesystem.h"
+#include "output_sink.h"
+
+/**
+ * @brief: Keeps the files written by one job in memory until they are flushed to the output.
+ *
+ * Installed by setThreadOFS() while the job is formatted, so the exporters write into memory
+ * and the writing to the disk (or to the output sink) is left to another thread. Existence
+ * of the files is answered from the staged files and from the output. The paths are claimed
+ * in the output too, so the jobs staged at the same time do not write the same texture.
+ */
+class StagingFileSystem : public SinkFileSystem
+{
+public:
+	/**
+	 * @param[in] target The file system receiving the files on flush()
+	 * @param[in] root The path prepended to the staged paths in the target (the export path)
+	 */
+	StagingFileSystem(FileSystem *target, const String &root);
+	virtual ~StagingFileSystem();
+
+	virtual String name() const override;
+	virtual bool exists(const String &filename) override;
+	virtual bool claim(const String &filename) override;
+
+	/**
+	 * @brief: Writes the staged files into the target and forgets them
+	 *
+	 * @return @c True if all of the files have been written
+	 */
+	bool flush();
+
+private:
+	MemoryOutputSink m_staged;
+	FileSystem *m_target;
+	String m_root;
+};
+
+/* eof */
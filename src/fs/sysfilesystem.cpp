@@ -26,6 +26,11 @@
 
 #include "sysfs_file.h"
 
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
 SysFileSystem::SysFileSystem(const String &root)
 	: m_root(root)
 {
@@ -97,11 +102,12 @@ bool SysFileSystem::mkdir(const String &dir)
 	{
 		if (!dirExists(dirr.substr(0, pos).c_str()))
 		{
+			// the directory may have been just created by another thread
 		#ifdef _WIN32
-			if (::mkdir(dirr.substr(0, pos).c_str()) != 0)
+			if (::mkdir(dirr.substr(0, pos).c_str()) != 0 && errno != EEXIST)
 				return false;
 		#else
-			if (::mkdir(dirr.substr(0, pos).c_str(), 0775) != 0)
+			if (::mkdir(dirr.substr(0, pos).c_str(), 0775) != 0 && errno != EEXIST)
 				return false;
 		#endif
 		}
@@ -125,6 +131,39 @@ bool SysFileSystem::exists(const String &filename)
 	return false;
 }
 
+bool SysFileSystem::claim(const String &filename)
+{
+	// the file is created exclusively, so only one of the writers racing for the path gets it
+	const String path = m_root + filename;
+	FILE *fp = fopen(path.c_str(), "wbx");
+	if (!fp && errno == ENOENT && mkdir(directory(filename)))
+	{
+		fp = fopen(path.c_str(), "wbx");
+	}
+	if (!fp)
+	{
+		return errno != EEXIST; // the other errors are reported by the open of the writer
+	}
+	fclose(fp);
+	return true;
+}
+
+bool SysFileSystem::fileSize(PathId path, u64 &size)
+{
+	if (!path.valid())
+	{
+		return false;
+	}
+
+	struct stat buffer;
+	if (stat((m_root + getPaths()->string(path)).c_str(), &buffer) != 0 || (buffer.st_mode & S_IFDIR) != 0)
+	{
+		return false;
+	}
+	size = static_cast<u64>(buffer.st_size);
+	return true;
+}
+
 bool SysFileSystem::dirExists(const String &dirpath)
 {
 	struct stat buffer;
@@ -173,7 +212,10 @@ auto SysFileSystem::readDir(const String &directory, bool absolutePaths, bool re
 	struct dirent *ent;
 	struct stat st;
 
-	dir = opendir(directoryNoSlash.c_str());
+	dir = opendir((m_root + directoryNoSlash).c_str());
+	if (!dir)
+		return UniquePtr<List<Entry>>();
+
 	while ((ent = readdir(dir)) != 0)
 	{
 		const String fileName = ent->d_name;
@@ -182,7 +224,7 @@ auto SysFileSystem::readDir(const String &directory, bool absolutePaths, bool re
 		if (fileName[0] == '.')
 			continue;
 
-		if (stat(fullFileName.c_str(), &st) == -1)
+		if (stat((m_root + fullFileName).c_str(), &st) == -1)
 			continue;
 
 		const bool isDirectory = !!(st.st_mode & S_IFDIR);
@@ -209,4 +251,35 @@ String SysFileSystem::getError() const
 	return strerror(errno);
 }
 
+UniquePtr<File> SysFileSystem::openStdout()
+{
+	fflush(stdout);
+#ifdef _WIN32
+	const int fd = ::_dup(::_fileno(stdout));
+	if (fd == -1)
+	{
+		return UniquePtr<File>();
+	}
+	::_setmode(fd, _O_BINARY);
+	::_dup2(::_fileno(stderr), ::_fileno(stdout));
+	FILE *fp = ::_fdopen(fd, "wb");
+#else
+	const int fd = ::dup(::fileno(stdout));
+	if (fd == -1)
+	{
+		return UniquePtr<File>();
+	}
+	::dup2(::fileno(stderr), ::fileno(stdout));
+	FILE *fp = ::fdopen(fd, "wb");
+#endif
+	if (!fp)
+	{
+		return UniquePtr<File>();
+	}
+
+	auto file = std::make_unique<SysFsFile>();
+	file->m_fp = fp;
+	return std::move(file);
+}
+
 /* eof */
@@ -36,11 +36,20 @@ public:
 	virtual bool mkdir(const String &directory) override;
 	virtual bool rmdir(const String &directory) override;
 	virtual bool exists(const String &filename) override;
+	virtual bool fileSize(PathId path, u64 &size) override;
+	virtual bool claim(const String &filename) override;
 	virtual bool dirExists(const String &dirpath) override;
 	virtual UniquePtr<List<Entry>> readDir(const String &path, bool absolutePaths, bool recursive) override;
 
 	String getError() const;
 
+	/**
+	 * @brief: Opens the standard output of the process as binary file
+	 *
+	 * Text printed to stdout afterwards goes to stderr, so it cannot corrupt the data.
+	 */
+	UniquePtr<File> openStdout();
+
 private:
 	String m_root; // does not contain / at end
 };
@@ -64,6 +64,32 @@ bool SysFsFile::seek(uint64_t offset, Attrib attr)
 #endif
 }
 
+bool SysFsFile::blockRead(void *buffer, uint64_t offset, uint64_t size)
+{
+#ifdef _WIN32
+	return File::blockRead(buffer, offset, size);
+#else
+	const int fd = ::fileno(m_fp);
+	char *it = static_cast<char *>(buffer);
+	while (size > 0)
+	{
+		const ssize_t count = ::pread(fd, it, static_cast<size_t>(size), static_cast<off_t>(offset));
+		if (count < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (count <= 0)
+		{
+			return false;
+		}
+		it += count;
+		offset += static_cast<uint64_t>(count);
+		size -= static_cast<uint64_t>(count);
+	}
+	return true;
+#endif
+}
+
 void SysFsFile::rewind()
 {
 	::rewind(m_fp);
@@ -43,6 +43,14 @@ public:
 	virtual uint64_t tell() const override;
 	virtual void flush() override;
 
+	/**
+	 * @brief: Reads the block without moving the position of the file (pread on POSIX)
+	 *
+	 * The position of the descriptor is shared with the forked worker processes (see ProcessPool),
+	 * so the archives opened by the supervisor are read by the workers at explicit offsets.
+	 */
+	virtual bool blockRead(void *buffer, uint64_t offset, uint64_t size) override;
+
 private:
 	FILE *m_fp = nullptr;
 
@@ -0,0 +1,167 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/tar_sink.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "tar_sink.h"
+
+#include "file.h"
+
+#include <structs/tar.h>
+
+static void writeOctal(char *field, size_t length, u64 value)
+{
+	if (value >> (3 * (length - 1)))
+	{
+		// does not fit as octal number, use the base-256 encoding
+		memset(field, 0, length);
+		field[0] = static_cast<char>(0x80);
+		for (size_t i = length - 1; i > 0 && value; --i, value >>= 8)
+		{
+			field[i] = static_cast<char>(value & 0xFF);
+		}
+		return;
+	}
+	field[length - 1] = '\0';
+	for (size_t i = length - 1; i > 0; --i, value >>= 3)
+	{
+		field[i - 1] = static_cast<char>('0' + (value & 7));
+	}
+}
+
+TarOutputSink::TarOutputSink(UniquePtr<File> output)
+	: m_output(std::move(output))
+{
+}
+
+TarOutputSink::~TarOutputSink()
+{
+	if (m_output)
+	{
+		finish();
+	}
+}
+
+bool TarOutputSink::receive(const String &path, const void *data, size_t size)
+{
+	const String name = trimSlashesAtBegin(path);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_output)
+	{
+		error("tar", path, "The archive has been already finished!");
+		return false;
+	}
+
+	if (!writeHeader(name, size, tar::TYPE_FLAG::REGULAR) || !writePadded(data, size))
+	{
+		error_f("tar", path, "Unable to write entry into the archive (%s)!", strerror(errno));
+		m_failed = true;
+		return false;
+	}
+	return true;
+}
+
+bool TarOutputSink::finish()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_output)
+	{
+		return !m_failed;
+	}
+
+	const char terminator[2 * tar::BLOCK_SIZE] = { 0 };
+	if (m_output->write(terminator, 1, sizeof(terminator)) != sizeof(terminator))
+	{
+		m_failed = true;
+	}
+	m_output->flush();
+	m_output.reset();
+	return !m_failed;
+}
+
+bool TarOutputSink::writeHeader(const String &name, u64 size, char type)
+{
+	tar::Header header;
+	memset(&header, 0, sizeof(header));
+
+	if (name.length() <= sizeof(header.name))
+	{
+		memcpy(header.name, name.c_str(), name.length());
+	}
+	else
+	{
+		// try to split the name between prefix and name fields at the slash
+		size_t split = name.rfind('/', sizeof(header.prefix));
+		if (split != String::npos && split > 0 && name.length() - split - 1 <= sizeof(header.name) && name.length() - split - 1 > 0)
+		{
+			memcpy(header.prefix, name.c_str(), split);
+			memcpy(header.name, name.c_str() + split + 1, name.length() - split - 1);
+		}
+		else
+		{
+			if (!writeHeader("././@LongLink", name.length() + 1, tar::TYPE_FLAG::GNU_LONG_NAME)
+			 || !writePadded(name.c_str(), name.length() + 1))
+			{
+				return false;
+			}
+			memcpy(header.name, name.c_str(), sizeof(header.name));
+		}
+	}
+
+	writeOctal(header.mode, sizeof(header.mode), 0644);
+	writeOctal(header.uid, sizeof(header.uid), 0);
+	writeOctal(header.gid, sizeof(header.gid), 0);
+	writeOctal(header.size, sizeof(header.size), size);
+	writeOctal(header.mtime, sizeof(header.mtime), 0);
+	header.typeflag = type;
+	memcpy(header.magic, "ustar", 6);
+	memcpy(header.version, "00", 2);
+
+	memset(header.checksum, ' ', sizeof(header.checksum));
+	unsigned checksum = 0;
+	for (size_t i = 0; i < sizeof(header); ++i)
+	{
+		checksum += reinterpret_cast<const u8 *>(&header)[i];
+	}
+	writeOctal(header.checksum, sizeof(header.checksum) - 1, checksum);
+
+	return m_output->write(&header, 1, sizeof(header)) == sizeof(header);
+}
+
+bool TarOutputSink::writePadded(const void *data, u64 size)
+{
+	if (size > 0 && m_output->write(data, 1, size) != size)
+	{
+		return false;
+	}
+
+	const char padding[tar::BLOCK_SIZE] = { 0 };
+	const u64 remainder = size % tar::BLOCK_SIZE;
+	if (remainder != 0)
+	{
+		return m_output->write(padding, 1, tar::BLOCK_SIZE - remainder) == tar::BLOCK_SIZE - remainder;
+	}
+	return true;
+}
+
+/* eof */
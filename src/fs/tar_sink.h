@@ -0,0 +1,55 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/tar_sink.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "output_sink.h"
+
+/**
+ * @brief: Writes all of the received files as a single ustar stream.
+ *
+ * Names longer than the ustar limits are stored using GNU long name records.
+ * The stream is terminated by finish().
+ */
+class TarOutputSink : public OutputSink
+{
+public:
+	/**
+	 * @param[in] output The file or stream opened for writing
+	 */
+	TarOutputSink(UniquePtr<File> output);
+	virtual ~TarOutputSink();
+
+	virtual bool receive(const String &path, const void *data, size_t size) override;
+	virtual bool finish() override;
+
+private:
+	bool writeHeader(const String &name, u64 size, char type);
+	bool writePadded(const void *data, u64 size);
+
+private:
+	UniquePtr<File> m_output;
+	std::mutex m_mutex;
+	bool m_failed = false;
+};
+
+/* eof */
@@ -25,6 +25,8 @@
 #include "uberfilesystem.h"
 
 #include "file.h"
+#include "read_ahead.h"
+#include "prefetcher.h"
 
 UberFileSystem::UberFileSystem()
 {
@@ -46,9 +48,28 @@ String UberFileSystem::name() const
 
 UniquePtr<File> UberFileSystem::open(const String &filename, FsOpenMode mode)
 {
+	return open(getPaths()->intern(filename), mode);
+}
+
+UniquePtr<File> UberFileSystem::open(PathId path, FsOpenMode mode)
+{
+	if (ReadAhead *files = ReadAhead::current())
+	{
+		if (UniquePtr<File> file = files->open(path))
+		{
+			return file;
+		}
+	}
+	if (getPrefetcher()->enabled())
+	{
+		if (UniquePtr<File> file = getPrefetcher()->take(path))
+		{
+			return file;
+		}
+	}
 	for (auto it = m_filesystems.rbegin(); it != m_filesystems.rend(); ++it)
 	{
-		UniquePtr<File> file = (*it).second->open(filename, mode);
+		UniquePtr<File> file = (*it).second->open(path, mode);
 		if (file)
 		{
 			return file;
@@ -57,6 +78,27 @@ UniquePtr<File> UberFileSystem::open(const String &filename, FsOpenMode mode)
 	return UniquePtr<File>();
 }
 
+FileSystem::AsyncRead UberFileSystem::readWholeAsync(PathId path)
+{
+	if (ReadAhead *files = ReadAhead::current())
+	{
+		if (UniquePtr<File> file = files->open(path))
+		{
+			return readyRead(readWhole(std::move(file)));
+		}
+	}
+
+	// the layer is resolved now, only reading the file is left to the I/O threads
+	for (auto it = m_filesystems.rbegin(); it != m_filesystems.rend(); ++it)
+	{
+		if ((*it).second->exists(path))
+		{
+			return (*it).second->readWholeAsync(path);
+		}
+	}
+	return readyRead(UniquePtr<Array<u8>>());
+}
+
 bool UberFileSystem::mkdir(const String &directory)
 {
 	return false;
@@ -69,67 +111,167 @@ bool UberFileSystem::rmdir(const String &directory)
 
 bool UberFileSystem::exists(const String &filename)
 {
+	return exists(getPaths()->intern(filename));
+}
+
+bool UberFileSystem::exists(PathId path)
+{
+	if (ReadAhead *files = ReadAhead::current())
+	{
+		if (files->contains(path))
+		{
+			return true;
+		}
+	}
 	for (const auto &fs : m_filesystems)
 	{
-		if (fs.second->exists(filename))
+		if (fs.second->exists(path))
 			return true;
 	}
 	return false;
 }
 
-bool UberFileSystem::dirExists(const String &dirpath)
+bool UberFileSystem::fileSize(PathId path, u64 &size)
 {
-	for (const auto &fs : m_filesystems)
+	if (ReadAhead *files = ReadAhead::current())
 	{
-		if (fs.second->dirExists(dirpath))
+		if (files->size(path, size))
+		{
 			return true;
+		}
+	}
+	for (auto it = m_filesystems.rbegin(); it != m_filesystems.rend(); ++it)
+	{
+		if ((*it).second->fileSize(path, size))
+		{
+			return true;
+		}
 	}
 	return false;
 }
 
+bool UberFileSystem::dirExists(const String &dirpath)
+{
+	std::lock_guard<std::mutex> lock(m_treeMutex);
+	return directory(dirpath).m_exists;
+}
+
 auto UberFileSystem::readDir(const String &path, bool absolutePaths, bool recursive) -> UniquePtr<List<Entry>>
 {
-	UniquePtr<List<Entry>> result;
-	Map<String, int> aux;
+	std::lock_guard<std::mutex> lock(m_treeMutex);
+	const String dirpath = path.size() > 1 ? removeSlashAtEnd(path) : "/";
+	const Directory &dir = listedDirectory(dirpath);
+	if (!dir.m_exists)
+	{
+		return UniquePtr<List<Entry>>();
+	}
+
+	auto result = std::make_unique<List<Entry>>();
+	appendEntries(dirpath, absolutePaths ? (dirpath.size() > 1 ? dirpath + "/" : dirpath) : "", dir, recursive, *result);
+	return result;
+}
+
+auto UberFileSystem::directory(const String &path) -> Directory &
+{
+	const String dirpath = path.size() > 1 ? removeSlashAtEnd(path) : "/";
+	auto &node = m_directories[dirpath];
+	if (!node)
+	{
+		node = std::make_unique<Directory>();
+		for (const auto &fs : m_filesystems)
+		{
+			if (fs.second->dirExists(dirpath))
+			{
+				node->m_exists = true;
+				break;
+			}
+		}
+	}
+	return *node;
+}
 
+auto UberFileSystem::listedDirectory(const String &path) -> Directory &
+{
+	Directory &dir = directory(path);
+	if (dir.m_listed || !dir.m_exists)
+	{
+		return dir;
+	}
+	dir.m_listed = true;
+
+	std::unordered_set<const String *> seen;
 	for (auto it = m_filesystems.rbegin(); it != m_filesystems.rend(); ++it)
 	{
-		const auto &fs = (*it);
-		if(!fs.second->dirExists(path))
+		FileSystem *const fs = it->second.get();
+		if (!fs->dirExists(path))
 		{
 			continue;
 		}
-
-		auto current = fs.second->readDir(path, absolutePaths, recursive);
-		if (!current)
+		auto entries = fs->readDir(path, false, false);
+		if (!entries)
 		{
 			continue;
 		}
-
-		if (!result)
+		for (const Entry &entry : *entries)
 		{
-			result = std::make_unique<List<Entry>>();
+			const String *name = &*m_names.insert(entry.GetPath()).first;
+			if (seen.insert(name).second)
+			{
+				dir.m_children.push_back({ name, fs, entry.IsDirectory(), entry.IsEncrypted() });
+			}
 		}
+	}
+	return dir;
+}
 
-		for (const FileSystem::Entry &entry : (*current))
+void UberFileSystem::appendEntries(const String &path, const String &prefix, const Directory &dir, bool recursive, List<Entry> &result)
+{
+	for (const Child &child : dir.m_children)
+	{
+		result.push_back(Entry(prefix + *child.m_name, child.m_directory, child.m_encrypted, child.m_layer));
+		if (recursive && child.m_directory)
 		{
-			int &auxValue = aux[entry.GetPath()];
-			if (auxValue == 1) { continue; }
-			auxValue = 1;
-			result->push_back(entry);
+			const String childPath = (path.size() > 1 ? path + "/" : path) + *child.m_name;
+			appendEntries(childPath, prefix + *child.m_name + "/", listedDirectory(childPath), recursive, result);
 		}
 	}
+}
+
+bool UberFileSystem::verify(ThreadPool &pool)
+{
+	bool result = true;
+	for (const auto &fs : m_filesystems)
+	{
+		result = fs.second->verify(pool) && result;
+	}
 	return result;
 }
 
 FileSystem *UberFileSystem::mount(UniquePtr<FileSystem> fs, Priority priority)
 {
+	refresh();
 	m_filesystems[priority] = std::move(fs);
 	return m_filesystems[priority].get();
 }
 
+Array<FileSystem *> UberFileSystem::mount(Array<UniquePtr<FileSystem>> filesystems, Priority priority)
+{
+	refresh();
+	Array<FileSystem *> result(filesystems.size(), nullptr);
+	for (size_t i = 0; i < filesystems.size(); ++i)
+	{
+		if (filesystems[i])
+		{
+			result[i] = filesystems[i].get();
+			m_filesystems[priority + static_cast<Priority>(i)] = std::move(filesystems[i]);
+		}
+	}
+	return result;
+}
+
 void UberFileSystem::unmount(FileSystem *filesystem)
 {
+	refresh();
 	for (const auto &fs : m_filesystems)
 	{
 		if (fs.second.get() == filesystem)
@@ -140,4 +282,12 @@ void UberFileSystem::unmount(FileSystem *filesystem)
 	}
 }
 
+void UberFileSystem::refresh()
+{
+	getPrefetcher()->clear(); // the files may come from other layers now
+	std::lock_guard<std::mutex> lock(m_treeMutex);
+	m_directories.clear();
+	m_names.clear();
+}
+
 /* eof */
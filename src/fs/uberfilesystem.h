@@ -24,6 +24,16 @@
 
 #include "filesystem.h"
 
+#include <mutex>
+#include <unordered_set>
+
+/**
+ * @brief: Overlay of the mounted file systems, the higher priority wins.
+ *
+ * readDir() and dirExists() are answered from the merged directory tree. Its nodes are
+ * listed from the layers on the first request and kept until the mount set changes
+ * (or refresh() is called), so every directory of every layer is listed only once.
+ */
 class UberFileSystem : public FileSystem
 {
 public:
@@ -36,17 +46,60 @@ public:
 	virtual String root() const override;
 	virtual String name() const override;
 	virtual UniquePtr<File> open(const String &filename, FsOpenMode mode) override;
+	virtual UniquePtr<File> open(PathId path, FsOpenMode mode) override;
 	virtual bool mkdir(const String &directory) override;
 	virtual bool rmdir(const String &directory) override;
 	virtual bool exists(const String &filename) override;
+	virtual bool exists(PathId path) override;
+	virtual bool fileSize(PathId path, u64 &size) override;
+	virtual AsyncRead readWholeAsync(PathId path) override;
 	virtual bool dirExists(const String &dirpath) override;
 	virtual UniquePtr<List<Entry>> readDir(const String &path, bool absolutePaths, bool recursive) override;
+	virtual bool verify(ThreadPool &pool) override;
 
 	FileSystem *mount(UniquePtr<FileSystem> fs, Priority priority);
+
+	/**
+	 * @brief: Mounts already opened file systems in one update
+	 *
+	 * @param[in] filesystems The file systems in the order of increasing priority, may contain nullptr
+	 * @param[in] priority The priority of the first file system, the next ones get the following priorities
+	 * @return @c The mounted file systems in the same order, nullptr where nothing was given
+	 */
+	Array<FileSystem *> mount(Array<UniquePtr<FileSystem>> filesystems, Priority priority);
 	void unmount(FileSystem *fs);
 
+	/**
+	 * @brief: Forgets the merged directory tree and the prefetched files, e.g. after the mounted directories have changed
+	 */
+	void refresh();
+
+private:
+	struct Child
+	{
+		const String *m_name;	// interned in m_names
+		FileSystem *m_layer;	// the file system of the highest priority having the entry
+		bool m_directory;
+		bool m_encrypted;
+	};
+
+	struct Directory
+	{
+		bool m_exists = false;
+		bool m_listed = false;
+		Array<Child> m_children;
+	};
+
+	Directory &directory(const String &path);
+	Directory &listedDirectory(const String &path);
+	void appendEntries(const String &path, const String &prefix, const Directory &dir, bool recursive, List<Entry> &result);
+
 private:
 	std::map<Priority, UniquePtr<FileSystem>> m_filesystems;
+
+	std::mutex m_treeMutex;
+	UnorderedMap<String, UniquePtr<Directory>> m_directories;	// merged tree, path -> node
+	std::unordered_set<String> m_names;
 };
 
 /* eof */
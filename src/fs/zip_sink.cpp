@@ -0,0 +1,363 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/zip_sink.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "zip_sink.h"
+
+#include "file.h"
+
+#include <structs/zip.h>
+#include <utils/thread_pool.h>
+
+#include <set>
+
+#ifndef FILE_ATTRIBUTE_DIRECTORY
+#define FILE_ATTRIBUTE_DIRECTORY 0x00000010
+#endif
+
+namespace
+{
+	const size_t MAX_PENDING_BYTES = 256 * 1024 * 1024;
+
+	const u32 ZIP64_LIMIT = 0xFFFFFFFF;
+	const u16 ZIP64_ENTRIES_LIMIT = 0xFFFF;
+
+	const u16 VERSION_DEFAULT = 20;
+	const u16 VERSION_ZIP64 = 45;
+
+	const u16 FLAG_UTF8_NAMES = (1 << 11);
+
+	// the entries are written in the order of receive() and dated 1980-01-01 00:00,
+	// so the same files received in the same order give the same archive
+	const u16 DOS_TIME = 0;
+	const u16 DOS_DATE = (1 << 5) | 1;
+}
+
+ZipOutputSink::ZipOutputSink(UniquePtr<File> output, bool deflate, size_t threads)
+	: m_output(std::move(output))
+	, m_pool(std::make_unique<ThreadPool>(threads))
+	, m_deflate(deflate)
+{
+}
+
+ZipOutputSink::~ZipOutputSink()
+{
+	if (!m_finished)
+	{
+		finish();
+	}
+}
+
+bool ZipOutputSink::receive(const String &path, const void *data, size_t size)
+{
+	if (m_finished)
+	{
+		error("zip", path, "The archive has been already finished!");
+		return false;
+	}
+
+	u64 sequence;
+	{
+		std::unique_lock<std::mutex> lock(m_pendingMutex);
+		m_pendingReleased.wait(lock, [&] { return m_pendingBytes == 0 || m_pendingBytes + size <= MAX_PENDING_BYTES; });
+		m_pendingBytes += size;
+		sequence = m_received++;
+	}
+
+	const u8 *const bytes = static_cast<const u8 *>(data);
+	Array<u8> buffer(bytes, bytes + size);
+	const String name = trimSlashesAtBegin(path);
+
+	m_pool->submit([this, sequence, name, buffer = std::move(buffer)]() mutable {
+		compressEntry(sequence, name, std::move(buffer));
+	});
+	return true;
+}
+
+bool ZipOutputSink::finish()
+{
+	if (m_finished)
+	{
+		return !m_failed;
+	}
+	m_finished = true;
+	m_pool->wait();
+
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+	if (!writeCentralDirectory())
+	{
+		m_failed = true;
+	}
+	m_output->flush();
+	m_output.reset();
+	return !m_failed;
+}
+
+void ZipOutputSink::compressEntry(u64 sequence, const String &name, Array<u8> &&data)
+{
+	Record record;
+	record.m_name = name;
+	uLong crc = crc32(0, Z_NULL, 0);
+	for (size_t offset = 0; offset < data.size(); offset += ZIP64_LIMIT)
+	{
+		crc = crc32(crc, data.data() + offset, static_cast<uInt>(std::min<size_t>(data.size() - offset, ZIP64_LIMIT)));
+	}
+	record.m_crc = static_cast<u32>(crc);
+	record.m_size = data.size();
+	record.m_compressedSize = data.size();
+	record.m_method = zip::COMPRESSION_METHOD::STORED;
+	record.m_offset = 0;
+
+	Array<u8> compressed;
+	if (m_deflate && !data.empty() && data.size() < ZIP64_LIMIT)
+	{
+		z_stream stream;
+		memset(&stream, 0, sizeof(stream));
+		if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+		{
+			compressed.resize(deflateBound(&stream, static_cast<uLong>(data.size())));
+			stream.next_in = data.data();
+			stream.avail_in = static_cast<uInt>(data.size());
+			stream.next_out = compressed.data();
+			stream.avail_out = static_cast<uInt>(compressed.size());
+			const int result = ::deflate(&stream, Z_FINISH);
+			if (result == Z_STREAM_END && stream.total_out < data.size())
+			{
+				record.m_method = zip::COMPRESSION_METHOD::DEFLATED;
+				record.m_compressedSize = stream.total_out;
+			}
+			deflateEnd(&stream);
+		}
+	}
+
+	Compressed entry;
+	entry.m_record = record;
+	entry.m_payload = record.m_method == zip::COMPRESSION_METHOD::DEFLATED ? std::move(compressed) : std::move(data);
+
+	u64 written = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_writeMutex);
+		m_compressed.emplace(sequence, std::move(entry));
+		for (auto it = m_compressed.begin(); it != m_compressed.end() && it->first == m_nextWrite; it = m_compressed.erase(it), ++m_nextWrite)
+		{
+			Record &next = it->second.m_record;
+			if (!writeEntry(next, it->second.m_payload.data()))
+			{
+				error_f("zip", next.m_name, "Unable to write entry into the archive (%s)!", strerror(errno));
+				m_failed = true;
+			}
+			else
+			{
+				m_records.push_back(next);
+			}
+			written += next.m_size;
+		}
+	}
+
+	// the entries waiting for the previous ones still count into the pending bytes
+	if (written != 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_pendingMutex);
+			m_pendingBytes -= static_cast<size_t>(written);
+		}
+		m_pendingReleased.notify_all();
+	}
+}
+
+bool ZipOutputSink::writeEntry(Record &record, const u8 *data)
+{
+	const bool zip64 = record.m_size >= ZIP64_LIMIT || record.m_compressedSize >= ZIP64_LIMIT;
+
+	record.m_offset = m_offset;
+
+	zip::LocalFileHeader header;
+	header.signature = zip::LocalFileHeader::SIGNATURE;
+	header.versionNeededToExtract = zip64 ? VERSION_ZIP64 : VERSION_DEFAULT;
+	header.generalPurposeBitFlag = FLAG_UTF8_NAMES;
+	header.compressionMethod = record.m_method;
+	header.lastModTime = DOS_TIME;
+	header.lastModDate = DOS_DATE;
+	header.crc32 = record.m_crc;
+	header.compressedSize = zip64 ? ZIP64_LIMIT : static_cast<u32>(record.m_compressedSize);
+	header.uncompressedSize = zip64 ? ZIP64_LIMIT : static_cast<u32>(record.m_size);
+	header.filenameLength = static_cast<u16>(record.m_name.length());
+	header.extrafieldLength = zip64 ? sizeof(zip::ExtraFieldHeader) + 2 * sizeof(u64) : 0;
+
+	if (!ioWrite(&header, sizeof(header)) || !ioWrite(record.m_name.c_str(), record.m_name.length()))
+	{
+		return false;
+	}
+
+	if (zip64)
+	{
+		zip::ExtraFieldHeader extra;
+		extra.headerId = zip::ExtraFieldHeader::ZIP64_EXTENDED_INFORMATION;
+		extra.dataSize = 2 * sizeof(u64);
+		if (!ioWrite(&extra, sizeof(extra))
+		 || !ioWrite(&record.m_size, sizeof(u64))
+		 || !ioWrite(&record.m_compressedSize, sizeof(u64)))
+		{
+			return false;
+		}
+	}
+
+	return ioWrite(data, static_cast<size_t>(record.m_compressedSize));
+}
+
+bool ZipOutputSink::writeCentralDirectory()
+{
+	// directory entries let readers find directories without deriving them from the file names
+	std::set<String> directories;
+	for (const Record &record : m_records)
+	{
+		for (size_t slash = record.m_name.find('/'); slash != String::npos; slash = record.m_name.find('/', slash + 1))
+		{
+			directories.insert(record.m_name.substr(0, slash + 1));
+		}
+	}
+	for (const String &directory : directories)
+	{
+		Record record;
+		record.m_name = directory;
+		record.m_crc = 0;
+		record.m_method = zip::COMPRESSION_METHOD::STORED;
+		record.m_size = 0;
+		record.m_compressedSize = 0;
+		if (!writeEntry(record, nullptr))
+		{
+			return false;
+		}
+		m_records.push_back(record);
+	}
+
+	std::sort(m_records.begin(), m_records.end(),
+		[](const Record &a, const Record &b) {
+			return a.m_name < b.m_name;
+		}
+	);
+
+	const u64 centralDirOffset = m_offset;
+	for (const Record &record : m_records)
+	{
+		u64 extraValues[3];
+		u16 extraCount = 0;
+		if (record.m_size >= ZIP64_LIMIT) extraValues[extraCount++] = record.m_size;
+		if (record.m_compressedSize >= ZIP64_LIMIT) extraValues[extraCount++] = record.m_compressedSize;
+		if (record.m_offset >= ZIP64_LIMIT) extraValues[extraCount++] = record.m_offset;
+
+		const u16 version = extraCount > 0 ? VERSION_ZIP64 : VERSION_DEFAULT;
+
+		zip::CentralDirectoryFileHeader header;
+		header.signature = zip::CentralDirectoryFileHeader::SIGNATURE;
+		header.versionMadeBy = (zip::VERSION_MADE_BY::DOS_OS2 << 8) | version;
+		header.versionNeededToExtract = version;
+		header.generalPurposeBitFlag = FLAG_UTF8_NAMES;
+		header.compressionMethod = record.m_method;
+		header.lastModTime = DOS_TIME;
+		header.lastModDate = DOS_DATE;
+		header.crc32 = record.m_crc;
+		header.compressedSize = static_cast<u32>(std::min<u64>(record.m_compressedSize, ZIP64_LIMIT));
+		header.uncompressedSize = static_cast<u32>(std::min<u64>(record.m_size, ZIP64_LIMIT));
+		header.filenameLength = static_cast<u16>(record.m_name.length());
+		header.extrafieldLength = extraCount > 0 ? static_cast<u16>(sizeof(zip::ExtraFieldHeader) + extraCount * sizeof(u64)) : 0;
+		header.fileCommentLength = 0;
+		header.diskNumberStart = 0;
+		header.internalFileAttributes = 0;
+		header.externalFileAttributes = record.m_name.back() == '/' ? FILE_ATTRIBUTE_DIRECTORY : 0;
+		header.relOffsetOfLocalHeader = static_cast<u32>(std::min<u64>(record.m_offset, ZIP64_LIMIT));
+
+		if (!ioWrite(&header, sizeof(header)) || !ioWrite(record.m_name.c_str(), record.m_name.length()))
+		{
+			return false;
+		}
+
+		if (extraCount > 0)
+		{
+			zip::ExtraFieldHeader extra;
+			extra.headerId = zip::ExtraFieldHeader::ZIP64_EXTENDED_INFORMATION;
+			extra.dataSize = static_cast<u16>(extraCount * sizeof(u64));
+			if (!ioWrite(&extra, sizeof(extra)) || !ioWrite(extraValues, extraCount * sizeof(u64)))
+			{
+				return false;
+			}
+		}
+	}
+	const u64 centralDirSize = m_offset - centralDirOffset;
+	const u64 entries = m_records.size();
+
+	if (entries >= ZIP64_ENTRIES_LIMIT || centralDirOffset >= ZIP64_LIMIT || centralDirSize >= ZIP64_LIMIT)
+	{
+		const u64 zip64EndOffset = m_offset;
+
+		zip::ZIP64EndOfCentralDirectory end64;
+		end64.signature = zip::ZIP64EndOfCentralDirectory::SIGNATURE;
+		end64.sizeOfCentralDirRecord = sizeof(end64) - 12;
+		end64.versionMadeBy = VERSION_ZIP64;
+		end64.versionNeededToExtract = VERSION_ZIP64;
+		end64.diskNumber = 0;
+		end64.startCentralDirDiskNumber = 0;
+		end64.centralDirEntriesOnDisk = entries;
+		end64.centralDirTotalEntries = entries;
+		end64.centralDirSize = centralDirSize;
+		end64.centralDirOffsetStartDisk = centralDirOffset;
+
+		zip::ZIP64EndOfCentralDirectoryLocator locator;
+		locator.signature = zip::ZIP64EndOfCentralDirectoryLocator::SIGNATURE;
+		locator.diskNumber = 0;
+		locator.relativeOffset = zip64EndOffset;
+		locator.totalNumDisks = 1;
+
+		if (!ioWrite(&end64, sizeof(end64)) || !ioWrite(&locator, sizeof(locator)))
+		{
+			return false;
+		}
+	}
+
+	zip::EndOfCentralDirectory end;
+	end.signature = zip::EndOfCentralDirectory::SIGNATURE;
+	end.diskNumber = 0;
+	end.startDisk = 0;
+	end.startOffset = static_cast<u16>(std::min<u64>(entries, ZIP64_ENTRIES_LIMIT));
+	end.numEntries = static_cast<u16>(std::min<u64>(entries, ZIP64_ENTRIES_LIMIT));
+	end.size = static_cast<u32>(std::min<u64>(centralDirSize, ZIP64_LIMIT));
+	end.offset = static_cast<u32>(std::min<u64>(centralDirOffset, ZIP64_LIMIT));
+	end.zipCommentLength = 0;
+	return ioWrite(&end, sizeof(end));
+}
+
+bool ZipOutputSink::ioWrite(const void *buffer, size_t size)
+{
+	if (size == 0)
+	{
+		return true;
+	}
+	if (m_output->write(buffer, 1, size) != size)
+	{
+		return false;
+	}
+	m_offset += size;
+	return true;
+}
+
+/* eof */
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/fs/zip_sink.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "output_sink.h"
+
+#include <condition_variable>
+
+class ThreadPool;
+
+/**
+ * @brief: Writes all of the received files into a single zip archive.
+ *
+ * Entries are deflated in parallel on the internal thread pool and appended to the
+ * archive in the order they were received, the ones compressed early wait for the
+ * previous ones. ZIP64 records are written when the archive needs them.
+ * The archive is complete after finish() returns.
+ */
+class ZipOutputSink : public OutputSink
+{
+public:
+	/**
+	 * @param[in] output The archive file opened for writing
+	 * @param[in] deflate Whether entries should be deflated or stored
+	 * @param[in] threads The number of compression threads, 0 means one per hardware thread
+	 */
+	ZipOutputSink(UniquePtr<File> output, bool deflate = true, size_t threads = 0);
+	virtual ~ZipOutputSink();
+
+	virtual bool receive(const String &path, const void *data, size_t size) override;
+	virtual bool finish() override;
+
+private:
+	struct Record
+	{
+		String m_name;
+		u32 m_crc;
+		u16 m_method;
+		u64 m_size;
+		u64 m_compressedSize;
+		u64 m_offset;
+	};
+
+	struct Compressed
+	{
+		Record m_record;
+		Array<u8> m_payload;	// deflated or stored data
+	};
+
+private:
+	void compressEntry(u64 sequence, const String &name, Array<u8> &&data);
+	bool writeEntry(Record &record, const u8 *data);
+	bool writeCentralDirectory();
+	bool ioWrite(const void *buffer, size_t size);
+
+private:
+	UniquePtr<File> m_output;
+	UniquePtr<ThreadPool> m_pool;
+	bool m_deflate;
+	bool m_finished = false;
+
+	std::mutex m_writeMutex;
+	Array<Record> m_records;
+	Map<u64, Compressed> m_compressed;	// waiting for the previous entries, by sequence
+	u64 m_nextWrite = 0;
+	u64 m_offset = 0;
+	bool m_failed = false;
+
+	std::mutex m_pendingMutex;
+	std::condition_variable m_pendingReleased;
+	size_t m_pendingBytes = 0;	// received but not yet written
+	u64 m_received = 0;
+};
+
+/* eof */
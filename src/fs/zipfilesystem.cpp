@@ -27,8 +27,13 @@
 #include "sysfilesystem.h"
 #include "file.h"
 #include "zipfs_file.h"
+#include "decompression_cache.h"
+#include "inflate_reader.h"
+
+#include <config.h>
 
 #include <structs/zip.h>
+#include <utils/thread_pool.h>
 
 #include <zlib/zlib.h>
 
@@ -50,6 +55,7 @@ ZipFileSystem::ZipFileSystem(const String &root)
 
 ZipFileSystem::~ZipFileSystem()
 {
+	getDecompressionCache()->remove(this);
 }
 
 String ZipFileSystem::root() const
@@ -73,6 +79,56 @@ UniquePtr<File> ZipFileSystem::open(const String &filename, FsOpenMode mode)
 	return std::make_unique<ZipFsFile>(filename, this, entry);
 }
 
+UniquePtr<File> ZipFileSystem::open(PathId path, FsOpenMode mode)
+{
+	ZipEntry *const entry = findEntry(path);
+	if (!entry)
+	{
+		return UniquePtr<File>();
+	}
+
+	return std::make_unique<ZipFsFile>(getPaths()->string(path), this, entry);
+}
+
+FileSystem::AsyncRead ZipFileSystem::readWholeAsync(PathId path)
+{
+	const ZipEntry *const entry = findEntry(path);
+	if (!entry || entry->m_directory)
+	{
+		return readyRead(UniquePtr<Array<u8>>());
+	}
+
+	return getIoPool()->submit([this, path, entry]() {
+		const String filename = getPaths()->string(path);
+		auto contents = std::make_unique<Array<u8>>(static_cast<size_t>(entry->m_size));
+		if (entry->m_compressed)
+		{
+			Array<u8> compressed(static_cast<size_t>(entry->m_compressedSize));
+			if (!ioRead(compressed.data(), compressed.size(), entry->m_offset)
+			 || !InflateReader::inflateWhole(filename, compressed.data(), compressed.size(), contents->data(), contents->size(), -MAX_WBITS))
+			{
+				error("zipfs", filename, "Unable to read the entry!");
+				return UniquePtr<Array<u8>>();
+			}
+		}
+		else if (!ioRead(contents->data(), contents->size(), entry->m_offset))
+		{
+			error("zipfs", filename, "Unable to read the entry!");
+			return UniquePtr<Array<u8>>();
+		}
+
+		if (Config::s_verifyOnRead)
+		{
+			const u32 crc = Crc32::compute(contents->data(), contents->size());
+			if (crc != entry->m_crc)
+			{
+				error_f("zipfs", filename, "CRC mismatch (stored: %08X, computed: %08X)!", entry->m_crc, crc);
+			}
+		}
+		return contents;
+	});
+}
+
 bool ZipFileSystem::mkdir(const String &directory)
 {
 	return false;
@@ -104,6 +160,33 @@ bool ZipFileSystem::exists(const String &filename)
 	return true;
 }
 
+bool ZipFileSystem::exists(PathId path)
+{
+	if (!path.valid())
+	{
+		return false;
+	}
+
+	ZipEntry *const entry = findEntry(path);
+	return entry && !entry->m_directory;
+}
+
+bool ZipFileSystem::fileSize(PathId path, u64 &size)
+{
+	if (!path.valid())
+	{
+		return false;
+	}
+
+	const ZipEntry *const entry = findEntry(path);
+	if (!entry || entry->m_directory)
+	{
+		return false;
+	}
+	size = entry->m_size;
+	return true;
+}
+
 bool ZipFileSystem::dirExists(const String &dirpath)
 {
 	if (dirpath.empty())
@@ -157,11 +240,11 @@ auto ZipFileSystem::readDir(const String &path, bool absolutePaths, bool recursi
 			String directorypath;
 			if (absolutePaths)
 			{
-				directorypath = removeSlashAtEnd(dirpath) + "/" + e->m_name;
+				directorypath = getPaths()->string(e->m_path);
 			}
 			else
 			{
-				directorypath = e->m_name;
+				directorypath = e->name();
 			}
 			result->push_back(Entry(directorypath, true, false, this));
 			if (recursive)
@@ -178,11 +261,11 @@ auto ZipFileSystem::readDir(const String &path, bool absolutePaths, bool recursi
 			String filepath;
 			if (absolutePaths)
 			{
-				filepath = removeSlashAtEnd(dirpath) + "/" + e->m_name;
+				filepath = getPaths()->string(e->m_path);
 			}
 			else
 			{
-				filepath = e->m_name;
+				filepath = e->name();
 			}
 			result->push_back(Entry(filepath, false, false, this));
 		}
@@ -191,8 +274,42 @@ auto ZipFileSystem::readDir(const String &path, bool absolutePaths, bool recursi
 	return result;
 }
 
+bool ZipFileSystem::verify(ThreadPool &pool)
+{
+	Array<std::future<bool>> results;
+	results.reserve(m_entries.size());
+	for (const auto &entry : m_entries)
+	{
+		if (entry.second.m_directory)
+		{
+			continue;
+		}
+
+		const ZipEntry *const e = &entry.second;
+		results.push_back(pool.submit([this, e]() {
+			ZipFsFile file(m_rootFilename + ":" + getPaths()->str(e->m_path), this, e);
+			return file.verify();
+		}));
+	}
+
+	size_t damaged = 0;
+	for (auto &result : results)
+	{
+		damaged += result.get() ? 0 : 1;
+	}
+
+	if (damaged > 0)
+	{
+		error_f("zipfs", m_rootFilename, "Verification failed, %u of %u entries are damaged!", damaged, results.size());
+		return false;
+	}
+	info_f("zipfs", m_rootFilename, "Verified %u entries", results.size());
+	return true;
+}
+
 bool ZipFileSystem::ioRead(void *const buffer, uint64_t bytes, uint64_t offset)
 {
+	std::lock_guard<std::mutex> lock(m_ioMutex);
 	return m_root->blockRead(buffer, offset, bytes);
 }
 
@@ -200,8 +317,7 @@ void ZipFileSystem::readZip()
 {
 	ZipEntry rootEntry;
 	rootEntry.m_directory = true;
-	rootEntry.m_name = "";
-	rootEntry.m_path = "/";
+	rootEntry.m_path = getPaths()->intern("/", 1);
 	registerEntry(rootEntry);
 
 	const uint64_t size = m_root->size();
@@ -242,49 +358,85 @@ void ZipFileSystem::readZip()
 		return;
 	}
 
-	const uint16_t numEntriesLimit = 60000;
-	if (centralDirEnd->numEntries > numEntriesLimit)
+	uint64_t numEntries = centralDirEnd->numEntries;
+	uint64_t centralDirOffset = centralDirEnd->offset;
+
+	if (centralDirEnd->numEntries == 0xFFFF || centralDirEnd->offset == 0xFFFFFFFF)
 	{
-		error_f("zipfs", m_rootFilename, "The number of files(%u) exceeded limits(%u).", centralDirEnd->numEntries, numEntriesLimit);
+		const uint64_t centralDirEndOffset = size - blockSizeToFindCentralDirEnd + (reinterpret_cast<uint8_t *>(centralDirEnd) - blockToFindCentralDirEnd.get());
+
+		zip::ZIP64EndOfCentralDirectoryLocator locator;
+		if (centralDirEndOffset < sizeof(locator)
+		 || !m_root->blockRead(&locator, centralDirEndOffset - sizeof(locator), sizeof(locator))
+		 || locator.signature != zip::ZIP64EndOfCentralDirectoryLocator::SIGNATURE)
+		{
+			error("zipfs", m_rootFilename, "Cannot find the zip::ZIP64EndOfCentralDirectoryLocator structure!");
+			return;
+		}
+
+		zip::ZIP64EndOfCentralDirectory centralDirEnd64;
+		if (!m_root->blockRead(&centralDirEnd64, locator.relativeOffset, sizeof(centralDirEnd64))
+		 || centralDirEnd64.signature != zip::ZIP64EndOfCentralDirectory::SIGNATURE)
+		{
+			error("zipfs", m_rootFilename, "Failed to read the zip::ZIP64EndOfCentralDirectory structure!");
+			return;
+		}
+
+		numEntries = centralDirEnd64.centralDirTotalEntries;
+		centralDirOffset = centralDirEnd64.centralDirOffsetStartDisk;
+	}
+
+	const uint64_t numEntriesLimit = 1000000;
+	if (numEntries > numEntriesLimit)
+	{
+		error_f("zipfs", m_rootFilename, "The number of files(%llu) exceeded limits(%llu).", numEntries, numEntriesLimit);
 		return;
 	}
 
-	for (size_t e = 0, currentOffset = centralDirEnd->offset; e < centralDirEnd->numEntries; ++e)
+	uint8_t extrafieldBuffer[0x10000];
+	for (uint64_t e = 0, currentOffset = centralDirOffset; e < numEntries; ++e)
 	{
 		zip::CentralDirectoryFileHeader entry;
 		if (!m_root->blockRead(&entry, currentOffset, sizeof(zip::CentralDirectoryFileHeader)))
 		{
-			error_f("zipfs", m_rootFilename, "Failed to read central directory data(%u)!", e);
+			error_f("zipfs", m_rootFilename, "Failed to read central directory data(%llu)!", e);
 			return;
 		}
 
 		if (entry.signature != zip::CentralDirectoryFileHeader::SIGNATURE)
 		{
-			error_f("zipfs", m_rootFilename, "Central directory data(%u) has invalid signature!", e);
+			error_f("zipfs", m_rootFilename, "Central directory data(%llu) has invalid signature!", e);
 			return;
 		}
 
 		if (entry.filenameLength == 0 || entry.filenameLength > 255)
 		{
-			error_f("zipfs", m_rootFilename, "Central directory data(%u) has invalid name!", e);
+			error_f("zipfs", m_rootFilename, "Central directory data(%llu) has invalid name!", e);
 			return;
 		}
 
 		char filenameBuffer[256] = { 0 };
 		if (!m_root->blockRead(filenameBuffer, currentOffset + sizeof(zip::CentralDirectoryFileHeader), entry.filenameLength))
 		{
-			error_f("zipfs", m_rootFilename, "Failed to read name of directory data(%u)!", e);
+			error_f("zipfs", m_rootFilename, "Failed to read name of directory data(%llu)!", e);
 			return;
 		}
 		const String filename = filenameBuffer;
 
+		if (entry.extrafieldLength > 0
+		 && !m_root->blockRead(extrafieldBuffer, currentOffset + sizeof(zip::CentralDirectoryFileHeader) + entry.filenameLength, entry.extrafieldLength))
+		{
+			error_f("zipfs", m_rootFilename, "Failed to read extra field of directory data(%llu)!", e);
+			return;
+		}
+
 		if (entry.compressionMethod != zip::COMPRESSION_METHOD::STORED && entry.compressionMethod != zip::COMPRESSION_METHOD::DEFLATED)
 		{
 			error_f("zipfs", m_rootFilename, "Unsupported compression method(%s : %u)!", filename.c_str(), entry.compressionMethod);
 			return;
 		}
 
-		processEntry(trimSlashesAtEnd(trimSlashesAtBegin(filename)), &entry);
+		processEntry(trimSlashesAtEnd(trimSlashesAtBegin(filename)), &entry, entry.extrafieldLength > 0 ? extrafieldBuffer : nullptr);
 
 		currentOffset += sizeof(zip::CentralDirectoryFileHeader)
 			+ entry.filenameLength
@@ -295,10 +447,31 @@ void ZipFileSystem::readZip()
 	link();
 }
 
-void ZipFileSystem::processEntry(const String &name, zip::CentralDirectoryFileHeader *entry)
+void ZipFileSystem::processEntry(const String &name, zip::CentralDirectoryFileHeader *entry, const uint8_t *extrafield)
 {
 	ZipEntry zipentry;
 
+	uint64_t uncompressedSize = entry->uncompressedSize;
+	uint64_t compressedSize = entry->compressedSize;
+	uint64_t localHeaderOffset = entry->relOffsetOfLocalHeader;
+
+	// values which do not fit into 32 bits are stored in the ZIP64 extended information
+	for (size_t offset = 0; extrafield && offset + sizeof(zip::ExtraFieldHeader) <= entry->extrafieldLength;)
+	{
+		const zip::ExtraFieldHeader *const header = reinterpret_cast<const zip::ExtraFieldHeader *>(extrafield + offset);
+		offset += sizeof(zip::ExtraFieldHeader);
+		if (header->headerId == zip::ExtraFieldHeader::ZIP64_EXTENDED_INFORMATION)
+		{
+			const uint64_t *value = reinterpret_cast<const uint64_t *>(extrafield + offset);
+			const uint64_t *const end = reinterpret_cast<const uint64_t *>(extrafield + std::min<size_t>(offset + header->dataSize, entry->extrafieldLength));
+			if (uncompressedSize == 0xFFFFFFFF && value < end) uncompressedSize = *value++;
+			if (compressedSize == 0xFFFFFFFF && value < end) compressedSize = *value++;
+			if (localHeaderOffset == 0xFFFFFFFF && value < end) localHeaderOffset = *value++;
+			break;
+		}
+		offset += header->dataSize;
+	}
+
 	const uint8_t versionMadeBy = entry->versionMadeBy & 0xff00;
 
 	if (versionMadeBy == zip::VERSION_MADE_BY::WINDOWS_NTFS
@@ -312,7 +485,7 @@ void ZipFileSystem::processEntry(const String &name, zip::CentralDirectoryFileHe
 		else
 		{
 			zipentry.m_directory = false;
-			zipentry.m_offset = entry->relOffsetOfLocalHeader;
+			zipentry.m_offset = localHeaderOffset;
 		}
 	}
 	else if (versionMadeBy == zip::VERSION_MADE_BY::UNIX)
@@ -324,7 +497,7 @@ void ZipFileSystem::processEntry(const String &name, zip::CentralDirectoryFileHe
 		else
 		{
 			zipentry.m_directory = false;
-			zipentry.m_offset = entry->relOffsetOfLocalHeader;
+			zipentry.m_offset = localHeaderOffset;
 		}
 	}
 	else
@@ -333,18 +506,7 @@ void ZipFileSystem::processEntry(const String &name, zip::CentralDirectoryFileHe
 		return;
 	}
 
-	if (zipentry.m_directory)
-	{
-		String dirname = trimSlashesAtEnd(trimSlashesAtBegin(name));
-		zipentry.m_name = dirname.substr(dirname.find_last_of('/') + 1);
-		zipentry.m_path = "/" + dirname;
-	}
-	else
-	{
-		String filename = trimSlashesAtEnd(trimSlashesAtBegin(name));
-		zipentry.m_name = filename.substr(filename.find_last_of('/') + 1);
-		zipentry.m_path = "/" + filename;
-	}
+	zipentry.m_path = getPaths()->intern("/" + trimSlashesAtEnd(trimSlashesAtBegin(name)));
 
 	if (!zipentry.m_directory)
 	{
@@ -362,8 +524,9 @@ void ZipFileSystem::processEntry(const String &name, zip::CentralDirectoryFileHe
 		}
 
 		zipentry.m_compressed = entry->compressionMethod == zip::COMPRESSION_METHOD::DEFLATED;
-		zipentry.m_size = entry->uncompressedSize;
-		zipentry.m_compressedSize = entry->compressedSize;
+		zipentry.m_size = uncompressedSize;
+		zipentry.m_compressedSize = compressedSize;
+		zipentry.m_crc = entry->crc32;
 
 		zipentry.m_offset = zipentry.m_offset + sizeof(zip::LocalFileHeader) + localEntry.filenameLength + localEntry.extrafieldLength;
 	}
@@ -380,79 +543,51 @@ void ZipFileSystem::processEntry(const String &name, zip::CentralDirectoryFileHe
 
 ZipEntry *ZipFileSystem::registerEntry(const ZipEntry &entry)
 {
-	if (ZipEntry *existing = findEntry(entry.m_path))
+	const u64 hash = getPaths()->hash(entry.m_path);
+	auto it = m_entries.find(hash);
+	if (it != m_entries.end())
 	{
-		return existing;
+		return &it->second;
 	}
-	const uint64_t hash = prism::city_hash_64(entry.m_path.c_str() + 1, entry.m_path.length() - 1);
-	ZipEntry *const e = &(m_entries[hash] = entry);
-	return e;
+	return &(m_entries[hash] = entry);
 }
 
 void ZipFileSystem::link()
 {
-	Array<ZipEntry> toRegister;
+	PathTable *const paths = getPaths();
+	const PathId root = paths->intern("/", 1);
 
-	for (Pair<const u64, ZipEntry> &entry : m_entries)
+	// the archives may omit the entries of directories, they are created from the paths of their content
+	Array<PathId> directories;
+	for (const Pair<const u64, ZipEntry> &entry : m_entries)
 	{
-		ZipEntry *const e = &entry.second;
-		if (e->m_path != "/")
+		if (entry.second.m_path != root)
 		{
-			String directory = trimSlashesAtEnd(trimSlashesAtBegin(e->m_path.substr(0, e->m_path.find_last_of('/'))));
-			ZipEntry *dir = findEntry("/" + directory);
-			if (!dir)
-			{
-				auto dirit = std::find_if(toRegister.begin(), toRegister.end(),
-					[directory](ZipEntry &e)
-					{
-						return e.path() == ("/" + directory);
-					});
-				if (dirit == toRegister.end())
-				{
-					ZipEntry newDirEntry;
-					newDirEntry.m_directory = true;
-					newDirEntry.m_name = directory.substr(directory.find_last_of('/') + 1);
-					newDirEntry.m_path = "/" + directory;
-					newDirEntry.m_compressed = false;
-					newDirEntry.m_size = 0;
-					newDirEntry.m_compressedSize = 0;
-					newDirEntry.m_offset = 0;
-					toRegister.push_back(newDirEntry);
-				}
-			}
+			directories.push_back(paths->parent(entry.second.m_path));
 		}
 	}
-
-	for (size_t i = 0; i < toRegister.size(); ++i)
+	while (!directories.empty())
 	{
-		ZipEntry entry = toRegister[i];
-		if (entry.m_path != "/" && !entry.m_path.empty())
+		const PathId directory = directories.back();
+		directories.pop_back();
+		if (!directory.valid() || findEntry(directory))
 		{
-			ZipEntry *const e = registerEntry(entry);
-			String directory = trimSlashesAtEnd(trimSlashesAtBegin(e->m_path.substr(0, e->m_path.find_last_of('/'))));
-			ZipEntry *dir = findEntry("/" + directory);
-			if (!dir)
-			{
-				ZipEntry newDirEntry;
-				newDirEntry.m_directory = true;
-				newDirEntry.m_name = directory.substr(directory.find_last_of('/') + 1);
-				newDirEntry.m_path = "/" + directory;
-				newDirEntry.m_compressed = false;
-				newDirEntry.m_size = 0;
-				newDirEntry.m_compressedSize = 0;
-				newDirEntry.m_offset = 0;
-				toRegister.push_back(newDirEntry);
-			}
+			continue;
 		}
+
+		ZipEntry newDirEntry;
+		newDirEntry.m_directory = true;
+		newDirEntry.m_path = directory;
+		registerEntry(newDirEntry);
+		directories.push_back(paths->parent(directory));
 	}
 
 	for (Pair<const u64, ZipEntry> &entry : m_entries)
 	{
 		ZipEntry *const e = &entry.second;
-		if (e->m_path != "/")
+		if (e->m_path != root)
 		{
-			String directory = trimSlashesAtEnd(trimSlashesAtBegin(e->m_path.substr(0, e->m_path.find_last_of('/'))));
-			ZipEntry *dir = findEntry("/" + directory);
+			ZipEntry *dir = findEntry(paths->parent(e->m_path));
 			assert(dir);
 			dir->addChild(e);
 		}
@@ -461,8 +596,16 @@ void ZipFileSystem::link()
 
 auto ZipFileSystem::findEntry(const String &path) -> ZipEntry *
 {
-	const u64 hash = prism::city_hash_64(path.c_str() + 1, path.length() - 1);
+	return findEntry(PathTable::hash(path.c_str(), path.length()));
+}
+
+auto ZipFileSystem::findEntry(PathId path) -> ZipEntry *
+{
+	return findEntry(getPaths()->hash(path));
+}
 
+auto ZipFileSystem::findEntry(u64 hash) -> ZipEntry *
+{
 	auto it = m_entries.find(hash);
 	if (it != m_entries.end())
 	{
@@ -488,7 +631,7 @@ void ZipEntry::addChild(ZipEntry *e)
 		 ++it)
 	{
 		ZipEntry *current = (*it);
-		if (e->m_name < current->m_name)
+		if (strcmp(e->name(), current->name()) < 0)
 		{
 			m_children.insert(it, e);
 			return;
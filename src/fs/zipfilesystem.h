@@ -26,6 +26,8 @@
 
 #include <structs/zip.h>
 
+#include <mutex>
+
 class ZipEntry;
 
 class ZipFileSystem : public FileSystem
@@ -37,25 +39,33 @@ public:
 	virtual String root() const override;
 	virtual String name() const override;
 	virtual UniquePtr<File> open(const String &filename, FsOpenMode mode) override;
+	virtual UniquePtr<File> open(PathId path, FsOpenMode mode) override;
 	virtual bool mkdir(const String &directory) override;
 	virtual bool rmdir(const String &directory) override;
 	virtual bool exists(const String &filename) override;
+	virtual bool exists(PathId path) override;
+	virtual bool fileSize(PathId path, u64 &size) override;
+	virtual AsyncRead readWholeAsync(PathId path) override;
 	virtual bool dirExists(const String &dirpath) override;
 	virtual UniquePtr<List<Entry>> readDir(const String &path, bool absolutePaths, bool recursive) override;
+	virtual bool verify(ThreadPool &pool) override;
 
 	bool ioRead(void *const buffer, uint64_t bytes, uint64_t offset);
 
 private:
 	void readZip();
-	void processEntry(const String &name, zip::CentralDirectoryFileHeader *entry);
+	void processEntry(const String &name, zip::CentralDirectoryFileHeader *entry, const uint8_t *extrafield);
 	ZipEntry *registerEntry(const ZipEntry &entry);
 	void link();
 
 	ZipEntry *findEntry(const String &path);
+	ZipEntry *findEntry(PathId path);
+	ZipEntry *findEntry(u64 hash);
 
 private:
 	String m_rootFilename;
 	UniquePtr<File> m_root;
+	std::mutex m_ioMutex;
 
 	Map<u64, ZipEntry> m_entries;
 
@@ -68,20 +78,22 @@ public:
 	~ZipEntry();
 
 	void addChild(ZipEntry *e);
-	const String &path() const { return m_path; }
+	PathId path() const { return m_path; }
+	const char *name() const { return getPaths()->name(m_path); }
 
 private:
 	bool m_directory;
 
-	String m_path;
-	String m_name;
+	PathId m_path;
 
-	uint32_t m_offset = 0;
+	uint64_t m_offset = 0;
 
 	bool m_compressed = false;
 
-	size_t m_size = 0;
-	size_t m_compressedSize = 0;
+	uint64_t m_size = 0;
+	uint64_t m_compressedSize = 0;
+
+	uint32_t m_crc = 0;
 
 	Array<ZipEntry *> m_children;
 
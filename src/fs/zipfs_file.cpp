@@ -26,24 +26,32 @@
 
 #include "zipfilesystem.h"
 
+#include "inflate_reader.h"
+
+#include <config.h>
+
 ZipFsFile::ZipFsFile(const String &filepath, ZipFileSystem *filesystem, const class ZipEntry *entry)
 	: m_filepath(filepath)
 	, m_filesystem(filesystem)
 	, m_entry(entry)
 	, m_position(0)
+	, m_verify(Config::s_verifyOnRead)
 {
 	if (m_entry->m_compressed)
 	{
-		inflateInitialize();
+		const uint64_t offset = m_entry->m_offset;
+		m_inflate = std::make_unique<InflateReader>(m_filepath,
+			[filesystem, offset](void *buffer, uint64_t bytes, uint64_t position) {
+				return filesystem->ioRead(buffer, bytes, offset + position);
+			},
+			m_entry->m_compressedSize, m_entry->m_size, -MAX_WBITS,
+			m_entry->m_size > InflateIndex::SPAN ? getDecompressionCache()->index(filesystem, offset) : SharedPtr<InflateIndex>()
+		);
 	}
 }
 
 ZipFsFile::~ZipFsFile()
 {
-	if (m_entry->m_compressed)
-	{
-		inflateDestroy();
-	}
 }
 
 uint64_t ZipFsFile::write(const void *buffer, uint64_t elementSize, uint64_t elementCount)
@@ -53,70 +61,25 @@ uint64_t ZipFsFile::write(const void *buffer, uint64_t elementSize, uint64_t ele
 
 uint64_t ZipFsFile::read(void *buffer, uint64_t elementSize, uint64_t elementCount)
 {
-	if (!m_entry->m_compressed)
+	if (m_position >= m_entry->m_size)
 	{
-		if (m_position >= m_entry->m_size)
-		{
-			return 0;
-		}
+		return 0;
+	}
 
-		if (m_filesystem->ioRead(buffer, elementSize * elementCount, m_entry->m_offset + m_position))
-		{
-			uint64_t result = std::min(elementSize * elementCount, m_entry->m_size - m_position);
-			m_position += elementSize * elementCount;
-			if (m_position > m_entry->m_size)
-			{
-				m_position = m_entry->m_size;
-			}
-			return result;
-		}
-		else
-		{
-			return 0;
-		}
+	const uint64_t bytes = std::min(elementSize * elementCount, m_entry->m_size - m_position);
+	uint64_t result = 0;
+	if (m_inflate)
+	{
+		result = m_inflate->read(buffer, bytes, m_position);
 	}
-	else
+	else if (m_filesystem->ioRead(buffer, bytes, m_entry->m_offset + m_position))
 	{
-		const uint64_t chunk = 1024 * 4;
-		uint8_t inbuffer[chunk];
-		uint64_t bufferOffset = 0;
-
-		while (m_position < m_entry->m_compressedSize && bufferOffset < (elementSize * elementCount))
-		{
-			uint64_t left = m_entry->m_compressedSize - m_position;
-			uint64_t bytes = std::min(chunk, left);
-			if (bytes == 0) {
-				break;
-			}
-
-			if (!m_filesystem->ioRead(inbuffer, bytes, m_entry->m_offset + m_position))
-			{
-				error("zipfs", m_filepath, "Unable to read from filesystem file");
-				return 0;
-			}
-
-			m_stream.avail_in = static_cast<unsigned int>(bytes);
-			m_stream.next_in = inbuffer;
-
-			m_stream.avail_out = static_cast<unsigned int>((elementSize * elementCount) - bufferOffset);
-			m_stream.next_out = (uint8_t *)buffer + bufferOffset;
-
-			int ret = inflate(&m_stream, Z_NO_FLUSH);
-			assert(ret != Z_STREAM_ERROR);
-
-			if (ret != Z_OK && ret != Z_STREAM_END)
-			{
-				error_f("zipfs", m_filepath, "zLib error: %s", zError(ret));
-				return 0;
-			}
-
-			uint64_t wroteToBuffer = ((elementSize * elementCount) - bufferOffset) - m_stream.avail_out;
-			bufferOffset += wroteToBuffer;
-			assert(bufferOffset <= (elementSize * elementCount));
-			m_position += (bytes - m_stream.avail_in);
-		}
-		return bufferOffset;
+		result = bytes;
 	}
+
+	verifyRead(buffer, m_position, result);
+	m_position += result;
+	return result;
 }
 
 uint64_t ZipFsFile::size()
@@ -126,35 +89,19 @@ uint64_t ZipFsFile::size()
 
 bool ZipFsFile::seek(uint64_t offset, Attrib attr)
 {
-	if (m_entry->m_compressed)
+	if (attr == SeekSet)
 	{
-		if (offset == 0 && attr == SeekSet)
-		{
-			if (m_position != 0)
-			{
-				inflateDestroy();
-				inflateInitialize();
-			}
-			return true;
-		}
-		return false; // random access is not allowed
+		m_position = offset;
 	}
-	else
+	else if (attr == SeekCur)
 	{
-		if (attr == SeekSet)
-		{
-			m_position = offset;
-		}
-		else if (attr == SeekCur)
-		{
-			m_position += offset;
-		}
-		else if (attr == SeekEnd)
-		{
-			m_position = size() - offset;
-		}
-		return true;
+		m_position += offset;
+	}
+	else if (attr == SeekEnd)
+	{
+		m_position = size() - offset;
 	}
+	return true;
 }
 
 void ZipFsFile::rewind()
@@ -171,23 +118,62 @@ void ZipFsFile::flush()
 {
 }
 
-void ZipFsFile::inflateInitialize()
+bool ZipFsFile::verify()
 {
-	m_stream.zalloc = Z_NULL;
-	m_stream.zfree = Z_NULL;
-	m_stream.opaque = Z_NULL;
-	m_stream.avail_in = 0;
-	m_stream.next_in = Z_NULL;
-	if (inflateInit2(&m_stream, 0xFFFFFFF1) != Z_OK)
+	const bool verifyOnRead = m_verify;
+	m_verify = false;
+
+	Crc32 crc;
+	Array<u8> buffer(64 * 1024);
+	uint64_t total = 0;
+	for (uint64_t bytes; (bytes = read(buffer.data(), 1, buffer.size())) > 0; total += bytes)
 	{
-		error("zipfs", "", "Failed to inflate init");
-		return;
+		crc.update(buffer.data(), static_cast<size_t>(bytes));
 	}
+	m_verify = verifyOnRead;
+
+	if (total != m_entry->m_size)
+	{
+		error_f("zipfs", m_filepath, "Unable to read the whole entry (%llu of %llu bytes)!", total, m_entry->m_size);
+		return false;
+	}
+	if (crc.value() != m_entry->m_crc)
+	{
+		error_f("zipfs", m_filepath, "CRC mismatch (stored: %08X, computed: %08X)!", m_entry->m_crc, crc.value());
+		return false;
+	}
+	return true;
 }
 
-void ZipFsFile::inflateDestroy()
+void ZipFsFile::verifyRead(const void *buffer, uint64_t offset, uint64_t bytes)
 {
-	inflateEnd(&m_stream);
+	if (!m_verify)
+	{
+		return;
+	}
+
+	if (offset == 0)
+	{
+		m_crc.reset();
+		m_crcOffset = 0;
+	}
+	else if (offset != m_crcOffset)
+	{
+		m_crcOffset = UINT64_MAX; // random access, the checksum cannot be computed
+		return;
+	}
+
+	m_crc.update(buffer, static_cast<size_t>(bytes));
+	m_crcOffset += bytes;
+
+	if (m_crcOffset == m_entry->m_size)
+	{
+		m_crcOffset = UINT64_MAX;
+		if (m_crc.value() != m_entry->m_crc)
+		{
+			error_f("zipfs", m_filepath, "CRC mismatch (stored: %08X, computed: %08X)!", m_entry->m_crc, m_crc.value());
+		}
+	}
 }
 
 /* eof */
@@ -24,6 +24,8 @@
 
 #include "file.h"
 
+#include <utils/crc32.h>
+
 class ZipFsFile : public File
 {
 public:
@@ -43,17 +45,27 @@ public:
 	virtual uint64_t tell() const override;
 	virtual void flush() override;
 
+	/**
+	 * @brief: Reads the whole entry and compares its checksum with the one stored in the archive
+	 *
+	 * @return @c True if the checksums match
+	 */
+	bool verify();
+
 private:
 	String			m_filepath;
 	ZipFileSystem * m_filesystem;
-	z_stream		m_stream;
 	uint64_t		m_position;
+	UniquePtr<InflateReader> m_inflate;
+
+	Crc32			m_crc;
+	uint64_t		m_crcOffset = 0;
+	bool			m_verify;
 
 	const class ZipEntry *m_entry;
 
 private:
-	void inflateInitialize();
-	void inflateDestroy();
+	void verifyRead(const void *buffer, uint64_t offset, uint64_t bytes);
 
 	friend class ZipFileSystem;
 };
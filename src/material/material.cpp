@@ -30,6 +30,8 @@
 #include <texture/texture_object.h>
 #include <fs/file.h>
 #include <fs/uberfilesystem.h>
+#include <fs/prefetcher.h>
+#include <utils/emitter.h>
 
 Material::Attribute::Attribute()
 	: m_valueType(FLOAT)
@@ -236,6 +238,17 @@ bool Material::load(String filePath)
 		}
 	}
 
+	if (getPrefetcher()->enabled())
+	{
+		for (const auto &tex : m_textures)
+		{
+			if (!tex.texture().empty() && !ResourceLibrary::Get()->contains(tex.texture()))
+			{
+				getPrefetcher()->hint(tex.texture());
+			}
+		}
+	}
+
 	for (auto &tex : m_textures)
 	{
 		if (!tex.load())
@@ -249,62 +262,62 @@ bool Material::load(String filePath)
 
 String Material::toDefinition(const String &prefix) const
 {
-	String result;
-	result += prefix + "Material {\n";
+	Emitter out;
+	out << prefix << "Material {\n";
 	{
-		result += prefix + fmt::sprintf(TAB "Alias: \"%s\"\n", alias().c_str());
-		result += prefix + fmt::sprintf(TAB "Effect: \"%s\"\n", m_effect.c_str());
-		result += prefix + fmt::sprintf(TAB "Flags: %i\n", 0);
-		result += prefix + fmt::sprintf(TAB "AttributeCount: %i\n", (int32_t)m_attributes.size());
-		result += prefix + fmt::sprintf(TAB "TextureCount: %i\n", (int32_t)m_textures.size());
+		out << prefix << TAB "Alias: \"" << alias() << "\"\n";
+		out << prefix << TAB "Effect: \"" << m_effect << "\"\n";
+		out << prefix << TAB "Flags: 0\n";
+		out << prefix << TAB "AttributeCount: " << static_cast<int32_t>(m_attributes.size()) << "\n";
+		out << prefix << TAB "TextureCount: " << static_cast<int32_t>(m_textures.size()) << "\n";
 		for (size_t i = 0; i < m_attributes.size(); ++i)
 		{
 			const Attribute *const attr = &m_attributes[i];
-			result += prefix + TAB + "Attribute {\n";
+			out << prefix << TAB "Attribute {\n";
 			{
-				result += prefix + fmt::sprintf(TAB TAB "Format: %s" SEOL, attr->getFormat());
-				result += prefix + fmt::sprintf(TAB TAB "Tag: \"%s\"" SEOL, attr->m_name.c_str());
-				result += prefix + fmt::sprintf(TAB TAB "Value: ( ");
+				out << prefix << TAB TAB "Format: " << attr->getFormat() << SEOL;
+				out << prefix << TAB TAB "Tag: \"" << attr->m_name << "\"" SEOL;
+				out << prefix << TAB TAB "Value: ( ";
 				if (attr->m_valueType == Attribute::FLOAT)
 				{
 					for (uint32_t j = 0; j < attr->m_valueCount; ++j)
 					{
-						result += fmt::sprintf("%f ", attr->m_value[j]);
+						out << emit::real(attr->m_value[j]) << " ";
 					}
 				}
 				else
 				{
-					result += "\"" + attr->m_stringValue + "\" ";
+					out << "\"" << attr->m_stringValue << "\" ";
 				}
-				result += ")" SEOL;
+				out << ")" SEOL;
 			}
-			result += prefix + TAB + "}\n";
+			out << prefix << TAB "}\n";
 		}
 		for (size_t i = 0; i < m_textures.size(); ++i)
 		{
 			const Texture *const tex = &m_textures[i];
-			result += prefix + TAB + "Texture {\n";
+			out << prefix << TAB "Texture {\n";
 			{
-				result += prefix + fmt::sprintf(TAB TAB "Tag: \"texture[%i]:%s\"\n", (int)i, tex->m_textureName.c_str());
-				result += prefix + fmt::sprintf(TAB TAB "Value: \"%s\"\n", String(tex->m_texture.c_str()).substr(0, tex->m_texture.length() - 5).c_str());
+				out << prefix << TAB TAB "Tag: \"texture[" << static_cast<int>(i) << "]:" << tex->m_textureName << "\"\n";
+				out << prefix << TAB TAB "Value: \"" << tex->m_texture.substr(0, tex->m_texture.length() - 5) << "\"\n";
 			}
-			result += prefix + TAB + "}\n";
+			out << prefix << TAB "}\n";
 		}
 	}
-	result += prefix + "}\n";
-	return result;
+	out << prefix << "}\n";
+	return out.str();
 }
 
 String Material::toDeclaration(const String &prefix) const
 {
-	String result;
-	result += prefix + "Material {\n";
+	Emitter out;
+	out << prefix << "Material {\n";
 	{
-		result += prefix + fmt::sprintf(TAB "Alias: \"%s\"\n", alias().c_str());
-		result += prefix + fmt::sprintf(TAB "Effect: \"%s\"\n", m_effect.c_str());
+		out << prefix << TAB "Alias: \"" << alias() << "\"\n";
+		out << prefix << TAB "Effect: \"" << m_effect << "\"\n";
 	}
-	result += prefix + "}\n";
-	return result;
+	out << prefix << "}\n";
+	return out.str();
 }
 
 Pix::Value Material::toPixDefinition() const
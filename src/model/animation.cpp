@@ -29,17 +29,159 @@
 #include <fs/uberfilesystem.h>
 #include <structs/pma_0x03.h>
 #include <structs/pma_0x04.h>
+#include <structs/validator.h>
 #include <model/model.h>
 #include <pix/pix.h>
+#include <utils/thread_pool.h>
+#include <config.h>
 
 #include <glm/gtx/transform.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANIMATION_SSE2 1
+#include <emmintrin.h>
+#endif
+
 using namespace prism;
 
+namespace
+{
+	const size_t PARALLEL_KEYFRAMES = 4096;	// fewer keyframes of all bones are reduced by the calling thread
+
+	/**
+	 * @brief: Pool reducing the keyframes of the bones, shared by the conversion threads
+	 */
+	ThreadPool &reducePool()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	/**
+	 * @brief: Keyframe of one bone in the form the importer interpolates, every part padded to 4 floats
+	 */
+	struct Key
+	{
+		float m_translation[4];
+		float m_rotation[4];	// w, x, y, z
+		float m_scale[4];
+		float m_time;
+	};
+
+	/**
+	 * @brief: Checks the key against the given translation, rotation and scale
+	 *
+	 * The rotation matches also with the opposite sign, which represents the same orientation.
+	 * NaN (e.g. of normalized zero quaternion) never matches.
+	 */
+#ifdef ANIMATION_SSE2
+	bool matches(__m128 translation, __m128 rotation, __m128 scale, const Key &key, float tolerance)
+	{
+		const __m128 sign = _mm_set1_ps(-0.f);
+		const __m128 limit = _mm_set1_ps(tolerance);
+		const __m128 expected = _mm_loadu_ps(key.m_rotation);
+
+		const __m128 errorTS = _mm_max_ps(
+			_mm_andnot_ps(sign, _mm_sub_ps(translation, _mm_loadu_ps(key.m_translation))),
+			_mm_andnot_ps(sign, _mm_sub_ps(scale, _mm_loadu_ps(key.m_scale)))
+		);
+		if (_mm_movemask_ps(_mm_cmpnle_ps(errorTS, limit)) != 0)
+		{
+			return false;
+		}
+		return _mm_movemask_ps(_mm_cmpnle_ps(_mm_andnot_ps(sign, _mm_sub_ps(rotation, expected)), limit)) == 0
+			|| _mm_movemask_ps(_mm_cmpnle_ps(_mm_andnot_ps(sign, _mm_add_ps(rotation, expected)), limit)) == 0;
+	}
+#else
+	bool matches(const float *translation, const float *rotation, const float *scale, const Key &key, float tolerance)
+	{
+		bool same = true, opposite = true;
+		for (int i = 0; i < 4; ++i)
+		{
+			if (!(fabsf(translation[i] - key.m_translation[i]) <= tolerance) || !(fabsf(scale[i] - key.m_scale[i]) <= tolerance))
+			{
+				return false;
+			}
+			same = same && fabsf(rotation[i] - key.m_rotation[i]) <= tolerance;
+			opposite = opposite && fabsf(rotation[i] + key.m_rotation[i]) <= tolerance;
+		}
+		return same || opposite;
+	}
+#endif
+
+	/**
+	 * @brief: Checks that the key is reproduced within the tolerance by interpolating between the keys a and b
+	 *
+	 * Translation and scale are interpolated linearly, the rotation quaternion component-wise
+	 * and normalized, as the importers interpolate the channels of the decomposed matrices.
+	 */
+	bool reproduced(const Key &a, const Key &b, const Key &key, float tolerance)
+	{
+		const float span = b.m_time - a.m_time;
+		const float u = span > 0.f ? (key.m_time - a.m_time) / span : 0.f;
+#ifdef ANIMATION_SSE2
+		const __m128 factor = _mm_set1_ps(u);
+		const auto lerp = [&](const float *x, const float *y) {
+			const __m128 from = _mm_loadu_ps(x);
+			return _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(y), from), factor));
+		};
+		const __m128 rotation = lerp(a.m_rotation, b.m_rotation);
+		__m128 length = _mm_mul_ps(rotation, rotation);
+		length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(2, 3, 0, 1)));
+		length = _mm_add_ps(length, _mm_shuffle_ps(length, length, _MM_SHUFFLE(1, 0, 3, 2)));
+		return matches(lerp(a.m_translation, b.m_translation), _mm_div_ps(rotation, _mm_sqrt_ps(length)),
+			lerp(a.m_scale, b.m_scale), key, tolerance);
+#else
+		float translation[4], rotation[4], scale[4];
+		float length = 0.f;
+		for (int i = 0; i < 4; ++i)
+		{
+			translation[i] = a.m_translation[i] + (b.m_translation[i] - a.m_translation[i]) * u;
+			rotation[i] = a.m_rotation[i] + (b.m_rotation[i] - a.m_rotation[i]) * u;
+			scale[i] = a.m_scale[i] + (b.m_scale[i] - a.m_scale[i]) * u;
+			length += rotation[i] * rotation[i];
+		}
+		length = sqrtf(length);
+		for (float &component : rotation)
+		{
+			component /= length;
+		}
+		return matches(translation, rotation, scale, key, tolerance);
+#endif
+	}
+
+	/**
+	 * @brief: Checks that all keys equal the first one within the tolerance
+	 */
+	bool constant(const Array<Key> &keys, float tolerance)
+	{
+		const Key &first = keys.front();
+		for (const Key &key : keys)
+		{
+#ifdef ANIMATION_SSE2
+			if (!matches(_mm_loadu_ps(first.m_translation), _mm_loadu_ps(first.m_rotation), _mm_loadu_ps(first.m_scale), key, tolerance))
+#else
+			if (!matches(first.m_translation, first.m_rotation, first.m_scale, key, tolerance))
+#endif
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+} // namespace
+
 bool Animation::loadAnim0x03(const uint8_t *const buffer, const size_t size)
 {
 	using namespace prism::pma_0x03;
 
+	String diagnostic;
+	if (!validate_pma_0x03(buffer, size, diagnostic))
+	{
+		error_f("animation", m_filePath, "Animation file is malformed (%s)!", diagnostic);
+		return false;
+	}
+
 	pma_header_t *header = (pma_header_t *)(buffer);
 
 	m_totalLength = header->m_anim_length;
@@ -79,6 +221,13 @@ bool Animation::loadAnim0x04(const uint8_t *const buffer, const size_t size)
 {
 	using namespace prism::pma_0x04;
 
+	String diagnostic;
+	if (!validate_pma_0x04(buffer, size, diagnostic))
+	{
+		error_f("animation", m_filePath, "Animation file is malformed (%s)!", diagnostic);
+		return false;
+	}
+
 	pma_header_t *header = (pma_header_t *)(buffer);
 
 	m_totalLength = header->m_anim_length;
@@ -145,6 +294,12 @@ bool Animation::load(SharedPtr<Model> model, String filePath)
 	file->read((char *)buffer.get(), sizeof(uint8_t), fileSize);
 	file.reset();
 
+	if (fileSize == 0)
+	{
+		error("animation", m_filePath, "Animation file is empty!");
+		return false;
+	}
+
 	switch ((u8)buffer.get()[0])
 	{
 		case 0x03: return loadAnim0x03(buffer.get(), fileSize);
@@ -157,13 +312,61 @@ bool Animation::load(SharedPtr<Model> model, String filePath)
 	return false;
 }
 
+Array<uint32_t> Animation::reduceKeyframes(size_t boneIndex, float tolerance) const
+{
+	const JobArray<Frame> &frames = m_frames[boneIndex];
+	const size_t count = std::min(frames.size(), m_timeframes.size());
+
+	Array<uint32_t> kept;
+	if (count == 0)
+	{
+		return kept;
+	}
+
+	Array<Key> keys(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Frame &frame = frames[i];
+		keys[i] = {
+			{ frame.m_translation[0], frame.m_translation[1], frame.m_translation[2], 0.f },
+			{ frame.m_rotation.m_w, frame.m_rotation.m_x, frame.m_rotation.m_y, frame.m_rotation.m_z },
+			{ frame.m_scale[0], frame.m_scale[1], frame.m_scale[2], 0.f },
+			m_timeframes[i]
+		};
+	}
+
+	kept.push_back(0);
+	if (count > 1 && !constant(keys, tolerance))
+	{
+		// the segment from the last kept key grows while it reproduces all keys inside it
+		size_t anchor = 0;
+		for (size_t end = anchor + 2; end < count; ++end)
+		{
+			for (size_t k = anchor + 1; k < end; ++k)
+			{
+				if (!reproduced(keys[anchor], keys[end], keys[k], tolerance))
+				{
+					anchor = end - 1;
+					kept.push_back(static_cast<uint32_t>(anchor));
+					break;
+				}
+			}
+		}
+	}
+	if (count > 1)
+	{
+		kept.push_back(static_cast<uint32_t>(count - 1));
+	}
+	return kept;
+}
+
 void Animation::saveToPia(String exportPath) const
 {
 	const String piafile = exportPath + m_filePath + ".pia";
-	UniquePtr<File> file = getSFS()->open(piafile, FileSystem::write | FileSystem::binary);
+	UniquePtr<File> file = getOFS()->open(piafile, FileSystem::write | FileSystem::binary);
 	if (!file)
 	{
-		error_f("animation", piafile, "Unable to save file (%s)", getSFS()->getError());
+		error_f("animation", piafile, "Unable to save file (%s)", strerror(errno));
 		return;
 	}
 
@@ -210,6 +413,27 @@ void Animation::saveToPia(String exportPath) const
 		}
 	}
 
+	// the keyframes written for every bone, all of them unless reduced
+	const bool reduce = Config::s_keyframeTolerance > 0.f;
+	Array<Array<uint32_t>> keyframes(reduce ? m_bones.size() : 0);
+	if (reduce)
+	{
+		const auto task = [&](size_t boneIndex) {
+			keyframes[boneIndex] = reduceKeyframes(boneIndex, Config::s_keyframeTolerance);
+		};
+		if (m_bones.size() > 1 && m_bones.size() * m_timeframes.size() >= PARALLEL_KEYFRAMES)
+		{
+			reducePool().parallelFor(m_bones.size(), task);
+		}
+		else
+		{
+			for (size_t boneIndex = 0; boneIndex < m_bones.size(); ++boneIndex)
+			{
+				task(boneIndex);
+			}
+		}
+	}
+
 	for (size_t boneIndex = 0; boneIndex < m_bones.size(); ++boneIndex)
 	{
 		if (m_bones[boneIndex] >= m_model->boneCount())
@@ -220,29 +444,34 @@ void Animation::saveToPia(String exportPath) const
 
 		const auto bone = m_model->bone(m_bones[boneIndex]);
 
+		const size_t keyframeCount = reduce ? keyframes[boneIndex].size() : m_timeframes.size();
+		const auto frameIndex = [&](size_t keyframe) -> size_t {
+			return reduce ? keyframes[boneIndex][keyframe] : keyframe;
+		};
+
 		Pix::Value &channel = root["BoneChannel"];
 		channel["Name"] = bone->m_name;
 		channel["StreamCount"] = 2;
-		channel["KeyframeCount"] = m_timeframes.size();
+		channel["KeyframeCount"] = keyframeCount;
 
 		{
 			Pix::Value &stream = channel["Stream"];
 			stream["Format"] = Pix::Value::Enumeration("FLOAT");
 			stream["Tag"] = "_TIME";
-			stream.allocateIndexedObjects(m_timeframes.size());
-			for (size_t timeframe = 0; timeframe < m_timeframes.size(); ++timeframe)
+			stream.allocateIndexedObjects(keyframeCount);
+			for (size_t timeframe = 0; timeframe < keyframeCount; ++timeframe)
 			{
-				stream[timeframe] = Float1(m_timeframes[timeframe]);
+				stream[timeframe] = Float1(m_timeframes[frameIndex(timeframe)]);
 			}
 		}
 		{
 			Pix::Value &stream = channel["Stream"];
 			stream["Format"] = Pix::Value::Enumeration("FLOAT4x4");
 			stream["Tag"] = "_MATRIX";
-			stream.allocateIndexedObjects(m_timeframes.size());
-			for (size_t keyframe = 0; keyframe < m_timeframes.size(); ++keyframe)
+			stream.allocateIndexedObjects(keyframeCount);
+			for (size_t keyframe = 0; keyframe < keyframeCount; ++keyframe)
 			{
-				const Frame *frame = &m_frames[boneIndex][keyframe];
+				const Frame *frame = &m_frames[boneIndex][frameIndex(keyframe)];
 				const glm::vec3 trans = glm_cast(frame->m_translation);
 				const glm::quat rot = glm_cast(frame->m_rotation);
 				const glm::vec3 scale = glm_cast(frame->m_scale) * bone->m_signOfDeterminantOfMatrix;
@@ -24,6 +24,7 @@
 
 #include <math/quaternion.h>
 #include <math/vector.h>
+#include <utils/job_allocator.h>
 
 class Animation
 {
@@ -45,11 +46,23 @@ public:
 	bool loadAnim0x04(const uint8_t *const buffer, const size_t size);
 	void saveToPia(String exportPath) const;
 
+private:
+	/**
+	 * @brief: Selects the keyframes of the bone which the importer cannot interpolate from the others
+	 *
+	 * The first and the last keyframes are always kept, so constant bones keep two of them.
+	 *
+	 * @param[in] boneIndex The index of the bone channel
+	 * @param[in] tolerance The largest error of the translation, rotation and scale components
+	 * @return @c The indices of the kept keyframes, in ascending order
+	 */
+	Array<uint32_t> reduceKeyframes(size_t boneIndex, float tolerance) const;
+
 private:
 	float m_totalLength = 0.f;
 	Array<uint8_t> m_bones;
-	Array<Array<Frame>> m_frames; // @[bone][frame]
-	Array<float> m_timeframes;
+	Array<JobArray<Frame>> m_frames; // @[bone][frame]
+	JobArray<float> m_timeframes;
 	UniquePtr<Array<Float3>> m_movement;
 
 	String m_filePath;
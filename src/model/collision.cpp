@@ -28,6 +28,8 @@
 #include <fs/file.h>
 #include <fs/uberfilesystem.h>
 #include <fs/sysfilesystem.h>
+#include <structs/validator.h>
+#include <utils/emitter.h>
 
 bool Collision::load(Model *const model, String filePath)
 {
@@ -47,6 +49,12 @@ bool Collision::load(Model *const model, String filePath)
 	file->read((char *)buffer.get(), sizeof(char), fileSize);
 	file.reset();
 
+	if (fileSize < sizeof(prism::pmc_header_t))
+	{
+		error("collision", m_filePath, "Collision file is malformed!");
+		return false;
+	}
+
 	const auto header = reinterpret_cast<prism::pmc_header_t *>(buffer.get());
 	if (header->m_version != prism::pmc_header_t::SUPPORTED_VERSION)
 	{
@@ -54,6 +62,18 @@ bool Collision::load(Model *const model, String filePath)
 		return false;
 	}
 
+	String diagnostic;
+	if (!prism::validate_pmc(buffer.get(), fileSize, diagnostic))
+	{
+		error_f("collision", m_filePath, "Collision file is malformed (%s)!", diagnostic);
+		return false;
+	}
+	if (header->m_variant_count > m_model->getVariants().size())
+	{
+		error_f("collision", m_filePath, "Collision file has more variants than model (%i/%i)!", header->m_variant_count, m_model->getVariants().size());
+		return false;
+	}
+
 	for (size_t i = 0; i < header->m_piece_count; ++i)
 	{
 		const auto piecef = reinterpret_cast<prism::pmc_piece_t *>(buffer.get() + header->m_piece_offset) + i;
@@ -84,8 +104,6 @@ bool Collision::load(Model *const model, String filePath)
 		variant.m_modelVariant = &m_model->getVariants()[i];
 		for (size_t j = 0, currentOffset = 0; ; ++j)
 		{
-			assert((variantDef->m_offset + currentOffset) < fileSize);
-
 			const auto locatorf = reinterpret_cast<prism::pmc_locator_t *>(buffer.get() + variantDef->m_offset + currentOffset);
 			if (locatorf->m_data_size == -1)
 				break;
@@ -229,90 +247,74 @@ void Collision::assignPartToLocator(const SharedPtr<Locator> &loc, const size_t
 bool Collision::saveToPic(String exportPath) const
 {
 	const String picFilePath = exportPath + m_filePath + ".pic";
-	auto file = getSFS()->open(picFilePath, FileSystem::write | FileSystem::binary);
+	auto file = getOFS()->open(picFilePath, FileSystem::write | FileSystem::binary);
 	if (!file)
 	{
-		error_f("collision", picFilePath, "Unable to save file! (%s)", getSFS()->getError());
+		error_f("collision", picFilePath, "Unable to save file! (%s)", strerror(errno));
 		return false;
 	}
 
-	*file << fmt::sprintf(
+	Emitter out(file.get());
+
+	out <<
 		"Header {"							SEOL
 		TAB "FormatVersion: 2"				SEOL
-		TAB "Source: \"%s\""				SEOL
+		TAB "Source: \"" STRING_VERSION "\""	SEOL
 		TAB "Type: \"Collision\""			SEOL
-		TAB "Name: \"%s\""					SEOL
-		"}"									SEOL,
-			STRING_VERSION,
-			m_model->fileName().c_str()
-	);
+		TAB "Name: \"" << m_model->fileName() << "\""	SEOL
+		"}"									SEOL;
 
-	*file << fmt::sprintf(
+	out <<
 		"Global {"							SEOL
-		TAB "VertexCount: %u"				SEOL
-		TAB "TriangleCount: %u"				SEOL
-		TAB "MaterialCount: %u"				SEOL
-		TAB "PieceCount: %i"				SEOL
-		TAB "PartCount: %i"					SEOL
-		TAB "LocatorCount: %i"				SEOL
-		"}"									SEOL,
-			m_vertCount,
-			m_triangleCount,
-			(m_pieces.empty() ? 0 : 1),
-			(int)m_pieces.size(),
-			(int)m_model->getParts().size(),
-			(int)m_locators.size()
-	);
+		TAB "VertexCount: " << emit::uint(m_vertCount) << SEOL
+		TAB "TriangleCount: " << emit::uint(m_triangleCount) << SEOL
+		TAB "MaterialCount: " << emit::uint(m_pieces.empty() ? 0 : 1) << SEOL
+		TAB "PieceCount: " << m_pieces.size() << SEOL
+		TAB "PartCount: " << m_model->getParts().size() << SEOL
+		TAB "LocatorCount: " << m_locators.size() << SEOL
+		"}"									SEOL;
 
 	if (!m_pieces.empty())
 	{
-		*file << fmt::sprintf(
+		out <<
 			"Material {"						SEOL
-			TAB "Alias: \"%s\""					SEOL
-			TAB "Effect: \"%s\""				SEOL
-			"}"									SEOL,
-			"convex",
-			"dry.void"
-		);
+			TAB "Alias: \"convex\""			SEOL
+			TAB "Effect: \"dry.void\""		SEOL
+			"}"									SEOL;
 	}
 
 	for (size_t i = 0; i < m_pieces.size(); ++i)
 	{
 		const auto &piece = m_pieces[i];
-		*file << fmt::sprintf(
+		out <<
 			"Piece {"						SEOL
-			TAB "Index: %i"					SEOL
+			TAB "Index: " << i << SEOL
 			TAB "Material: 0"				SEOL
-			TAB "VertexCount: %i"			SEOL
-			TAB "TriangleCount: %i"			SEOL
-			TAB "StreamCount: 1"			SEOL,
-			(int)i, (int)piece.m_verts.size(), (int)piece.m_triangles.size()
-		);
-		*file << fmt::sprintf(
+			TAB "VertexCount: " << piece.m_verts.size() << SEOL
+			TAB "TriangleCount: " << piece.m_triangles.size() << SEOL
+			TAB "StreamCount: 1"			SEOL;
+		out <<
 			TAB "Stream {"					SEOL
 			TAB TAB "Format: FLOAT3"		SEOL
-			TAB TAB "Tag: \"_POSITION\""	SEOL
-		);
+			TAB TAB "Tag: \"_POSITION\""	SEOL;
 		for (size_t j = 0; j < piece.m_verts.size(); ++j)
 		{
-			*file << fmt::sprintf(
-				TAB TAB "%-5i( %s )"		SEOL,
-				j, prism::to_string(piece.m_verts[j]).c_str()
-			);
+			out << TAB TAB << emit::left<5>(j) << "( " << piece.m_verts[j] << " )" SEOL;
 		}
-		*file << TAB "}"					SEOL; // Stream {
+		out << TAB "}"						SEOL; // Stream {
 
-		*file << TAB "Triangles {"			SEOL;
+		out << TAB "Triangles {"			SEOL;
 		for (size_t j = 0; j < piece.m_triangles.size(); ++j)
 		{
-			*file << fmt::sprintf(
-				TAB TAB "%-5i( %-5i %-5i %-5i )" SEOL,
-				(int)j, piece.m_triangles[j].a[2], piece.m_triangles[j].a[1], piece.m_triangles[j].a[0]
-			);
+			const auto &triangle = piece.m_triangles[j];
+			out << TAB TAB << emit::left<5>(j) << "( "
+				<< emit::left<5>(triangle.a[2]) << " "
+				<< emit::left<5>(triangle.a[1]) << " "
+				<< emit::left<5>(triangle.a[0]) << " )" SEOL;
 		}
-		*file << TAB "}"					SEOL; // Triangles {
+		out << TAB "}"						SEOL; // Triangles {
 
-		*file << "}"						SEOL; // Piece {
+		out << "}"							SEOL; // Piece {
 	}
 
 	for (size_t i = 0; i < m_model->getParts().size(); ++i)
@@ -331,81 +333,73 @@ bool Collision::saveToPic(String exportPath) const
 		Array<int> pieces;
 		/* No idea what are pieces here */
 
-		*file << fmt::sprintf(
+		out <<
 			"Part {"						SEOL
-			TAB "Name: \"%s\""				SEOL
-			TAB "PieceCount: %i"			SEOL
-			TAB "LocatorCount: %i"			SEOL,
-				part.m_name.c_str(),
-				(int)pieces.size(),
-				(int)locators.size()
-		);
+			TAB "Name: \"" << part.m_name << "\""	SEOL
+			TAB "PieceCount: " << pieces.size() << SEOL
+			TAB "LocatorCount: " << locators.size() << SEOL;
 
-		*file << TAB "Pieces: ";
+		out << TAB "Pieces: ";
 		for (const auto piece : pieces)
 		{
-			*file << fmt::sprintf("%i ", piece);
+			out << piece << " ";
 		}
-		*file <<							SEOL;
+		out <<								SEOL;
 
-		*file << TAB "Locators: ";
+		out << TAB "Locators: ";
 		for (const auto loc : locators)
 		{
-			*file << fmt::sprintf("%i ", loc);
+			out << loc << " ";
 		}
-		*file <<							SEOL;
+		out <<								SEOL;
 
-		*file << "}"						SEOL; // Part {
+		out << "}"							SEOL; // Part {
 	}
 
 	for (const auto &locator : m_locators)
 	{
-		*file << locator->toDefinition() << SEOL;
+		locator->toDefinition(out);
+		out << SEOL;
 	}
 
 	return true;
 }
 
-String Collision::Locator::toDefinition() const
+void Collision::Locator::toDefinition(Emitter &out) const
 {
-	return
+	out <<
 		"Locator {" SEOL
-		TAB + fmt::sprintf("Name: \"%s\"" SEOL, m_name.c_str()) +
-		TAB + fmt::sprintf("Index: %i" SEOL, m_index) +
-		TAB + fmt::sprintf("Position: ( %s )" SEOL, prism::to_string(m_position)) +
-		TAB + fmt::sprintf("Rotation: ( %s )" SEOL, prism::to_string(m_rotation)) +
-		TAB + fmt::sprintf("Alias: \"%s\"" SEOL,  /* TODO: */ "") +
-		TAB + fmt::sprintf("Weight: " FLT_FT SEOL, flh(m_weight)) +
-		TAB + fmt::sprintf("Type: \"%s\"" SEOL, type().c_str())
-	;
+		TAB "Name: \"" << m_name << "\"" SEOL
+		TAB "Index: " << m_index << SEOL
+		TAB "Position: ( " << m_position << " )" SEOL
+		TAB "Rotation: ( " << m_rotation << " )" SEOL
+		TAB "Alias: \"\"" SEOL /* TODO: */
+		TAB "Weight: " << emit::hex(m_weight) << SEOL
+		TAB "Type: \"" << type() << "\"" SEOL;
 }
 
-String Collision::ConvexLocator::toDefinition() const
+void Collision::ConvexLocator::toDefinition(Emitter &out) const
 {
-	return Locator::toDefinition() +
-		TAB + fmt::sprintf("ConvexPiece: %i" SEOL, m_convexPiece) +
-	"}";
+	Locator::toDefinition(out);
+	out << TAB "ConvexPiece: " << m_convexPiece << SEOL "}";
 }
 
-String Collision::CylinderLocator::toDefinition() const
+void Collision::CylinderLocator::toDefinition(Emitter &out) const
 {
-	return Locator::toDefinition() +
-		TAB + fmt::sprintf("Parameters: ( " FLT_FT "  " FLT_FT "  " FLT_FT "  " FLT_FT " )" SEOL, flh(m_radius), flh(m_depth), 0, 0) +
-	"}";
+	Locator::toDefinition(out);
+	out << TAB "Parameters: ( " << emit::hex(m_radius) << "  " << emit::hex(m_depth) << "  " << emit::hex(0.f) << "  " << emit::hex(0.f) << " )" SEOL "}";
 }
 
-String Collision::BoxLocator::toDefinition() const
+void Collision::BoxLocator::toDefinition(Emitter &out) const
 {
-	return Locator::toDefinition() +
-		TAB + fmt::sprintf("Parameters: ( %s  " FLT_FT " )" SEOL, prism::to_string(m_scale), 0) +
-	"}";
+	Locator::toDefinition(out);
+	out << TAB "Parameters: ( " << m_scale << "  " << emit::hex(0.f) << " )" SEOL "}";
 }
 
-String Collision::SphereLocator::toDefinition() const
+void Collision::SphereLocator::toDefinition(Emitter &out) const
 {
-	return Locator::toDefinition() +
-		TAB + fmt::sprintf("Parameters: ( " FLT_FT "  " FLT_FT "  " FLT_FT "  " FLT_FT " )" SEOL, flh(m_radius), 0, 0, 0) +
-		"}";
+	Locator::toDefinition(out);
+	out << TAB "Parameters: ( " << emit::hex(m_radius) << "  " << emit::hex(0.f) << "  " << emit::hex(0.f) << "  " << emit::hex(0.f) << " )" SEOL "}";
 }
 
 /* eof */
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <structs/pmc.h>
+#include <utils/job_allocator.h>
 
 class Collision
 {
@@ -58,15 +59,15 @@ private:
 class Collision::Piece
 {
 public:
-	Array<prism::float3> m_verts;
-	Array<prism::pmc_triangle_t> m_triangles;
+	JobArray<prism::float3> m_verts;
+	JobArray<prism::pmc_triangle_t> m_triangles;
 };
 
 class Collision::Locator
 {
 public:
 	virtual String type() const = 0;
-	virtual String toDefinition() const;
+	virtual void toDefinition(Emitter &out) const;
 
 public:
 	int m_type = 0; // 1 - box, 2 - ..., 4 - ..., 8 - convex
@@ -82,7 +83,7 @@ class Collision::ConvexLocator : public Locator
 {
 public:
 	virtual String type() const override { return "Convex"; }
-	virtual String toDefinition() const override;
+	virtual void toDefinition(Emitter &out) const override;
 
 public:
 	unsigned int m_convexPiece = 0;
@@ -92,7 +93,7 @@ class Collision::CylinderLocator : public Locator
 {
 public:
 	virtual String type() const override { return "Cylinder"; }
-	virtual String toDefinition() const override;
+	virtual void toDefinition(Emitter &out) const override;
 
 public:
 	float m_radius;
@@ -103,7 +104,7 @@ class Collision::BoxLocator : public Locator
 {
 public:
 	virtual String type() const override { return "Box"; }
-	virtual String toDefinition() const override;
+	virtual void toDefinition(Emitter &out) const override;
 
 public:
 	Float3 m_scale;
@@ -113,7 +114,7 @@ class Collision::SphereLocator : public Locator
 {
 public:
 	virtual String type() const override { return "Sphere"; }
-	virtual String toDefinition() const override;
+	virtual void toDefinition(Emitter &out) const override;
 
 public:
 	float m_radius;
@@ -26,17 +26,24 @@
 
 #include <fs/file.h>
 #include <fs/uberfilesystem.h>
+#include <fs/prefetcher.h>
 #include <fs/sysfilesystem.h>
 
 #include <pix/pix.h>
+#include <pix/pix_parser.h>
 #include <resource_lib.h>
 #include <texture/texture.h>
+#include <texture/texture_object.h>
 #include <prefab/prefab.h>
 #include <model/collision.h>
+#include <utils/json.h>
+#include <utils/emitter.h>
+#include <config.h>
 
 #include <structs/pmg_0x13.h>
 #include <structs/pmg_0x14.h>
 #include <structs/pmg_0x15.h>
+#include <structs/validator.h>
 
 #include <glm/gtx/transform.hpp>
 
@@ -103,6 +110,12 @@ bool Model::loadModel()
 	file->read((char *)buffer.get(), sizeof(char), fileSize);
 	file.reset();
 
+	if (fileSize < sizeof(u32))
+	{
+		error("model", m_filePath, "Geometry file is malformed!");
+		return false;
+	}
+
 	const auto version = *(const u32 *)(buffer.get());
 	switch (version)
 	{
@@ -122,13 +135,19 @@ bool Model::loadModel0x13(const uint8_t *const buffer, const size_t size)
 {
 	using namespace prism::pmg_0x13;
 
-	if (size < sizeof(pmg_header_t))
+	String diagnostic;
+	if (!validate_pmg_0x13(buffer, size, diagnostic))
 	{
-		error("model", m_filePath, "Geometry file is malformed!");
+		error_f("model", m_filePath, "Geometry file is malformed (%s)!", diagnostic);
 		return false;
 	}
 
 	const auto header = (const pmg_header_t *)(buffer);
+	if (static_cast<size_t>(header->m_part_count) > m_parts.size())
+	{
+		error_f("model", m_filePath, "Geometry file has more parts than descriptor (%i/%i)!", header->m_part_count, m_parts.size());
+		return false;
+	}
 
 	m_pieces.resize(header->m_piece_count);
 	m_bones.resize(header->m_bone_count);
@@ -192,9 +211,8 @@ bool Model::loadModel0x13(const uint8_t *const buffer, const size_t size)
 		currentLocator->m_name = token_to_string(locator->m_name);
 
 		if (locator->m_name_block_offset != -1) {
-			currentLocator->m_hookup = String(
-				(const char *)(buffer + header->m_locator_name_offset + locator->m_name_block_offset)
-			).substr(0, header->m_locators_name_size - locator->m_name_block_offset);
+			const char *const hookup = (const char *)(buffer + header->m_locator_name_offset + locator->m_name_block_offset);
+			currentLocator->m_hookup = String(hookup, strnlen(hookup, header->m_locators_name_size - locator->m_name_block_offset));
 		}
 		else {
 			currentLocator->m_hookup = "";
@@ -211,6 +229,11 @@ bool Model::loadModel0x13(const uint8_t *const buffer, const size_t size)
 		currentPiece->m_bones = piece->m_bone_count;
 		currentPiece->m_material = piece->m_material;
 
+		if (static_cast<size_t>(piece->m_uv_channels) > Vertex::TEXCOORD_COUNT)
+		{
+			error_f("model", m_filePath, "Texture coordinate count in piece: %i exceeds maximum (%i/%i)!", i, piece->m_uv_channels, Vertex::TEXCOORD_COUNT);
+			return false;
+		}
 		if (piece->m_bone_count > Vertex::BONE_COUNT)
 		{
 			warning_f("model", m_filePath,
@@ -347,9 +370,10 @@ bool Model::loadModel0x14(const uint8_t *const buffer, const size_t size)
 {
 	using namespace prism::pmg_0x14;
 
-	if (size < sizeof(pmg_header_t))
+	String diagnostic;
+	if (!validate_pmg_0x14(buffer, size, diagnostic))
 	{
-		error("model", m_filePath, "Geometry file is malformed!");
+		error_f("model", m_filePath, "Geometry file is malformed (%s)!", diagnostic);
 		return false;
 	}
 
@@ -418,9 +442,8 @@ bool Model::loadModel0x14(const uint8_t *const buffer, const size_t size)
 		currentLocator->m_name = token_to_string(locator->m_name);
 
 		if (locator->m_hookup_offset != -1) {
-			currentLocator->m_hookup = String(
-				(const char *)(buffer + header->m_string_pool_offset + locator->m_hookup_offset)
-			).substr(0, header->m_string_pool_size - locator->m_hookup_offset);
+			const char *const hookup = (const char *)(buffer + header->m_string_pool_offset + locator->m_hookup_offset);
+			currentLocator->m_hookup = String(hookup, strnlen(hookup, header->m_string_pool_size - locator->m_hookup_offset));
 		}
 		else {
 			currentLocator->m_hookup = "";
@@ -437,6 +460,12 @@ bool Model::loadModel0x14(const uint8_t *const buffer, const size_t size)
 		currentPiece->m_bones = header->m_weight_width;
 		currentPiece->m_material = piece->m_material;
 
+		if (static_cast<size_t>(piece->m_texcoord_width) > Vertex::TEXCOORD_COUNT)
+		{
+			error_f("model", m_filePath, "Texture coordinate count in piece: %i exceeds maximum (%i/%i)!", i, piece->m_texcoord_width, Vertex::TEXCOORD_COUNT);
+			return false;
+		}
+
 		currentPiece->m_vertices.resize(piece->m_verts);
 		m_vertCount += piece->m_verts;
 
@@ -564,9 +593,10 @@ bool Model::loadModel0x15(const uint8_t *const buffer, const size_t size)
 {
 	using namespace prism::pmg_0x15;
 
-	if (size < sizeof(pmg_header_t))
+	String diagnostic;
+	if (!validate_pmg_0x15(buffer, size, diagnostic))
 	{
-		error("model", m_filePath, "Geometry file is malformed!");
+		error_f("model", m_filePath, "Geometry file is malformed (%s)!", diagnostic);
 		return false;
 	}
 
@@ -635,9 +665,8 @@ bool Model::loadModel0x15(const uint8_t *const buffer, const size_t size)
 		currentLocator->m_name = token_to_string(locator->m_name);
 
 		if (locator->m_hookup_offset != -1) {
-			currentLocator->m_hookup = String(
-				(const char *)(buffer + header->m_string_pool_offset + locator->m_hookup_offset)
-			).substr(0, header->m_string_pool_size - locator->m_hookup_offset);
+			const char *const hookup = (const char *)(buffer + header->m_string_pool_offset + locator->m_hookup_offset);
+			currentLocator->m_hookup = String(hookup, strnlen(hookup, header->m_string_pool_size - locator->m_hookup_offset));
 		}
 		else {
 			currentLocator->m_hookup = "";
@@ -654,6 +683,12 @@ bool Model::loadModel0x15(const uint8_t *const buffer, const size_t size)
 		currentPiece->m_bones = header->m_weight_width;
 		currentPiece->m_material = piece->m_material;
 
+		if (static_cast<size_t>(piece->m_texcoord_width) > Vertex::TEXCOORD_COUNT)
+		{
+			error_f("model", m_filePath, "Texture coordinate count in piece: %i exceeds maximum (%i/%i)!", i, piece->m_texcoord_width, Vertex::TEXCOORD_COUNT);
+			return false;
+		}
+
 		currentPiece->m_vertices.resize(piece->m_verts);
 		m_vertCount += piece->m_verts;
 
@@ -807,9 +842,27 @@ bool Model::loadDescriptor()
 		return false;
 	}
 
+	String diagnostic;
+	if (!validate_pmd(buffer.get(), fileSize, diagnostic))
+	{
+		error_f("model", m_filePath, "Descriptor file is malformed (%s)!", diagnostic);
+		return false;
+	}
+
 	m_materialCount = header->m_material_count;
 	m_looks.resize(header->m_look_count);
 
+	// the materials of all looks are read in the background while the first ones are being parsed
+	if (getPrefetcher()->enabled())
+	{
+		for (uint32_t i = 0; i < header->m_look_count * header->m_material_count; ++i)
+		{
+			const uint32_t offsetMaterial = *(uint32_t *)(buffer.get() + header->m_material_offset + i*sizeof(uint32_t));
+			const char *materialPath = (const char *)(buffer.get() + offsetMaterial);
+			getPrefetcher()->hint(materialPath[0] == '/' ? materialPath : (m_directory + "/" + materialPath));
+		}
+	}
+
 	for (uint32_t i = 0; i < m_looks.size(); ++i)
 	{
 		Look *currentLook = &m_looks[i];
@@ -918,7 +971,7 @@ bool Model::loadCollision()
 bool Model::saveToPim(String exportPath) const
 {
 	const String pimFilePath = exportPath + m_filePath + ".pim";
-	auto file = getSFS()->open(pimFilePath, FileSystem::write | FileSystem::binary);
+	auto file = getOFS()->open(pimFilePath, FileSystem::write | FileSystem::binary);
 	if (!file)
 	{
 		error_f("model", m_filePath, "Unable to save model file [%s] (%s)!", pimFilePath, strerror(errno));
@@ -1120,43 +1173,33 @@ bool Model::saveToPim(String exportPath) const
 	//Pix::StyledFileWriter writer;
 	//writer.write(file.get(), root);
 
-	*file << fmt::sprintf(
+	Emitter out(file.get());
+
+	out <<
 		"Header {"							SEOL
 		TAB "FormatVersion: 5"				SEOL
-		TAB "Source: \"%s\""				SEOL
+		TAB "Source: \"" STRING_VERSION "\""	SEOL
 		TAB "Type: \"Model\""				SEOL
-		TAB "Name: \"%s\""					SEOL
-		"}"									SEOL,
-			STRING_VERSION,
-			m_fileName.c_str()
-		);
+		TAB "Name: \"" << m_fileName << "\""	SEOL
+		"}"									SEOL;
 
-	*file << fmt::sprintf(
+	out <<
 		"Global {"							SEOL
-		TAB "VertexCount: %i"				SEOL
-		TAB "TriangleCount: %i"				SEOL
-		TAB "MaterialCount: %i"				SEOL
-		TAB "PieceCount: %i"				SEOL
-		TAB "PartCount: %i"					SEOL
-		TAB "BoneCount: %i"					SEOL
-		TAB "LocatorCount: %i"				SEOL
-		TAB "Skeleton: \"%s\""				SEOL
-		"}"									SEOL,
-			m_vertCount,
-			m_triangleCount,
-			m_materialCount,
-			(int)m_pieces.size(),
-			(int)m_parts.size(),
-			(int)m_bones.size(),
-			(int)m_locators.size(),
-			(m_fileName + ".pis").c_str()
-		);
+		TAB "VertexCount: " << m_vertCount << SEOL
+		TAB "TriangleCount: " << m_triangleCount << SEOL
+		TAB "MaterialCount: " << m_materialCount << SEOL
+		TAB "PieceCount: " << m_pieces.size() << SEOL
+		TAB "PartCount: " << m_parts.size() << SEOL
+		TAB "BoneCount: " << m_bones.size() << SEOL
+		TAB "LocatorCount: " << m_locators.size() << SEOL
+		TAB "Skeleton: \"" << m_fileName << ".pis\""	SEOL
+		"}"									SEOL;
 
 	if(m_looks.size() > 0)
 	{
 		for (uint32_t i = 0; i < m_materialCount; ++i)
 		{
-			*file << m_looks[0].m_materials[i].toDeclaration();
+			out << m_looks[0].m_materials[i].toDeclaration();
 		}
 	}
 
@@ -1164,79 +1207,55 @@ bool Model::saveToPim(String exportPath) const
 	{
 		const Piece *currentPiece = &m_pieces[i];
 
-		*file << fmt::sprintf(
+		out <<
 			"Piece {"						SEOL
-			TAB "Index: %i"					SEOL
-			TAB "Material: %i"				SEOL
-			TAB "VertexCount: %i"			SEOL
-			TAB "TriangleCount: %i"			SEOL
-			TAB "StreamCount: %i"			SEOL,
-				currentPiece->m_index,
-				currentPiece->m_material,
-				(int)currentPiece->m_vertices.size(),
-				(int)currentPiece->m_triangles.size(),
-				currentPiece->m_streamCount
-			);
+			TAB "Index: " << currentPiece->m_index << SEOL
+			TAB "Material: " << currentPiece->m_material << SEOL
+			TAB "VertexCount: " << currentPiece->m_vertices.size() << SEOL
+			TAB "TriangleCount: " << currentPiece->m_triangles.size() << SEOL
+			TAB "StreamCount: " << currentPiece->m_streamCount << SEOL;
 
 		if (currentPiece->m_position)
 		{
-			*file << fmt::sprintf(
+			out <<
 				TAB "Stream {"				SEOL
-				TAB TAB "Format: %s"		SEOL
-				TAB TAB "Tag: \"%s\""		SEOL,
-					"FLOAT3",
-					"_POSITION"
-				);
+				TAB TAB "Format: FLOAT3"	SEOL
+				TAB TAB "Tag: \"_POSITION\""	SEOL;
 
 			for (uint32_t j = 0; j < currentPiece->m_vertices.size(); ++j)
 			{
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %s )" SEOL,
-						j, to_string(currentPiece->m_vertices[j].m_position).c_str()
-					);
+				out << TAB TAB << emit::left<5>(j) << "( " << currentPiece->m_vertices[j].m_position << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 		}
 		if (currentPiece->m_normal)
 		{
-			*file << fmt::sprintf(
+			out <<
 				TAB "Stream {"				SEOL
-				TAB TAB "Format: %s"		SEOL
-				TAB TAB "Tag: \"%s\""		SEOL,
-					"FLOAT3",
-					"_NORMAL"
-				);
+				TAB TAB "Format: FLOAT3"	SEOL
+				TAB TAB "Tag: \"_NORMAL\""	SEOL;
 
 			for (uint32_t j = 0; j < currentPiece->m_vertices.size(); ++j)
 			{
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %s )" SEOL,
-						j, to_string(currentPiece->m_vertices[j].m_normal).c_str()
-					);
+				out << TAB TAB << emit::left<5>(j) << "( " << currentPiece->m_vertices[j].m_normal << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 		}
 		if (currentPiece->m_tangent)
 		{
-			*file << fmt::sprintf(
+			out <<
 				TAB "Stream {"				SEOL
-				TAB TAB "Format: %s"		SEOL
-				TAB TAB "Tag: \"%s\""		SEOL,
-					"FLOAT4",
-					"_TANGENT"
-				);
+				TAB TAB "Format: FLOAT4"	SEOL
+				TAB TAB "Tag: \"_TANGENT\""	SEOL;
 
 			for (uint32_t j = 0; j < currentPiece->m_vertices.size(); ++j)
 			{
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %s )" SEOL,
-						j, to_string(currentPiece->m_vertices[j].m_tangent).c_str()
-					);
+				out << TAB TAB << emit::left<5>(j) << "( " << currentPiece->m_vertices[j].m_tangent << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 		}
 		if (currentPiece->m_texcoord)
 		{
@@ -1244,156 +1263,128 @@ bool Model::saveToPim(String exportPath) const
 			{
 				Array<uint32_t> texCoords = currentPiece->texCoords(j);
 
-				*file << fmt::sprintf(
+				out <<
 					TAB "Stream {"				SEOL
 					TAB TAB "Format: FLOAT2"	SEOL
-					TAB TAB "Tag: \"_UV%i\""	SEOL
-					TAB TAB "AliasCount: %i"	SEOL
-					TAB TAB "Aliases: " ,
-						j, texCoords.size()
-					);
+					TAB TAB "Tag: \"_UV" << j << "\""	SEOL
+					TAB TAB "AliasCount: " << texCoords.size() << SEOL
+					TAB TAB "Aliases: ";
 
 				for (const uint32_t& texCoord : texCoords)
 				{
-					*file << fmt::sprintf("\"_TEXCOORD%i\" ", texCoord);
+					out << "\"_TEXCOORD" << texCoord << "\" ";
 				}
-				*file << SEOL;
+				out << SEOL;
 
 				for (uint32_t k = 0; k < currentPiece->m_vertices.size(); ++k)
 				{
-					*file << fmt::sprintf(
-						TAB TAB "%-5i( %s )" SEOL,
-							k, to_string(currentPiece->m_vertices[k].m_texcoords[j]).c_str()
-						);
+					out << TAB TAB << emit::left<5>(k) << "( " << currentPiece->m_vertices[k].m_texcoords[j] << " )" SEOL;
 				}
 
-				*file << TAB "}" SEOL;
+				out << TAB "}" SEOL;
 			}
 
 		}
 		if (currentPiece->m_color)
 		{
-			*file << fmt::sprintf(
+			out <<
 				TAB "Stream {" SEOL
-				TAB TAB "Format: %s" SEOL
-				TAB TAB "Tag: \"%s\"" SEOL,
-					"FLOAT4",
-					"_RGBA"
-				);
+				TAB TAB "Format: FLOAT4" SEOL
+				TAB TAB "Tag: \"_RGBA\"" SEOL;
 
 			for (uint32_t j = 0; j < currentPiece->m_vertices.size(); ++j)
 			{
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %s )" SEOL,
-						j, to_string(currentPiece->m_vertices[j].m_color).c_str()
-					);
+				out << TAB TAB << emit::left<5>(j) << "( " << currentPiece->m_vertices[j].m_color << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 		}
 
 		{ // triangles
-			*file << fmt::sprintf(
-				TAB "%s {" SEOL,
-					"Triangles"
-				);
+			out << TAB "Triangles {" SEOL;
 
 			for (uint32_t j = 0; j < currentPiece->m_triangles.size(); ++j)
 			{
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %-5i %-5i %-5i )" SEOL,
-						j, currentPiece->m_triangles[j].m_attach[0],
-						   currentPiece->m_triangles[j].m_attach[1],
-						   currentPiece->m_triangles[j].m_attach[2]
-					);
+				const Triangle &triangle = currentPiece->m_triangles[j];
+				out << TAB TAB << emit::left<5>(j) << "( "
+					<< emit::left<5>(triangle.m_attach[0]) << " "
+					<< emit::left<5>(triangle.m_attach[1]) << " "
+					<< emit::left<5>(triangle.m_attach[2]) << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 		}
-		*file << "}" SEOL; // piece
+		out << "}" SEOL; // piece
 	}
 
 	for (uint32_t i = 0; i < m_parts.size(); ++i)
 	{
 		const Part *currentPart = &m_parts[i];
 
-		*file << fmt::sprintf(
+		out <<
 			"Part {" SEOL
-			TAB "Name: \"%s\"" SEOL
-			TAB "PieceCount: %i" SEOL
-			TAB "LocatorCount: %i" SEOL,
-				currentPart->m_name.c_str(),
-				currentPart->m_pieceCount,
-				currentPart->m_locatorCount
-			);
-
-		*file << TAB "Pieces: ";
+			TAB "Name: \"" << currentPart->m_name << "\"" SEOL
+			TAB "PieceCount: " << currentPart->m_pieceCount << SEOL
+			TAB "LocatorCount: " << currentPart->m_locatorCount << SEOL;
+
+		out << TAB "Pieces: ";
 		for (uint32_t j = 0; j < currentPart->m_pieceCount; ++j)
 		{
-			*file << fmt::sprintf("%i ", currentPart->m_pieceId + j);
+			out << currentPart->m_pieceId + j << " ";
 		}
-		*file << SEOL;
+		out << SEOL;
 
-		*file << TAB "Locators: ";
+		out << TAB "Locators: ";
 		for (uint32_t j = 0; j < currentPart->m_locatorCount; ++j)
 		{
-			*file << fmt::sprintf("%i ", currentPart->m_locatorId + j);
+			out << currentPart->m_locatorId + j << " ";
 		}
-		*file << SEOL;
+		out << SEOL;
 
-		*file << "}" SEOL; // part
+		out << "}" SEOL; // part
 	}
 
 	for (uint32_t i = 0; i < m_locators.size(); ++i)
 	{
 		const Locator *currentLocator = &m_locators[i];
 
-		*file << fmt::sprintf(
+		out <<
 			"Locator {"										SEOL
-			TAB "Name: \"%s\""								SEOL,
-				currentLocator->m_name.c_str()
-			);
+			TAB "Name: \"" << currentLocator->m_name << "\""	SEOL;
 
 		if (currentLocator->m_hookup.length() > 0)
 		{
-			*file << fmt::sprintf(
-				TAB "Hookup: \"%s\""						SEOL,
-					currentLocator->m_hookup.c_str()
-				);
+			out << TAB "Hookup: \"" << currentLocator->m_hookup << "\"" SEOL;
 		}
 
-		*file << fmt::sprintf(
-			TAB "Index: %i"									SEOL
-			TAB "Position: ( %s )"							SEOL
-			TAB "Rotation: ( %s )"							SEOL
-			TAB "Scale: ( %s )"								SEOL,
-				currentLocator->m_index,
-				to_string(currentLocator->m_position).c_str(),
-				to_string(currentLocator->m_rotation).c_str(),
-				to_string(currentLocator->m_scale).c_str()
-			);
+		out <<
+			TAB "Index: " << currentLocator->m_index << SEOL
+			TAB "Position: ( " << currentLocator->m_position << " )" SEOL
+			TAB "Rotation: ( " << currentLocator->m_rotation << " )" SEOL
+			TAB "Scale: ( " << currentLocator->m_scale << " )" SEOL;
 
-		*file << "}" SEOL; // locator
+		out << "}" SEOL; // locator
 	}
 
 	if (m_bones.size() > 0)
 	{
-		*file << "Bones {" SEOL;
+		out << "Bones {" SEOL;
 		for (uint32_t i = 0; i < m_bones.size(); ++i)
 		{
-			*file << fmt::sprintf(TAB "%-5i( \"%s\" )" SEOL, i, m_bones[i].m_name.c_str());
+			out << TAB << emit::left<5>(i) << "( \"" << m_bones[i].m_name << "\" )" SEOL;
 		}
-		*file << "}" SEOL;
+		out << "}" SEOL;
 	}
 
 	if (m_skinVertCount > 0)
 	{
-		*file << "Skin {" SEOL;
-		*file << TAB "StreamCount: 1"			SEOL;
-		*file << TAB "SkinStream {"				SEOL;
+		out << "Skin {" SEOL;
+		out << TAB "StreamCount: 1"			SEOL;
+		out << TAB "SkinStream {"				SEOL;
 		unsigned itemIdx = 0, weightIdx = 0;
-		Array<String> skinStreams;
 
+		// the counts precede the items, so the items are collected first
+		Emitter items;
 		for (uint32_t i = 0; i < m_pieces.size(); ++i)
 		{
 			if (m_pieces[i].m_bones == 0)
@@ -1403,11 +1394,7 @@ bool Model::saveToPim(String exportPath) const
 			{
 				const Vertex *const vert = &m_pieces[i].m_vertices[j];
 
-				String skinStream;
-				skinStream += fmt::sprintf(
-					TAB TAB "%-6i( ( %s )" SEOL,
-					itemIdx, to_string(vert->m_position).c_str()
-				);
+				items << TAB TAB << emit::left<6>(itemIdx) << "( ( " << vert->m_position << " )" SEOL;
 
 				uint32_t weights = 0;
 				for (uint32_t k = 0; k < m_pieces[i].m_bones; ++k)
@@ -1419,64 +1406,265 @@ bool Model::saveToPim(String exportPath) const
 				}
 				weightIdx += weights;
 
-				skinStream += fmt::sprintf(
-					TAB TAB TAB TAB "Weights: %-6i ",
-					weights
-				);
+				items << TAB TAB TAB TAB "Weights: " << emit::left<6>(weights) << " ";
 
 				for (uint32_t k = 0; k < m_pieces[i].m_bones; ++k)
 				{
 					if (vert->m_boneWeight[k] != 0)
 					{
 						float weight = (float)vert->m_boneWeight[k] / 255.f;
-						skinStream += fmt::sprintf(
-							"%-4i " FLT_FT " ",
-							vert->m_boneIndex[k], flh(weight)
-						);
+						items << emit::left<4>(vert->m_boneIndex[k]) << " " << emit::hex(weight) << " ";
 					}
 				}
 
-				skinStream += SEOL;
+				items << SEOL;
 
-				skinStream += fmt::sprintf(
-					TAB TAB TAB TAB "Clones: %-6i %-4i %-6i" SEOL,
-					1, i, j
-				);
+				items << TAB TAB TAB TAB "Clones: " << emit::left<6>(1) << " " << emit::left<4>(i) << " " << emit::left<6>(j) << SEOL;
 
-				skinStream += TAB TAB "      )"				SEOL;
+				items << TAB TAB "      )"				SEOL;
 				++itemIdx;
+			}
+		}
+
+		out <<
+			TAB TAB "Format: FLOAT3"			SEOL
+			TAB TAB "Tag: \"_POSITION\""		SEOL
+			TAB TAB "ItemCount: " << itemIdx << SEOL
+			TAB TAB "TotalWeightCount: " << weightIdx << SEOL
+			TAB TAB "TotalCloneCount: " << itemIdx << SEOL;
+
+		out << items.str();
+		out << TAB "}" SEOL;
+		out << "}" SEOL;
+	}
+	return true;
+}
+
+namespace
+{
+	/**
+	 * @brief: Collects the piece streams and triangles of the parsed pim
+	 */
+	class PimPieceReader : public Pix::Handler
+	{
+	public:
+		struct Stream
+		{
+			String m_tag;
+			Array<float> m_values;
+		};
+
+		struct PieceData
+		{
+			Pix::Value::LargestInt m_index = -1;
+			Pix::Value::LargestInt m_material = -1;
+			Pix::Value::LargestInt m_vertexCount = -1;
+			Pix::Value::LargestInt m_triangleCount = -1;
+			Array<Stream> m_streams;
+			Array<Pix::Value::LargestInt> m_triangles;
+		};
+
+		Array<PieceData> m_pieces;
+
+	public:
+		virtual bool beginObject(const char *name, size_t length) override
+		{
+			++m_depth;
+			const String object(name, length);
+			if (m_depth == 1)
+			{
+				m_piece = object == "Piece";
+				if (m_piece)
+				{
+					m_pieces.emplace_back();
+				}
+			}
+			else if (m_depth == 2 && m_piece)
+			{
+				m_stream = object == "Stream";
+				m_triangles = object == "Triangles";
+				if (m_stream)
+				{
+					m_pieces.back().m_streams.emplace_back();
+				}
+			}
+			return true;
+		}
+
+		virtual bool endObject() override
+		{
+			if (m_depth == 2)
+			{
+				m_stream = m_triangles = false;
+			}
+			else if (m_depth == 1)
+			{
+				m_piece = false;
+			}
+			--m_depth;
+			return true;
+		}
 
-				skinStreams.push_back(skinStream);
+		virtual bool beginAttribute(const char *name, size_t length) override
+		{
+			m_attribute.assign(name, length);
+			return true;
+		}
+
+		virtual bool endAttribute() override
+		{
+			m_attribute.clear();
+			return true;
+		}
+
+		virtual bool intValue(Pix::Value::LargestInt value) override
+		{
+			if (m_triangles && m_attribute.empty())
+			{
+				m_pieces.back().m_triangles.push_back(value);
 			}
+			else if (m_piece && m_depth == 1)
+			{
+				PieceData &piece = m_pieces.back();
+				if (m_attribute == "Index") piece.m_index = value;
+				else if (m_attribute == "Material") piece.m_material = value;
+				else if (m_attribute == "VertexCount") piece.m_vertexCount = value;
+				else if (m_attribute == "TriangleCount") piece.m_triangleCount = value;
+			}
+			return true;
 		}
 
-		*file << fmt::sprintf(
-			TAB TAB "Format: %s"			SEOL
-			TAB TAB "Tag: \"%s\""			SEOL
-			TAB TAB "ItemCount: %i"			SEOL
-			TAB TAB "TotalWeightCount: %i"	SEOL
-			TAB TAB "TotalCloneCount: %i"	SEOL,
-				"FLOAT3",
-				"_POSITION",
-				itemIdx,
-				weightIdx,
-				itemIdx
-		);
+		virtual bool floatValue(float value) override
+		{
+			if (m_stream && m_attribute.empty())
+			{
+				m_pieces.back().m_streams.back().m_values.push_back(value);
+			}
+			return true;
+		}
 
-		for (const auto &stream : skinStreams)
+		virtual bool stringValue(const char *value, size_t length) override
 		{
-			*file << stream.c_str();
+			if (m_stream && m_attribute == "Tag")
+			{
+				m_pieces.back().m_streams.back().m_tag.assign(value, length);
+			}
+			return true;
 		}
-		*file << TAB "}" SEOL;
-		*file << "}" SEOL;
+
+	private:
+		int m_depth = 0;
+		bool m_piece = false;
+		bool m_stream = false;
+		bool m_triangles = false;
+		String m_attribute;
+	};
+}
+
+bool Model::checkPim(const String &name, const char *data, size_t size) const
+{
+	PimPieceReader reader;
+	Pix::Parser parser(&reader);
+	if (!parser.parse(name, data, size))
+	{
+		return false;
 	}
-	return true;
+
+	if (reader.m_pieces.size() != m_pieces.size())
+	{
+		error_f("roundtrip", name, "Piece count mismatch: %u != %u", reader.m_pieces.size(), m_pieces.size());
+		return false;
+	}
+
+	bool result = true;
+	for (size_t i = 0; i < m_pieces.size(); ++i)
+	{
+		const Piece &piece = m_pieces[i];
+		const auto &parsed = reader.m_pieces[i];
+
+		if (parsed.m_index != piece.m_index || parsed.m_material != piece.m_material
+		 || parsed.m_vertexCount != (Pix::Value::LargestInt)piece.m_vertices.size()
+		 || parsed.m_triangleCount != (Pix::Value::LargestInt)piece.m_triangles.size())
+		{
+			error_f("roundtrip", name, "Piece %u: header mismatch", i);
+			result = false;
+			continue;
+		}
+
+		const uint32_t streams = (piece.m_position ? 1 : 0) + (piece.m_normal ? 1 : 0) + (piece.m_tangent ? 1 : 0)
+			+ (piece.m_texcoord ? piece.m_texcoordCount : 0) + (piece.m_color ? 1 : 0);
+		if (parsed.m_streams.size() != streams)
+		{
+			error_f("roundtrip", name, "Piece %u: stream count mismatch: %u != %u", i, parsed.m_streams.size(), streams);
+			result = false;
+		}
+
+		for (const auto &stream : parsed.m_streams)
+		{
+			// the stream tags as written by saveToPim
+			enum { POSITION, NORMAL, TANGENT, COLOR, TEXCOORD } kind;
+			int uv = -1;
+			if (stream.m_tag == "_POSITION")				kind = POSITION;
+			else if (stream.m_tag == "_NORMAL")			kind = NORMAL;
+			else if (stream.m_tag == "_TANGENT")		kind = TANGENT;
+			else if (stream.m_tag == "_RGBA")			kind = COLOR;
+			else if (sscanf(stream.m_tag.c_str(), "_UV%i", &uv) == 1
+				&& uv >= 0 && uv < (int)Vertex::TEXCOORD_COUNT)	kind = TEXCOORD;
+			else
+			{
+				warning_f("roundtrip", name, "Piece %u: unknown stream %s", i, stream.m_tag);
+				continue;
+			}
+
+			Array<float> expected;
+			expected.reserve(piece.m_vertices.size() * 4);
+			for (const Vertex &vertex : piece.m_vertices)
+			{
+				switch (kind)
+				{
+					case POSITION:	expected.insert(expected.end(), &vertex.m_position[0], &vertex.m_position[0] + 3);		break;
+					case NORMAL:	expected.insert(expected.end(), &vertex.m_normal[0], &vertex.m_normal[0] + 3);			break;
+					case TANGENT:	expected.insert(expected.end(), &vertex.m_tangent[0], &vertex.m_tangent[0] + 4);		break;
+					case COLOR:		expected.insert(expected.end(), &vertex.m_color[0], &vertex.m_color[0] + 4);			break;
+					case TEXCOORD:	expected.insert(expected.end(), &vertex.m_texcoords[uv][0], &vertex.m_texcoords[uv][0] + 2);	break;
+				}
+			}
+
+			// compare the bits, the floats are stored in hex so nothing may be lost
+			if (expected.size() != stream.m_values.size()
+			 || memcmp(expected.data(), stream.m_values.data(), expected.size() * sizeof(float)) != 0)
+			{
+				error_f("roundtrip", name, "Piece %u: stream %s differs", i, stream.m_tag);
+				result = false;
+			}
+		}
+
+		Array<Pix::Value::LargestInt> triangles;
+		for (const Triangle &triangle : piece.m_triangles)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				triangles.push_back(triangle.m_attach[k]);
+			}
+		}
+		if (triangles != parsed.m_triangles)
+		{
+			error_f("roundtrip", name, "Piece %u: triangles differ", i);
+			result = false;
+		}
+	}
+
+	if (result)
+	{
+		info_f("roundtrip", name, "%u pieces match", m_pieces.size());
+	}
+	return result;
 }
 
 bool Model::saveToPit(String exportPath) const
 {
 	const String pitFilePath = exportPath + m_filePath + ".pit";
-	auto file = getSFS()->open(pitFilePath, FileSystem::write | FileSystem::binary);
+	auto file = getOFS()->open(pitFilePath, FileSystem::write | FileSystem::binary);
 	if (!file)
 	{
 		error_f("model", m_filePath, "Unable to save trait file [%s] (%s)!", pitFilePath, strerror(errno));
@@ -1535,58 +1723,299 @@ bool Model::saveToPis(String exportPath) const
 		return false;
 
 	const String pitFilePath = exportPath + m_filePath + + ".pis";
-	auto file = getSFS()->open(pitFilePath, FileSystem::write | FileSystem::binary);
+	auto file = getOFS()->open(pitFilePath, FileSystem::write | FileSystem::binary);
 	if (!file)
 	{
 		error_f("model", m_filePath, "Unable to save skeleton file [%s] (%s)!", pitFilePath, strerror(errno));
 		return false;
 	}
 
-	*file << fmt::sprintf(
+	Emitter out(file.get());
+
+	out <<
 		"Header {"					SEOL
 		TAB "FormatVersion: 1"		SEOL
-		TAB "Source: \"%s\""		SEOL
+		TAB "Source: \"" STRING_VERSION "\""	SEOL
 		TAB "Type: \"Skeleton\""	SEOL
-		TAB "Name: \"%s\""			SEOL
-		"}"							SEOL,
-			STRING_VERSION,
-			m_fileName.c_str()
-		);
+		TAB "Name: \"" << m_fileName << "\""	SEOL
+		"}"							SEOL;
 
-	*file << fmt::sprintf(
+	out <<
 		"Global {"					SEOL
-		TAB "BoneCount: %i"			SEOL
-		"}"							SEOL,
-			(int)m_bones.size()
-		);
+		TAB "BoneCount: " << m_bones.size() << SEOL
+		"}"							SEOL;
 
-	*file << "Bones {"				SEOL;
+	out << "Bones {"				SEOL;
 	{
 		for (size_t i = 0; i < m_bones.size(); ++i)
 		{
 			prism::mat4 mat = glm_cast(m_bones[i].m_transformation);
 
-			*file << fmt::sprintf(
-				TAB "%-5i ( Name:  \"%s\""													SEOL
-				TAB TAB "   Parent: \"%s\""													SEOL
-				TAB TAB "   Matrix: ( " FLT_FT "  " FLT_FT "  " FLT_FT "  " FLT_FT ""		SEOL
-				TAB TAB "             " FLT_FT "  " FLT_FT "  " FLT_FT "  " FLT_FT ""		SEOL
-				TAB TAB "             " FLT_FT "  " FLT_FT "  " FLT_FT "  " FLT_FT ""		SEOL
-				TAB TAB "             " FLT_FT "  " FLT_FT "  " FLT_FT "  " FLT_FT " )"		SEOL
-				TAB "  )" SEOL,
-					(int)i, m_bones[i].m_name.c_str(),
-					(m_bones[i].m_parent != 0xff ? m_bones[m_bones[i].m_parent].m_name.c_str() : ""),
-					flh(mat[0][0]), flh(mat[1][0]), flh(mat[2][0]), flh(mat[3][0]),
-					flh(mat[0][1]), flh(mat[1][1]), flh(mat[2][1]), flh(mat[3][1]),
-					flh(mat[0][2]), flh(mat[1][2]), flh(mat[2][2]), flh(mat[3][2]),
-					flh(mat[0][3]), flh(mat[1][3]), flh(mat[2][3]), flh(mat[3][3])
-				);
+			out <<
+				TAB << emit::left<5>(i) << " ( Name:  \"" << m_bones[i].m_name << "\""		SEOL
+				TAB TAB "   Parent: \"" << (m_bones[i].m_parent != 0xff ? m_bones[m_bones[i].m_parent].m_name : String()) << "\""	SEOL
+				TAB TAB "   Matrix: ( " << emit::hex(mat[0][0]) << "  " << emit::hex(mat[1][0]) << "  " << emit::hex(mat[2][0]) << "  " << emit::hex(mat[3][0]) << SEOL
+				TAB TAB "             " << emit::hex(mat[0][1]) << "  " << emit::hex(mat[1][1]) << "  " << emit::hex(mat[2][1]) << "  " << emit::hex(mat[3][1]) << SEOL
+				TAB TAB "             " << emit::hex(mat[0][2]) << "  " << emit::hex(mat[1][2]) << "  " << emit::hex(mat[2][2]) << "  " << emit::hex(mat[3][2]) << SEOL
+				TAB TAB "             " << emit::hex(mat[0][3]) << "  " << emit::hex(mat[1][3]) << "  " << emit::hex(mat[2][3]) << "  " << emit::hex(mat[3][3]) << " )"	SEOL
+				TAB "  )" SEOL;
 		}
 	}
-	*file << "}"					SEOL;
+	out << "}"						SEOL;
 	return true;
 }
 
+bool Model::saveToGlb(String exportPath) const
+{
+	const String glbFilePath = exportPath + m_filePath + ".glb";
+	auto file = getOFS()->open(glbFilePath, FileSystem::write | FileSystem::binary);
+	if (!file)
+	{
+		error_f("model", m_filePath, "Unable to save model file [%s] (%s)!", glbFilePath, strerror(errno));
+		return false;
+	}
+
+	enum
+	{
+		GL_UNSIGNED_BYTE = 5121,
+		GL_UNSIGNED_INT = 5125,
+		GL_FLOAT = 5126,
+		GL_ARRAY_BUFFER = 34962,
+		GL_ELEMENT_ARRAY_BUFFER = 34963
+	};
+
+	Array<uint8_t> binary;
+	String bufferViews, accessors;
+	size_t viewCount = 0, accessorCount = 0;
+
+	// every view starts at 4-byte boundary, as required by the float components
+	const auto addView = [&](const void *data, size_t size, size_t stride, int target) -> size_t {
+		const size_t offset = binary.size();
+		binary.insert(binary.end(), static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + size);
+		binary.resize((binary.size() + 3) & ~static_cast<size_t>(3));
+		bufferViews += fmt::sprintf("%s{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":%u", viewCount ? "," : "", offset, size);
+		bufferViews += stride ? fmt::sprintf(",\"byteStride\":%u", stride) : "";
+		bufferViews += target ? fmt::sprintf(",\"target\":%i}", target) : "}";
+		return viewCount++;
+	};
+	const auto addAccessor = [&](size_t view, size_t offset, int componentType, size_t count, const char *type, const String &extra = "") -> size_t {
+		accessors += fmt::sprintf("%s{\"bufferView\":%u,\"byteOffset\":%u,\"componentType\":%i,\"count\":%u,\"type\":\"%s\"%s}",
+			accessorCount ? "," : "", view, offset, componentType, count, type, extra);
+		return accessorCount++;
+	};
+	const auto vec3 = [](const Float3 &v) -> String {
+		return fmt::sprintf("[%.9g,%.9g,%.9g]", v[0], v[1], v[2]);
+	};
+	const auto matrix = [](const glm::mat4 &m) -> String {
+		String result = "[";
+		for (int i = 0; i < 16; ++i)
+		{
+			result += fmt::sprintf("%s%.9g", i ? "," : "", m[i / 4][i % 4]);
+		}
+		return result + "]";
+	};
+
+	// vertices are stored as they are decoded, attributes are interleaved in the Vertex layout
+	Array<String> primitives(m_pieces.size());
+	bool skinned = !m_bones.empty();
+	for (size_t i = 0; i < m_pieces.size(); ++i)
+	{
+		const Piece &piece = m_pieces[i];
+		if (piece.m_vertices.empty() || piece.m_triangles.empty())
+			continue;
+
+		const size_t count = piece.m_vertices.size();
+		const size_t vertices = addView(piece.m_vertices.data(), count * sizeof(Vertex), sizeof(Vertex), GL_ARRAY_BUFFER);
+
+		Float3 min = piece.m_vertices[0].m_position, max = min;
+		for (const Vertex &vertex : piece.m_vertices)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				min[k] = std::min(min[k], vertex.m_position[k]);
+				max[k] = std::max(max[k], vertex.m_position[k]);
+			}
+		}
+
+		String attributes = fmt::sprintf("\"POSITION\":%u", addAccessor(vertices, offsetof(Vertex, m_position), GL_FLOAT, count, "VEC3",
+			fmt::sprintf(",\"min\":%s,\"max\":%s", vec3(min), vec3(max))));
+		if (piece.m_normal)
+		{
+			attributes += fmt::sprintf(",\"NORMAL\":%u", addAccessor(vertices, offsetof(Vertex, m_normal), GL_FLOAT, count, "VEC3"));
+		}
+		if (piece.m_tangent)
+		{
+			attributes += fmt::sprintf(",\"TANGENT\":%u", addAccessor(vertices, offsetof(Vertex, m_tangent), GL_FLOAT, count, "VEC4"));
+		}
+		if (piece.m_texcoord)
+		{
+			for (uint32_t j = 0; j < piece.m_texcoordCount && j < Vertex::TEXCOORD_COUNT; ++j)
+			{
+				attributes += fmt::sprintf(",\"TEXCOORD_%u\":%u", j,
+					addAccessor(vertices, offsetof(Vertex, m_texcoords) + j * sizeof(Float2), GL_FLOAT, count, "VEC2"));
+			}
+		}
+		if (piece.m_color)
+		{
+			attributes += fmt::sprintf(",\"COLOR_0\":%u", addAccessor(vertices, offsetof(Vertex, m_color), GL_FLOAT, count, "VEC4"));
+		}
+		if (piece.m_color2)
+		{
+			attributes += fmt::sprintf(",\"COLOR_1\":%u", addAccessor(vertices, offsetof(Vertex, m_color2), GL_FLOAT, count, "VEC4"));
+		}
+
+		if (piece.m_bones > 0 && skinned)
+		{
+			// unused slots hold index 0xff, which is not a valid joint even with zero weight
+			const size_t sets = piece.m_bones > 4 ? 2 : 1;
+			Array<uint8_t> joints(count * Vertex::BONE_COUNT);
+			for (size_t j = 0; j < count; ++j)
+			{
+				for (size_t k = 0; k < Vertex::BONE_COUNT; ++k)
+				{
+					const uint8_t index = piece.m_vertices[j].m_boneIndex[k];
+					joints[j * Vertex::BONE_COUNT + k] = index < m_bones.size() && k < sets * 4 ? index : 0;
+				}
+			}
+			const size_t jointView = addView(joints.data(), joints.size(), Vertex::BONE_COUNT, GL_ARRAY_BUFFER);
+			for (size_t set = 0; set < sets; ++set)
+			{
+				attributes += fmt::sprintf(",\"JOINTS_%u\":%u,\"WEIGHTS_%u\":%u",
+					set, addAccessor(jointView, set * 4, GL_UNSIGNED_BYTE, count, "VEC4"),
+					set, addAccessor(vertices, offsetof(Vertex, m_boneWeight) + set * 4, GL_UNSIGNED_BYTE, count, "VEC4", ",\"normalized\":true"));
+			}
+		}
+		else
+		{
+			skinned = false; // all primitives of the skinned mesh need the joints
+		}
+
+		const size_t indices = addAccessor(addView(piece.m_triangles.data(), piece.m_triangles.size() * sizeof(Triangle), 0, GL_ELEMENT_ARRAY_BUFFER),
+			0, GL_UNSIGNED_INT, piece.m_triangles.size() * 3, "SCALAR");
+		primitives[i] = fmt::sprintf("{\"attributes\":{%s},\"indices\":%u", attributes, indices);
+		if (piece.m_material >= 0 && static_cast<uint32_t>(piece.m_material) < m_materialCount && !m_looks.empty())
+		{
+			primitives[i] += fmt::sprintf(",\"material\":%i", piece.m_material);
+		}
+		primitives[i] += "}";
+	}
+
+	// nodes: parts, then bones, then locators
+	Array<Part> parts = m_parts;
+	if (parts.empty())
+	{
+		Part part;
+		part.m_name = m_fileName;
+		part.m_pieceCount = static_cast<uint32_t>(m_pieces.size());
+		part.m_locatorCount = static_cast<uint32_t>(m_locators.size());
+		parts.push_back(part);
+	}
+	const size_t boneNode = parts.size();
+	const size_t locatorNode = boneNode + m_bones.size();
+
+	String nodes, meshes, sceneNodes;
+	size_t meshCount = 0;
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		const Part &part = parts[i];
+		String mesh;
+		for (uint32_t j = part.m_pieceId; j < part.m_pieceId + part.m_pieceCount && j < primitives.size(); ++j)
+		{
+			if (!primitives[j].empty())
+			{
+				mesh += (mesh.empty() ? "" : ",") + primitives[j];
+			}
+		}
+
+		nodes += fmt::sprintf("%s{\"name\":%s", i ? "," : "", json::quote(part.m_name));
+		if (!mesh.empty())
+		{
+			meshes += fmt::sprintf("%s{\"name\":%s,\"primitives\":[%s]}", meshCount ? "," : "", json::quote(part.m_name), mesh);
+			nodes += fmt::sprintf(",\"mesh\":%u%s", meshCount++, skinned ? ",\"skin\":0" : "");
+		}
+		String children;
+		for (uint32_t j = part.m_locatorId; j < part.m_locatorId + part.m_locatorCount && j < m_locators.size(); ++j)
+		{
+			children += fmt::sprintf("%s%u", children.empty() ? "" : ",", locatorNode + j);
+		}
+		nodes += children.empty() ? "}" : fmt::sprintf(",\"children\":[%s]}", children);
+		sceneNodes += fmt::sprintf("%s%u", i ? "," : "", i);
+	}
+
+	String joints;
+	Array<glm::mat4> inverseBind(m_bones.size());
+	for (size_t i = 0; i < m_bones.size(); ++i)
+	{
+		const Bone &bone = m_bones[i];
+		// pmg stores the matrices column-major like glTF, glm_cast gives the transposition
+		const glm::mat4 world = glm::transpose(glm_cast(bone.m_transformation));
+		const bool root = bone.m_parent < 0 || static_cast<size_t>(bone.m_parent) >= m_bones.size();
+		const glm::mat4 local = root ? world : glm::inverse(glm::transpose(glm_cast(m_bones[bone.m_parent].m_transformation))) * world;
+		inverseBind[i] = glm::inverse(world);
+
+		String children;
+		for (size_t j = 0; j < m_bones.size(); ++j)
+		{
+			if (j != i && m_bones[j].m_parent == static_cast<int32_t>(i))
+			{
+				children += fmt::sprintf("%s%u", children.empty() ? "" : ",", boneNode + j);
+			}
+		}
+		nodes += fmt::sprintf(",{\"name\":%s,\"matrix\":%s%s}", json::quote(bone.m_name), matrix(local),
+			children.empty() ? "" : fmt::sprintf(",\"children\":[%s]", children));
+		joints += fmt::sprintf("%s%u", i ? "," : "", boneNode + i);
+		if (root)
+		{
+			sceneNodes += fmt::sprintf(",%u", boneNode + i);
+		}
+	}
+
+	for (const Locator &locator : m_locators)
+	{
+		nodes += fmt::sprintf(",{\"name\":%s,\"translation\":%s,\"rotation\":[%.9g,%.9g,%.9g,%.9g],\"scale\":%s}",
+			json::quote(locator.m_name), vec3(locator.m_position),
+			locator.m_rotation.m_x, locator.m_rotation.m_y, locator.m_rotation.m_z, locator.m_rotation.m_w, vec3(locator.m_scale));
+	}
+
+	String document = fmt::sprintf("{\"asset\":{\"version\":\"2.0\",\"generator\":%s},\"scene\":0,\"scenes\":[{\"name\":%s,\"nodes\":[%s]}],\"nodes\":[%s]",
+		json::quote(STRING_VERSION), json::quote(m_fileName), sceneNodes, nodes);
+	if (!meshes.empty())
+	{
+		document += fmt::sprintf(",\"meshes\":[%s]", meshes);
+	}
+	if (m_looks.size() > 0 && m_materialCount > 0)
+	{
+		document += ",\"materials\":[";
+		for (uint32_t i = 0; i < m_materialCount; ++i)
+		{
+			document += fmt::sprintf("%s{\"name\":%s}", i ? "," : "", json::quote(m_looks[0].m_materials[i].alias()));
+		}
+		document += "]";
+	}
+	if (skinned && !meshes.empty())
+	{
+		const size_t matrices = addAccessor(addView(inverseBind.data(), inverseBind.size() * sizeof(glm::mat4), 0, 0), 0, GL_FLOAT, inverseBind.size(), "MAT4");
+		document += fmt::sprintf(",\"skins\":[{\"inverseBindMatrices\":%u,\"joints\":[%s]}]", matrices, joints);
+	}
+	if (viewCount > 0)
+	{
+		document += fmt::sprintf(",\"accessors\":[%s],\"bufferViews\":[%s],\"buffers\":[{\"byteLength\":%u}]", accessors, bufferViews, binary.size());
+	}
+	document += "}";
+	document.resize((document.size() + 3) & ~static_cast<size_t>(3), ' ');
+
+	// header, JSON chunk and binary chunk
+	const uint32_t header[5] = {
+		0x46546C67, 2, static_cast<uint32_t>(12 + 8 + document.size() + (binary.empty() ? 0 : 8 + binary.size())),
+		static_cast<uint32_t>(document.size()), 0x4E4F534A
+	};
+	const uint32_t binaryHeader[2] = { static_cast<uint32_t>(binary.size()), 0x004E4942 };
+	return file->write(header, sizeof(header), 1) == 1
+		&& file->write(document.data(), sizeof(char), document.size()) == document.size()
+		&& (binary.empty() || (file->write(binaryHeader, sizeof(binaryHeader), 1) == 1
+			&& file->write(binary.data(), sizeof(uint8_t), binary.size()) == binary.size()));
+}
+
 void Model::convertTextures(String exportPath) const
 {
 	for (size_t i = 0; i < m_looks.size(); ++i)
@@ -1598,8 +2027,47 @@ void Model::convertTextures(String exportPath) const
 	}
 }
 
+Array<String> Model::dependencies() const
+{
+	Array<String> files = { m_filePath + ".pmg", m_filePath + ".pmd", m_filePath + ".ppd", m_filePath + ".pmc" };
+	for (const Look &look : m_looks)
+	{
+		for (const Material &material : look.m_materials)
+		{
+			files.push_back(material.m_filePath);
+			for (const Texture &texture : material.m_textures)
+			{
+				files.push_back(texture.texture());
+				if (const auto &tobj = texture.texobj())
+				{
+					files.insert(files.end(), tobj->m_textures, tobj->m_textures + tobj->m_texturesCount);
+				}
+			}
+		}
+	}
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+	return files;
+}
+
 void Model::saveToMidFormat(String exportPath, bool convertTexture) const
 {
+	auto state = [](bool x) -> const char * { return x ? "yes" : "no"; };
+
+	if (Config::s_glb)
+	{
+		// the skeleton is part of the glb
+		bool glb = saveToGlb(exportPath);
+		bool pit = saveToPit(exportPath);
+		bool pic = m_collision ? m_collision->saveToPic(exportPath) : false;
+		bool pip = m_prefab ? m_prefab->saveToPip(exportPath) : false;
+		if (convertTexture) { convertTextures(exportPath); }
+
+		info_f("model", m_fileName, "glb:%s pit:%s pic:%s pip:%s vertices:%i indices:%i materials:%i",
+			   state(glb), state(pit), state(pic), state(pip), m_vertCount, m_triangleCount, m_materialCount);
+		return;
+	}
+
 	bool pim = saveToPim(exportPath);
 	bool pit = saveToPit(exportPath);
 	bool pis = saveToPis(exportPath);
@@ -1607,8 +2075,6 @@ void Model::saveToMidFormat(String exportPath, bool convertTexture) const
 	bool pip = m_prefab ? m_prefab->saveToPip(exportPath) : false;
 	if (convertTexture) { convertTextures(exportPath); }
 
-	auto state = [](bool x) -> const char * { return x ? "yes" : "no"; };
-
 	info_f("model", m_fileName, "pim:%s pit:%s pis:%s pic:%s pip:%s vertices:%i indices:%i materials:%i",
 		   state(pim), state(pit), state(pis), state(pic), state(pip), m_vertCount, m_triangleCount, m_materialCount);
 }
@@ -1670,15 +2136,15 @@ auto Variant::operator[](size_t id) -> Part &
 
 String Variant::Attribute::toDefinition(const String &prefix) const
 {
-	String result;
-	result += prefix + "Attribute {" SEOL;
+	Emitter out;
+	out << prefix << "Attribute {" SEOL;
 	{
-		result += prefix + fmt::sprintf(TAB "Format: %s" SEOL, m_type == INT ? "INT" : "UNKNOWN");
-		result += prefix + fmt::sprintf(TAB "Tag: \"%s\"" SEOL, m_name.c_str());
-		result += prefix + fmt::sprintf(TAB "Value: ( %i )" SEOL, m_intValue);
+		out << prefix << TAB "Format: " << emit::text(m_type == INT ? "INT" : "UNKNOWN") << SEOL;
+		out << prefix << TAB "Tag: \"" << m_name << "\"" SEOL;
+		out << prefix << TAB "Value: ( " << m_intValue << " )" SEOL;
 	}
-	result += prefix + "}" SEOL;
-	return result;
+	out << prefix << "}" SEOL;
+	return out.str();
 }
 
 Pix::Value Variant::Attribute::toPixDefinition() const
@@ -72,9 +72,41 @@ public:
 	bool saveToPim(String exportPath) const;
 	bool saveToPit(String exportPath) const;
 	bool saveToPis(String exportPath) const;
+
+	/**
+	 * @brief: Writes the pieces, skin and skeleton as binary glTF 2.0 (.glb)
+	 *
+	 * The vertices are stored in the layout of the Vertex structure, so the streams
+	 * are copied without any formatting. Parts become nodes with meshes, bones and
+	 * locators become nodes as well.
+	 *
+	 * @param[in] exportPath The path prepended to the written file
+	 * @return @c True if the file has been written
+	 */
+	bool saveToGlb(String exportPath) const;
+
+	/**
+	 * @brief: Compares the piece streams of the pim document with the loaded pieces
+	 *
+	 * @param[in] name The name of the document used in messages
+	 * @param[in] data The text of the pim document
+	 * @param[in] size The size of the text
+	 * @return @c True if every stream matches bit for bit
+	 */
+	bool checkPim(const String &name, const char *data, size_t size) const;
 	void convertTextures(String exportPath) const;
 	void saveToMidFormat(String exportPath, bool convertTexture = true) const;
 
+	/**
+	 * @brief: Lists the files read by the conversion of the model
+	 *
+	 * The geometry, descriptor, prefab and collision files are listed even when they do not exist,
+	 * so that creating them is noticed as well.
+	 *
+	 * @return @c The sorted paths of the files (relative to base)
+	 */
+	Array<String> dependencies() const;
+
 	bool loaded() const { return m_loaded; }
 	String fileName() const { return m_fileName; }
 	String filePath() const { return m_filePath; }
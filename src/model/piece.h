@@ -23,6 +23,7 @@
 #pragma once
 
 #include <math/vector.h>
+#include <utils/job_allocator.h>
 
 struct Vertex
 {
@@ -65,8 +66,8 @@ private:
 	bool m_color = false;
 	bool m_color2 = false;
 
-	Array<Vertex> m_vertices;
-	Array<Triangle> m_triangles;
+	JobArray<Vertex> m_vertices;
+	JobArray<Triangle> m_triangles;
 
 	friend Model;
 };
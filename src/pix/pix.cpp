@@ -24,15 +24,88 @@
 
 #include "pix.h"
 
-String toString(const float value[], const size_t count);
-String toString(const double value[], const size_t count);
-String toString(const Pix::Value::LargestInt value[], const size_t count);
+#include <cityhash/city.h>
+#include <utils/emitter.h>
+#include <utils/number_format.h>
+
+void floatToBuffer(char *const buffer, uint32_t fl);
 
 using namespace Pix;
 
+namespace
+{
+	// rows and indexed objects grow in powers of two, so the capacity need not be stored
+	size_t rowCapacity(size_t count)
+	{
+		if (count == 0)
+		{
+			return 0;
+		}
+		size_t capacity = 4;
+		while (capacity < count)
+		{
+			capacity *= 2;
+		}
+		return capacity;
+	}
+
+	template < typename T >
+	T scalarAt(Value::Type type, const void *data, size_t index)
+	{
+		switch (type)
+		{
+			case Value::Type::Int:			return static_cast<T>(static_cast<const Value::LargestInt *>(data)[index]);
+			case Value::Type::UInt:			return static_cast<T>(static_cast<const Value::LargestUInt *>(data)[index]);
+			case Value::Type::Double:		return static_cast<T>(static_cast<const double *>(data)[index]);
+			case Value::Type::Boolean:		return static_cast<T>(static_cast<const bool *>(data)[index]);
+			case Value::Type::Float:
+			case Value::Type::FloatMatrix:	return static_cast<T>(static_cast<const float *>(data)[index]);
+			default:						return T();
+		}
+	}
+}
+
+Document::Document()
+{
+}
+
+Document::~Document()
+{
+}
+
+const char *Document::intern(const char *name, size_t length)
+{
+	const auto it = m_names.find(Key{ name, length });
+	if (it != m_names.end())
+	{
+		return it->second;
+	}
+	const char *const result = copy(name, length);
+	m_names.emplace(Key{ result, length }, result);
+	return result;
+}
+
+const char *Document::copy(const char *data, size_t length)
+{
+	char *const result = m_arena.allocate<char>(length + 1);
+	memcpy(result, data, length);
+	result[length] = '\0';
+	return result;
+}
+
+size_t Document::KeyHash::operator()(const Key &key) const
+{
+	return static_cast<size_t>(CityHash64(key.m_data, key.m_length));
+}
+
+bool Document::KeyEqual::operator()(const Key &lhs, const Key &rhs) const
+{
+	return lhs.m_length == rhs.m_length && memcmp(lhs.m_data, rhs.m_data, lhs.m_length) == 0;
+}
+
 Value::Value(Type type/*= Type::Null*/)
 {
-	m_type = type;
+	reset(type);
 }
 
 Value::Value(const char *const value)
@@ -41,153 +114,496 @@ Value::Value(const char *const value)
 }
 
 Value::Value(const String &value)
+	: Value()
 {
-	m_type = Type::String;
-	ValueHolder valueHolder;
-	valueHolder.m_valueCount = 1;
-	valueHolder.m_string = value;
-	m_values.push_back(valueHolder);
+	allocateStrings(Type::String, 1, false);
+	setString(0, value.data(), value.length());
 }
 
 Value::Value(const Enumeration &value)
+	: Value()
 {
-	m_type = Type::Enum;
-	ValueHolder valueHolder;
-	valueHolder.m_valueCount = 1;
-	valueHolder.m_string = value.m_name;
-	m_values.push_back(valueHolder);
+	allocateStrings(Type::Enum, 1, false);
+	setString(0, value.m_name.data(), value.m_name.length());
 }
 
 Value::Value(bool value)
+	: Value()
 {
-	m_type = Type::Boolean;
-	ValueHolder valueHolder;
-	valueHolder.m_valueCount = 1;
-	valueHolder.m_boolean[0] = value;
-	m_values.push_back(valueHolder);
+	store(Type::Boolean, allocateScalars(Type::Boolean, 1, 1, false), 0, value);
 }
 
 Value::Value(const Array<String> &value)
+	: Value()
 {
-	m_type = Type::String;
-	for (const String &s : value)
+	allocateStrings(Type::String, static_cast<u32>(value.size()), false);
+	for (size_t i = 0; i < value.size(); ++i)
 	{
-		ValueHolder valueHolder;
-		valueHolder.m_valueCount = 1;
-		valueHolder.m_string = s;
-		m_values.push_back(valueHolder);
+		setString(i, value[i].data(), value[i].length());
 	}
 }
 
 Value::Value(Quaternion quat)
+	: Value()
 {
-	m_type = Type::Float;
-	ValueHolder valueHolder;
-	valueHolder.m_valueCount = 4;
-	valueHolder.m_float[0] = quat.m_w;
-	valueHolder.m_float[1] = quat.m_x;
-	valueHolder.m_float[2] = quat.m_y;
-	valueHolder.m_float[3] = quat.m_z;
-	valueHolder.m_parentheses = true;
-	m_values.push_back(valueHolder);
+	float *const data = static_cast<float *>(allocateScalars(Type::Float, 1, 4, true));
+	data[0] = quat.m_w;
+	data[1] = quat.m_x;
+	data[2] = quat.m_y;
+	data[3] = quat.m_z;
 }
 
 Value::Value(const Value &rhs)
+	: Value()
 {
+	assign(rhs);
+}
+
+Value::Value(Value &&rhs)
+	: Value()
+{
+	*this = std::move(rhs);
+}
+
+Value::~Value()
+{
+	if (m_flags & OWNER)
+	{
+		delete m_document;
+	}
+}
+
+Value &Value::operator=(const Value &rhs)
+{
+	assign(rhs);
+	return (*this);
+}
+
+Value &Value::operator=(Value &&rhs)
+{
+	if (this == &rhs)
+	{
+		return (*this);
+	}
+
+	// nodes of a document can only be copied, the document is taken over only from its owner
+	const bool canTake = !m_document || (m_flags & OWNER);
+	const bool canGive = !rhs.m_document || (rhs.m_flags & OWNER);
+	if (!canTake || !canGive)
+	{
+		assign(rhs);
+		return (*this);
+	}
+
+	release();
 	m_type = rhs.m_type;
-	switch (m_type)
+	m_components = rhs.m_components;
+	m_flags = rhs.m_flags;
+	m_count = rhs.m_count;
+	m_document = rhs.m_document;
+	m_storage = rhs.m_storage;
+
+	rhs.m_flags = 0;
+	rhs.m_document = nullptr;
+	rhs.reset(Type::Null);
+	return (*this);
+}
+
+Value &Value::addObject(const String &name)
+{
+	return appendNamed(name.data(), name.length());
+}
+
+Value &Value::operator[](const String &name)
+{
+	return addObject(name);
+}
+
+Value &Value::operator[](const size_t index)
+{
+	assert(m_type == Type::Object && index < m_count);
+	if (m_flags & TYPED_ROWS)
 	{
-		case Type::Null:
-		case Type::Int:
-		case Type::UInt:
-		case Type::Double:
+		expandRows();
+	}
+	return m_storage.m_object.m_rows[index];
+}
+
+void Value::allocateNamedObjects(const size_t size)
+{
+	if (m_type != Type::Object)
+	{
+		reset(Type::Object);
+	}
+}
+
+void Value::allocateIndexedObjects(const size_t size)
+{
+	if (m_type != Type::Object)
+	{
+		reset(Type::Object);
+	}
+	if (m_flags & TYPED_ROWS)
+	{
+		expandRows();
+	}
+
+	const size_t capacity = rowCapacity(m_count);
+	if (size > capacity)
+	{
+		// the nodes do not own anything, so they can be moved by the arena
+		Document *const document = this->document();
+		const size_t newCapacity = rowCapacity(size);
+		Value *const rows = static_cast<Value *>(document->arena().reallocate(m_storage.m_object.m_rows, sizeof(Value) * capacity, sizeof(Value) * newCapacity, alignof(Value)));
+		for (size_t i = capacity; i < newCapacity; ++i)
+		{
+			new (rows + i) Value();
+			rows[i].m_document = document;
+		}
+		m_storage.m_object.m_rows = rows;
+	}
+	for (size_t i = m_count; i < size; ++i)
+	{
+		m_storage.m_object.m_rows[i].reset(Type::Null);
+	}
+	m_count = static_cast<u32>(size);
+}
+
+Value::LargestInt Value::asInt(size_t element/*= 0*/, size_t component/*= 0*/) const
+{
+	const size_t index = element * elementSize(m_type, m_components) / std::max<size_t>(scalarSize(m_type), 1) + component;
+	return index < scalarCount() ? scalarAt<LargestInt>(m_type, scalars(), index) : 0;
+}
+
+double Value::asDouble(size_t element/*= 0*/, size_t component/*= 0*/) const
+{
+	const size_t index = element * elementSize(m_type, m_components) / std::max<size_t>(scalarSize(m_type), 1) + component;
+	return index < scalarCount() ? scalarAt<double>(m_type, scalars(), index) : 0.0;
+}
+
+float Value::asFloat(size_t element/*= 0*/, size_t component/*= 0*/) const
+{
+	const size_t index = element * elementSize(m_type, m_components) / std::max<size_t>(scalarSize(m_type), 1) + component;
+	return index < scalarCount() ? scalarAt<float>(m_type, scalars(), index) : 0.f;
+}
+
+bool Value::asBool(size_t element/*= 0*/, size_t component/*= 0*/) const
+{
+	const size_t index = element * elementSize(m_type, m_components) / std::max<size_t>(scalarSize(m_type), 1) + component;
+	return index < scalarCount() ? scalarAt<bool>(m_type, scalars(), index) : false;
+}
+
+String Value::asString(size_t element/*= 0*/) const
+{
+	if ((m_type != Type::String && m_type != Type::Enum) || element >= m_count)
+	{
+		return String();
+	}
+	const StringRef &string = strings()[element];
+	return String(string.m_data, string.m_length);
+}
+
+const Value *Value::find(const String &name) const
+{
+	if (m_type != Type::Object)
+	{
+		return nullptr;
+	}
+	for (const NamedNode *node = m_storage.m_object.m_first; node; node = node->m_next)
+	{
+		if (strcmp(node->m_name, name.c_str()) == 0)
+		{
+			return &node->m_value;
+		}
+	}
+	return nullptr;
+}
+
+const Value &Value::indexed(size_t index) const
+{
+	assert(m_type == Type::Object && index < m_count && !(m_flags & TYPED_ROWS));
+	return m_storage.m_object.m_rows[index];
+}
+
+const Value *Value::typedRows() const
+{
+	return m_type == Type::Object && (m_flags & TYPED_ROWS) ? m_storage.m_object.m_rows : nullptr;
+}
+
+size_t Value::memoryUsage() const
+{
+	return sizeof(Value) + (m_document ? sizeof(Document) + m_document->arena().reserved() : 0);
+}
+
+size_t Value::scalarSize(Type type)
+{
+	switch (type)
+	{
+		case Type::Int:			return sizeof(LargestInt);
+		case Type::UInt:		return sizeof(LargestUInt);
+		case Type::Double:		return sizeof(double);
 		case Type::Float:
-		case Type::FloatMatrix:
-		case Type::Boolean:
-			m_values = rhs.m_values;
-			break;
-		case Type::String:
-		case Type::Enum:
-			for (const auto &value : rhs.m_values)
-			{
-				ValueHolder valueHolder;
-				valueHolder.m_valueCount = 1;
-				valueHolder.m_string = value.m_string;
-				m_values.push_back(valueHolder);
-			}
-			break;
-		case Type::Object:
-			m_objects = rhs.m_objects;
-		break;
-		default:
-			assert(false); // Unreachable assert
+		case Type::FloatMatrix:	return sizeof(float);
+		case Type::Boolean:		return sizeof(bool);
+		default:				return 0;
 	}
 }
 
-Value::~Value()
+size_t Value::elementSize(Type type, size_t components)
 {
+	return (type == Type::FloatMatrix ? components * components : components) * scalarSize(type);
 }
 
-Value &Value::operator=(const Value &rhs)
+size_t Value::scalarCount() const
 {
-	m_type = rhs.m_type;
-	switch (m_type)
+	if (scalarSize(m_type) == 0)
+	{
+		return 0;
+	}
+	return m_type == Type::FloatMatrix ? m_count * m_components * m_components : m_count * m_components;
+}
+
+void *Value::scalars()
+{
+	return const_cast<void *>(static_cast<const Value *>(this)->scalars());
+}
+
+const void *Value::scalars() const
+{
+	const bool external = (m_flags & EXTERNAL) || scalarCount() * scalarSize(m_type) > sizeof(Storage);
+	return external ? m_storage.m_data : m_storage.m_inline;
+}
+
+auto Value::strings() -> StringRef *
+{
+	return const_cast<StringRef *>(static_cast<const Value *>(this)->strings());
+}
+
+auto Value::strings() const -> const StringRef *
+{
+	const bool external = m_count * sizeof(StringRef) > sizeof(Storage);
+	return static_cast<const StringRef *>(external ? m_storage.m_data : static_cast<const void *>(m_storage.m_inline));
+}
+
+Document *Value::document()
+{
+	if (!m_document)
+	{
+		m_document = new Document();
+		m_flags |= OWNER;
+	}
+	return m_document;
+}
+
+void Value::reset(Type type)
+{
+	m_type = type;
+	m_components = 0;
+	m_flags &= OWNER;
+	m_count = 0;
+	memset(&m_storage, 0, sizeof(m_storage));
+}
+
+void Value::release()
+{
+	if (m_flags & OWNER)
+	{
+		delete m_document;
+	}
+	m_document = nullptr;
+	m_flags = 0;
+	reset(Type::Null);
+}
+
+void *Value::allocateScalars(Type type, u32 count, u8 components, bool parentheses)
+{
+	reset(type);
+	m_components = components;
+	m_count = count;
+	if (parentheses)
+	{
+		m_flags |= PARENTHESES;
+	}
+
+	const size_t bytes = scalarCount() * scalarSize(type);
+	if (bytes > sizeof(Storage))
+	{
+		m_storage.m_data = document()->arena().allocate(bytes, sizeof(LargestInt));
+	}
+	return scalars();
+}
+
+void Value::allocateStrings(Type type, u32 count, bool parentheses)
+{
+	reset(type);
+	m_components = 1;
+	m_count = count;
+	if (parentheses)
+	{
+		m_flags |= PARENTHESES;
+	}
+
+	if (count * sizeof(StringRef) > sizeof(Storage))
+	{
+		m_storage.m_data = document()->arena().allocate<StringRef>(count);
+	}
+	memset(strings(), 0, count * sizeof(StringRef));
+}
+
+void Value::setString(size_t element, const char *data, size_t length)
+{
+	// enumerations repeat a lot (FLOAT3, INT, ...), so they are interned as well
+	Document *const document = this->document();
+	strings()[element] = { m_type == Type::Enum ? document->intern(data, length) : document->copy(data, length), length };
+}
+
+void Value::assign(const Value &rhs)
+{
+	if (this == &rhs)
+	{
+		return;
+	}
+
+	switch (rhs.m_type)
 	{
 		case Type::Null:
-		case Type::Int:
-		case Type::UInt:
-		case Type::Double:
-		case Type::Float:
-		case Type::FloatMatrix:
-		case Type::Boolean:
-			m_values = rhs.m_values;
+			reset(Type::Null);
 			break;
 		case Type::String:
 		case Type::Enum:
-			for (const auto &value : rhs.m_values)
+		{
+			allocateStrings(rhs.m_type, rhs.m_count, (rhs.m_flags & PARENTHESES) != 0);
+			const StringRef *const strings = rhs.strings();
+			for (size_t i = 0; i < rhs.m_count; ++i)
 			{
-				ValueHolder valueHolder;
-				valueHolder.m_valueCount = 1;
-				valueHolder.m_string = value.m_string;
-				m_values.push_back(valueHolder);
+				setString(i, strings[i].m_data, strings[i].m_length);
 			}
-			break;
+		} break;
 		case Type::Object:
-			m_objects = rhs.m_objects;
-		break;
+		{
+			reset(Type::Object);
+			for (const NamedNode *node = rhs.m_storage.m_object.m_first; node; node = node->m_next)
+			{
+				appendNamed(node->m_name, strlen(node->m_name)).assign(node->m_value);
+			}
+
+			if (rhs.m_flags & TYPED_ROWS)
+			{
+				const Value &source = *rhs.m_storage.m_object.m_rows;
+				const size_t rowSize = elementSize(source.m_type, source.m_components);
+				Value *const rows = createValues(1);
+				rows->m_type = source.m_type;
+				rows->m_components = source.m_components;
+				rows->m_count = source.m_count;
+				rows->m_flags = EXTERNAL;
+				rows->m_storage.m_data = document()->arena().allocate(rowSize * rowCapacity(source.m_count), sizeof(LargestInt));
+				memcpy(rows->m_storage.m_data, source.m_storage.m_data, rowSize * source.m_count);
+				m_storage.m_object.m_rows = rows;
+				m_flags |= TYPED_ROWS;
+			}
+			else if (rhs.m_count != 0)
+			{
+				Value *const rows = createValues(rowCapacity(rhs.m_count));
+				for (size_t i = 0; i < rhs.m_count; ++i)
+				{
+					rows[i].assign(rhs.m_storage.m_object.m_rows[i]);
+				}
+				m_storage.m_object.m_rows = rows;
+			}
+			m_count = rhs.m_count;
+		} break;
 		default:
-			assert(false); // Unreachable assert
+		{
+			void *const data = allocateScalars(rhs.m_type, rhs.m_count, rhs.m_components, (rhs.m_flags & PARENTHESES) != 0);
+			memcpy(data, rhs.scalars(), scalarCount() * scalarSize(m_type));
+		} break;
 	}
-	return (*this);
 }
 
-Value &Value::addObject(const String &name)
+Value *Value::createValues(size_t count)
 {
-	m_type = Type::Object;
-	m_objects.m_named.push_back(ObjectsHolder::NamedObject(name));
-	return m_objects.m_named.back().m_value;
+	Document *const document = this->document();
+	Value *const values = document->arena().allocate<Value>(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		new (values + i) Value();
+		values[i].m_document = document;
+	}
+	return values;
 }
 
-Value &Value::operator[](const String &name)
+Value &Value::appendNamed(const char *name, size_t length)
 {
-	return addObject(name);
+	if (m_type != Type::Object)
+	{
+		reset(Type::Object);
+	}
+
+	Document *const document = this->document();
+	NamedNode *const node = document->arena().allocate<NamedNode>(1);
+	node->m_name = document->intern(name, length);
+	new (&node->m_value) Value();
+	node->m_value.m_document = document;
+	node->m_next = nullptr;
+
+	ObjectStorage &object = m_storage.m_object;
+	(object.m_last ? object.m_last->m_next : object.m_first) = node;
+	object.m_last = node;
+	return node->m_value;
 }
 
-Value &Value::operator[](const size_t index)
+Value &Value::appendRow()
 {
-	return m_objects.m_indexed.data()[index];
+	allocateIndexedObjects(m_count + 1);
+	return m_storage.m_object.m_rows[m_count - 1];
 }
 
-void Value::allocateNamedObjects(const size_t size)
+bool Value::appendTypedRow(Type type, u8 components, const void *data)
 {
-	m_type = Type::Object;
-	m_objects.m_named.reserve(size);
+	if (m_type != Type::Object)
+	{
+		reset(Type::Object);
+	}
+
+	if (m_count == 0 && !(m_flags & TYPED_ROWS))
+	{
+		Value *const rows = createValues(1);
+		rows->m_type = type;
+		rows->m_components = components;
+		rows->m_flags = EXTERNAL;
+		m_storage.m_object.m_rows = rows;
+		m_flags |= TYPED_ROWS;
+	}
+
+	Value *const rows = m_storage.m_object.m_rows;
+	if (!(m_flags & TYPED_ROWS) || rows->m_type != type || rows->m_components != components)
+	{
+		return false;
+	}
+
+	const size_t rowSize = elementSize(type, components);
+	if (m_count == rowCapacity(m_count))
+	{
+		rows->m_storage.m_data = document()->arena().reallocate(rows->m_storage.m_data, rowSize * m_count, rowSize * rowCapacity(m_count + 1), sizeof(LargestInt));
+	}
+	memcpy(static_cast<u8 *>(rows->m_storage.m_data) + rowSize * m_count, data, rowSize);
+	rows->m_count = ++m_count;
+	return true;
 }
 
-void Value::allocateIndexedObjects(const size_t size)
+void Value::expandRows()
 {
-	m_type = Type::Object;
-	m_objects.m_indexed.resize(size);
+	const Value &typed = *m_storage.m_object.m_rows;
+	const size_t rowSize = elementSize(typed.m_type, typed.m_components);
+	const u8 *const source = static_cast<const u8 *>(typed.m_storage.m_data);
+
+	Value *const rows = createValues(rowCapacity(m_count));
+	for (size_t i = 0; i < m_count; ++i)
+	{
+		memcpy(rows[i].allocateScalars(typed.m_type, 1, typed.m_components, false), source + rowSize * i, rowSize);
+	}
+	m_storage.m_object.m_rows = rows;
+	m_flags &= ~TYPED_ROWS;
 }
 
 Writer::Writer()
@@ -216,101 +632,145 @@ void StyledWriter::writeValue(const Value &value)
 			push("null");
 			break;
 		case Value::Type::Int:
-			for (const auto &v : value.m_values)
+		case Value::Type::UInt:
+		case Value::Type::Float:
+		case Value::Type::Double:
+			for (size_t i = 0; i < value.m_count; ++i)
 			{
-				push(toString(v.m_int, v.m_valueCount));
-				if (&v != &value.m_values.back())
+				if (i != 0)
 				{
 					push(" ");
 				}
+				writeElement(value, i);
 			}
 			break;
-		case Value::Type::UInt:
-			for (const auto &v : value.m_values)
+		case Value::Type::FloatMatrix:
+			writeElement(value, 0);
+			break;
+		case Value::Type::String:
+			for (size_t i = 0; i < value.m_count; ++i)
 			{
-				push(std::to_string(v.m_uint[0]));
-				if (&v != &value.m_values.back())
+				if (i != 0)
 				{
 					push(" ");
 				}
+				push(valueToQuotedString(value.asString(i)));
 			}
 			break;
-		case Value::Type::Float:
-			for (const auto &v : value.m_values)
-			{
-				push(toString(v.m_float, v.m_valueCount));
-				if (&v != &value.m_values.back())
+		case Value::Type::Enum:
+			push(value.asString(0));
+			break;
+		case Value::Type::Object:
+			indent();
+			value.forEachNamed([this](const char *name, const Value &object) {
+				const bool header = object.m_type == Value::Type::Object;
+				const bool parentheses = (object.m_flags & Value::PARENTHESES) != 0;
+				writeWithIndent(name);
+				push(header ? (" {" + m_defaultNewLine) : ": ");
+				push(parentheses ? "( " : "");
+				writeValue(object);
+				push(parentheses ? " )" : "");
+				if (header)
 				{
-					push(" ");
+					writeWithIndent("}");
 				}
-			}
-			break;
-		case Value::Type::FloatMatrix:
-			for (size_t i = 0; i < value.m_values[0].m_valueCount; ++i)
+				push(m_defaultNewLine);
+			});
+			if (const Value *const rows = value.typedRows())
 			{
-				for (size_t j = 0; j < value.m_values[0].m_valueCount; ++j)
+				for (size_t i = 0; i < value.m_count; ++i)
 				{
-					push(((j != 0 ? "  " : "") + fmt::sprintf(FLT_FT, flh(value.m_values[0].m_float4x4[i][j]))));
+					writeIndex(i);
+					push("( ");
+					writeElement(*rows, i);
+					push(" )" + m_defaultNewLine);
 				}
-				if (i != (value.m_values[0].m_valueCount - 1))
+			}
+			else
+			{
+				for (size_t i = 0; i < value.m_count; ++i)
 				{
-					push(m_defaultNewLine + m_indent + String(7, ' '));
+					writeIndex(i);
+					push("( ");
+					writeValue(value.m_storage.m_object.m_rows[i]);
+					push(" )" + m_defaultNewLine);
 				}
 			}
+			unindent();
 			break;
-		case Value::Type::Double:
-			for (const auto &v : value.m_values)
+		default:
+			; // Unreachable
+	}
+}
+
+void StyledWriter::writeElement(const Value &value, size_t element)
+{
+	const size_t count = value.m_components;
+	const size_t offset = element * count;
+	char buffer[NumberFormat::MAX_REAL];
+	switch (value.type())
+	{
+		case Value::Type::Int:
+		{
+			const Value::LargestInt *const values = static_cast<const Value::LargestInt *>(value.scalars()) + offset;
+			for (size_t i = 0; i < count; ++i)
 			{
-				push(toString(v.m_double, v.m_valueCount));
-				if (&v != &value.m_values.back())
+				if (i != 0)
 				{
-					push(" ");
+					push("  ", 2);
 				}
+				push(buffer, count > 1 ? NumberFormat::left(buffer, values[i], 5) : NumberFormat::integer(buffer, values[i]));
 			}
+		} break;
+		case Value::Type::UInt:
+			push(buffer, NumberFormat::unsignedInteger(buffer, static_cast<const Value::LargestUInt *>(value.scalars())[offset]));
 			break;
-		case Value::Type::String:
-			for (const auto &v : value.m_values)
+		case Value::Type::Float:
+		{
+			const float *const values = static_cast<const float *>(value.scalars()) + offset;
+			for (size_t i = 0; i < count; ++i)
 			{
-				push(valueToQuotedString(v.m_string));
-				if (&v != &value.m_values.back())
+				if (i != 0)
 				{
-					push(" ");
+					push("  ", 2);
 				}
+				floatToBuffer(buffer, flh(values[i]));
+				push(buffer, 9);
 			}
-			break;
-		case Value::Type::Enum:
-			push(value.m_values[0].m_string);
-			break;
-		case Value::Type::Object:
-			indent();
-			for (auto it = value.m_objects.m_named.cbegin(); it != value.m_objects.m_named.cend(); ++it)
+		} break;
+		case Value::Type::Double:
+		{
+			const double *const values = static_cast<const double *>(value.scalars()) + offset;
+			for (size_t i = 0; i < count; ++i)
 			{
-				const auto &object = *it;
-				const bool header = object.m_value.m_type == Value::Type::Object;
-				const bool parentheses = object.m_value.m_values.size() != 0 ? object.m_value.m_values[0].m_parentheses : false;
-				writeWithIndent(object.m_name);
-				push(header ? (" {" + m_defaultNewLine) : ": ");
-				push(parentheses ? "( " : "");
-				writeValue(object.m_value);
-				push(parentheses ? " )" : "");
-				if(header)
+				if (i != 0)
 				{
-					writeWithIndent("}");
+					push("  ", 2);
 				}
-				push(m_defaultNewLine);
+				push(buffer, NumberFormat::real(buffer, values[i]));
 			}
-			for (size_t i = 0; i < value.m_objects.m_indexed.size(); ++i)
+		} break;
+		case Value::Type::FloatMatrix:
+		{
+			const float *const matrix = static_cast<const float *>(value.scalars()) + offset * count;
+			for (size_t i = 0; i < count; ++i)
 			{
-				const auto &object = value.m_objects.m_indexed[i];
-				writeWithIndent(fmt::sprintf("%-5i", i));
-				push("( ");
-				writeValue(object);
-				push(" )" + m_defaultNewLine);
+				for (size_t j = 0; j < count; ++j)
+				{
+					if (j != 0)
+					{
+						push("  ", 2);
+					}
+					push(buffer, NumberFormat::hex(buffer, flh(matrix[i * count + j])));
+				}
+				if (i != (count - 1))
+				{
+					push(m_defaultNewLine + m_indent + String(7, ' '));
+				}
 			}
-			unindent();
-			break;
+		} break;
 		default:
-			; // Unreachable
+			; // Only numbers are stored in elements of more values
 	}
 }
 
@@ -337,7 +797,15 @@ void StyledWriter::unindent()
 
 void StyledWriter::writeWithIndent(const String &value)
 {
-	push(m_indent + value);
+	push(m_indent);
+	push(value);
+}
+
+void StyledWriter::writeIndex(size_t index)
+{
+	char buffer[NumberFormat::MAX_INTEGER];
+	push(m_indent);
+	push(buffer, NumberFormat::left(buffer, static_cast<s64>(index), 5));
 }
 
 String StyledStringWriter::write(const Value &value)
@@ -348,9 +816,9 @@ String StyledStringWriter::write(const Value &value)
 	return m_data;
 }
 
-void StyledStringWriter::push(const String &value)
+void StyledStringWriter::push(const char *data, size_t size)
 {
-	m_data += value;
+	m_data.append(data, size);
 }
 
 StyledFileWriter::StyledFileWriter()
@@ -363,17 +831,19 @@ StyledFileWriter::~StyledFileWriter()
 
 void StyledFileWriter::write(File *const file, const Value &value)
 {
-	m_file = file;
+	Emitter out(file);
+	m_out = &out;
 	writeValue(value);
 	push(m_defaultNewLine);
+	m_out = nullptr;
 }
 
-void StyledFileWriter::push(const String &value)
+void StyledFileWriter::push(const char *data, size_t size)
 {
-	(*m_file) << value;
+	m_out->write(data, size);
 }
 
-inline void floatToBuffer(char *const buffer, uint32_t fl)
+void floatToBuffer(char *const buffer, uint32_t fl)
 {
 #define TO_HEX(i) (i <= 9 ? '0' + i : 'A' - 10 + i)
 	buffer[0] = '&';
@@ -389,46 +859,6 @@ inline void floatToBuffer(char *const buffer, uint32_t fl)
 #undef TO_HEX
 }
 
-inline String toString(const float value[], const size_t count)
-{
-	String result;
-	result.reserve(64);
-
-	for (size_t i = 0; i < count; ++i)
-	{
-		if (i != 0)
-		{
-			result.append("  ");
-		}
-
-		char buffer[10];
-		floatToBuffer(buffer, flh(value[i]));
-		result.append(buffer);
-	}
-	return result;
-}
-
-inline String toString(const double value[], const size_t count)
-{
-	String result;
-	for (size_t i = 0; i < count; ++i)
-	{
-		result += ((i != 0 ? "  " : "") + fmt::sprintf("%f", value[i]));
-	}
-	return result;
-}
-
-inline String toString(const Pix::Value::LargestInt value[], const size_t count)
-{
-	const String format = count > 1 ? "%-5lli" : "%lli";
-	String result;
-	for (size_t i = 0; i < count; ++i)
-	{
-		result += ((i != 0 ? "  " : "") + fmt::sprintf(format, value[i]));
-	}
-	return result;
-}
-
 void pix_test()
 {
 	/*Pix::Value root;
@@ -462,9 +892,9 @@ void pix_test()
 	stream["Format"] = Pix::Value::Enumeration("FLOAT3");
 	stream["Tag"] = "_POSITION";
 	stream.allocateIndexedObjects(10);
-	for (auto &i : stream.m_objects.m_indexed)
+	for (size_t k = 0; k < 10; ++k)
 	{
-	i = Float3(0.2f, 0.3f, 0.4f);
+	stream[k] = Float3(0.2f, 0.3f, 0.4f);
 	}
 	}
 	}
@@ -482,8 +912,8 @@ void pix_test()
 	stream["Format"] = Pix::Value::Enumeration("FLOAT");
 	stream["Tag"] = "_TIME";
 	stream.allocateIndexedObjects(2);
-	stream.m_objects.m_indexed[0] = 0.1f;
-	stream.m_objects.m_indexed[1] = 0.2f;
+	stream[0] = 0.1f;
+	stream[1] = 0.2f;
 	}
 
 	Pix::StyledWriter writer;
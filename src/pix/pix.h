@@ -23,6 +23,7 @@
 #pragma once
 
 #include <fs/file.h>
+#include <utils/arena.h>
 
 #include <math/vector.h>
 #include <math/quaternion.h>
@@ -30,13 +31,59 @@
 
 namespace Pix
 {
+	/**
+	 * @brief: Storage of the Value tree.
+	 *
+	 * Every node, array and string of the tree lives in the arena of the document
+	 * and object names are interned, so the tree is released at once with the root value.
+	 */
+	class Document
+	{
+	public:
+		Document();
+		~Document();
+
+		/**
+		 * @brief: Returns the unique copy of the name, equal names share the same pointer
+		 */
+		const char *intern(const char *name, size_t length);
+
+		/**
+		 * @brief: Returns null terminated copy of the string
+		 */
+		const char *copy(const char *data, size_t length);
+
+		inline Arena &arena() { return m_arena; }
+		inline const Arena &arena() const { return m_arena; }
+
+	private:
+		struct Key
+		{
+			const char *m_data;
+			size_t m_length;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key &key) const;
+		};
+
+		struct KeyEqual
+		{
+			bool operator()(const Key &lhs, const Key &rhs) const;
+		};
+
+		Arena m_arena;
+		std::unordered_map<Key, const char *, KeyHash, KeyEqual> m_names;
+	};
+
 	class Value
 	{
 	public:
 		using LargestInt	= int64_t;
 		using LargestUInt	= uint64_t;
 
-		enum class Type
+		enum class Type : u8
 		{
 			Null = 0,
 			Int,
@@ -50,8 +97,6 @@ namespace Pix
 			Object
 		};
 
-		Type m_type;
-
 		class Enumeration
 		{
 		public:
@@ -75,131 +120,60 @@ namespace Pix
 
 		template < typename T >
 		Value(T value, typename EnableIfArithmetic<T>::type = 0)
+			: Value()
 		{
-			ValueHolder valueHolder;
-			valueHolder.m_valueCount = 1;
-			if (IsFloatingPoint<T>::value)
-			{
-				if (std::is_same<T, float>::value)
-				{
-					m_type = Type::Float;
-					valueHolder.m_float[0] = static_cast<float>(value);
-				}
-				else
-				{
-					m_type = Type::Double;
-					valueHolder.m_double[0] = static_cast<double>(value);
-				}
-			}
-			else if (std::numeric_limits<T>::is_signed)
-			{
-				m_type = Type::Int;
-				valueHolder.m_int[0] = static_cast<LargestInt>(value);
-			}
-			else
-			{
-				m_type = Type::UInt;
-				valueHolder.m_uint[0] = static_cast<LargestUInt>(value);
-			}
-			m_values.push_back(valueHolder);
+			const Type type = scalarType<T>();
+			store(type, allocateScalars(type, 1, 1, false), 0, value);
 		}
 
 		template < typename T, size_t N >
 		Value(const prism::vec_t<T, N> &value, size_t valueCount = N, typename EnableIfArithmetic<T>::type = 0)
+			: Value()
 		{
-			ValueHolder valueHolder;
-			valueHolder.m_valueCount = valueCount;
-			valueHolder.m_parentheses = true;
-			if (IsFloatingPoint<T>::value)
-			{
-				if (std::is_same<T, float>::value)
-				{
-					m_type = Type::Float;
-					for (size_t i = 0; i < valueCount; ++i)
-					{
-						valueHolder.m_float[i] = static_cast<float>(value.m_a[i]);
-					}
-				}
-				else
-				{
-					m_type = Type::Double;
-					for (size_t i = 0; i < valueCount; ++i)
-					{
-						valueHolder.m_double[i] = static_cast<double>(value.m_a[i]);
-					}
-				}
-			}
-			else if (std::numeric_limits<T>::is_signed)
-			{
-				for (size_t i = 0; i < valueCount; ++i)
-				{
-					valueHolder.m_int[i] = static_cast<LargestInt>(value.m_a[i]);
-				}
-				m_type = Type::Int;
-			}
-			else
+			const Type type = scalarType<T>();
+			void *const data = allocateScalars(type, 1, static_cast<u8>(valueCount), true);
+			for (size_t i = 0; i < valueCount; ++i)
 			{
-				for (size_t i = 0; i < valueCount; ++i)
-				{
-					valueHolder.m_uint[i] = static_cast<LargestUInt>(value.m_a[i]);
-				}
-				m_type = Type::UInt;
+				store(type, data, i, value.m_a[i]);
 			}
-			m_values.push_back(valueHolder);
 		}
 
 		template < size_t N >
 		Value(const prism::mat_sq_t<float, N> &value)
+			: Value()
 		{
-			ValueHolder valueHolder;
-			valueHolder.m_valueCount = N;
-			valueHolder.m_parentheses = true;
+			float *const data = static_cast<float *>(allocateScalars(Type::FloatMatrix, 1, N, true));
 			for (size_t i = 0; i < N; ++i)
 			{
 				for (size_t j = 0; j < N; ++j)
 				{
-					valueHolder.m_float4x4[i][j] = value.m[j][i];
+					data[i * N + j] = value.m[j][i];
 				}
 			}
-			m_type = Type::FloatMatrix;
-			m_values.push_back(valueHolder);
 		}
 
 		template < typename T >
 		Value(const Array<T> &values, typename EnableIfArithmetic<T>::type = 0)
+			: Value()
 		{
+			// floating point arrays are always stored as floats
+			const Type type = IsFloatingPoint<T>::value ? Type::Float : scalarType<T>();
+			void *const data = allocateScalars(type, static_cast<u32>(values.size()), 1, false);
+			size_t i = 0;
 			for (const auto &value : values)
 			{
-				ValueHolder valueHolder;
-				valueHolder.m_valueCount = 1;
-				if (IsFloatingPoint<T>::value)
-				{
-					valueHolder.m_float[0] = static_cast<float>(value);
-					m_type = Type::Float;
-				}
-				else if (std::numeric_limits<T>::is_signed)
-				{
-					valueHolder.m_int[0] = static_cast<LargestInt>(value);
-					m_type = Type::Int;
-				}
-				else
-				{
-					valueHolder.m_uint[0] = static_cast<LargestUInt>(value);
-					m_type = Type::UInt;
-				}
-				m_values.push_back(valueHolder);
+				store(type, data, i++, value);
 			}
 		}
 
 		template < size_t N >
 		Value(const prism::vec_t<bool, N> &value)
+			: Value()
 		{
-			ValueHolder valueHolder;
-			valueHolder.m_valueCount = N;
-			valueHolder.m_parentheses = true;
+			void *const data = allocateScalars(Type::Boolean, 1, N, true);
 			for (size_t i = 0; i < N; ++i)
 			{
-				valueHolder.m_boolean[i] = value.m_a[i];
+				store(Type::Boolean, data, i, value.m_a[i]);
 			}
 		}
 
@@ -210,9 +184,11 @@ namespace Pix
 		Value(const Array<String> &value);
 		Value(Quaternion quat);
 		Value(const Value &rhs);
+		Value(Value &&rhs);
 		~Value();
 
 		Value &operator=(const Value &rhs);
+		Value &operator=(Value &&rhs);
 
 		Type type() const { return m_type; }
 
@@ -223,50 +199,149 @@ namespace Pix
 
 		void allocateNamedObjects(const size_t size);
 		void allocateIndexedObjects(const size_t size);
-		inline Array<Value> &getIndexedObjects() { return m_objects.m_indexed; }
+
+		/**
+		 * @brief: Read access to the values
+		 *
+		 * Scalar and string values are arrays of elements of components() values each,
+		 * elements of FloatMatrix are components() x components() floats (row major).
+		 */
+		inline size_t size() const { return m_type != Type::Object ? m_count : 0; }
+		inline size_t components() const { return m_components; }
+		LargestInt asInt(size_t element = 0, size_t component = 0) const;
+		double asDouble(size_t element = 0, size_t component = 0) const;
+		float asFloat(size_t element = 0, size_t component = 0) const;
+		bool asBool(size_t element = 0, size_t component = 0) const;
+		String asString(size_t element = 0) const;
+
+		/**
+		 * @brief: Read access to the objects
+		 */
+		const Value *find(const String &name) const;
+		template < typename F >
+		void forEachNamed(F function) const;	// function(const char *name, const Value &value)
+		inline size_t indexedCount() const { return m_type == Type::Object ? m_count : 0; }
+		const Value &indexed(size_t index) const;
+
+		/**
+		 * @brief: Returns the rows stored as single array (one element per row), or nullptr
+		 *
+		 * Rows made of numbers of the same type and count are kept in one contiguous array
+		 * until any of them is accessed by operator[].
+		 */
+		const Value *typedRows() const;
+
+		/**
+		 * @brief: Returns the number of bytes used by the tree
+		 */
+		size_t memoryUsage() const;
 
 	private:
-		struct ValueHolder
+		enum Flags : u8
 		{
-			size_t	m_valueCount = 0;
-			bool	m_parentheses = false;
-			union
-			{
-				LargestInt	m_int[4];
-				LargestUInt	m_uint[4];
-				double		m_double[4];
-				float		m_float[4];
-				float		m_float4x4[4][4];
-				bool		m_boolean[4];
-			};
-			String	m_string;
+			PARENTHESES		= 1 << 0,
+			OWNER			= 1 << 1,	// m_document is owned by this value
+			TYPED_ROWS		= 1 << 2,	// m_rows points to single value with the rows as elements
+			EXTERNAL		= 1 << 3	// scalars are never inline (growing rows)
 		};
-		Array<ValueHolder> m_values;
 
-		struct ObjectsHolder
+		struct StringRef
 		{
-			struct NamedObject;
+			const char *m_data;
+			size_t m_length;
+		};
 
-			Array<NamedObject>	m_named;
-			Array<Value>		m_indexed;
-		} m_objects;
+		struct NamedNode;
+
+		struct ObjectStorage
+		{
+			NamedNode *m_first;
+			NamedNode *m_last;
+			Value *m_rows;
+		};
+
+		template < typename T >
+		static constexpr Type scalarType()
+		{
+			return IsFloatingPoint<T>::value
+				? (std::is_same<T, float>::value ? Type::Float : Type::Double)
+				: (std::numeric_limits<T>::is_signed ? Type::Int : Type::UInt);
+		}
+
+		template < typename T >
+		static void store(Type type, void *data, size_t index, T value)
+		{
+			switch (type)
+			{
+				case Type::Int:			static_cast<LargestInt *>(data)[index] = static_cast<LargestInt>(value);	break;
+				case Type::UInt:		static_cast<LargestUInt *>(data)[index] = static_cast<LargestUInt>(value);	break;
+				case Type::Double:		static_cast<double *>(data)[index] = static_cast<double>(value);			break;
+				case Type::Boolean:		static_cast<bool *>(data)[index] = value != 0;								break;
+				default:				static_cast<float *>(data)[index] = static_cast<float>(value);				break;
+			}
+		}
+
+		static size_t scalarSize(Type type);
+		static size_t elementSize(Type type, size_t components);
+		size_t scalarCount() const;
+		void *scalars();
+		const void *scalars() const;
+		StringRef *strings();
+		const StringRef *strings() const;
+
+		Document *document();
+		void reset(Type type);
+		void *allocateScalars(Type type, u32 count, u8 components, bool parentheses);
+		void allocateStrings(Type type, u32 count, bool parentheses);
+		void setString(size_t element, const char *data, size_t length);
+		void assign(const Value &rhs);
+		void release();
+
+		Value *createValues(size_t count);
+		Value &appendNamed(const char *name, size_t length);
+		Value &appendRow();
+		bool appendTypedRow(Type type, u8 components, const void *data);
+		void expandRows();
+
+	private:
+		Type m_type = Type::Null;
+		u8 m_components = 0;
+		u8 m_flags = 0;
+		u32 m_count = 0;						// elements, or rows of object
+		Document *m_document = nullptr;
+		union Storage
+		{
+			u8 m_inline[24];					// elements which fit
+			void *m_data;						// elements in the document
+			ObjectStorage m_object;
+		} m_storage;
 
 		friend class Writer;
 		friend class StyledWriter;
 		friend class FileWriter;
 		friend class StyledFileWriter;
+		friend class ValueHandler;
 	};
 
-	struct Value::ObjectsHolder::NamedObject
+	struct Value::NamedNode
 	{
-		String m_name;
+		const char *m_name;
 		Value m_value;
+		NamedNode *m_next;
+	};
 
-		NamedObject(const String &name)
-			: m_name(name)
+	template < typename F >
+	void Value::forEachNamed(F function) const
+	{
+		if (m_type != Type::Object)
 		{
+			return;
 		}
-	};
+		for (const NamedNode *node = m_storage.m_object.m_first; node; node = node->m_next)
+		{
+			function(node->m_name, node->m_value);
+		}
+	}
 
 	class Writer
 	{
@@ -275,7 +350,11 @@ namespace Pix
 		virtual ~Writer();
 
 	protected:
-		virtual void push(const String &value) = 0;
+		virtual void push(const char *data, size_t size) = 0;
+
+		template < size_t N >
+		inline void push(const char (&literal)[N]) { push(literal, N - 1); }
+		inline void push(const String &value) { push(value.data(), value.size()); }
 	};
 
 	class StyledWriter : public Writer
@@ -286,10 +365,12 @@ namespace Pix
 
 	protected:
 		void writeValue(const Value &value);
+		void writeElement(const Value &value, size_t element);
 
 		void indent();
 		void unindent();
 		void writeWithIndent(const String &value);
+		void writeIndex(size_t index); // "%-5i" of the row
 
 	protected:
 		String m_indent;
@@ -304,7 +385,8 @@ namespace Pix
 		String write(const Value &value);
 
 	protected:
-		virtual void push(const String &value) override;
+		using StyledWriter::push;
+		virtual void push(const char *data, size_t size) override;
 
 	private:
 		String m_data;
@@ -320,10 +402,11 @@ namespace Pix
 		void write(File *const file, const Value &value);
 
 	protected:
-		virtual void push(const String &value) override;
+		using StyledWriter::push;
+		virtual void push(const char *data, size_t size) override;
 
 	private:
-		File *m_file = nullptr;
+		Emitter *m_out = nullptr;	// buffers the text written to the file
 	};
 } // namespace Pix
 
@@ -0,0 +1,803 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/pix/pix_parser.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "pix_parser.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIX_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	inline bool isDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline bool isIdentifierChar(char c)
+	{
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || isDigit(c) || c == '_';
+	}
+
+	inline bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline int hexDigit(char c)
+	{
+		if (isDigit(c)) return c - '0';
+		if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+		if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+		return -1;
+	}
+
+	/**
+	 * @brief: Decodes 8 hex digits (most significant first)
+	 *
+	 * @param[in] s The digits, at least 8 bytes have to be readable
+	 * @param[out] value The decoded value
+	 * @return @c False if any of the characters is not a hex digit
+	 */
+	inline bool decodeHex8(const char *s, u32 &value)
+	{
+	#ifdef PIX_SSE2
+		const __m128i chars = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s));
+
+		// classify the characters, bytes >= 0x80 end up outside of both ranges
+		const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+		const __m128i isNumber = _mm_and_si128(_mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)), _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+		const __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+		const __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(letter, _mm_set1_epi8(-1)), _mm_cmplt_epi8(letter, _mm_set1_epi8(6)));
+		if ((_mm_movemask_epi8(_mm_or_si128(isNumber, isLetter)) & 0xFF) != 0xFF)
+		{
+			return false;
+		}
+		const __m128i nibbles = _mm_or_si128(_mm_and_si128(isNumber, digit), _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+
+		// join pairs of nibbles into bytes: 16 bit lane holds (first | second << 8)
+		__m128i bytes = _mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8));
+		bytes = _mm_and_si128(bytes, _mm_set1_epi16(0x00FF));
+
+		// reverse the byte order, the first digits are the most significant
+		bytes = _mm_shufflelo_epi16(bytes, _MM_SHUFFLE(0, 1, 2, 3));
+		value = static_cast<u32>(_mm_cvtsi128_si32(_mm_packus_epi16(bytes, bytes)));
+		return true;
+	#else
+		u32 result = 0;
+		for (int i = 0; i < 8; ++i)
+		{
+			const int nibble = hexDigit(s[i]);
+			if (nibble < 0)
+			{
+				return false;
+			}
+			result = (result << 4) | static_cast<u32>(nibble);
+		}
+		value = result;
+		return true;
+	#endif
+	}
+}
+
+namespace Pix
+{
+	Handler::~Handler()
+	{
+	}
+
+	bool Handler::beginObject(const char *name, size_t length) { return true; }
+	bool Handler::endObject() { return true; }
+	bool Handler::beginAttribute(const char *name, size_t length) { return true; }
+	bool Handler::endAttribute() { return true; }
+	bool Handler::beginRow(Value::LargestInt index) { return true; }
+	bool Handler::endRow() { return true; }
+	bool Handler::beginGroup() { return true; }
+	bool Handler::endGroup() { return true; }
+	bool Handler::label(const char *name, size_t length) { return true; }
+	bool Handler::intValue(Value::LargestInt value) { return true; }
+	bool Handler::floatValue(float value) { return true; }
+	bool Handler::doubleValue(double value) { return true; }
+	bool Handler::stringValue(const char *value, size_t length) { return true; }
+	bool Handler::enumValue(const char *value, size_t length) { return true; }
+
+	Parser::Parser(Handler *handler)
+		: m_handler(handler)
+	{
+	}
+
+	bool Parser::parse(const String &name, const char *data, size_t size)
+	{
+		m_name = name;
+		m_cursor = data;
+		m_end = data + size;
+		m_line = 1;
+		return parseMembers(false);
+	}
+
+	bool Parser::parse(const String &name, File *file)
+	{
+		const uint64_t size = file->size();
+		String data(static_cast<size_t>(size), '\0');
+		if (!file->blockRead(&data[0], 0, size))
+		{
+			error("pix", name, "Unable to read the file");
+			return false;
+		}
+		return parse(name, data.data(), data.size());
+	}
+
+	bool Parser::parseMembers(bool nested)
+	{
+		for (;;)
+		{
+			skipWhitespace();
+			if (m_cursor == m_end)
+			{
+				return nested ? fail("Unexpected end of data, missing }") : true;
+			}
+
+			const char c = *m_cursor;
+			if (c == '}')
+			{
+				if (!nested)
+				{
+					return fail("Unexpected }");
+				}
+				++m_cursor;
+				return true;
+			}
+
+			if (isDigit(c) || c == '-')
+			{
+				const bool negative = c == '-';
+				m_cursor += negative ? 1 : 0;
+				Value::LargestInt index = 0;
+				const char *const digits = m_cursor;
+				for (; m_cursor < m_end && isDigit(*m_cursor); ++m_cursor)
+				{
+					index = index * 10 + (*m_cursor - '0');
+				}
+				if (m_cursor == digits)
+				{
+					return fail("Invalid row index");
+				}
+				while (m_cursor < m_end && isBlank(*m_cursor))
+				{
+					++m_cursor;
+				}
+				if (m_cursor == m_end || *m_cursor != '(')
+				{
+					return fail("Expected ( after row index");
+				}
+				++m_cursor;
+				if (!m_handler->beginRow(negative ? -index : index) || !parseValues(true) || !m_handler->endRow())
+				{
+					return false;
+				}
+				continue;
+			}
+
+			const size_t length = identifier();
+			if (length == 0)
+			{
+				return fail("Unexpected character");
+			}
+			const char *const name = m_cursor;
+			m_cursor += length;
+			while (m_cursor < m_end && isBlank(*m_cursor))
+			{
+				++m_cursor;
+			}
+
+			if (m_cursor < m_end && *m_cursor == '{')
+			{
+				++m_cursor;
+				if (!m_handler->beginObject(name, length) || !parseMembers(true) || !m_handler->endObject())
+				{
+					return false;
+				}
+			}
+			else if (m_cursor < m_end && *m_cursor == ':')
+			{
+				++m_cursor;
+				if (!m_handler->beginAttribute(name, length) || !parseValues(false) || !m_handler->endAttribute())
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return fail("Expected { or : after the name");
+			}
+		}
+	}
+
+	bool Parser::parseValues(bool row)
+	{
+		// attributes end with the line (unless the parentheses are still open), rows with the closing parenthesis
+		int depth = 0;
+		for (;;)
+		{
+			while (m_cursor < m_end && isBlank(*m_cursor))
+			{
+				++m_cursor;
+			}
+			if (m_cursor == m_end)
+			{
+				return (row || depth > 0) ? fail("Unexpected end of data, missing )") : true;
+			}
+
+			const char c = *m_cursor;
+			bool result = true;
+			switch (c)
+			{
+				case '\n':
+				{
+					++m_cursor;
+					++m_line;
+					if (!row && depth == 0)
+					{
+						return true;
+					}
+				} break;
+				case '&':
+				{
+					result = parseHexFloat();
+				} break;
+				case '"':
+				{
+					result = parseString();
+				} break;
+				case '(':
+				{
+					++m_cursor;
+					++depth;
+					result = m_handler->beginGroup();
+				} break;
+				case ')':
+				{
+					++m_cursor;
+					if (depth == 0)
+					{
+						return row ? true : fail("Unexpected )");
+					}
+					--depth;
+					result = m_handler->endGroup();
+				} break;
+				default:
+				{
+					if (isDigit(c) || c == '-' || c == '+' || c == '.')
+					{
+						result = parseNumber();
+						break;
+					}
+
+					const size_t length = identifier();
+					if (length == 0)
+					{
+						return fail("Unexpected character");
+					}
+					const char *const name = m_cursor;
+					m_cursor += length;
+					if (m_cursor < m_end && *m_cursor == ':')
+					{
+						++m_cursor;
+						result = m_handler->label(name, length);
+					}
+					else
+					{
+						result = m_handler->enumValue(name, length);
+					}
+				} break;
+			}
+
+			if (!result)
+			{
+				return false;
+			}
+		}
+	}
+
+	bool Parser::parseHexFloat()
+	{
+		const char *const digits = m_cursor + 1;
+		u32 bits = 0;
+		if (m_end - digits < 8 || !decodeHex8(digits, bits))
+		{
+			return fail("Invalid hex float");
+		}
+		m_cursor = digits + 8;
+		if (m_cursor < m_end && isIdentifierChar(*m_cursor))
+		{
+			return fail("Invalid hex float");
+		}
+
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return m_handler->floatValue(value);
+	}
+
+	bool Parser::parseNumber()
+	{
+		const char *const start = m_cursor;
+		bool real = false;
+		for (; m_cursor < m_end; ++m_cursor)
+		{
+			const char c = *m_cursor;
+			if (c == '.' || c == 'e' || c == 'E')
+			{
+				real = true;
+			}
+			else if (!isDigit(c) && !((c == '-' || c == '+') && (m_cursor == start || m_cursor[-1] == 'e' || m_cursor[-1] == 'E')))
+			{
+				break;
+			}
+		}
+		if (m_cursor < m_end && isIdentifierChar(*m_cursor))
+		{
+			return fail("Invalid number");
+		}
+
+		if (real)
+		{
+			char buffer[64];
+			const size_t length = static_cast<size_t>(m_cursor - start);
+			if (length >= sizeof(buffer))
+			{
+				return fail("Invalid number");
+			}
+			memcpy(buffer, start, length);
+			buffer[length] = '\0';
+
+			char *end = nullptr;
+			const double value = strtod(buffer, &end);
+			if (end != buffer + length)
+			{
+				return fail("Invalid number");
+			}
+			return m_handler->doubleValue(value);
+		}
+
+		const char *digits = start;
+		const bool negative = *digits == '-';
+		if (*digits == '-' || *digits == '+')
+		{
+			++digits;
+		}
+		if (digits == m_cursor)
+		{
+			return fail("Invalid number");
+		}
+		Value::LargestInt value = 0;
+		for (; digits < m_cursor; ++digits)
+		{
+			value = value * 10 + (*digits - '0');
+		}
+		return m_handler->intValue(negative ? -value : value);
+	}
+
+	bool Parser::parseString()
+	{
+		const char *const begin = m_cursor + 1;
+		const char *const end = static_cast<const char *>(memchr(begin, '"', static_cast<size_t>(m_end - begin)));
+		if (!end)
+		{
+			return fail("Unterminated string");
+		}
+		m_cursor = end + 1;
+		return m_handler->stringValue(begin, static_cast<size_t>(end - begin));
+	}
+
+	void Parser::skipWhitespace()
+	{
+		for (; m_cursor < m_end; ++m_cursor)
+		{
+			if (*m_cursor == '\n')
+			{
+				++m_line;
+			}
+			else if (!isBlank(*m_cursor))
+			{
+				break;
+			}
+		}
+	}
+
+	size_t Parser::identifier() const
+	{
+		if (m_cursor == m_end || isDigit(*m_cursor) || !isIdentifierChar(*m_cursor))
+		{
+			return 0;
+		}
+		const char *end = m_cursor + 1;
+		while (end < m_end && isIdentifierChar(*end))
+		{
+			++end;
+		}
+		return static_cast<size_t>(end - m_cursor);
+	}
+
+	bool Parser::fail(const char *message)
+	{
+		error_f("pix", m_name, "Line %u: %s", m_line, message);
+		return false;
+	}
+
+	ValueHandler::ValueHandler(Value *root)
+	{
+		root->allocateNamedObjects(0);
+		m_stack.push_back(root);
+	}
+
+	bool ValueHandler::beginObject(const char *name, size_t length)
+	{
+		Value &object = m_stack.back()->appendNamed(name, length);
+		object.allocateNamedObjects(0);
+		m_stack.push_back(&object);
+		return true;
+	}
+
+	bool ValueHandler::endObject()
+	{
+		m_stack.pop_back();
+		return true;
+	}
+
+	bool ValueHandler::beginAttribute(const char *name, size_t length)
+	{
+		m_current = &m_stack.back()->appendNamed(name, length);
+		m_tokens.clear();
+		return true;
+	}
+
+	bool ValueHandler::endAttribute()
+	{
+		build(*m_current, m_tokens.cbegin(), m_tokens.cend(), false);
+		m_current = nullptr;
+		return true;
+	}
+
+	bool ValueHandler::beginRow(Value::LargestInt index)
+	{
+		// rows are kept in the order of appearance, the index is only informative
+		m_tokens.clear();
+		return true;
+	}
+
+	bool ValueHandler::endRow()
+	{
+		Value &parent = *m_stack.back();
+		if (!appendTypedRow(parent, m_tokens.cbegin(), m_tokens.cend()))
+		{
+			build(parent.appendRow(), m_tokens.cbegin(), m_tokens.cend(), true);
+		}
+		return true;
+	}
+
+	bool ValueHandler::beginGroup()
+	{
+		push(TokenKind::GroupBegin);
+		return true;
+	}
+
+	bool ValueHandler::endGroup()
+	{
+		push(TokenKind::GroupEnd);
+		return true;
+	}
+
+	bool ValueHandler::label(const char *name, size_t length)
+	{
+		push(TokenKind::Label).m_string.assign(name, length);
+		return true;
+	}
+
+	bool ValueHandler::intValue(Value::LargestInt value)
+	{
+		push(TokenKind::Scalar, Value::Type::Int).m_int = value;
+		return true;
+	}
+
+	bool ValueHandler::floatValue(float value)
+	{
+		push(TokenKind::Scalar, Value::Type::Float).m_float = value;
+		return true;
+	}
+
+	bool ValueHandler::doubleValue(double value)
+	{
+		push(TokenKind::Scalar, Value::Type::Double).m_double = value;
+		return true;
+	}
+
+	bool ValueHandler::stringValue(const char *value, size_t length)
+	{
+		push(TokenKind::Scalar, Value::Type::String).m_string.assign(value, length);
+		return true;
+	}
+
+	bool ValueHandler::enumValue(const char *value, size_t length)
+	{
+		push(TokenKind::Scalar, Value::Type::Enum).m_string.assign(value, length);
+		return true;
+	}
+
+	ValueHandler::Token &ValueHandler::push(TokenKind kind, Value::Type type)
+	{
+		m_tokens.emplace_back();
+		Token &token = m_tokens.back();
+		token.m_kind = kind;
+		token.m_type = type;
+		token.m_double = 0.0;
+		return token;
+	}
+
+	void ValueHandler::build(Value &target, TokenIt begin, TokenIt end, bool row)
+	{
+		if (buildUniform(target, begin, end, row))
+		{
+			return;
+		}
+
+		// single group with complex contents
+		if (begin->m_kind == TokenKind::GroupBegin && closing(begin, end) == end - 1)
+		{
+			build(target, begin + 1, end - 1, false);
+			return;
+		}
+
+		target.allocateNamedObjects(0);
+
+		bool labels = false;
+		for (TokenIt it = begin; it != end; ++it)
+		{
+			if (it->m_kind == TokenKind::GroupBegin)
+			{
+				it = closing(it, end);
+			}
+			else if (it->m_kind == TokenKind::Label)
+			{
+				labels = true;
+				break;
+			}
+		}
+
+		if (labels)
+		{
+			// Weights: 2  5 &3F000000  7 &3F000000 -> named parts
+			String name;
+			bool named = false;
+			TokenIt partBegin = begin;
+			for (TokenIt it = begin; it != end; ++it)
+			{
+				if (it->m_kind == TokenKind::GroupBegin)
+				{
+					it = closing(it, end);
+				}
+				else if (it->m_kind == TokenKind::Label)
+				{
+					if (named || it != partBegin)
+					{
+						build(target.addObject(name), partBegin, it, false);
+					}
+					name = it->m_string;
+					named = true;
+					partBegin = it + 1;
+				}
+			}
+			build(target.addObject(name), partBegin, end, false);
+			return;
+		}
+
+		// mixed types -> one indexed part per value or group
+		for (TokenIt it = begin; it != end; )
+		{
+			const TokenIt next = it->m_kind == TokenKind::GroupBegin ? closing(it, end) + 1 : it + 1;
+			build(target.appendRow(), it, next, false);
+			it = next;
+		}
+	}
+
+	bool ValueHandler::buildUniform(Value &target, TokenIt begin, TokenIt end, bool row)
+	{
+		bool typed = false;
+		Value::Type type = Value::Type::Null;
+		size_t count = 0;
+		size_t groups = 0;
+		bool bare = false;
+		int depth = 0;
+		for (TokenIt it = begin; it != end; ++it)
+		{
+			switch (it->m_kind)
+			{
+				case TokenKind::Label:
+					return false;
+				case TokenKind::GroupBegin:
+					if (++depth > 1)
+					{
+						return false;
+					}
+					++groups;
+					break;
+				case TokenKind::GroupEnd:
+					--depth;
+					break;
+				case TokenKind::Scalar:
+					if (typed && it->m_type != type)
+					{
+						return false;
+					}
+					type = it->m_type;
+					typed = true;
+					bare = bare || depth == 0;
+					++count;
+					break;
+			}
+		}
+
+		if (!typed)
+		{
+			target.reset(Value::Type::Null);
+			return true;
+		}
+
+		if (type == Value::Type::String || type == Value::Type::Enum)
+		{
+			target.allocateStrings(type, static_cast<u32>(count), groups != 0);
+			size_t i = 0;
+			for (TokenIt it = begin; it != end; ++it)
+			{
+				if (it->m_kind == TokenKind::Scalar)
+				{
+					target.setString(i++, it->m_string.data(), it->m_string.length());
+				}
+			}
+			return true;
+		}
+
+		if (type == Value::Type::Float && groups == 1 && !bare && (count == 9 || count == 16))
+		{
+			const u8 n = count == 16 ? 4 : 3;
+			store(Value::Type::FloatMatrix, target.allocateScalars(Value::Type::FloatMatrix, 1, n, true), begin, end);
+			return true;
+		}
+
+		if (row && groups == 0 && count <= MAX_COMPONENTS)
+		{
+			store(type, target.allocateScalars(type, 1, static_cast<u8>(count), false), begin, end);
+			return true;
+		}
+
+		// every value or group is one element, all of them must have the same size
+		size_t elements = 0;
+		size_t components = 0;
+		for (TokenIt it = begin; it != end; ++it, ++elements)
+		{
+			size_t size = 1;
+			if (it->m_kind == TokenKind::GroupBegin)
+			{
+				const TokenIt close = closing(it, end);
+				size = static_cast<size_t>(close - it) - 1;
+				it = close;
+			}
+			if ((elements != 0 && size != components) || size == 0 || size > MAX_COMPONENTS)
+			{
+				return false;
+			}
+			components = size;
+		}
+		store(type, target.allocateScalars(type, static_cast<u32>(elements), static_cast<u8>(components), groups != 0), begin, end);
+		return true;
+	}
+
+	bool ValueHandler::appendTypedRow(Value &parent, TokenIt begin, TokenIt end)
+	{
+		// ( 9 or 16 floats ) -> matrix row
+		const bool group = end - begin > 2 && begin->m_kind == TokenKind::GroupBegin && (end - 1)->m_kind == TokenKind::GroupEnd;
+		if (group)
+		{
+			++begin;
+			--end;
+		}
+
+		const size_t count = static_cast<size_t>(end - begin);
+		if (count == 0 || count > MAX_COMPONENTS || begin->m_kind != TokenKind::Scalar)
+		{
+			return false;
+		}
+
+		const Value::Type type = begin->m_type;
+		if (type != Value::Type::Int && type != Value::Type::Float && type != Value::Type::Double)
+		{
+			return false;
+		}
+		for (TokenIt it = begin; it != end; ++it)
+		{
+			if (it->m_kind != TokenKind::Scalar || it->m_type != type)
+			{
+				return false;
+			}
+		}
+
+		Value::LargestInt row[MAX_COMPONENTS];
+		if (group)
+		{
+			if (type != Value::Type::Float || (count != 9 && count != 16))
+			{
+				return false;
+			}
+			store(Value::Type::FloatMatrix, row, begin, end);
+			return parent.appendTypedRow(Value::Type::FloatMatrix, count == 16 ? 4 : 3, row);
+		}
+		store(type, row, begin, end);
+		return parent.appendTypedRow(type, static_cast<u8>(count), row);
+	}
+
+	void ValueHandler::store(Value::Type type, void *data, TokenIt begin, TokenIt end)
+	{
+		size_t i = 0;
+		for (TokenIt it = begin; it != end; ++it)
+		{
+			if (it->m_kind != TokenKind::Scalar)
+			{
+				continue;
+			}
+			switch (it->m_type)
+			{
+				case Value::Type::Int:		Value::store(type, data, i++, it->m_int);		break;
+				case Value::Type::Float:	Value::store(type, data, i++, it->m_float);		break;
+				case Value::Type::Double:	Value::store(type, data, i++, it->m_double);	break;
+				default:					break;
+			}
+		}
+	}
+
+	ValueHandler::TokenIt ValueHandler::closing(TokenIt open, TokenIt end)
+	{
+		int depth = 0;
+		for (TokenIt it = open; it != end; ++it)
+		{
+			if (it->m_kind == TokenKind::GroupBegin)
+			{
+				++depth;
+			}
+			else if (it->m_kind == TokenKind::GroupEnd && --depth == 0)
+			{
+				return it;
+			}
+		}
+		return end - 1;
+	}
+
+	bool parse(const String &name, const char *data, size_t size, Value &root)
+	{
+		ValueHandler handler(&root);
+		Parser parser(&handler);
+		return parser.parse(name, data, size);
+	}
+} // namespace Pix
+
+/* eof */
@@ -0,0 +1,183 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/pix/pix_parser.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "pix.h"
+
+namespace Pix
+{
+	/**
+	 * @brief: Receives events of the parsed PIX document (SAX style).
+	 *
+	 * The names and strings point into the parsed buffer and are valid only during the call.
+	 * Returning false from any of the events stops the parser.
+	 */
+	class Handler
+	{
+	public:
+		virtual ~Handler();
+
+		virtual bool beginObject(const char *name, size_t length);	// Name {
+		virtual bool endObject();									// }
+		virtual bool beginAttribute(const char *name, size_t length);	// Name: values until the end of line
+		virtual bool endAttribute();
+		virtual bool beginRow(Value::LargestInt index);				// index ( values )
+		virtual bool endRow();
+		virtual bool beginGroup();									// ( values ) nested in attribute or row
+		virtual bool endGroup();
+		virtual bool label(const char *name, size_t length);		// Name: inside of row
+
+		virtual bool intValue(Value::LargestInt value);
+		virtual bool floatValue(float value);						// &XXXXXXXX
+		virtual bool doubleValue(double value);
+		virtual bool stringValue(const char *value, size_t length);
+		virtual bool enumValue(const char *value, size_t length);
+	};
+
+	/**
+	 * @brief: Parses PIX text (pim, pis, pia, pit, pic, pip) held in memory.
+	 *
+	 * Hex encoded floats are decoded with SSE2 when it is available.
+	 */
+	class Parser
+	{
+	public:
+		Parser(Handler *handler);
+
+		/**
+		 * @brief: Parses the whole document
+		 *
+		 * @param[in] name The name used in error messages
+		 * @param[in] data The text of the document
+		 * @param[in] size The size of the text
+		 * @return @c True if the document has been parsed and the handler has accepted every event
+		 */
+		bool parse(const String &name, const char *data, size_t size);
+
+		/**
+		 * @brief: Reads the whole file and parses it
+		 */
+		bool parse(const String &name, File *file);
+
+	private:
+		bool parseMembers(bool nested);
+		bool parseValues(bool row);
+		bool parseHexFloat();
+		bool parseNumber();
+		bool parseString();
+
+		void skipWhitespace();
+		size_t identifier() const;
+		bool fail(const char *message);
+
+	private:
+		Handler *m_handler;
+		String m_name;
+		const char *m_cursor = nullptr;
+		const char *m_end = nullptr;
+		u32 m_line = 0;
+	};
+
+	/**
+	 * @brief: Builds Value tree from the parser events.
+	 *
+	 * Attributes and rows made of values of a single type become values of that type,
+	 * groups of 9 or 16 floats become FloatMatrix. Rows of numbers of the same type and count
+	 * are appended to one contiguous array of the parent object. Anything more complex (labels
+	 * inside rows, mixed types) becomes an object of named (by label) or indexed parts.
+	 */
+	class ValueHandler : public Handler
+	{
+	public:
+		ValueHandler(Value *root);
+
+		virtual bool beginObject(const char *name, size_t length) override;
+		virtual bool endObject() override;
+		virtual bool beginAttribute(const char *name, size_t length) override;
+		virtual bool endAttribute() override;
+		virtual bool beginRow(Value::LargestInt index) override;
+		virtual bool endRow() override;
+		virtual bool beginGroup() override;
+		virtual bool endGroup() override;
+		virtual bool label(const char *name, size_t length) override;
+
+		virtual bool intValue(Value::LargestInt value) override;
+		virtual bool floatValue(float value) override;
+		virtual bool doubleValue(double value) override;
+		virtual bool stringValue(const char *value, size_t length) override;
+		virtual bool enumValue(const char *value, size_t length) override;
+
+	private:
+		enum class TokenKind
+		{
+			Scalar,
+			GroupBegin,
+			GroupEnd,
+			Label
+		};
+
+		struct Token
+		{
+			TokenKind m_kind;
+			Value::Type m_type;
+			union
+			{
+				Value::LargestInt m_int;
+				float m_float;
+				double m_double;
+			};
+			String m_string;
+		};
+
+		using TokenIt = Array<Token>::const_iterator;
+
+		Token &push(TokenKind kind, Value::Type type = Value::Type::Null);
+
+		static void build(Value &target, TokenIt begin, TokenIt end, bool row);
+		static bool buildUniform(Value &target, TokenIt begin, TokenIt end, bool row);
+		static TokenIt closing(TokenIt open, TokenIt end);
+		static bool appendTypedRow(Value &parent, TokenIt begin, TokenIt end);
+		static void store(Value::Type type, void *data, TokenIt begin, TokenIt end);
+
+	private:
+		static const size_t MAX_COMPONENTS = 255;	// values in one element
+
+	private:
+		Array<Value *> m_stack;
+		Value *m_current = nullptr;	// attribute being built
+		Array<Token> m_tokens;
+	};
+
+	/**
+	 * @brief: Parses the document into the Value tree
+	 *
+	 * @param[in] name The name used in error messages
+	 * @param[in] data The text of the document
+	 * @param[in] size The size of the text
+	 * @param[out] root The value which receives the top level objects
+	 * @return @c True if the document has been parsed
+	 */
+	bool parse(const String &name, const char *data, size_t size, Value &root);
+} // namespace Pix
+
+/* eof */
@@ -27,10 +27,12 @@
 #include <fs/file.h>
 #include <fs/uberfilesystem.h>
 #include <fs/sysfilesystem.h>
+#include <utils/emitter.h>
 
 #include <structs/ppd_0x15.h>
 #include <structs/ppd_0x16.h>
 #include <structs/ppd_0x17.h>
+#include <structs/validator.h>
 
 #include <prefab/node.h>
 #include <prefab/curve.h>
@@ -68,6 +70,12 @@ bool Prefab::load(String filePath)
 	file->read((char *)buffer.get(), sizeof(uint8_t), fileSize);
 	file.reset();
 
+	if (fileSize < sizeof(u32))
+	{
+		error("prefab", m_filePath, "Prefab file is malformed!");
+		return false;
+	}
+
 	const auto version = *reinterpret_cast<const u32 *>(buffer.get());
 
 	switch (version)
@@ -87,24 +95,15 @@ bool Prefab::loadVersion0x15(const uint8_t * const buffer, const size_t fileSize
 {
 	using namespace prism::ppd_0x15;
 
-	const ppd_header_t *const header = (ppd_header_t *)(buffer);
-
-	if (header->m_node_offset > fileSize
-		|| header->m_nav_curve_offset > fileSize
-		|| header->m_sign_offset > fileSize
-		|| header->m_semaphore_offset > fileSize
-		|| header->m_spawn_point_offset > fileSize
-		|| header->m_terrain_point_pos_offset > fileSize
-		|| header->m_terrain_point_normal_offset > fileSize
-		|| header->m_terrain_point_variant_offset > fileSize
-		|| header->m_map_point_offset > fileSize
-		|| header->m_trigger_point_offset > fileSize
-		|| header->m_intersection_offset > fileSize)
-	{
-		error_f("prefab", m_filePath, "Offset inside file exceeds file size!");
+	String diagnostic;
+	if (!validate_ppd_0x15(buffer, fileSize, diagnostic))
+	{
+		error_f("prefab", m_filePath, "Prefab file is malformed (%s)!", diagnostic);
 		return false;
 	}
 
+	const ppd_header_t *const header = (ppd_header_t *)(buffer);
+
 	Node node; Curve curve; Sign sign; Semaphore semaphore; SpawnPoint spawnPoint; MapPoint mapPoint;
 	TerrainPointVariant terrainPointVariant; TriggerPoint triggerPoint; Intersection intersection;
 	TerrainPoint terrainPoint;
@@ -244,24 +243,15 @@ bool Prefab::loadVersion0x16(const uint8_t * const buffer, const size_t fileSize
 {
 	using namespace prism::ppd_0x16;
 
-	const ppd_header_t *const header = (ppd_header_t *)(buffer);
-
-	if (header->m_node_offset > fileSize
-		|| header->m_nav_curve_offset > fileSize
-		|| header->m_sign_offset > fileSize
-		|| header->m_semaphore_offset > fileSize
-		|| header->m_spawn_point_offset > fileSize
-		|| header->m_terrain_point_pos_offset > fileSize
-		|| header->m_terrain_point_normal_offset > fileSize
-		|| header->m_terrain_point_variant_offset > fileSize
-		|| header->m_map_point_offset > fileSize
-		|| header->m_trigger_point_offset > fileSize
-		|| header->m_intersection_offset > fileSize)
-	{
-		error_f("prefab", m_filePath, "Offset inside file exceeds file size!");
+	String diagnostic;
+	if (!validate_ppd_0x16(buffer, fileSize, diagnostic))
+	{
+		error_f("prefab", m_filePath, "Prefab file is malformed (%s)!", diagnostic);
 		return false;
 	}
 
+	const ppd_header_t *const header = (ppd_header_t *)(buffer);
+
 	Node node; Curve curve; Sign sign; Semaphore semaphore; SpawnPoint spawnPoint; MapPoint mapPoint;
 	TerrainPointVariant terrainPointVariant; TriggerPoint triggerPoint; Intersection intersection;
 	TerrainPoint terrainPoint;
@@ -401,24 +391,15 @@ bool Prefab::loadVersion0x17(const uint8_t * const buffer, const size_t fileSize
 {
 	using namespace prism::ppd_0x17;
 
-	const ppd_header_t *const header = (ppd_header_t *)(buffer);
-
-	if (header->m_node_offset > fileSize
-		|| header->m_nav_curve_offset > fileSize
-		|| header->m_sign_offset > fileSize
-		|| header->m_semaphore_offset > fileSize
-		|| header->m_spawn_point_offset > fileSize
-		|| header->m_terrain_point_pos_offset > fileSize
-		|| header->m_terrain_point_normal_offset > fileSize
-		|| header->m_terrain_point_variant_offset > fileSize
-		|| header->m_map_point_offset > fileSize
-		|| header->m_trigger_point_offset > fileSize
-		|| header->m_intersection_offset > fileSize)
-	{
-		error_f("prefab", m_filePath, "Offset inside file exceeds file size!");
+	String diagnostic;
+	if (!validate_ppd_0x17(buffer, fileSize, diagnostic))
+	{
+		error_f("prefab", m_filePath, "Prefab file is malformed (%s)!", diagnostic);
 		return false;
 	}
 
+	const ppd_header_t *const header = (ppd_header_t *)(buffer);
+
 	Node node; Curve curve; Sign sign; Semaphore semaphore; SpawnPoint spawnPoint; MapPoint mapPoint;
 	TerrainPointVariant terrainPointVariant; TriggerPoint triggerPoint; Intersection intersection;
 	TerrainPoint terrainPoint;
@@ -571,84 +552,61 @@ void Prefab::destroy()
 bool Prefab::saveToPip(String exportPath) const
 {
 	String pipFilePath = exportPath + m_filePath + ".pip";
-	auto file = getSFS()->open(pipFilePath, FileSystem::write | FileSystem::binary);
+	auto file = getOFS()->open(pipFilePath, FileSystem::write | FileSystem::binary);
 	if (!file)
 	{
-		error_f("prefab", pipFilePath, "Unable to save file (%s)", getSFS()->getError());
+		error_f("prefab", pipFilePath, "Unable to save file (%s)", strerror(errno));
 		return false;
 	}
 
-	*file << fmt::sprintf(
+	Emitter out(file.get());
+
+	out <<
 		"Header {"							SEOL
 		TAB "FormatVersion: 2"				SEOL
-		TAB "Source: \"%s\""				SEOL
+		TAB "Source: \"" STRING_VERSION "\""	SEOL
 		TAB "Type: \"Prefab\""				SEOL
-		TAB "Name: \"%s\""					SEOL
-		"}"									SEOL,
-			STRING_VERSION,
-			m_fileName.c_str()
-		);
+		TAB "Name: \"" << m_fileName << "\""	SEOL
+		"}"									SEOL;
 
-	*file << fmt::sprintf(
+	out <<
 		"Global {"							SEOL
-		TAB "NodeCount: %i"					SEOL
-		TAB "TerrainPointCount : %i"		SEOL
-		TAB "TerrainPointVariantCount : %i"	SEOL
-		TAB "NavCurveCount : %i"			SEOL
-		TAB "SignCount : %i"				SEOL
-		TAB "SpawnPointCount : %i"			SEOL
-		TAB "SemaphoreCount : %i"			SEOL
-		TAB "MapPointCount : %i"			SEOL
-		TAB "TriggerPointCount : %i"		SEOL
-		TAB "IntersectionCount : %i"		SEOL
-		"}"									SEOL,
-			(int)m_nodes.size(),
-			(int)m_terrainPoints.size(),
-			(int)m_terrainPointVariants.size(),
-			(int)m_curves.size(),
-			(int)m_signs.size(),
-			(int)m_spawnPoints.size(),
-			(int)m_semaphores.size(),
-			(int)m_mapPoints.size(),
-			(int)m_triggerPoints.size(),
-			(int)m_intersections.size()
-		);
+		TAB "NodeCount: " << m_nodes.size() << SEOL
+		TAB "TerrainPointCount : " << m_terrainPoints.size() << SEOL
+		TAB "TerrainPointVariantCount : " << m_terrainPointVariants.size() << SEOL
+		TAB "NavCurveCount : " << m_curves.size() << SEOL
+		TAB "SignCount : " << m_signs.size() << SEOL
+		TAB "SpawnPointCount : " << m_spawnPoints.size() << SEOL
+		TAB "SemaphoreCount : " << m_semaphores.size() << SEOL
+		TAB "MapPointCount : " << m_mapPoints.size() << SEOL
+		TAB "TriggerPointCount : " << m_triggerPoints.size() << SEOL
+		TAB "IntersectionCount : " << m_intersections.size() << SEOL
+		"}"									SEOL;
 
 	for (size_t i = 0; i < m_nodes.size(); ++i)
 	{
 		const Node *node = &m_nodes[i];
-		*file << "Node {" SEOL;
-		*file << fmt::sprintf(
-			TAB "Index: %i" SEOL
-			TAB "Position : ( %s )" SEOL
-			TAB "Direction : ( %s )" SEOL,
-				i,
-				to_string(node->m_position).c_str(),
-				to_string(node->m_direction).c_str()
-			);
-
-		*file << TAB "InputLanes: ("; for (u32 j = 0; j < 8; ++j) { *file << fmt::sprintf(" %i", node->m_inputLines[j]); } *file << " )" SEOL;
-		*file << TAB "OutputLanes: ("; for (u32 j = 0; j < 8; ++j) { *file << fmt::sprintf(" %i", node->m_outputLines[j]); } *file << " )" SEOL;
-		*file << SEOL;
-
-		*file << fmt::sprintf(
-			TAB "TerrainPointCount: %i" SEOL
-			TAB "TerrainPointVariantCount : %i" SEOL
-			TAB "StreamCount : %i" SEOL,
-				node->m_terrainPointCount,
-				node->m_variantCount,
-				(node->m_variantCount > 0 ? 1 : 0) + (node->m_terrainPointCount > 0 ? 2 : 0)
-			);
+		out << "Node {" SEOL;
+		out <<
+			TAB "Index: " << i << SEOL
+			TAB "Position : ( " << node->m_position << " )" SEOL
+			TAB "Direction : ( " << node->m_direction << " )" SEOL;
+
+		out << TAB "InputLanes: ("; for (u32 j = 0; j < 8; ++j) { out << " " << node->m_inputLines[j]; } out << " )" SEOL;
+		out << TAB "OutputLanes: ("; for (u32 j = 0; j < 8; ++j) { out << " " << node->m_outputLines[j]; } out << " )" SEOL;
+		out << SEOL;
+
+		out <<
+			TAB "TerrainPointCount: " << node->m_terrainPointCount << SEOL
+			TAB "TerrainPointVariantCount : " << node->m_variantCount << SEOL
+			TAB "StreamCount : " << (node->m_variantCount > 0 ? 1 : 0) + (node->m_terrainPointCount > 0 ? 2 : 0) << SEOL;
 
 		if (node->m_terrainPointCount > 0)
 		{
-			*file << fmt::sprintf(
+			out <<
 				TAB "Stream {" SEOL
-				TAB TAB "Format: %s" SEOL
-				TAB TAB "Tag: \"%s\"" SEOL,
-					"FLOAT3",
-					"_POSITION"
-				);
+				TAB TAB "Format: FLOAT3" SEOL
+				TAB TAB "Tag: \"_POSITION\"" SEOL;
 
 			for (u32 j = 0; j < node->m_terrainPointCount; ++j)
 			{
@@ -658,21 +616,15 @@ bool Prefab::saveToPip(String exportPath) const
 					break;
 				}
 
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %s )" SEOL,
-						j, to_string(m_terrainPoints[node->m_terrainPointIdx + j].m_position).c_str()
-					);
+				out << TAB TAB << emit::left<5>(j) << "( " << m_terrainPoints[node->m_terrainPointIdx + j].m_position << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 
-			*file << fmt::sprintf(
+			out <<
 				TAB "Stream {" SEOL
-				TAB TAB "Format: %s" SEOL
-				TAB TAB "Tag: \"%s\"" SEOL,
-					"FLOAT3",
-					"_NORMAL"
-				);
+				TAB TAB "Format: FLOAT3" SEOL
+				TAB TAB "Tag: \"_NORMAL\"" SEOL;
 
 			for (u32 j = 0; j < node->m_terrainPointCount; ++j)
 			{
@@ -682,222 +634,154 @@ bool Prefab::saveToPip(String exportPath) const
 					break;
 				}
 
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %s )" SEOL,
-						j, to_string(m_terrainPoints[node->m_terrainPointIdx + j].m_normal).c_str()
-					);
+				out << TAB TAB << emit::left<5>(j) << "( " << m_terrainPoints[node->m_terrainPointIdx + j].m_normal << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 		}
 
 		if (node->m_variantCount > 0)
 		{
-			*file << fmt::sprintf(
+			out <<
 				TAB "Stream {" SEOL
-				TAB TAB "Format: %s" SEOL
-				TAB TAB "Tag: \"%s\"" SEOL,
-					"INT2",
-					"_VARIANT_BLOCK"
-				);
+				TAB TAB "Format: INT2" SEOL
+				TAB TAB "Tag: \"_VARIANT_BLOCK\"" SEOL;
 
 			for (u32 j = 0; j < node->m_variantCount; ++j)
 			{
-				TerrainPointVariant data = m_terrainPointVariants[node->m_variantIdx + j];
-				*file << fmt::sprintf(
-					TAB TAB "%-5i( %i %i )" SEOL,
-						j, data.m_attach0, data.m_attach1
-					);
+				const TerrainPointVariant &data = m_terrainPointVariants[node->m_variantIdx + j];
+				out << TAB TAB << emit::left<5>(j) << "( " << data.m_attach0 << " " << data.m_attach1 << " )" SEOL;
 			}
 
-			*file << TAB "}" SEOL;
+			out << TAB "}" SEOL;
 		}
-		*file << "}" SEOL;
+		out << "}" SEOL;
 	}
 
 	for (size_t i = 0; i < m_curves.size(); ++i)
 	{
 		const Curve *curve = &m_curves[i];
-		*file << "Curve {" SEOL;
-		*file << fmt::sprintf(
-			TAB "Index: %i" SEOL
-			TAB "Name: \"%s\"" SEOL
-			TAB "Flags: %u" SEOL
-			TAB "LeadsToNodes: %i" SEOL,
-				i,
-				curve->m_name.c_str(),
-				curve->m_flags,
-				curve->m_leadsToNodes
-			);
+		out << "Curve {" SEOL;
+		out <<
+			TAB "Index: " << i << SEOL
+			TAB "Name: \"" << curve->m_name << "\"" SEOL
+			TAB "Flags: " << emit::uint(curve->m_flags) << SEOL
+			TAB "LeadsToNodes: " << curve->m_leadsToNodes << SEOL;
 
 		if (curve->m_trafficRule.length() > 0)
 		{
-			*file << fmt::sprintf(
-				TAB "TrafficRule: \"%s\"" SEOL,
-				curve->m_trafficRule.c_str()
-			);
+			out << TAB "TrafficRule: \"" << curve->m_trafficRule << "\"" SEOL;
 		}
 
 		if (curve->m_semaphoreId != -1)
 		{
-			*file << fmt::sprintf(
-				TAB "SemaphoreID: %i" SEOL,
-				curve->m_semaphoreId
-			);
+			out << TAB "SemaphoreID: " << curve->m_semaphoreId << SEOL;
 		}
 
-		*file << TAB "NextCurves: ("; for (u32 j = 0; j < 4; ++j) { *file << fmt::sprintf(" %i", curve->m_nextLines[j]); } *file << " )" SEOL;
-		*file << TAB "PrevCurves: ("; for (u32 j = 0; j < 4; ++j) { *file << fmt::sprintf(" %i", curve->m_prevLines[j]); } *file << " )" SEOL;
+		out << TAB "NextCurves: ("; for (u32 j = 0; j < 4; ++j) { out << " " << curve->m_nextLines[j]; } out << " )" SEOL;
+		out << TAB "PrevCurves: ("; for (u32 j = 0; j < 4; ++j) { out << " " << curve->m_prevLines[j]; } out << " )" SEOL;
 
-		*file << fmt::sprintf(
-			TAB "Length: " FLT_FT SEOL,
-				flh(curve->m_length)
-			);
+		out << TAB "Length: " << emit::hex(curve->m_length) << SEOL;
 
-		*file << TAB "Bezier {" SEOL;
-		*file << fmt::sprintf(
+		out << TAB "Bezier {" SEOL;
+		out <<
 			TAB TAB "Start {" SEOL
-			TAB TAB TAB "Position: ( %s )" SEOL
-			TAB TAB TAB "Rotation: ( %s )" SEOL
-			TAB TAB "}" SEOL,
-				to_string(curve->m_startPosition).c_str(),
-				to_string(curve->m_startRotation).c_str()
-			);
-
-		*file << fmt::sprintf(
+			TAB TAB TAB "Position: ( " << curve->m_startPosition << " )" SEOL
+			TAB TAB TAB "Rotation: ( " << curve->m_startRotation << " )" SEOL
+			TAB TAB "}" SEOL;
+
+		out <<
 			TAB TAB "End {" SEOL
-			TAB TAB TAB "Position: ( %s )" SEOL
-			TAB TAB TAB "Rotation: ( %s )" SEOL
-			TAB TAB "}" SEOL,
-				to_string(curve->m_endPosition).c_str(),
-				to_string(curve->m_endRotation).c_str()
-			);
+			TAB TAB TAB "Position: ( " << curve->m_endPosition << " )" SEOL
+			TAB TAB TAB "Rotation: ( " << curve->m_endRotation << " )" SEOL
+			TAB TAB "}" SEOL;
 
-		*file << TAB "}" SEOL;
-		*file << "}" SEOL;
+		out << TAB "}" SEOL;
+		out << "}" SEOL;
 	}
 
 	for (size_t i = 0; i < m_signs.size(); ++i)
 	{
 		const Sign *sign = &m_signs[i];
-		*file << "Sign {" SEOL;
-		*file << fmt::sprintf(
-			TAB "Name: \"%s\"" SEOL
-			TAB "Position: ( %s )" SEOL
-			TAB "Rotation: ( %s )" SEOL
-			TAB "Model: \"%s\"" SEOL
-			TAB "Part: \"%s\"" SEOL,
-				sign->m_name.c_str(),
-				to_string(sign->m_position).c_str(),
-				to_string(sign->m_rotation).c_str(),
-				sign->m_model.c_str(),
-				sign->m_part.c_str()
-			);
-		*file << "}" SEOL;
+		out << "Sign {" SEOL;
+		out <<
+			TAB "Name: \"" << sign->m_name << "\"" SEOL
+			TAB "Position: ( " << sign->m_position << " )" SEOL
+			TAB "Rotation: ( " << sign->m_rotation << " )" SEOL
+			TAB "Model: \"" << sign->m_model << "\"" SEOL
+			TAB "Part: \"" << sign->m_part << "\"" SEOL;
+		out << "}" SEOL;
 	}
 
 	for (size_t i = 0; i < m_spawnPoints.size(); ++i)
 	{
 		const SpawnPoint *sp = &m_spawnPoints[i];
-		*file << "SpawnPoint {" SEOL;
-		*file << fmt::sprintf(
-			TAB "Name: \"%s\"" SEOL
-			TAB "Position: ( %s )" SEOL
-			TAB "Rotation: ( %s )" SEOL
-			TAB "Type: %i" SEOL,
-				fmt::sprintf("sp_%i", (int)i).c_str(),
-				to_string(sp->m_position).c_str(),
-				to_string(sp->m_rotation).c_str(),
-				sp->m_type
-			);
-		*file << "}" SEOL;
+		out << "SpawnPoint {" SEOL;
+		out <<
+			TAB "Name: \"sp_" << i << "\"" SEOL
+			TAB "Position: ( " << sp->m_position << " )" SEOL
+			TAB "Rotation: ( " << sp->m_rotation << " )" SEOL
+			TAB "Type: " << sp->m_type << SEOL;
+		out << "}" SEOL;
 	}
 
 	for (size_t i = 0; i < m_semaphores.size(); ++i)
 	{
 		const Semaphore *semaphore = &m_semaphores[i];
-		*file << "Semaphore {" SEOL;
-		*file << fmt::sprintf(
-			TAB "Position: ( %s )" SEOL
-			TAB "Rotation: ( %s )" SEOL
-			TAB "Type: %i" SEOL
-			TAB "SemaphoreID: %i" SEOL
-			TAB "Intervals: ( %s )" SEOL
-			TAB "Cycle: " FLT_FT SEOL
-			TAB "Profile: \"%s\"" SEOL,
-				to_string(semaphore->m_position).c_str(),
-				to_string(semaphore->m_rotation).c_str(),
-				semaphore->m_type,
-				semaphore->m_semaphoreId,
-				to_string(semaphore->m_intervals).c_str(),
-				flh(semaphore->m_cycle),
-				semaphore->m_profile.c_str()
-			);
-		*file << "}" SEOL;
+		out << "Semaphore {" SEOL;
+		out <<
+			TAB "Position: ( " << semaphore->m_position << " )" SEOL
+			TAB "Rotation: ( " << semaphore->m_rotation << " )" SEOL
+			TAB "Type: " << semaphore->m_type << SEOL
+			TAB "SemaphoreID: " << semaphore->m_semaphoreId << SEOL
+			TAB "Intervals: ( " << semaphore->m_intervals << " )" SEOL
+			TAB "Cycle: " << emit::hex(semaphore->m_cycle) << SEOL
+			TAB "Profile: \"" << semaphore->m_profile << "\"" SEOL;
+		out << "}" SEOL;
 	}
 
 	for (size_t i = 0; i < m_mapPoints.size(); ++i)
 	{
 		const MapPoint *mp = &m_mapPoints[i];
-		*file << "MapPoint {" SEOL;
-		*file << fmt::sprintf(
-			TAB "Index: %i" SEOL
-			TAB "MapVisualFlags: %u" SEOL
-			TAB "MapNavFlags: %u" SEOL
-			TAB "Position: ( %s )" SEOL
-			TAB "Neighbours: ( %s )" SEOL,
-				i,
-				mp->m_mapVisualFlags,
-				mp->m_mapNavFlags,
-				to_string(mp->m_position).c_str(),
-				to_string(mp->m_neighbour).c_str()
-			);
-		*file << "}" SEOL;
+		out << "MapPoint {" SEOL;
+		out <<
+			TAB "Index: " << i << SEOL
+			TAB "MapVisualFlags: " << emit::uint(mp->m_mapVisualFlags) << SEOL
+			TAB "MapNavFlags: " << emit::uint(mp->m_mapNavFlags) << SEOL
+			TAB "Position: ( " << mp->m_position << " )" SEOL
+			TAB "Neighbours: ( " << mp->m_neighbour << " )" SEOL;
+		out << "}" SEOL;
 	}
 
 	for (size_t i = 0; i < m_triggerPoints.size(); ++i)
 	{
 		const TriggerPoint *tp = &m_triggerPoints[i];
-		*file << "TriggerPoint {" SEOL;
-		*file << fmt::sprintf(
-			TAB "Index: %i" SEOL
-			TAB "TriggerID: %i" SEOL
-			TAB "TriggerAction: \"%s\"" SEOL
-			TAB "TriggerRange: %f" SEOL
-			TAB "TriggerResetDelay: %f" SEOL
-			TAB "TriggerResetDist: %f" SEOL
-			TAB "Flags: %u" SEOL
-			TAB "Position: ( %s )" SEOL
-			TAB "Neighbours: ( %s )" SEOL,
-				(int)i,
-				tp->m_id,
-				tp->m_action.c_str(),
-				tp->m_range,
-				tp->m_reset_delay,
-				tp->m_reset_dist,
-				tp->m_flags,
-				to_string(tp->m_position).c_str(),
-				to_string(tp->m_neighbours).c_str()
-			);
-		*file << "}" SEOL;
+		out << "TriggerPoint {" SEOL;
+		out <<
+			TAB "Index: " << i << SEOL
+			TAB "TriggerID: " << tp->m_id << SEOL
+			TAB "TriggerAction: \"" << tp->m_action << "\"" SEOL
+			TAB "TriggerRange: " << emit::real(tp->m_range) << SEOL
+			TAB "TriggerResetDelay: " << emit::real(tp->m_reset_delay) << SEOL
+			TAB "TriggerResetDist: " << emit::real(tp->m_reset_dist) << SEOL
+			TAB "Flags: " << emit::uint(tp->m_flags) << SEOL
+			TAB "Position: ( " << tp->m_position << " )" SEOL
+			TAB "Neighbours: ( " << tp->m_neighbours << " )" SEOL;
+		out << "}" SEOL;
 	}
 
 	for (size_t i = 0; i < m_intersections.size(); ++i)
 	{
 		const Intersection *is = &m_intersections[i];
-		*file << "Intersection {" SEOL;
-		*file << fmt::sprintf(
-			TAB "InterCurveID: %i" SEOL
-			TAB "InterPosition: %f" SEOL
-			TAB "InterRadius: %f" SEOL
-			TAB "Flags: %u" SEOL,
-				is->m_curveId,
-				is->m_position,
-				is->m_radius,
-				is->m_flags
-			);
-		*file << "}" SEOL;
-	}
+		out << "Intersection {" SEOL;
+		out <<
+			TAB "InterCurveID: " << is->m_curveId << SEOL
+			TAB "InterPosition: " << emit::real(is->m_position) << SEOL
+			TAB "InterRadius: " << emit::real(is->m_radius) << SEOL
+			TAB "Flags: " << emit::uint(is->m_flags) << SEOL;
+		out << "}" SEOL;
+	}
+	out.flush();
 	file.reset();
 	return true;
 }
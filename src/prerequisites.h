@@ -147,9 +147,20 @@ class SysFileSystem;
 class ZipFileSystem;
 class HashFileSystem;
 class UberFileSystem;
+class SinkFileSystem;
 
 class File;
 class SysFsFile;
+class InflateReader;
+class MemoryFile;
+
+class OutputSink;
+class FingerprintManifest;
+
+class ThreadPool;
+class Arena;
+class Emitter;
+class Metrics;
 
 struct Vertex;
 struct Polygon;
@@ -177,6 +188,7 @@ class Collision;
 
 class Texture;
 class TextureObject;
+class Image;
 class Material;
 
 class ResourceLibrary;
@@ -29,6 +29,7 @@
 
 auto ResourceLibrary::obtain(String tobjfile) -> Entry
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	if (m_tobjs.find(tobjfile) == m_tobjs.end())
 	{
 		Entry texobj = std::make_shared<TextureObject>();
@@ -45,8 +46,39 @@ auto ResourceLibrary::obtain(String tobjfile) -> Entry
 	return m_tobjs[tobjfile];
 }
 
+bool ResourceLibrary::contains(const String &tobjfile)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_tobjs.find(tobjfile) != m_tobjs.end();
+}
+
+size_t ResourceLibrary::release(const Array<String> &paths)
+{
+	const auto changed = [&](const String &path) {
+		return std::binary_search(paths.begin(), paths.end(), path);
+	};
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t released = 0;
+	for (auto it = m_tobjs.begin(); it != m_tobjs.end();)
+	{
+		const TextureObject &tobj = *it->second;
+		if (changed(it->first) || std::any_of(tobj.m_textures, tobj.m_textures + tobj.m_texturesCount, changed))
+		{
+			it = m_tobjs.erase(it);
+			++released;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	return released;
+}
+
 void ResourceLibrary::destroy()
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	m_tobjs.clear();
 }
 
@@ -25,6 +25,8 @@
 #include <utils/explicit_singleton.h>
 #include <material/material.h>
 
+#include <mutex>
+
 class ResourceLibrary : public ExplicitSingleton<ResourceLibrary>
 {
 public:
@@ -32,9 +34,25 @@ public:
 
 public:
 	Entry obtain(String tobjfile);
+
+	/**
+	 * @brief: Checks whether the texture object has been loaded already
+	 */
+	bool contains(const String &tobjfile);
 	void destroy();
 
+	/**
+	 * @brief: Drops the cached texture objects which have changed or use changed textures
+	 *
+	 * The next obtain() loads them again, the objects held by loaded models are not affected.
+	 *
+	 * @param[in] paths The sorted paths of the changed files
+	 * @return @c The number of dropped texture objects
+	 */
+	size_t release(const Array<String> &paths);
+
 private:
+	std::mutex m_mutex;
 	UnorderedMap<String, Entry> m_tobjs;
 };
 
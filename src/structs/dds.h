@@ -61,6 +61,12 @@ namespace dds
 		HF_DEPTH						= 0x800000
 	};
 
+	enum caps2_flags
+	{
+		CAPS2_CUBEMAP					= 0x200,
+		CAPS2_VOLUME					= 0x200000
+	};
+
 	struct header
 	{
 		u32 m_size;						// +0
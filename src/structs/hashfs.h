@@ -35,6 +35,8 @@ namespace prism
 		u32 m_start_offset;		// +16
 		pad(12);				// +20
 		// +32 --
+		static constexpr u32 MAGIC = MAKEFOURCC('S', 'C', 'S', '#');
+		static constexpr u32 HASH_METHOD_CITY = MAKEFOURCC('C', 'I', 'T', 'Y');
 		static constexpr u32 SUPPORTED_VERSION = 0x01;
 	};	ENSURE_SIZE(hashfs_header_t, 32);
 
@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/structs/tar.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+#pragma pack(push, 1)
+
+namespace tar
+{
+	const size_t BLOCK_SIZE = 512;
+
+	struct TYPE_FLAG
+	{
+		enum : char
+		{
+			REGULAR				= '0',
+			DIRECTORY			= '5',
+			GNU_LONG_NAME		= 'L'
+		};
+	};
+
+	struct Header
+	{
+		char name[100];						// +0
+		char mode[8];						// +100
+		char uid[8];						// +108
+		char gid[8];						// +116
+		char size[12];						// +124
+		char mtime[12];						// +136
+		char checksum[8];					// +148
+		char typeflag;						// +156
+		char linkname[100];					// +157
+		char magic[6];						// +257
+		char version[2];					// +263
+		char uname[32];						// +265
+		char gname[32];						// +297
+		char devmajor[8];					// +329
+		char devminor[8];					// +337
+		char prefix[155];					// +345
+		char padding[12];					// +500
+	};	static_assert(sizeof(Header) == BLOCK_SIZE, "Unexpected structure size");
+} // namespace tar
+
+#pragma pack(pop)
+
+/* eof */
@@ -0,0 +1,678 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/structs/validator.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "validator.h"
+
+#include <structs/pmd.h>
+#include <structs/pmg_0x13.h>
+#include <structs/pmg_0x14.h>
+#include <structs/pmg_0x15.h>
+#include <structs/pma_0x03.h>
+#include <structs/pma_0x04.h>
+#include <structs/pmc.h>
+#include <structs/ppd_0x15.h>
+#include <structs/ppd_0x16.h>
+#include <structs/ppd_0x17.h>
+#include <structs/tobj.h>
+#include <texture/texture_object.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VALIDATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+using namespace prism;
+
+namespace
+{
+	/**
+	 * @brief: Returns the largest of the 16-bit values (triangle indices, animation binds)
+	 */
+	u16 max_u16(const u8 *data, size_t count)
+	{
+		size_t i = 0;
+		u16 result = 0;
+#ifdef VALIDATOR_SSE2
+		if (count >= 16)
+		{
+			// there is no unsigned 16-bit max in SSE2, the values are compared flipped to signed
+			const __m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+			__m128i max0 = bias;
+			__m128i max1 = bias;
+			for (; i + 16 <= count; i += 16)
+			{
+				const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * sizeof(u16)));
+				const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + (i + 8) * sizeof(u16)));
+				max0 = _mm_max_epi16(max0, _mm_xor_si128(v0, bias));
+				max1 = _mm_max_epi16(max1, _mm_xor_si128(v1, bias));
+			}
+			u16 lanes[8];
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), _mm_xor_si128(_mm_max_epi16(max0, max1), bias));
+			for (const u16 lane : lanes)
+			{
+				result = std::max(result, lane);
+			}
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			u16 value;
+			memcpy(&value, data + i * sizeof(u16), sizeof(u16));
+			result = std::max(result, value);
+		}
+		return result;
+	}
+
+	/**
+	 * @brief: Finds the entry of the table whose 32-bit field lies outside [0, limit)
+	 *
+	 * @param[in] field The field in the first entry
+	 * @param[in] stride The size of the entry
+	 * @param[in] count The number of entries
+	 * @param[in] limit The end of the valid range
+	 * @param[in] optional Accepts -1 as no offset
+	 * @return The index of the entry or count if all are valid
+	 */
+	size_t find_outside(const u8 *field, size_t stride, size_t count, i32 limit, bool optional)
+	{
+		size_t i = 0;
+#ifdef VALIDATOR_SSE2
+		const __m128i none = _mm_set1_epi32(-1);
+		const __m128i accept = optional ? none : _mm_setzero_si128();
+		const __m128i bound = _mm_set1_epi32(limit);
+		for (; i + 4 <= count; i += 4)
+		{
+			i32 lanes[4];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				memcpy(&lanes[k], field + (i + k) * stride, sizeof(i32));
+			}
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lanes));
+			const __m128i inside = _mm_and_si128(_mm_cmpgt_epi32(v, none), _mm_cmplt_epi32(v, bound));
+			const __m128i valid = _mm_or_si128(inside, _mm_and_si128(_mm_cmpeq_epi32(v, none), accept));
+			if (_mm_movemask_epi8(valid) != 0xFFFF)
+			{
+				break; // the scalar loop finds which one
+			}
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			i32 value;
+			memcpy(&value, field + i * stride, sizeof(i32));
+			if (!(optional && value == -1) && (value < 0 || value >= limit))
+			{
+				return i;
+			}
+		}
+		return count;
+	}
+
+	/**
+	 * @brief: Checks ranges of the buffer and describes the first one which does not fit
+	 */
+	class Layout
+	{
+	public:
+		Layout(const u8 *data, size_t size, String &diagnostic)
+			: m_data(data)
+			, m_size(size)
+			, m_diagnostic(diagnostic)
+		{
+		}
+
+		template <typename T>
+		const T *at(u64 offset) const
+		{
+			return reinterpret_cast<const T *>(m_data + offset);
+		}
+
+		size_t size() const { return m_size; }
+
+		/**
+		 * @brief: Prefixes the following diagnostics with the entry, e.g. "piece 3: "
+		 */
+		void enter(const char *scope, i64 index)
+		{
+			m_scope = scope;
+			m_index = index;
+		}
+
+		void leave()
+		{
+			m_scope = nullptr;
+		}
+
+		template <typename... Args>
+		bool fail(const char *format, const Args &... args)
+		{
+			m_diagnostic = fmt::sprintf(format, args...);
+			if (m_scope)
+			{
+				m_diagnostic = fmt::sprintf("%s %lli: ", m_scope, m_index) + m_diagnostic;
+			}
+			return false;
+		}
+
+		bool header(size_t headerSize)
+		{
+			if (m_size < headerSize)
+			{
+				return fail("header: %zu bytes exceed file size %zu", headerSize, m_size);
+			}
+			return true;
+		}
+
+		/**
+		 * @brief: Checks the table of count entries of stride bytes at the offset
+		 */
+		bool table(const char *name, i64 offset, i64 count, u64 stride)
+		{
+			if (count < 0)
+			{
+				return fail("%s: negative count %lli", name, count);
+			}
+			if (count == 0)
+			{
+				return true;
+			}
+			if (offset < 0 || !inside(static_cast<u64>(offset), static_cast<u64>(count) * stride))
+			{
+				return fail("%s: %lli x %llu bytes at offset %lli exceed file size %zu", name, count, stride, offset, m_size);
+			}
+			return true;
+		}
+
+		/**
+		 * @brief: Checks the vertex stream of count elements of elementSize bytes interleaved by the stride
+		 */
+		bool stream(const char *name, i64 offset, i64 count, u64 stride, u64 elementSize)
+		{
+			if (count <= 0)
+			{
+				return true;
+			}
+			if (offset < 0 || !inside(static_cast<u64>(offset), stride * static_cast<u64>(count - 1) + elementSize))
+			{
+				return fail("%s stream: %lli elements of %llu bytes (stride %llu) at offset %lli exceed file size %zu",
+					name, count, elementSize, stride, offset, m_size);
+			}
+			return true;
+		}
+
+		/**
+		 * @brief: Checks that the zero terminated string at the offset ends inside the buffer
+		 */
+		bool string(const char *name, u64 offset)
+		{
+			if (offset >= m_size || !memchr(m_data + offset, '\0', m_size - offset))
+			{
+				return fail("%s: string at offset %llu is not terminated inside file size %zu", name, offset, m_size);
+			}
+			return true;
+		}
+
+		/**
+		 * @brief: Checks the triangle list at the offset, every index must be below the vertex count
+		 */
+		bool indices(const char *name, i64 offset, i64 count, i64 verts)
+		{
+			if (!table(name, offset, count, sizeof(u16)))
+			{
+				return false;
+			}
+			if (count > 0)
+			{
+				const u16 max = max_u16(m_data + offset, static_cast<size_t>(count));
+				if (max >= verts)
+				{
+					return fail("%s: vertex index %i exceeds vertex count %lli", name, max, verts);
+				}
+			}
+			return true;
+		}
+
+	private:
+		bool inside(u64 offset, u64 bytes) const
+		{
+			return offset <= m_size && bytes <= m_size - offset;
+		}
+
+	private:
+		const u8 *const m_data;
+		const size_t m_size;
+		String &m_diagnostic;
+
+		const char *m_scope = nullptr;
+		i64 m_index = 0;
+	};
+
+	template <typename Bone>
+	bool validate_bones(Layout &layout, const Bone *bones, i32 count)
+	{
+		for (i32 i = 0; i < count; ++i)
+		{
+			if (bones[i].m_parent != 0xff && bones[i].m_parent >= count)
+			{
+				return layout.fail("bone %i: parent %i exceeds bone count %i", i, bones[i].m_parent, count);
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief: Checks the hookup offsets of the locators against the size of the string pool
+	 */
+	template <typename Locator>
+	bool validate_hookups(Layout &layout, const Locator *locators, i32 count, size_t hookupField, i32 poolSize)
+	{
+		const size_t invalid = find_outside(reinterpret_cast<const u8 *>(locators) + hookupField, sizeof(Locator), count, poolSize, true);
+		if (invalid != static_cast<size_t>(count))
+		{
+			i32 hookup;
+			memcpy(&hookup, reinterpret_cast<const u8 *>(locators + invalid) + hookupField, sizeof(i32));
+			return layout.fail("locator %zu: hookup offset %i is outside string pool of size %i", invalid, hookup, poolSize);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief: Validates the geometry of version 0x14 and 0x15, which differ only in the header
+	 */
+	template <typename Header, typename BoneData, typename Part, typename Locator, typename Piece, typename Tangent>
+	bool validate_pmg_0x14_layout(const u8 *data, size_t size, String &diagnostic)
+	{
+		Layout layout(data, size, diagnostic);
+		if (!layout.header(sizeof(Header)))
+		{
+			return false;
+		}
+		const Header *const header = layout.at<Header>(0);
+
+		if (!layout.table("bones", header->m_skeleton_offset, header->m_bone_count, sizeof(BoneData))
+			|| !layout.table("parts", header->m_parts_offset, header->m_part_count, sizeof(Part))
+			|| !layout.table("locators", header->m_locators_offset, header->m_locator_count, sizeof(Locator))
+			|| !layout.table("pieces", header->m_pieces_offset, header->m_piece_count, sizeof(Piece))
+			|| !layout.table("string pool", header->m_string_pool_offset, header->m_string_pool_size, 1))
+		{
+			return false;
+		}
+
+		if (!validate_bones(layout, layout.at<BoneData>(header->m_skeleton_offset), header->m_bone_count)
+			|| !validate_hookups(layout, layout.at<Locator>(header->m_locators_offset), header->m_locator_count,
+				offsetof(Locator, m_hookup_offset), header->m_string_pool_size))
+		{
+			return false;
+		}
+
+		const Piece *piece = layout.at<Piece>(header->m_pieces_offset);
+		for (i32 i = 0; i < header->m_piece_count; ++i, ++piece)
+		{
+			layout.enter("piece", i);
+			if (piece->m_verts < 0 || piece->m_edges < 0 || piece->m_texcoord_width < 0)
+			{
+				return layout.fail("negative count (verts: %i, edges: %i, texcoords: %i)", piece->m_verts, piece->m_edges, piece->m_texcoord_width);
+			}
+
+			// the same stride as the loader, the streams are interleaved
+			u64 stride = 0;
+			if (piece->m_vert_position_offset != -1) stride += sizeof(float3);
+			if (piece->m_vert_normal_offset != -1) stride += sizeof(float3);
+			if (piece->m_vert_tangent_offset != -1) stride += sizeof(Tangent);
+			if (piece->m_vert_texcoord_offset != -1) stride += sizeof(float2) * piece->m_texcoord_width;
+			if (piece->m_vert_color_offset != -1) stride += sizeof(u32);
+			if (piece->m_vert_color2_offset != -1) stride += sizeof(u32);
+			if (piece->m_vert_bone_index_offset != -1) stride += 2 * sizeof(u32);
+
+			const auto stream = [&](const char *name, i32 offset, u64 elementSize) {
+				return offset == -1 || layout.stream(name, offset, piece->m_verts, stride, elementSize);
+			};
+			if (!stream("position", piece->m_vert_position_offset, sizeof(float3))
+				|| !stream("normal", piece->m_vert_normal_offset, sizeof(float3))
+				|| !stream("tangent", piece->m_vert_tangent_offset, sizeof(Tangent))
+				|| !stream("texcoord", piece->m_vert_texcoord_offset, sizeof(float2) * piece->m_texcoord_width)
+				|| !stream("color", piece->m_vert_color_offset, sizeof(u32))
+				|| !stream("color2", piece->m_vert_color2_offset, sizeof(u32))
+				|| !stream("bone index", piece->m_vert_bone_index_offset, sizeof(u32))
+				|| !stream("bone weight", piece->m_vert_bone_weight_offset, sizeof(u32))
+				|| !layout.indices("indices", piece->m_index_offset, (piece->m_edges / 3) * 3, piece->m_verts))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <typename Header, typename Frame>
+	bool validate_pma_layout(const u8 *data, size_t size, String &diagnostic)
+	{
+		Layout layout(data, size, diagnostic);
+		if (!layout.header(sizeof(Header)))
+		{
+			return false;
+		}
+		const Header *const header = layout.at<Header>(0);
+
+		return layout.table("bones", header->m_bones_offset, header->m_bones, sizeof(u8))
+			&& layout.table("lengths", header->m_lengths_offset, header->m_frames, sizeof(float))
+			&& layout.table("frames", header->m_frames_offset, static_cast<i64>(header->m_frames) * header->m_bones, sizeof(Frame))
+			&& (header->m_flags != 2 || layout.table("movement", header->m_delta_trans_offset, header->m_frames, sizeof(float3)));
+	}
+
+	template <typename Header, typename Node, typename Curve, typename Sign, typename Semaphore,
+			  typename SpawnPoint, typename TerrainPointVariant, typename MapPoint, typename TriggerPoint, typename Intersection>
+	bool validate_ppd_layout(const u8 *data, size_t size, String &diagnostic)
+	{
+		Layout layout(data, size, diagnostic);
+		if (!layout.header(sizeof(Header)))
+		{
+			return false;
+		}
+		const Header *const header = layout.at<Header>(0);
+
+		return layout.table("nodes", header->m_node_offset, header->m_node_count, sizeof(Node))
+			&& layout.table("curves", header->m_nav_curve_offset, header->m_nav_curve_count, sizeof(Curve))
+			&& layout.table("signs", header->m_sign_offset, header->m_sign_count, sizeof(Sign))
+			&& layout.table("semaphores", header->m_semaphore_offset, header->m_semaphore_count, sizeof(Semaphore))
+			&& layout.table("spawn points", header->m_spawn_point_offset, header->m_spawn_point_count, sizeof(SpawnPoint))
+			&& layout.table("terrain point positions", header->m_terrain_point_pos_offset, header->m_terrain_point_count, sizeof(float3))
+			&& layout.table("terrain point normals", header->m_terrain_point_normal_offset, header->m_terrain_point_count, sizeof(float3))
+			&& layout.table("terrain point variants", header->m_terrain_point_variant_offset, header->m_terrain_point_variant_count, sizeof(TerrainPointVariant))
+			&& layout.table("map points", header->m_map_point_offset, header->m_map_point_count, sizeof(MapPoint))
+			&& layout.table("trigger points", header->m_trigger_point_offset, header->m_trigger_point_count, sizeof(TriggerPoint))
+			&& layout.table("intersections", header->m_intersection_offset, header->m_intersection_count, sizeof(Intersection));
+	}
+} // namespace
+
+namespace prism
+{
+	bool validate_pmd(const u8 *data, size_t size, String &diagnostic)
+	{
+		Layout layout(data, size, diagnostic);
+		if (!layout.header(sizeof(pmd_header_t)))
+		{
+			return false;
+		}
+		const pmd_header_t *const header = layout.at<pmd_header_t>(0);
+
+		const u64 materials = static_cast<u64>(header->m_look_count) * header->m_material_count;
+		if (!layout.table("looks", header->m_look_offset, header->m_look_count, sizeof(token_t))
+			|| !layout.table("variants", header->m_variant_offset, header->m_variant_count, sizeof(token_t))
+			|| !layout.table("part attributes", header->m_part_attribs_offset, header->m_part_count, sizeof(pmd_attrib_link_t))
+			|| !layout.table("attributes", header->m_attribs_offset, header->m_attribs_count, sizeof(pmd_attrib_def_t))
+			|| !layout.table("attribute values", header->m_attribs_value_offset, header->m_variant_count, header->m_attribs_values_size)
+			|| !layout.table("materials", header->m_material_offset, materials, sizeof(u32)))
+		{
+			return false;
+		}
+
+		const u8 *const offsets = data + header->m_material_offset;
+		const i32 limit = static_cast<i32>(std::min<size_t>(size, INT32_MAX));
+		const size_t invalid = find_outside(offsets, sizeof(u32), static_cast<size_t>(materials), limit, false);
+		if (invalid != materials)
+		{
+			return layout.fail("material %zu: offset %u exceeds file size %zu", invalid, *layout.at<u32>(header->m_material_offset + invalid * sizeof(u32)), size);
+		}
+		for (u64 i = 0; i < materials; ++i)
+		{
+			layout.enter("material", i);
+			if (!layout.string("path", *layout.at<u32>(header->m_material_offset + i * sizeof(u32))))
+			{
+				return false;
+			}
+		}
+
+		const auto links = layout.at<pmd_attrib_link_t>(header->m_part_attribs_offset);
+		for (u32 i = 0; i < header->m_part_count; ++i)
+		{
+			if (links[i].m_from < 0 || links[i].m_from > links[i].m_to || static_cast<u32>(links[i].m_to) > header->m_attribs_count)
+			{
+				layout.enter("part", i);
+				return layout.fail("attributes [%i, %i) exceed attribute count %u", links[i].m_from, links[i].m_to, header->m_attribs_count);
+			}
+		}
+
+		const auto defs = layout.at<pmd_attrib_def_t>(header->m_attribs_offset);
+		for (u32 i = 0; i < header->m_attribs_count; ++i)
+		{
+			if (defs[i].m_offset < 0 || static_cast<u64>(defs[i].m_offset) + sizeof(pmd_attrib_value_t) > header->m_attribs_values_size)
+			{
+				layout.enter("attribute", i);
+				return layout.fail("value offset %i exceeds value block size %u", defs[i].m_offset, header->m_attribs_values_size);
+			}
+		}
+		return true;
+	}
+
+	bool validate_pmg_0x13(const u8 *data, size_t size, String &diagnostic)
+	{
+		using namespace pmg_0x13;
+
+		Layout layout(data, size, diagnostic);
+		if (!layout.header(sizeof(pmg_header_t)))
+		{
+			return false;
+		}
+		const pmg_header_t *const header = layout.at<pmg_header_t>(0);
+
+		if (!layout.table("bones", header->m_bone_offset, header->m_bone_count, sizeof(pmg_bone_t))
+			|| !layout.table("parts", header->m_part_offset, header->m_part_count, sizeof(pmg_part_t))
+			|| !layout.table("locators", header->m_locator_offset, header->m_locator_count, sizeof(pmg_locator_t))
+			|| !layout.table("pieces", header->m_piece_offset, header->m_piece_count, sizeof(pmg_piece_t))
+			|| !layout.table("locator names", header->m_locator_name_offset, header->m_locators_name_size, 1))
+		{
+			return false;
+		}
+
+		if (!validate_bones(layout, layout.at<pmg_bone_t>(header->m_bone_offset), header->m_bone_count)
+			|| !validate_hookups(layout, layout.at<pmg_locator_t>(header->m_locator_offset), header->m_locator_count,
+				offsetof(pmg_locator_t, m_name_block_offset), header->m_locators_name_size))
+		{
+			return false;
+		}
+
+		const pmg_piece_t *piece = layout.at<pmg_piece_t>(header->m_piece_offset);
+		for (i32 i = 0; i < header->m_piece_count; ++i, ++piece)
+		{
+			layout.enter("piece", i);
+			if (piece->m_verts < 0 || piece->m_edges < 0 || piece->m_uv_channels < 0 || piece->m_bone_count < 0)
+			{
+				return layout.fail("negative count (verts: %i, edges: %i, uv channels: %i, bones: %i)",
+					piece->m_verts, piece->m_edges, piece->m_uv_channels, piece->m_bone_count);
+			}
+
+			// the same strides as the loader, skinned pieces keep the positions apart from the rest
+			u64 strideStatic = 0;
+			u64 strideDynamic = 0;
+			if (piece->m_vert_position_offset != -1) strideStatic += sizeof(float3);
+			if (piece->m_vert_normal_offset != -1) strideStatic += sizeof(float3);
+			if (piece->m_vert_tangent_offset != -1) strideStatic += sizeof(pmg_vert_tangent_t);
+			if (piece->m_vert_uv_offset != -1) strideDynamic += sizeof(float2) * piece->m_uv_channels;
+			if (piece->m_vert_rgba_offset != -1) strideDynamic += sizeof(u32);
+			if (piece->m_vert_rgba2_offset != -1) strideDynamic += sizeof(u32);
+			if (piece->m_bone_count == 0)
+			{
+				strideStatic += strideDynamic;
+				strideDynamic = strideStatic;
+			}
+
+			const auto stream = [&](const char *name, i32 offset, u64 stride, u64 elementSize) {
+				return offset == -1 || layout.stream(name, offset, piece->m_verts, stride, elementSize);
+			};
+			if (!stream("position", piece->m_vert_position_offset, strideStatic, sizeof(float3))
+				|| !stream("normal", piece->m_vert_normal_offset, strideStatic, sizeof(float3))
+				|| !stream("tangent", piece->m_vert_tangent_offset, strideStatic, sizeof(pmg_vert_tangent_t))
+				|| !stream("uv", piece->m_vert_uv_offset, strideDynamic, sizeof(float2) * piece->m_uv_channels)
+				|| !stream("rgba", piece->m_vert_rgba_offset, strideDynamic, sizeof(u32))
+				|| !stream("rgba2", piece->m_vert_rgba2_offset, strideDynamic, sizeof(u32))
+				|| !layout.indices("triangles", piece->m_triangle_offset, (piece->m_edges / 3) * 3, piece->m_verts))
+			{
+				return false;
+			}
+
+			// every vertex selects a group of m_bone_count bones and weights
+			if (piece->m_anim_bind_offset != -1 && piece->m_verts > 0)
+			{
+				if (!layout.table("anim binds", piece->m_anim_bind_offset, piece->m_verts, sizeof(u16)))
+				{
+					return false;
+				}
+				const i64 groups = static_cast<i64>(max_u16(data + piece->m_anim_bind_offset, piece->m_verts)) + 1;
+				if (!layout.table("anim bind bones", piece->m_anim_bind_bones_offset, groups * piece->m_bone_count, sizeof(u8))
+					|| !layout.table("anim bind weights", piece->m_anim_bind_bones_weight_offset, groups * piece->m_bone_count, sizeof(u8)))
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool validate_pmg_0x14(const u8 *data, size_t size, String &diagnostic)
+	{
+		using namespace pmg_0x14;
+		return validate_pmg_0x14_layout<pmg_header_t, pmg_bone_data_t, pmg_part_t, pmg_locator_t, pmg_piece_t, pmg_vert_tangent_t>(data, size, diagnostic);
+	}
+
+	bool validate_pmg_0x15(const u8 *data, size_t size, String &diagnostic)
+	{
+		using namespace pmg_0x15;
+		return validate_pmg_0x14_layout<pmg_header_t, pmg_bone_data_t, pmg_part_t, pmg_locator_t, pmg_piece_t, pmg_vert_tangent_t>(data, size, diagnostic);
+	}
+
+	bool validate_pma_0x03(const u8 *data, size_t size, String &diagnostic)
+	{
+		return validate_pma_layout<pma_0x03::pma_header_t, pma_0x03::pma_frame_t>(data, size, diagnostic);
+	}
+
+	bool validate_pma_0x04(const u8 *data, size_t size, String &diagnostic)
+	{
+		return validate_pma_layout<pma_0x04::pma_header_t, pma_0x04::pma_frame_t>(data, size, diagnostic);
+	}
+
+	bool validate_pmc(const u8 *data, size_t size, String &diagnostic)
+	{
+		Layout layout(data, size, diagnostic);
+		if (!layout.header(sizeof(pmc_header_t)))
+		{
+			return false;
+		}
+		const pmc_header_t *const header = layout.at<pmc_header_t>(0);
+
+		if (!layout.table("pieces", header->m_piece_offset, header->m_piece_count, sizeof(pmc_piece_t))
+			|| !layout.table("variants", header->m_variant_offset, header->m_variant_count, sizeof(pmc_variant_t))
+			|| !layout.table("variant definitions", header->m_variant_def_offset, header->m_variant_count, sizeof(pmc_variant_def_t)))
+		{
+			return false;
+		}
+
+		const pmc_piece_t *piece = layout.at<pmc_piece_t>(header->m_piece_offset);
+		for (u32 i = 0; i < header->m_piece_count; ++i, ++piece)
+		{
+			layout.enter("piece", i);
+			if (!layout.table("vertices", piece->m_vert_offset, piece->m_verts, sizeof(float3))
+				|| !layout.indices("triangles", piece->m_face_offset, (piece->m_edges / 3) * 3, piece->m_verts))
+			{
+				return false;
+			}
+		}
+
+		// the locators of the variant follow each other up to the one with data size -1
+		const pmc_variant_def_t *def = layout.at<pmc_variant_def_t>(header->m_variant_def_offset);
+		for (u32 i = 0; i < header->m_variant_count; ++i, ++def)
+		{
+			layout.enter("variant", i);
+			for (u64 offset = def->m_offset; ; )
+			{
+				if (!layout.table("locator", offset, 1, sizeof(pmc_locator_t)))
+				{
+					return false;
+				}
+				const pmc_locator_t *const locator = layout.at<pmc_locator_t>(offset);
+				if (locator->m_data_size == -1)
+				{
+					break;
+				}
+				if (locator->m_data_size < static_cast<s32>(sizeof(pmc_locator_t)))
+				{
+					return layout.fail("locator at offset %llu: data size %i is smaller than locator", offset, locator->m_data_size);
+				}
+				if (!layout.table("locator", offset, 1, locator->m_data_size))
+				{
+					return false;
+				}
+				offset += locator->m_data_size;
+			}
+		}
+		return true;
+	}
+
+	bool validate_ppd_0x15(const u8 *data, size_t size, String &diagnostic)
+	{
+		using namespace ppd_0x15;
+		return validate_ppd_layout<ppd_header_t, ppd_node_t, ppd_curve_t, ppd_sign_t, ppd_semaphore_t, ppd_spawn_point_t,
+			ppd_terrain_point_variant_t, ppd_map_point_t, ppd_trigger_point_t, ppd_intersection_t>(data, size, diagnostic);
+	}
+
+	bool validate_ppd_0x16(const u8 *data, size_t size, String &diagnostic)
+	{
+		using namespace ppd_0x16;
+		return validate_ppd_layout<ppd_header_t, ppd_node_t, ppd_curve_t, ppd_sign_t, ppd_semaphore_t, ppd_spawn_point_t,
+			ppd_terrain_point_variant_t, ppd_map_point_t, ppd_trigger_point_t, ppd_intersection_t>(data, size, diagnostic);
+	}
+
+	bool validate_ppd_0x17(const u8 *data, size_t size, String &diagnostic)
+	{
+		using namespace ppd_0x17;
+		return validate_ppd_layout<ppd_header_t, ppd_node_t, ppd_curve_t, ppd_sign_t, ppd_semaphore_t, ppd_spawn_point_t,
+			ppd_terrain_point_variant_t, ppd_map_point_t, ppd_trigger_point_t, ppd_intersection_t>(data, size, diagnostic);
+	}
+
+	bool validate_tobj(const u8 *data, size_t size, String &diagnostic)
+	{
+		Layout layout(data, size, diagnostic);
+		if (!layout.header(sizeof(tobj_header_t)))
+		{
+			return false;
+		}
+		const tobj_header_t *const header = layout.at<tobj_header_t>(0);
+
+		// cube maps name all six faces, the other types (1D, 2D, 3D) one texture
+		const u32 textures = header->m_type == TextureObject::_CUBE_MAP ? 6 : 1;
+		u64 offset = sizeof(tobj_header_t);
+		for (u32 i = 0; i < textures; ++i)
+		{
+			layout.enter("texture", i);
+			if (!layout.table("entry", offset, 1, sizeof(tobj_texture_t))
+				|| !layout.table("path", offset + sizeof(tobj_texture_t), layout.at<tobj_texture_t>(offset)->m_length, 1))
+			{
+				return false;
+			}
+			offset += sizeof(tobj_texture_t) + layout.at<tobj_texture_t>(offset)->m_length;
+		}
+		return true;
+	}
+} // namespace prism
+
+/* eof */
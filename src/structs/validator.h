@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/structs/validator.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * Structural validation of the binary formats.
+ *
+ * Each function checks in one pass that every table given by an offset and a count,
+ * and every offset stored inside the tables (vertex streams, indices, strings, locators),
+ * lies inside the buffer. Indices into other tables are checked against their counts.
+ * When the function returns true the loader may follow the offsets without any further
+ * checks, otherwise the diagnostic names the first offending table and entry.
+ *
+ * @param[in] data The whole file
+ * @param[in] size The size of the file
+ * @param[out] diagnostic The description of the problem, set when false is returned
+ * @return @c True if the file is well formed
+ */
+namespace prism
+{
+	bool validate_pmd(const u8 *data, size_t size, String &diagnostic);
+
+	bool validate_pmg_0x13(const u8 *data, size_t size, String &diagnostic);
+	bool validate_pmg_0x14(const u8 *data, size_t size, String &diagnostic);
+	bool validate_pmg_0x15(const u8 *data, size_t size, String &diagnostic);
+
+	bool validate_pma_0x03(const u8 *data, size_t size, String &diagnostic);
+	bool validate_pma_0x04(const u8 *data, size_t size, String &diagnostic);
+
+	bool validate_pmc(const u8 *data, size_t size, String &diagnostic);
+
+	bool validate_ppd_0x15(const u8 *data, size_t size, String &diagnostic);
+	bool validate_ppd_0x16(const u8 *data, size_t size, String &diagnostic);
+	bool validate_ppd_0x17(const u8 *data, size_t size, String &diagnostic);
+
+	bool validate_tobj(const u8 *data, size_t size, String &diagnostic);
+} // namespace prism
+
+/* eof */
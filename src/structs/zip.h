@@ -159,6 +159,17 @@ namespace zip
 		uint64_t centralDirOffsetStartDisk;	// +48
 	};	static_assert(sizeof(ZIP64EndOfCentralDirectory) == 56, "Unexpected structure size");
 
+	struct ExtraFieldHeader
+	{
+		static constexpr uint16_t ZIP64_EXTENDED_INFORMATION = 0x0001;
+
+		uint16_t headerId;					// +0
+		uint16_t dataSize;					// +2
+		/*
+			char data[dataSize];
+		*/
+	};	static_assert(sizeof(ExtraFieldHeader) == 4, "Unexpected structure size");
+
 	struct DigitalSignature
 	{
 		static constexpr uint32_t SIGNATURE = MAKE_ZIP_SIGNATURE(5, 5);
@@ -0,0 +1,449 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/texture/dds_decoder.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "dds_decoder.h"
+#include "image.h"
+
+#include <structs/dds.h>
+#include <utils/thread_pool.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DDS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const u32 BAND_BLOCK_ROWS = 16;	// block rows decoded by single task
+
+	enum class Codec
+	{
+		BC1,		// DXT1
+		BC2,		// DXT2, DXT3
+		BC3,		// DXT4, DXT5
+		BC4,		// ATI1
+		BC5,		// ATI2
+		MASKED		// uncompressed, described by bit masks
+	};
+
+	inline u32 pack(u32 r, u32 g, u32 b, u32 a)
+	{
+		return r | (g << 8) | (b << 16) | (a << 24);
+	}
+
+	inline u32 readU32(const u8 *data)
+	{
+		u32 result;
+		memcpy(&result, data, sizeof(result));
+		return result;
+	}
+
+	inline u32 expand565(u32 c)
+	{
+		const u32 r = (c >> 11) & 0x1F;
+		const u32 g = (c >> 5) & 0x3F;
+		const u32 b = c & 0x1F;
+		return pack((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 0xFF);
+	}
+
+	inline u32 blend(u32 a, u32 b, u32 wa, u32 wb, u32 divisor)
+	{
+		u32 result = 0;
+		for (u32 shift = 0; shift < 24; shift += 8)
+		{
+			const u32 value = (((a >> shift) & 0xFF) * wa + ((b >> shift) & 0xFF) * wb) / divisor;
+			result |= value << shift;
+		}
+		return result | 0xFF000000;
+	}
+
+	/**
+	 * @brief: Writes the palette entries selected by 2-bit indices of 16 pixels
+	 */
+	inline void expandIndices(const u32 palette[4], u32 indices, u32 *out)
+	{
+#ifdef DDS_SSE2
+		// every lane masks its own 2 bits and compares them with the shifted index values
+		const __m128i masks = _mm_setr_epi32(0x03, 0x0C, 0x30, 0xC0);
+		const __m128i one = _mm_setr_epi32(0x01, 0x04, 0x10, 0x40);
+		const __m128i two = _mm_setr_epi32(0x02, 0x08, 0x20, 0x80);
+		const __m128i p0 = _mm_set1_epi32(static_cast<int>(palette[0]));
+		const __m128i p1 = _mm_set1_epi32(static_cast<int>(palette[1]));
+		const __m128i p2 = _mm_set1_epi32(static_cast<int>(palette[2]));
+		const __m128i p3 = _mm_set1_epi32(static_cast<int>(palette[3]));
+		for (u32 row = 0; row < 4; ++row, indices >>= 8)
+		{
+			const __m128i index = _mm_and_si128(_mm_set1_epi32(static_cast<int>(indices)), masks);
+			__m128i result = _mm_and_si128(_mm_cmpeq_epi32(index, _mm_setzero_si128()), p0);
+			result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi32(index, one), p1));
+			result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi32(index, two), p2));
+			result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi32(index, masks), p3));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out + row * 4), result);
+		}
+#else
+		for (u32 i = 0; i < 16; ++i)
+		{
+			out[i] = palette[(indices >> (i * 2)) & 3];
+		}
+#endif
+	}
+
+	/**
+	 * @brief: Decodes BC1 color block, the 3-color mode is used only by BC1 itself
+	 */
+	void decodeColors(const u8 *block, bool bc1, u32 *out)
+	{
+		const u32 c0 = block[0] | (block[1] << 8);
+		const u32 c1 = block[2] | (block[3] << 8);
+
+		u32 palette[4];
+		palette[0] = expand565(c0);
+		palette[1] = expand565(c1);
+		if (c0 > c1 || !bc1)
+		{
+			palette[2] = blend(palette[0], palette[1], 2, 1, 3);
+			palette[3] = blend(palette[0], palette[1], 1, 2, 3);
+		}
+		else
+		{
+			palette[2] = blend(palette[0], palette[1], 1, 1, 2);
+			palette[3] = 0;	// transparent black
+		}
+		expandIndices(palette, readU32(block + 4), out);
+	}
+
+	/**
+	 * @brief: Decodes BC4 block of single channel values
+	 */
+	void decodeChannel(const u8 *block, u8 *out)
+	{
+		const u32 a0 = block[0];
+		const u32 a1 = block[1];
+
+		u8 palette[8];
+		palette[0] = static_cast<u8>(a0);
+		palette[1] = static_cast<u8>(a1);
+		if (a0 > a1)
+		{
+			for (u32 i = 1; i < 7; ++i)
+			{
+				palette[i + 1] = static_cast<u8>(((7 - i) * a0 + i * a1) / 7);
+			}
+		}
+		else
+		{
+			for (u32 i = 1; i < 5; ++i)
+			{
+				palette[i + 1] = static_cast<u8>(((5 - i) * a0 + i * a1) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 0xFF;
+		}
+
+		u64 bits = 0;
+		for (u32 i = 0; i < 6; ++i)
+		{
+			bits |= static_cast<u64>(block[2 + i]) << (i * 8);
+		}
+		for (u32 i = 0; i < 16; ++i, bits >>= 3)
+		{
+			out[i] = palette[bits & 7];
+		}
+	}
+
+	inline u8 reconstructZ(u8 x, u8 y)
+	{
+		const float nx = x * (2.f / 255.f) - 1.f;
+		const float ny = y * (2.f / 255.f) - 1.f;
+		const float nz = std::sqrt(std::max(0.f, 1.f - nx * nx - ny * ny));
+		return static_cast<u8>(nz * 127.5f + 127.5f + 0.5f);
+	}
+
+	void decodeBlock(Codec codec, const u8 *block, bool tsnormal, u32 *out)
+	{
+		switch (codec)
+		{
+			case Codec::BC1:
+			{
+				decodeColors(block, true, out);
+			} break;
+			case Codec::BC2:
+			{
+				decodeColors(block + 8, false, out);
+				for (u32 i = 0; i < 16; ++i)
+				{
+					const u32 alpha = (block[i / 2] >> ((i & 1) * 4)) & 0xF;
+					out[i] = (out[i] & 0x00FFFFFF) | ((alpha | (alpha << 4)) << 24);
+				}
+			} break;
+			case Codec::BC3:
+			{
+				u8 alpha[16];
+				decodeChannel(block, alpha);
+				decodeColors(block + 8, false, out);
+				for (u32 i = 0; i < 16; ++i)
+				{
+					out[i] = (out[i] & 0x00FFFFFF) | (static_cast<u32>(alpha[i]) << 24);
+				}
+			} break;
+			case Codec::BC4:
+			{
+				u8 value[16];
+				decodeChannel(block, value);
+				for (u32 i = 0; i < 16; ++i)
+				{
+					out[i] = pack(value[i], value[i], value[i], 0xFF);
+				}
+			} break;
+			case Codec::BC5:
+			{
+				u8 x[16], y[16];
+				decodeChannel(block, x);
+				decodeChannel(block + 8, y);
+				for (u32 i = 0; i < 16; ++i)
+				{
+					out[i] = pack(x[i], y[i], tsnormal ? reconstructZ(x[i], y[i]) : 0, 0xFF);
+				}
+			} break;
+			default: break;
+		}
+	}
+
+	/**
+	 * @brief: Channel of the uncompressed pixel described by the bit mask
+	 */
+	struct Channel
+	{
+		u32 m_mask = 0;
+		u32 m_shift = 0;
+		u32 m_max = 0;
+
+		Channel(u32 mask)
+			: m_mask(mask)
+		{
+			if (mask)
+			{
+				while (!(mask & 1)) { mask >>= 1; ++m_shift; }
+				m_max = mask;
+			}
+		}
+
+		inline u32 extract(u32 pixel, u32 fallback) const
+		{
+			return m_max ? (((pixel & m_mask) >> m_shift) * 255 + m_max / 2) / m_max : fallback;
+		}
+	};
+
+	void decodeMasked(const dds::pixel_format &format, const u8 *data, u32 width, u32 first, u32 last, bool tsnormal, Image &image)
+	{
+		const u32 bytes = format.m_rgb_bit_count / 8;
+		const size_t pitch = static_cast<size_t>(width) * bytes;
+
+#ifdef DDS_SSE2
+		if (format == dds::FORMAT_A8R8G8B8)
+		{
+			// BGRA in memory, only red and blue are swapped
+			const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+			const __m128i low = _mm_set1_epi32(0xFF);
+			for (u32 y = first; y < last; ++y)
+			{
+				const u8 *src = data + y * pitch;
+				u8 *dst = image.row(y);
+				u32 x = 0;
+				for (; x + 4 <= width; x += 4)
+				{
+					const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x * 4));
+					const __m128i rb = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), low), _mm_slli_epi32(_mm_and_si128(v, low), 16));
+					_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), _mm_or_si128(_mm_and_si128(v, keep), rb));
+				}
+				for (; x < width; ++x)
+				{
+					dst[x * 4 + 0] = src[x * 4 + 2];
+					dst[x * 4 + 1] = src[x * 4 + 1];
+					dst[x * 4 + 2] = src[x * 4 + 0];
+					dst[x * 4 + 3] = src[x * 4 + 3];
+				}
+			}
+			return;
+		}
+#endif
+
+		const Channel r(format.m_r_bit_mask), g(format.m_g_bit_mask), b(format.m_b_bit_mask);
+		const Channel a(format.m_flags & dds::PF_ALPHAPIXELS ? format.m_a_bit_mask : 0);
+		const bool normal = tsnormal && format == dds::FORMAT_R16G16;
+		const bool luminance = (format.m_flags & dds::PF_LUMINANCE) != 0;
+		for (u32 y = first; y < last; ++y)
+		{
+			const u8 *src = data + y * pitch;
+			u32 *dst = reinterpret_cast<u32 *>(image.row(y));
+			for (u32 x = 0; x < width; ++x, src += bytes)
+			{
+				u32 pixel = 0;
+				memcpy(&pixel, src, bytes);
+				const u32 red = r.extract(pixel, 0);
+				const u32 green = luminance ? red : g.extract(pixel, 0);
+				const u32 blue = luminance ? red : normal ? reconstructZ(static_cast<u8>(red), static_cast<u8>(green)) : b.extract(pixel, 0);
+				dst[x] = pack(red, green, blue, a.extract(pixel, 0xFF));
+			}
+		}
+	}
+}
+
+namespace dds
+{
+	bool decode(const String &name, const void *data, size_t size, bool tsnormal, Image &image, ThreadPool *pool)
+	{
+		const u8 *const bytes = static_cast<const u8 *>(data);
+		if (size < sizeof(u32) + sizeof(header) || readU32(bytes) != MAGIC)
+		{
+			error("dds", name, "Invalid dds header!");
+			return false;
+		}
+
+		header h;
+		memcpy(&h, bytes + sizeof(u32), sizeof(h));
+		const pixel_format &format = h.m_pixel_format;
+		const u8 *const pixels = bytes + sizeof(u32) + sizeof(header);
+		const size_t available = size - sizeof(u32) - sizeof(header);
+		if (h.m_width == 0 || h.m_height == 0 || h.m_width > 0xFFFF || h.m_height > 0xFFFF)
+		{
+			error_f("dds", name, "Invalid dimensions %ux%u!", h.m_width, h.m_height);
+			return false;
+		}
+
+		// the other faces and slices follow the mip chain of the first one, but only one image is decoded
+		if (h.m_caps2 & CAPS2_CUBEMAP)
+		{
+			error("dds", name, "Cube map textures are not supported!");
+			return false;
+		}
+		if ((h.m_caps2 & CAPS2_VOLUME) || ((h.m_flags & HF_DEPTH) && h.m_depth > 1))
+		{
+			error_f("dds", name, "Volume textures are not supported (depth: %u)!", h.m_depth);
+			return false;
+		}
+
+		Codec codec = Codec::MASKED;
+		if (format.m_flags & PF_FOUR_CC)
+		{
+			switch (format.m_four_cc)
+			{
+				case COMPRESS_DXT1: codec = Codec::BC1; break;
+				case COMPRESS_DXT2:
+				case COMPRESS_DXT3: codec = Codec::BC2; break;
+				case COMPRESS_DXT4:
+				case COMPRESS_DXT5: codec = Codec::BC3; break;
+				case s2u32("ATI1"):
+				case s2u32("BC4U"): codec = Codec::BC4; break;
+				case COMPRESS_ATI2:
+				case s2u32("BC5U"): codec = Codec::BC5; break;
+				case s2u32("DX10"):
+				{
+					error("dds", name, "Textures with DX10 header (texture arrays) are not supported!");
+					return false;
+				}
+				default:
+				{
+					error_f("dds", name, "Unsupported compression format: %s", uint2s(format.m_four_cc));
+					return false;
+				}
+			}
+		}
+		else if (!(format.m_flags & (PF_RGB | PF_LUMINANCE)) || format.m_rgb_bit_count == 0
+			|| format.m_rgb_bit_count % 8 != 0 || format.m_rgb_bit_count > 32)
+		{
+			error_f("dds", name, "Unsupported pixel format (flags: 0x%x, bits: %u)!", format.m_flags, format.m_rgb_bit_count);
+			return false;
+		}
+
+		const u32 blocksWide = (h.m_width + 3) / 4;
+		const u32 blocksHigh = (h.m_height + 3) / 4;
+		const size_t blockSize = codec == Codec::BC1 || codec == Codec::BC4 ? 8 : 16;
+		const size_t required = codec == Codec::MASKED
+			? static_cast<size_t>(h.m_width) * h.m_height * (format.m_rgb_bit_count / 8)
+			: static_cast<size_t>(blocksWide) * blocksHigh * blockSize;
+		if (available < required)
+		{
+			error_f("dds", name, "Unexpected end of file (have: %u, expected: %u)!", available, required);
+			return false;
+		}
+
+		image = Image(h.m_width, h.m_height);
+
+		const u32 rows = codec == Codec::MASKED ? h.m_height : blocksHigh;
+		const u32 bandRows = codec == Codec::MASKED ? BAND_BLOCK_ROWS * 4 : BAND_BLOCK_ROWS;
+		const size_t bandCount = (rows + bandRows - 1) / bandRows;
+		const auto decodeBand = [&](size_t band) {
+			const u32 first = static_cast<u32>(band * bandRows);
+			const u32 last = std::min(rows, first + bandRows);
+			if (codec == Codec::MASKED)
+			{
+				decodeMasked(format, pixels, h.m_width, first, last, tsnormal, image);
+				return;
+			}
+
+			u32 tile[16];
+			for (u32 by = first; by < last; ++by)
+			{
+				const u8 *block = pixels + static_cast<size_t>(by) * blocksWide * blockSize;
+				const u32 height = std::min<u32>(4, h.m_height - by * 4);
+				for (u32 bx = 0; bx < blocksWide; ++bx, block += blockSize)
+				{
+					decodeBlock(codec, block, tsnormal, tile);
+					const u32 width = std::min<u32>(4, h.m_width - bx * 4);
+					for (u32 y = 0; y < height; ++y)
+					{
+						memcpy(image.row(by * 4 + y) + bx * 16, tile + y * 4, width * 4);
+					}
+				}
+			}
+		};
+
+		if (pool && bandCount > 1)
+		{
+			pool->parallelFor(bandCount, decodeBand);
+		}
+		else
+		{
+			for (size_t i = 0; i < bandCount; ++i)
+			{
+				decodeBand(i);
+			}
+		}
+
+		const bool alpha = codec == Codec::BC1 || codec == Codec::BC2 || codec == Codec::BC3
+			|| (codec == Codec::MASKED && (format.m_flags & PF_ALPHAPIXELS) && format.m_a_bit_mask);
+		if (alpha)
+		{
+			image.detectAlpha();
+		}
+		else
+		{
+			image.setAlpha(false);
+		}
+		return true;
+	}
+} // namespace dds
+
+/* eof */
@@ -0,0 +1,46 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/texture/dds_decoder.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+namespace dds
+{
+	/**
+	 * @brief: Decodes the top mip level of the dds file
+	 *
+	 * Supported are the block compressed formats DXT1-DXT5, ATI1 and ATI2 (BC1-BC5)
+	 * and the uncompressed formats described by bit masks (dds::FORMAT_*).
+	 * Cube maps, volume textures and texture arrays are rejected, as only one surface is decoded.
+	 * Bands of blocks are decoded in parallel when the pool is given.
+	 *
+	 * @param[in] name The name used in error messages
+	 * @param[in] data The whole dds file
+	 * @param[in] size The size of the file
+	 * @param[in] tsnormal Reconstructs the Z component of two channel normal maps (ATI2, R16G16)
+	 * @param[out] image The decoded image
+	 * @param[in] pool The pool decoding the bands, or nullptr
+	 * @return @c True if the image has been decoded
+	 */
+	bool decode(const String &name, const void *data, size_t size, bool tsnormal, Image &image, ThreadPool *pool = nullptr);
+} // namespace dds
+
+/* eof */
@@ -0,0 +1,259 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/texture/image.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "image.h"
+
+#include <fs/file.h>
+#include <utils/crc32.h>
+#include <utils/thread_pool.h>
+
+#include <zlib/zlib.h>
+
+namespace
+{
+	const size_t BAND_BYTES = 256 * 1024;	// filtered bytes deflated by single task
+	const int PNG_COMPRESSION = Z_BEST_SPEED;	// the textures are working copies, speed matters more
+
+	void writeU32be(u8 *out, u32 value)
+	{
+		out[0] = static_cast<u8>(value >> 24);
+		out[1] = static_cast<u8>(value >> 16);
+		out[2] = static_cast<u8>(value >> 8);
+		out[3] = static_cast<u8>(value);
+	}
+
+	bool writeChunk(File *file, const char *type, const u8 *data, size_t size)
+	{
+		u8 header[8];
+		writeU32be(header, static_cast<u32>(size));
+		memcpy(header + 4, type, 4);
+
+		Crc32 crc;
+		crc.update(type, 4);
+		crc.update(data, size);
+		u8 footer[4];
+		writeU32be(footer, crc.value());
+
+		return file->write(header, 1, sizeof(header)) == sizeof(header)
+			&& (size == 0 || file->write(data, 1, size) == size)
+			&& file->write(footer, 1, sizeof(footer)) == sizeof(footer);
+	}
+
+	inline u8 paeth(u8 a, u8 b, u8 c)
+	{
+		const int p = a + b - c;
+		const int pa = abs(p - a);
+		const int pb = abs(p - b);
+		const int pc = abs(p - c);
+		return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+	}
+
+	/**
+	 * @brief: Deflated band of rows
+	 */
+	struct Band
+	{
+		Array<u8> m_data;
+		uLong m_adler = 1;
+		size_t m_size = 0;	// filtered bytes
+		bool m_valid = false;
+	};
+}
+
+Image::Image(u32 width, u32 height)
+	: m_width(width)
+	, m_height(height)
+	, m_pixels(static_cast<size_t>(width) * height * 4)
+{
+}
+
+void Image::detectAlpha()
+{
+	m_alpha = false;
+	const size_t count = static_cast<size_t>(m_width) * m_height;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (m_pixels[i * 4 + 3] != 0xFF)
+		{
+			m_alpha = true;
+			return;
+		}
+	}
+}
+
+bool Image::saveTga(File *file) const
+{
+	const u32 channels = m_alpha ? 4 : 3;
+
+	u8 header[18] = {};
+	header[2] = 2;	// uncompressed true-color
+	header[12] = static_cast<u8>(m_width);
+	header[13] = static_cast<u8>(m_width >> 8);
+	header[14] = static_cast<u8>(m_height);
+	header[15] = static_cast<u8>(m_height >> 8);
+	header[16] = static_cast<u8>(channels * 8);
+	header[17] = static_cast<u8>(0x20 | (m_alpha ? 8 : 0));	// top-left origin, alpha bits
+	if (file->write(header, 1, sizeof(header)) != sizeof(header))
+	{
+		return false;
+	}
+
+	Array<u8> line(static_cast<size_t>(m_width) * channels);
+	for (u32 y = 0; y < m_height; ++y)
+	{
+		const u8 *src = row(y);
+		u8 *dst = line.data();
+		for (u32 x = 0; x < m_width; ++x, src += 4, dst += channels)
+		{
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = src[0];
+			if (m_alpha)
+			{
+				dst[3] = src[3];
+			}
+		}
+		if (file->write(line.data(), 1, line.size()) != line.size())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Image::savePng(File *file, ThreadPool *pool) const
+{
+	const u32 channels = m_alpha ? 4 : 3;
+	const size_t stride = static_cast<size_t>(m_width) * channels;
+
+	static const u8 SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	u8 ihdr[13];
+	writeU32be(ihdr, m_width);
+	writeU32be(ihdr + 4, m_height);
+	ihdr[8] = 8;					// bit depth
+	ihdr[9] = m_alpha ? 6 : 2;		// RGBA or RGB
+	ihdr[10] = ihdr[11] = ihdr[12] = 0;
+	if (file->write(SIGNATURE, 1, sizeof(SIGNATURE)) != sizeof(SIGNATURE) || !writeChunk(file, "IHDR", ihdr, sizeof(ihdr)))
+	{
+		return false;
+	}
+
+	// every band ends with a sync flush, so the raw deflate streams can be concatenated
+	const u32 bandRows = std::max<u32>(1, static_cast<u32>(BAND_BYTES / (stride + 1)));
+	const size_t bandCount = (m_height + bandRows - 1) / bandRows;
+	Array<Band> bands(bandCount);
+
+	const auto compress = [&](size_t index) {
+		Band &band = bands[index];
+		const u32 first = static_cast<u32>(index * bandRows);
+		const u32 last = std::min(m_height, first + bandRows);
+
+		Array<u8> previous(stride, 0), current(stride);
+		if (first > 0)
+		{
+			const u8 *src = row(first - 1);
+			for (size_t x = 0, i = 0; x < m_width; ++x, src += 4)
+			{
+				for (u32 c = 0; c < channels; ++c)
+				{
+					previous[i++] = src[c];
+				}
+			}
+		}
+
+		Array<u8> filtered((last - first) * (stride + 1));
+		u8 *out = filtered.data();
+		for (u32 y = first; y < last; ++y)
+		{
+			const u8 *src = row(y);
+			for (size_t x = 0, i = 0; x < m_width; ++x, src += 4)
+			{
+				for (u32 c = 0; c < channels; ++c)
+				{
+					current[i++] = src[c];
+				}
+			}
+
+			*out++ = 4;	// paeth
+			for (size_t i = 0; i < channels; ++i)
+			{
+				*out++ = static_cast<u8>(current[i] - previous[i]);
+			}
+			for (size_t i = channels; i < stride; ++i)
+			{
+				*out++ = static_cast<u8>(current[i] - paeth(current[i - channels], previous[i], previous[i - channels]));
+			}
+			std::swap(previous, current);
+		}
+
+		band.m_size = filtered.size();
+		band.m_adler = adler32(adler32(0L, Z_NULL, 0), filtered.data(), static_cast<uInt>(filtered.size()));
+
+		z_stream stream = {};
+		if (deflateInit2(&stream, PNG_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			return;
+		}
+		band.m_data.resize(deflateBound(&stream, static_cast<uLong>(filtered.size())) + 16);
+		stream.next_in = filtered.data();
+		stream.avail_in = static_cast<uInt>(filtered.size());
+		stream.next_out = band.m_data.data();
+		stream.avail_out = static_cast<uInt>(band.m_data.size());
+		const bool final = index + 1 == bandCount;
+		const int result = ::deflate(&stream, final ? Z_FINISH : Z_SYNC_FLUSH);
+		band.m_valid = final ? result == Z_STREAM_END : (result == Z_OK && stream.avail_in == 0);
+		band.m_data.resize(stream.total_out);
+		deflateEnd(&stream);
+	};
+
+	if (pool && bandCount > 1)
+	{
+		pool->parallelFor(bandCount, compress);
+	}
+	else
+	{
+		for (size_t i = 0; i < bandCount; ++i)
+		{
+			compress(i);
+		}
+	}
+
+	Array<u8> idat = { 0x78, 0x9C };
+	uLong adler = adler32(0L, Z_NULL, 0);
+	for (const Band &band : bands)
+	{
+		if (!band.m_valid)
+		{
+			return false;
+		}
+		idat.insert(idat.end(), band.m_data.begin(), band.m_data.end());
+		adler = adler32_combine(adler, band.m_adler, static_cast<z_off_t>(band.m_size));
+	}
+	idat.resize(idat.size() + 4);
+	writeU32be(idat.data() + idat.size() - 4, static_cast<u32>(adler));
+
+	return writeChunk(file, "IDAT", idat.data(), idat.size()) && writeChunk(file, "IEND", nullptr, 0);
+}
+
+/* eof */
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/texture/image.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Uncompressed 8-bit RGBA image, the source format of the SCS texture pipeline.
+ */
+class Image
+{
+public:
+	Image() = default;
+	Image(u32 width, u32 height);
+
+	inline u32 width() const { return m_width; }
+	inline u32 height() const { return m_height; }
+	inline u8 *pixels() { return m_pixels.data(); }
+	inline const u8 *pixels() const { return m_pixels.data(); }
+	inline u8 *row(u32 y) { return m_pixels.data() + static_cast<size_t>(y) * m_width * 4; }
+	inline const u8 *row(u32 y) const { return m_pixels.data() + static_cast<size_t>(y) * m_width * 4; }
+
+	/**
+	 * @brief: Tells whether the alpha channel is written, images without it are saved as 24-bit
+	 */
+	inline bool hasAlpha() const { return m_alpha; }
+	inline void setAlpha(bool alpha) { m_alpha = alpha; }
+
+	/**
+	 * @brief: Enables the alpha channel if any pixel is not opaque
+	 */
+	void detectAlpha();
+
+	/**
+	 * @brief: Writes uncompressed TGA (top-left origin)
+	 *
+	 * @param[in] file The file to write
+	 * @return @c True if the whole image has been written
+	 */
+	bool saveTga(File *file) const;
+
+	/**
+	 * @brief: Writes PNG, the bands of rows are deflated in parallel when the pool is given
+	 *
+	 * @param[in] file The file to write
+	 * @param[in] pool The pool compressing the bands, or nullptr
+	 * @return @c True if the whole image has been written
+	 */
+	bool savePng(File *file, ThreadPool *pool = nullptr) const;
+
+private:
+	u32 m_width = 0;
+	u32 m_height = 0;
+	bool m_alpha = true;
+	Array<u8> m_pixels;
+};
+
+/* eof */
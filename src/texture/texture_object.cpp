@@ -26,9 +26,27 @@
 
 #include <fs/file.h>
 #include <fs/uberfilesystem.h>
+#include <fs/prefetcher.h>
 #include <fs/sysfilesystem.h>
 #include <structs/tobj.h>
 #include <structs/dds.h>
+#include <structs/validator.h>
+#include <texture/image.h>
+#include <texture/dds_decoder.h>
+#include <utils/thread_pool.h>
+#include <config.h>
+
+namespace
+{
+	/**
+	 * @brief: Pool decoding and compressing bands of the images, shared by the conversion threads
+	 */
+	ThreadPool &decodePool()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+}
 
 bool TextureObject::load(String filepath)
 {
@@ -50,12 +68,19 @@ bool TextureObject::load(String filepath)
 	file.reset();
 
 	prism::tobj_header_t *header = (prism::tobj_header_t *)(buffer.get());
-	if (header->m_version != prism::tobj_header_t::SUPPORTED_MAGIC)
+	if (fileSize >= sizeof(u32) && header->m_version != prism::tobj_header_t::SUPPORTED_MAGIC)
 	{
 		error_f("tobj", m_filepath, "Invalid version of tobj file! (have: %i, expected: %i)", header->m_version, prism::tobj_header_t::SUPPORTED_MAGIC);
 		return false;
 	}
 
+	String diagnostic;
+	if (!prism::validate_tobj(buffer.get(), fileSize, diagnostic))
+	{
+		error_f("tobj", m_filepath, "Texture object file is malformed (%s)!", diagnostic);
+		return false;
+	}
+
 	m_type = (Type)(header->m_type);
 	m_magFilter = (Filter)(header->m_mag_filter);
 	m_minFilter = (Filter)(header->m_min_filter);
@@ -105,18 +130,22 @@ bool TextureObject::loadDDS(String filepath)
 	}
 	else
 	{
-		const size_t fileSize = static_cast<size_t>(file->size());
-		UniquePtr<uint8_t[]> buffer(new uint8_t[fileSize]);
-		file->read((char *)buffer.get(), sizeof(char), fileSize);
+		// only the header is inspected
+		uint8_t buffer[sizeof(uint32_t) + sizeof(dds::header)];
+		if (file->size() < sizeof(buffer) || !file->blockRead(buffer, 0, sizeof(buffer)))
+		{
+			error("dds", filepath, "Unable to read dds header");
+			return false;
+		}
 		file.reset();
 
-		const uint32_t magic = *(uint32_t *)(buffer.get());
+		const uint32_t magic = *(uint32_t *)(buffer);
 		if (magic != dds::MAGIC)
 		{
 			error_f("dds", filepath, "Invalid dds magic: %i expected: %i", magic, dds::MAGIC);
 			return false;
 		}
-		dds::header *header = (dds::header *)(buffer.get() + 4);
+		dds::header *header = (dds::header *)(buffer + 4);
 
 		if (m_customColorSpace)
 		{
@@ -130,15 +159,16 @@ bool TextureObject::loadDDS(String filepath)
 	}
 }
 
-bool TextureObject::saveToMidFormats(String exportpath)
+bool TextureObject::saveToMidFormats(String exportpath, const TextureFilter &textures)
 {
-	if (m_converted)
+	if (m_converted.exchange(true))
 		return true;
 
-	auto file = getSFS()->open(exportpath + m_filepath, FileSystem::write | FileSystem::binary);
+	auto file = getOFS()->open(exportpath + m_filepath, FileSystem::write | FileSystem::binary);
 	if (!file)
 	{
 		printf("Cannot open file: \"%s\"! %s\n" SEOL, m_filepath.c_str(), strerror(errno));
+		m_converted = false;
 		return false;
 	}
 
@@ -187,24 +217,8 @@ bool TextureObject::saveToMidFormats(String exportpath)
 	for (uint32_t i = 0; i < m_texturesCount; ++i)
 	{
 		*file << TAB << m_textures[i].c_str() << SEOL;
-
-		if (getSFS()->exists(exportpath + m_textures[i]))
-			continue;
-
-		auto inputf = getUFS()->open(m_textures[i], FileSystem::read | FileSystem::binary);
-		if (!inputf)
-		{
-			printf("Could not open file: \"%s\" to copy-read!\n", m_textures[i].c_str());
-			continue;
-		}
-		auto outputf = getSFS()->open(exportpath + m_textures[i], FileSystem::write | FileSystem::binary);
-		if (!outputf)
-		{
-			printf("Could not open file: \"%s\" to copy-read!\n", (exportpath + m_textures[i]).c_str());
-			continue;
-		}
-		copyFile(inputf.get(), outputf.get());
 	}
+	copyTextures(exportpath, textures);
 
 	*file << "addr" << SEOL;
 	*file << TAB << addrAttribute(m_addr_u) << SEOL;
@@ -255,7 +269,87 @@ bool TextureObject::saveToMidFormats(String exportpath)
 		*file << fmt::sprintf("bias %i" SEOL, m_bias);
 	}
 
-	m_converted = true;
+	return true;
+}
+
+uint32_t TextureObject::copyTextures(String exportpath, const TextureFilter &textures) const
+{
+	uint32_t copied = 0;
+	auto skipped = [&](uint32_t i) {
+		return (textures && !textures(m_textures[i])) || getOFS()->exists(exportpath + m_textures[i]);
+	};
+	if (getPrefetcher()->enabled())
+	{
+		for (uint32_t i = 1; i < m_texturesCount; ++i) // the first one is being opened right away
+		{
+			if (!skipped(i))
+			{
+				getPrefetcher()->hint(m_textures[i]);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < m_texturesCount; ++i)
+	{
+		if (skipped(i))
+			continue;
+
+		auto inputf = getUFS()->open(m_textures[i], FileSystem::read | FileSystem::binary);
+		if (!inputf)
+		{
+			printf("Could not open file: \"%s\" to copy-read!\n", m_textures[i].c_str());
+			continue;
+		}
+		// another job may have started copying the texture since the check above
+		if (!getOFS()->claim(exportpath + m_textures[i]))
+		{
+			continue;
+		}
+		auto outputf = getOFS()->open(exportpath + m_textures[i], FileSystem::write | FileSystem::binary);
+		if (!outputf)
+		{
+			printf("Could not open file: \"%s\" to copy-read!\n", (exportpath + m_textures[i]).c_str());
+			continue;
+		}
+		if (Config::s_decodeTextures.empty())
+		{
+			copyFile(inputf.get(), outputf.get());
+		}
+		else
+		{
+			// the dds is read once, copied and decoded from the same buffer
+			const size_t size = static_cast<size_t>(inputf->size());
+			UniquePtr<u8[]> buffer(new u8[size]);
+			if (!inputf->blockRead(buffer.get(), 0, size))
+			{
+				printf("Could not read file: \"%s\"!\n", m_textures[i].c_str());
+				continue;
+			}
+			outputf->write(buffer.get(), sizeof(u8), size);
+			outputf.reset();
+			decodeTexture(exportpath, m_textures[i], buffer.get(), size);
+		}
+		++copied;
+	}
+	return copied;
+}
+
+bool TextureObject::decodeTexture(const String &exportpath, const String &texture, const void *data, size_t size) const
+{
+	Image image;
+	if (!dds::decode(texture, data, size, m_tsnormal, image, &decodePool()))
+	{
+		return false;
+	}
+
+	const String format = Config::s_decodeTextures;
+	const String path = exportpath + texture.substr(0, texture.rfind('.')) + "." + format;
+	auto file = getOFS()->open(path, FileSystem::write | FileSystem::binary);
+	if (!file || !(format == "png" ? image.savePng(file.get(), &decodePool()) : image.saveTga(file.get())))
+	{
+		error_f("dds", path, "Unable to write decoded texture (%s)!", strerror(errno));
+		return false;
+	}
 	return true;
 }
 
@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+
 class TextureObject
 {
 public:
@@ -52,10 +55,40 @@ public:
 		MIRROR_CLAMP_TO_EDGE = 6
 	};
 
+	/**
+	 * @brief: Decides whether the texture file (absolute path) should be copied
+	 */
+	using TextureFilter = std::function<bool(const String &path)>;
+
 public:
 	bool load(String filepath);
 	bool loadDDS(String filepath);
-	bool saveToMidFormats(String exportpath);
+
+	/**
+	 * @brief: Writes the tobj and copies its textures which are not in the export path yet
+	 *
+	 * @param[in] exportpath The path prepended to the written files
+	 * @param[in] textures Selects the textures to copy, all of them when empty
+	 */
+	bool saveToMidFormats(String exportpath, const TextureFilter &textures = TextureFilter());
+
+	/**
+	 * @brief: Copies the textures only, the tobj itself is not written
+	 *
+	 * @return @c The number of copied textures
+	 */
+	uint32_t copyTextures(String exportpath, const TextureFilter &textures = TextureFilter()) const;
+
+private:
+	/**
+	 * @brief: Writes decoded copy of the dds in the format selected by Config::s_decodeTextures
+	 *
+	 * @param[in] exportpath The path prepended to the written file
+	 * @param[in] texture The path of the dds (ex. "/vehicle/truck/share/glass.dds")
+	 * @param[in] data The contents of the dds
+	 * @param[in] size The size of the dds
+	 */
+	bool decodeTexture(const String &exportpath, const String &texture, const void *data, size_t size) const;
 
 private:
 	uint32_t m_texturesCount = 0;
@@ -77,12 +110,13 @@ private:
 	bool m_customColorSpace = false;
 
 	String m_filepath; // @example /vehicle/truck/share/glass.tobj
-	bool m_converted = false;
+	std::atomic<bool> m_converted{ false }; // shared objects may be exported by several threads
 
 	bool m_tsnormal = false;
 	bool m_ui = false;
 
 	friend Model;
+	friend ResourceLibrary;
 };
 
 /* eof */
@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/arena.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "arena.h"
+
+const size_t Arena::MAX_BLOCK_SIZE;
+
+Arena::Arena(size_t blockSize)
+	: m_blockSize(blockSize)
+	, m_firstBlockSize(blockSize)
+{
+}
+
+Arena::~Arena()
+{
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+	const uintptr_t cursor = reinterpret_cast<uintptr_t>(m_cursor);
+	const uintptr_t aligned = (cursor + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1);
+	if (m_cursor && aligned + size <= reinterpret_cast<uintptr_t>(m_end))
+	{
+		m_cursor = reinterpret_cast<u8 *>(aligned + size);
+		m_allocated += size;
+		return reinterpret_cast<void *>(aligned);
+	}
+	return allocateBlock(size, alignment);
+}
+
+void *Arena::allocateBlock(size_t size, size_t alignment)
+{
+	m_allocated += size;
+
+	// large allocations get their own block, so the current one is not wasted
+	if (size + alignment > m_blockSize / 4)
+	{
+		m_large.emplace_back();
+		return allocateLarge(size, alignment, m_large.back());
+	}
+
+	UniquePtr<u8[]> block(new u8[m_blockSize]);
+	m_cursor = block.get();
+	m_end = m_cursor + m_blockSize;
+	m_reserved += m_blockSize;
+	m_blocks.push_back(std::move(block));
+	m_blockSize = std::min(m_blockSize * 2, std::max(MAX_BLOCK_SIZE, m_firstBlockSize));
+
+	const uintptr_t cursor = reinterpret_cast<uintptr_t>(m_cursor);
+	const uintptr_t aligned = (cursor + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1);
+	m_cursor = reinterpret_cast<u8 *>(aligned + size);
+	return reinterpret_cast<void *>(aligned);
+}
+
+void *Arena::allocateLarge(size_t size, size_t alignment, LargeBlock &block)
+{
+	block.m_memory.reset(new u8[size + alignment]);
+	const uintptr_t start = reinterpret_cast<uintptr_t>(block.m_memory.get());
+	block.m_data = reinterpret_cast<void *>((start + (alignment - 1)) & ~static_cast<uintptr_t>(alignment - 1));
+	m_reserved += size + alignment;
+	return block.m_data;
+}
+
+void *Arena::reallocate(void *data, size_t size, size_t newSize, size_t alignment)
+{
+	if (!data)
+	{
+		return allocate(newSize, alignment);
+	}
+
+	u8 *const bytes = static_cast<u8 *>(data);
+	if (bytes + size == m_cursor && newSize <= static_cast<size_t>(m_end - bytes))
+	{
+		m_cursor = bytes + newSize;
+		m_allocated += newSize - size;
+		return data;
+	}
+
+	// the growing allocation is usually one of the most recent ones
+	for (auto it = m_large.rbegin(); it != m_large.rend(); ++it)
+	{
+		if (it->m_data == data)
+		{
+			LargeBlock block;
+			allocateLarge(newSize, alignment, block);
+			memcpy(block.m_data, data, size);
+			m_reserved -= size + alignment;
+			m_allocated += newSize - size;
+			*it = std::move(block);
+			return it->m_data;
+		}
+	}
+
+	void *const result = allocate(newSize, alignment);
+	memcpy(result, data, size);
+	return result;
+}
+
+void Arena::reset()
+{
+	m_blocks.clear();
+	m_large.clear();
+	m_cursor = nullptr;
+	m_end = nullptr;
+	m_blockSize = m_firstBlockSize;
+	m_allocated = 0;
+	m_reserved = 0;
+}
+
+/* eof */
@@ -0,0 +1,106 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/arena.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Monotonic (bump) allocator.
+ *
+ * Memory is handed out from large blocks and released all at once when the arena
+ * is destroyed or reset. Destructors of the objects placed in the arena are never called.
+ */
+class Arena
+{
+public:
+	/**
+	 * @param[in] blockSize The size of the first block, next blocks grow up to MAX_BLOCK_SIZE
+	 */
+	Arena(size_t blockSize = 64 * 1024);
+	Arena(const Arena &) = delete;
+	Arena(Arena &&) = delete;
+	~Arena();
+
+	Arena &operator=(const Arena &) = delete;
+	Arena &operator=(Arena &&) = delete;
+
+	/**
+	 * @brief: Allocates uninitialized memory
+	 *
+	 * @param[in] size The number of bytes
+	 * @param[in] alignment The alignment, must be power of 2
+	 * @return @c The pointer to the memory valid until the arena is reset
+	 */
+	void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template < typename T >
+	T *allocate(size_t count)
+	{
+		return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/**
+	 * @brief: Grows the allocation, the contents are moved if it cannot grow in place
+	 *
+	 * The last allocation of the current block and the allocations which got their own
+	 * block grow without leaving the old memory behind.
+	 *
+	 * @param[in] data The allocation returned by allocate() or reallocate(), or nullptr
+	 * @param[in] size The size of the allocation
+	 * @param[in] newSize The requested size, not less than size
+	 * @param[in] alignment The alignment of the allocation
+	 * @return @c The pointer to the grown allocation
+	 */
+	void *reallocate(void *data, size_t size, size_t newSize, size_t alignment = alignof(std::max_align_t));
+
+	/**
+	 * @brief: Releases all of the allocations
+	 */
+	void reset();
+
+	inline size_t allocated() const { return m_allocated; }	// bytes handed out
+	inline size_t reserved() const { return m_reserved; }		// bytes of all blocks
+
+public:
+	static const size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+private:
+	struct LargeBlock
+	{
+		UniquePtr<u8[]> m_memory;
+		void *m_data;
+	};
+
+	void *allocateBlock(size_t size, size_t alignment);
+	void *allocateLarge(size_t size, size_t alignment, LargeBlock &block);
+
+private:
+	Array<UniquePtr<u8[]>> m_blocks;
+	Array<LargeBlock> m_large;
+	u8 *m_cursor = nullptr;
+	u8 *m_end = nullptr;
+	size_t m_blockSize;
+	size_t m_firstBlockSize;
+	size_t m_allocated = 0;
+	size_t m_reserved = 0;
+};
+
+/* eof */
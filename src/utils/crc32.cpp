@@ -0,0 +1,229 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/crc32.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "crc32.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CRC32_PCLMUL 1
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32_TARGET_PCLMUL
+#else
+#define CRC32_TARGET_PCLMUL __attribute__((target("sse2,pclmul")))
+#endif
+#endif
+
+namespace
+{
+	const u32 POLYNOMIAL = 0xEDB88320; // reflected 0x04C11DB7
+
+	struct Tables
+	{
+		u32 m_table[8][256];
+
+		Tables()
+		{
+			for (u32 i = 0; i < 256; ++i)
+			{
+				u32 crc = i;
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					crc = (crc >> 1) ^ (POLYNOMIAL & (0 - (crc & 1)));
+				}
+				m_table[0][i] = crc;
+			}
+			for (u32 i = 0; i < 256; ++i)
+			{
+				for (int slice = 1; slice < 8; ++slice)
+				{
+					m_table[slice][i] = (m_table[slice - 1][i] >> 8) ^ m_table[0][m_table[slice - 1][i] & 0xFF];
+				}
+			}
+		}
+	};
+
+	const Tables &tables()
+	{
+		static const Tables s_tables;
+		return s_tables;
+	}
+
+	u32 updateTable(u32 crc, const u8 *data, size_t size)
+	{
+		const auto &t = tables().m_table;
+
+		for (; size >= 8; size -= 8, data += 8)
+		{
+			u32 low, high;
+			memcpy(&low, data, sizeof(low));
+			memcpy(&high, data + 4, sizeof(high));
+			low ^= crc;
+			crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+				^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+		}
+		for (; size > 0; --size, ++data)
+		{
+			crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xFF];
+		}
+		return crc;
+	}
+
+#ifdef CRC32_PCLMUL
+	bool detectPclmul()
+	{
+	#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 1)) != 0; // ECX.PCLMULQDQ
+	#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("pclmul");
+	#endif
+	}
+
+	/**
+	 * @brief: Folds 64 bytes per iteration using carry-less multiplication
+	 *
+	 * The size has to be a multiple of 16 and at least 64 bytes.
+	 * See "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel).
+	 */
+	CRC32_TARGET_PCLMUL
+	u32 updatePclmul(u32 crc, const u8 *data, size_t size)
+	{
+		const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+		const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+		const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+		const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+		const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+
+		__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00));
+		__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10));
+		__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20));
+		__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30));
+		x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+		data += 64;
+		size -= 64;
+
+		// fold four lanes in parallel
+		for (; size >= 64; data += 64, size -= 64)
+		{
+			const __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+			const __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+			const __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+			const __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+			x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+			x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+			x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00)));
+			x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10)));
+			x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20)));
+			x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30)));
+		}
+
+		// fold the lanes into a single one
+		__m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x2), x5);
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x3), x5);
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k3k4, 0x11), x4), x5);
+
+		for (; size >= 16; data += 16, size -= 16)
+		{
+			x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i *>(data))), x5);
+		}
+
+		// fold 128 bits to 64 bits
+		x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+		x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+		x2 = _mm_srli_si128(x1, 4);
+		x1 = _mm_and_si128(x1, mask);
+		x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+
+		// barrett reduction to 32 bits
+		x2 = _mm_and_si128(x1, mask);
+		x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+		x2 = _mm_and_si128(x2, mask);
+		x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		return static_cast<u32>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+	}
+
+	const bool s_pclmul = detectPclmul();
+#endif
+}
+
+Crc32::Crc32()
+	: m_state(0xFFFFFFFF)
+{
+}
+
+void Crc32::update(const void *data, size_t size)
+{
+	const u8 *bytes = static_cast<const u8 *>(data);
+#ifdef CRC32_PCLMUL
+	if (s_pclmul && size >= 64)
+	{
+		const size_t blocks = size & ~static_cast<size_t>(15);
+		m_state = updatePclmul(m_state, bytes, blocks);
+		bytes += blocks;
+		size -= blocks;
+	}
+#endif
+	m_state = updateTable(m_state, bytes, size);
+}
+
+void Crc32::reset()
+{
+	m_state = 0xFFFFFFFF;
+}
+
+u32 Crc32::value() const
+{
+	return ~m_state;
+}
+
+u32 Crc32::compute(const void *data, size_t size)
+{
+	Crc32 crc;
+	crc.update(data, size);
+	return crc.value();
+}
+
+bool Crc32::accelerated()
+{
+#ifdef CRC32_PCLMUL
+	return s_pclmul;
+#else
+	return false;
+#endif
+}
+
+/* eof */
@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/crc32.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Computes CRC-32 (ISO-HDLC, the checksum used by zip and HashFS archives).
+ *
+ * On x86 processors with the PCLMULQDQ instruction the data is folded with carry-less
+ * multiplication, otherwise the slicing-by-8 table implementation is used.
+ */
+class Crc32
+{
+public:
+	Crc32();
+
+	/**
+	 * @brief: Appends the data to the checksum
+	 *
+	 * @param[in] data The data to process
+	 * @param[in] size The size of the data in bytes
+	 */
+	void update(const void *data, size_t size);
+
+	/**
+	 * @brief: Resets the checksum to the initial state
+	 */
+	void reset();
+
+	/**
+	 * @return @c The checksum of all the data processed so far
+	 */
+	u32 value() const;
+
+	/**
+	 * @brief: Computes the checksum of the single buffer
+	 *
+	 * @param[in] data The data to process
+	 * @param[in] size The size of the data in bytes
+	 * @return @c The checksum of the data
+	 */
+	static u32 compute(const void *data, size_t size);
+
+	/**
+	 * @return @c True if the hardware accelerated implementation is used
+	 */
+	static bool accelerated();
+
+private:
+	u32 m_state;
+};
+
+/* eof */
@@ -0,0 +1,68 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/emitter.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "emitter.h"
+
+#include <fs/file.h>
+
+Emitter::Emitter(File *file)
+	: m_file(file)
+	, m_buffer(file ? BUFFER_SIZE : STRING_SIZE, '\0')
+{
+}
+
+Emitter::~Emitter()
+{
+	flush();
+}
+
+String Emitter::str() const
+{
+	return m_buffer.substr(0, m_size);
+}
+
+bool Emitter::flush()
+{
+	if (!m_file || m_size == 0)
+	{
+		return true;
+	}
+	const bool result = m_file->write(m_buffer.data(), sizeof(char), m_size) == m_size;
+	m_size = 0;
+	return result;
+}
+
+void Emitter::grow(size_t size)
+{
+	if (m_file)
+	{
+		flush();
+	}
+	if (m_size + size > m_buffer.size())
+	{
+		m_buffer.resize(std::max(m_buffer.size() * 2, m_size + size));
+	}
+}
+
+/* eof */
@@ -0,0 +1,261 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/emitter.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <math/vector.h>
+#include <math/quaternion.h>
+#include <utils/number_format.h>
+
+#include <type_traits>
+
+/**
+ * @brief: Fields of the emitted records, the layout is resolved at compile time.
+ *
+ * @example out << TAB TAB << emit::left<5>(i) << "( " << position << " )" SEOL;
+ *   is written as "%-5i( &%08x  &%08x  &%08x )\n" without parsing the format.
+ */
+namespace emit
+{
+	/**
+	 * @brief: Converts the integer as "%i" does, the types up to 32 bits are printed as int
+	 * (ex. u32 0xFFFFFFFF is -1), the 64 bit types as long long.
+	 */
+	template < typename T >
+	inline s64 promoted(T value)
+	{
+		return sizeof(T) <= sizeof(s32) ? static_cast<s64>(static_cast<s32>(value)) : static_cast<s64>(value);
+	}
+
+	/**
+	 * @brief: Integer padded with spaces on the right up to WIDTH characters ("%-WIDTHi")
+	 */
+	template < int WIDTH >
+	struct Left
+	{
+		s64 m_value;
+	};
+
+	template < int WIDTH, typename T >
+	inline Left<WIDTH> left(T value) { return { promoted(value) }; }
+
+	/**
+	 * @brief: Integer printed without sign ("%u")
+	 */
+	struct Unsigned
+	{
+		u64 m_value;
+	};
+
+	template < typename T >
+	inline Unsigned uint(T value)
+	{
+		return { sizeof(T) <= sizeof(u32) ? static_cast<u64>(static_cast<u32>(value)) : static_cast<u64>(value) };
+	}
+
+	/**
+	 * @brief: Bits of the float in hexadecimal (FLT_FT)
+	 */
+	struct Hex
+	{
+		u32 m_bits;
+	};
+
+	inline Hex hex(float value) { return { flh(value) }; }
+
+	/**
+	 * @brief: Real number as "%f", or the shortest text reading back the same value
+	 * with -precise_doubles (see NumberFormat::real)
+	 */
+	struct Real
+	{
+		double m_value;
+		bool m_single;
+	};
+
+	inline Real real(double value) { return { value, false }; }
+	inline Real real(float value) { return { value, true }; }
+
+	/**
+	 * @brief: Null terminated string which is not a literal
+	 */
+	struct Text
+	{
+		const char *m_text;
+		size_t m_length;
+	};
+
+	inline Text text(const char *text) { return { text, strlen(text) }; }
+} // namespace emit
+
+/**
+ * @brief: Buffered writer of the text formats (pim, pis, pic, pip...).
+ *
+ * Replaces the fmt::sprintf formatting of every line: literals are copied with their
+ * length known at compile time, numbers are converted in place. The text is written to
+ * the file in blocks of BUFFER_SIZE, or collected in the string when there is no file.
+ * String literals only are accepted as they are, other C strings go through emit::text.
+ */
+class Emitter
+{
+public:
+	/**
+	 * @param[in] file The file receiving the text (flushed by the destructor), or nullptr to collect it for str()
+	 */
+	explicit Emitter(File *file = nullptr);
+	Emitter(const Emitter &) = delete;
+	Emitter(Emitter &&) = delete;
+	~Emitter();
+
+	Emitter &operator=(const Emitter &) = delete;
+	Emitter &operator=(Emitter &&) = delete;
+
+	template < size_t N >
+	inline Emitter &operator<<(const char (&literal)[N])
+	{
+		return write(literal, N - 1);
+	}
+
+	inline Emitter &operator<<(const String &text) { return write(text.data(), text.size()); }
+	inline Emitter &operator<<(emit::Text text) { return write(text.m_text, text.m_length); }
+
+	/**
+	 * @brief: Writes the integer as "%i", see emit::promoted
+	 */
+	template < typename T, typename = typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value>::type >
+	inline Emitter &operator<<(T value)
+	{
+		m_size += NumberFormat::integer(reserve(NumberFormat::MAX_INTEGER), emit::promoted(value));
+		return *this;
+	}
+
+	inline Emitter &operator<<(emit::Unsigned value)
+	{
+		m_size += NumberFormat::unsignedInteger(reserve(NumberFormat::MAX_INTEGER), value.m_value);
+		return *this;
+	}
+
+	template < int WIDTH >
+	inline Emitter &operator<<(emit::Left<WIDTH> value)
+	{
+		m_size += NumberFormat::left(reserve(NumberFormat::MAX_INTEGER + WIDTH), value.m_value, WIDTH);
+		return *this;
+	}
+
+	inline Emitter &operator<<(emit::Hex value)
+	{
+		m_size += NumberFormat::hex(reserve(NumberFormat::MAX_HEX), value.m_bits);
+		return *this;
+	}
+
+	inline Emitter &operator<<(emit::Real value)
+	{
+		m_size += NumberFormat::real(reserve(NumberFormat::MAX_REAL), value.m_value, value.m_single);
+		return *this;
+	}
+
+	/**
+	 * @brief: Writes the components as prism::to_string (FLT_FT separated by two spaces)
+	 */
+	template < size_t N >
+	inline Emitter &operator<<(const prism::vec_t<float, N> &vec)
+	{
+		char *out = reserve(11 * N);
+		for (size_t i = 0; i < N; ++i)
+		{
+			if (i != 0)
+			{
+				*out++ = ' ';
+				*out++ = ' ';
+			}
+			out += NumberFormat::hex(out, flh(vec[i]));
+		}
+		m_size += 11 * N - 2;
+		return *this;
+	}
+
+	/**
+	 * @brief: Writes the integers as prism::to_string (separated by one space)
+	 */
+	template < size_t N >
+	inline Emitter &operator<<(const int (&values)[N])
+	{
+		for (size_t i = 0; i < N; ++i)
+		{
+			if (i != 0)
+			{
+				write(" ", 1);
+			}
+			*this << values[i];
+		}
+		return *this;
+	}
+
+	inline Emitter &operator<<(const prism::quat_t &quat)
+	{
+		return *this << prism::vec_t<float, 4>(quat.m_w, quat.m_x, quat.m_y, quat.m_z);
+	}
+
+	/**
+	 * @brief: Writes the text of the known length
+	 */
+	inline Emitter &write(const char *data, size_t size)
+	{
+		memcpy(reserve(size), data, size);
+		m_size += size;
+		return *this;
+	}
+
+	/**
+	 * @brief: Returns the collected text of the emitter without file
+	 */
+	String str() const;
+
+	/**
+	 * @brief: Writes the buffered text to the file
+	 *
+	 * @return @c False if the file did not accept all of the text
+	 */
+	bool flush();
+
+private:
+	static const size_t BUFFER_SIZE = 64 * 1024;
+	static const size_t STRING_SIZE = 256; // initial size without file, grows as needed
+
+	inline char *reserve(size_t size)
+	{
+		if (m_size + size > m_buffer.size())
+		{
+			grow(size);
+		}
+		return &m_buffer[m_size];
+	}
+
+	void grow(size_t size);
+
+private:
+	File *m_file;
+	String m_buffer;
+	size_t m_size = 0;
+};
+
+/* eof */
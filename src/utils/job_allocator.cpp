@@ -0,0 +1,67 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/job_allocator.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "job_allocator.h"
+
+namespace
+{
+	thread_local Arena *s_jobArena = nullptr;
+}
+
+JobArena::JobArena(bool bind)
+	: m_arena(Arena::MAX_BLOCK_SIZE / 4)
+	, m_previous(s_jobArena)
+	, m_bound(bind)
+{
+	if (m_bound)
+	{
+		s_jobArena = &m_arena;
+	}
+}
+
+JobArena::~JobArena()
+{
+	if (m_bound)
+	{
+		s_jobArena = m_previous;
+	}
+}
+
+JobArena::Scope::Scope(JobArena &job)
+	: m_previous(s_jobArena)
+{
+	s_jobArena = &job.m_arena;
+}
+
+JobArena::Scope::~Scope()
+{
+	s_jobArena = m_previous;
+}
+
+Arena *JobArena::current()
+{
+	return s_jobArena;
+}
+
+/* eof */
@@ -0,0 +1,131 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/job_allocator.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <utils/arena.h>
+
+/**
+ * @brief: Arena of one conversion job, bound to the thread running the job.
+ *
+ * While the JobArena is alive the JobAllocator containers created on its thread take
+ * their memory from it, everything is released at once when the job ends. The scope must
+ * outlive the objects created in it (declare it before the Model of the job).
+ */
+class JobArena
+{
+public:
+	/**
+	 * @brief: Binds the arena to the current thread while the scope is alive
+	 *
+	 * Used by the jobs passed between threads (stages of the Pipeline), their arena is created unbound.
+	 */
+	class Scope
+	{
+	public:
+		Scope(JobArena &job);
+		Scope(const Scope &) = delete;
+		~Scope();
+
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		Arena *m_previous;
+	};
+
+public:
+	/**
+	 * @param[in] bind False to create the arena without binding it to the current thread, see Scope
+	 */
+	JobArena(bool bind = true);
+	JobArena(const JobArena &) = delete;
+	JobArena(JobArena &&) = delete;
+	~JobArena();
+
+	JobArena &operator=(const JobArena &) = delete;
+	JobArena &operator=(JobArena &&) = delete;
+
+	inline Arena &arena() { return m_arena; }
+
+	/**
+	 * @brief: Returns the arena of the job running on the current thread, or nullptr
+	 */
+	static Arena *current();
+
+private:
+	Arena m_arena;
+	Arena *m_previous;
+	bool m_bound;
+};
+
+/**
+ * @brief: Allocator of the containers filled during the conversion.
+ *
+ * Binds to the arena of the job when the container is created, outside of a job it uses
+ * the heap. The arena memory is never freed one by one, the growth of the containers leaves
+ * the old storage in the arena until the job ends.
+ */
+template < typename T >
+class JobAllocator
+{
+public:
+	using value_type = T;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	JobAllocator() : m_arena(JobArena::current()) {}
+	template < typename U >
+	JobAllocator(const JobAllocator<U> &other) : m_arena(other.arena()) {}
+
+	T *allocate(size_t count)
+	{
+		return m_arena
+			? m_arena->allocate<T>(count)
+			: static_cast<T *>(::operator new(sizeof(T) * count));
+	}
+
+	void deallocate(T *data, size_t)
+	{
+		if (!m_arena)
+		{
+			::operator delete(data);
+		}
+	}
+
+	// a copy belongs to the job making it, not to the job of the original
+	JobAllocator select_on_container_copy_construction() const { return JobAllocator(); }
+
+	inline Arena *arena() const { return m_arena; }
+
+private:
+	Arena *m_arena;
+};
+
+template < typename T, typename U >
+inline bool operator==(const JobAllocator<T> &lhs, const JobAllocator<U> &rhs) { return lhs.arena() == rhs.arena(); }
+template < typename T, typename U >
+inline bool operator!=(const JobAllocator<T> &lhs, const JobAllocator<U> &rhs) { return lhs.arena() != rhs.arena(); }
+
+template < typename T >
+using JobArray = std::vector<T, JobAllocator<T>>;
+
+/* eof */
@@ -0,0 +1,56 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/json.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "json.h"
+
+namespace json
+{
+	String quote(const String &value)
+	{
+		String result = "\"";
+		for (const char c : value)
+		{
+			switch (c)
+			{
+				case '"':	result += "\\\"";	break;
+				case '\\':	result += "\\\\";	break;
+				case '\n':	result += "\\n";	break;
+				case '\r':	result += "\\r";	break;
+				case '\t':	result += "\\t";	break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						result += fmt::sprintf("\\u%04x", static_cast<unsigned>(c));
+					}
+					else
+					{
+						result += c;
+					}
+			}
+		}
+		return result + "\"";
+	}
+} // namespace json
+
+/* eof */
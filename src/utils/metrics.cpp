@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/metrics.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "metrics.h"
+
+#include <fs/file.h>
+#include <utils/json.h>
+
+void Metrics::add(const String &name, u64 value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_counters[name] += value;
+}
+
+u64 Metrics::counter(const String &name) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const auto it = m_counters.find(name);
+	return it != m_counters.end() ? it->second : 0;
+}
+
+void Metrics::set(const String &name, u64 value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_counters[name] = value;
+}
+
+void Metrics::set(const String &name, double value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_values[name] = fmt::sprintf("%.3f", value);
+}
+
+void Metrics::set(const String &name, const String &value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_values[name] = json::quote(value);
+}
+
+bool Metrics::save(File *file) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Map<String, String> entries = m_values;
+	for (const auto &counter : m_counters)
+	{
+		entries[counter.first] = fmt::sprintf("%llu", counter.second);
+	}
+
+	String buffer = "{";
+	for (auto it = entries.cbegin(); it != entries.cend(); ++it)
+	{
+		buffer += fmt::sprintf("%s" SEOL "\t%s: %s", it == entries.cbegin() ? "" : ",", json::quote(it->first), it->second);
+	}
+	buffer += SEOL "}" SEOL;
+	return file->write(buffer.data(), sizeof(char), buffer.size()) == buffer.size();
+}
+
+/* eof */
@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/metrics.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <mutex>
+
+/**
+ * @brief: Named counters and values describing a run, saved as flat JSON object.
+ *
+ * @example { "jobs": 120, "seconds": 1.5, "shard": "0/4" }
+ */
+class Metrics
+{
+public:
+	/**
+	 * @brief: Increments the counter, may be called concurrently
+	 */
+	void add(const String &name, u64 value = 1);
+	u64 counter(const String &name) const;
+
+	void set(const String &name, u64 value);
+	void set(const String &name, double value);
+	void set(const String &name, const String &value);
+
+	/**
+	 * @brief: Writes the metrics sorted by name
+	 *
+	 * @param[in] file The file to write
+	 * @return @c True if the whole object has been written
+	 */
+	bool save(File *file) const;
+
+private:
+	mutable std::mutex m_mutex;
+	Map<String, u64> m_counters;
+	Map<String, String> m_values;	// JSON encoded
+};
+
+/* eof */
@@ -0,0 +1,174 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/mpmc_queue.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+
+/**
+ * @brief: Bounded lock-free queue of many producers and many consumers.
+ *
+ * Ring of cells, each with a sequence number telling whether the cell is free for the producer
+ * of the position or filled for its consumer (D. Vyukov). Producers and consumers claim
+ * the positions by compare and swap, nobody waits for a lock. The capacity is rounded up
+ * to a power of two.
+ */
+template < typename T >
+class MpmcQueue
+{
+public:
+	MpmcQueue(size_t capacity);
+	MpmcQueue(const MpmcQueue &) = delete;
+	MpmcQueue(MpmcQueue &&) = delete;
+	~MpmcQueue();
+
+	MpmcQueue &operator=(const MpmcQueue &) = delete;
+	MpmcQueue &operator=(MpmcQueue &&) = delete;
+
+	/**
+	 * @brief: Appends the value unless the queue is full
+	 *
+	 * @return @c False if the queue is full, the value is not moved then
+	 */
+	bool tryPush(T &value);
+
+	/**
+	 * @brief: Takes the oldest value unless the queue is empty
+	 *
+	 * @return @c False if the queue is empty
+	 */
+	bool tryPop(T &value);
+
+	/**
+	 * @brief: Returns the number of queued values, only approximate while the queue is used
+	 */
+	size_t size() const;
+
+	inline size_t capacity() const { return m_mask + 1; }
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> m_sequence;
+		T m_value;
+	};
+
+	static const size_t CACHE_LINE = 64;
+
+	UniquePtr<Cell[]> m_cells;
+	size_t m_mask;
+	alignas(CACHE_LINE) std::atomic<size_t> m_pushed{ 0 };	// the producers and the consumers do not share the line
+	alignas(CACHE_LINE) std::atomic<size_t> m_popped{ 0 };
+};
+
+template < typename T >
+MpmcQueue<T>::MpmcQueue(size_t capacity)
+{
+	size_t size = 2;
+	while (size < capacity)
+	{
+		size *= 2;
+	}
+	m_cells.reset(new Cell[size]);
+	m_mask = size - 1;
+	for (size_t i = 0; i < size; ++i)
+	{
+		m_cells[i].m_sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+template < typename T >
+MpmcQueue<T>::~MpmcQueue()
+{
+}
+
+template < typename T >
+bool MpmcQueue<T>::tryPush(T &value)
+{
+	size_t position = m_pushed.load(std::memory_order_relaxed);
+	Cell *cell;
+	for (;;)
+	{
+		cell = &m_cells[position & m_mask];
+		const size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+		const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+		if (difference == 0)
+		{
+			if (m_pushed.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			return false; // the cell still holds the value pushed one round ago
+		}
+		else
+		{
+			position = m_pushed.load(std::memory_order_relaxed);
+		}
+	}
+	cell->m_value = std::move(value);
+	cell->m_sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+template < typename T >
+bool MpmcQueue<T>::tryPop(T &value)
+{
+	size_t position = m_popped.load(std::memory_order_relaxed);
+	Cell *cell;
+	for (;;)
+	{
+		cell = &m_cells[position & m_mask];
+		const size_t sequence = cell->m_sequence.load(std::memory_order_acquire);
+		const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+		if (difference == 0)
+		{
+			if (m_popped.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			return false; // the cell has not been filled yet
+		}
+		else
+		{
+			position = m_popped.load(std::memory_order_relaxed);
+		}
+	}
+	value = std::move(cell->m_value);
+	cell->m_sequence.store(position + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+template < typename T >
+size_t MpmcQueue<T>::size() const
+{
+	const size_t popped = m_popped.load(std::memory_order_relaxed);
+	const size_t pushed = m_pushed.load(std::memory_order_relaxed);
+	return pushed > popped ? std::min(pushed - popped, m_mask + 1) : 0;
+}
+
+/* eof */
@@ -0,0 +1,288 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/number_format.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "number_format.h"
+
+#include <config.h>
+
+#include <cfloat>
+#include <cmath>
+
+static const char s_digitPairs[] =
+	"00010203040506070809101112131415161718192021222324"
+	"25262728293031323334353637383940414243444546474849"
+	"50515253545556575859606162636465666768697071727374"
+	"75767778798081828384858687888990919293949596979899";
+
+static inline size_t countDigits(u64 value)
+{
+	size_t count = 1;
+	for (;;)
+	{
+		if (value < 10) return count;
+		if (value < 100) return count + 1;
+		if (value < 1000) return count + 2;
+		if (value < 10000) return count + 3;
+		value /= 10000;
+		count += 4;
+	}
+}
+
+/**
+ * @brief: Formats the values not covered by the kernel (nan, inf, huge and very small ones) by printf
+ */
+static size_t printFixed(char *out, double value)
+{
+	const int length = snprintf(out, NumberFormat::MAX_FIXED, "%f", value);
+	return static_cast<size_t>(std::max(length, 0));
+}
+
+size_t NumberFormat::unsignedInteger(char *out, u64 value)
+{
+	const size_t length = countDigits(value);
+	char *it = out + length;
+	while (value >= 100)
+	{
+		const size_t pair = static_cast<size_t>(value % 100) * 2;
+		value /= 100;
+		it -= 2;
+		it[0] = s_digitPairs[pair];
+		it[1] = s_digitPairs[pair + 1];
+	}
+	if (value >= 10)
+	{
+		const size_t pair = static_cast<size_t>(value) * 2;
+		it[-2] = s_digitPairs[pair];
+		it[-1] = s_digitPairs[pair + 1];
+	}
+	else
+	{
+		it[-1] = static_cast<char>('0' + value);
+	}
+	return length;
+}
+
+size_t NumberFormat::fixed(char *out, double value)
+{
+	u64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	const bool negative = (bits >> 63) != 0;
+	const int biased = static_cast<int>((bits >> 52) & 0x7FF);
+	u64 mantissa = bits & ((1ull << 52) - 1);
+	if (biased == 0x7FF)
+	{
+		return printFixed(out, value);
+	}
+
+	int exponent = -1074;
+	if (biased != 0)
+	{
+		mantissa |= 1ull << 52;
+		exponent = biased - 1075;
+	}
+
+	// value = mantissa * 2^exponent = integral + fraction / 10^6, rounded half to even as printf does
+	u64 integral = 0;
+	u32 fraction = 0;
+	if (mantissa == 0)
+	{
+		// zero, keeps the sign
+	}
+	else if (exponent >= 0)
+	{
+		if (exponent > 11)
+		{
+			return printFixed(out, value); // does not fit into 64 bits
+		}
+		integral = mantissa << exponent;
+	}
+	else if (exponent >= -60)
+	{
+		const int shift = -exponent;
+		const u64 mask = (1ull << shift) - 1;
+		integral = mantissa >> shift;
+		u64 rest = mantissa & mask;
+		for (int i = 0; i < 6; ++i)
+		{
+			rest *= 10; // rest < 2^60, does not overflow
+			fraction = fraction * 10 + static_cast<u32>(rest >> shift);
+			rest &= mask;
+		}
+		const u64 half = 1ull << (shift - 1);
+		if (rest > half || (rest == half && (fraction & 1)))
+		{
+			if (++fraction == 1000000)
+			{
+				fraction = 0;
+				++integral;
+			}
+		}
+	}
+	else if (std::fabs(value) >= 4.9e-7)
+	{
+		return printFixed(out, value); // below 2^-8, the digits do not fit into 64 bits
+	}
+
+	size_t length = 0;
+	if (negative)
+	{
+		out[length++] = '-';
+	}
+	length += unsignedInteger(out + length, integral);
+	out[length++] = '.';
+	for (int i = 5; i >= 0; --i)
+	{
+		out[length + i] = static_cast<char>('0' + fraction % 10);
+		fraction /= 10;
+	}
+	return length + 6;
+}
+
+size_t NumberFormat::shortest(char *out, double value, bool single)
+{
+	if (!std::isfinite(value))
+	{
+		return static_cast<size_t>(std::max(snprintf(out, MAX_SHORTEST, "%f", value), 0));
+	}
+
+	auto same = [value, single](const char *text)
+	{
+		const double parsed = strtod(text, nullptr);
+		return single ? static_cast<float>(parsed) == static_cast<float>(value) : parsed == value;
+	};
+
+	// when half of the ulp is below 0.5e-6 the shortest text has at most 6 decimals if "%f" reads back,
+	// it is then "%f" without the trailing zeros
+	if (std::fabs(value) < (single ? 8.0 : 4294967296.0))
+	{
+		char buffer[MAX_FIXED];
+		size_t length = fixed(buffer, value);
+		buffer[length] = '\0';
+		if (same(buffer))
+		{
+			while (buffer[length - 1] == '0' && buffer[length - 2] != '.')
+			{
+				--length;
+			}
+			memcpy(out, buffer, length);
+			return length;
+		}
+	}
+
+	// the significant digits are taken from "%.*e" with the least precision reading back,
+	// every text of fewer digits than the precision of the type is shortened by "%.*e" itself
+	// except of the subnormal values, having less precision
+	char buffer[MAX_SHORTEST];
+	const int last = single ? 9 : 17;
+	const bool subnormal = std::fabs(value) < (single ? FLT_MIN : DBL_MIN);
+	for (int precision = subnormal ? 1 : (single ? 6 : 15); ; ++precision)
+	{
+		snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, value);
+		if (precision == last || same(buffer))
+		{
+			break;
+		}
+	}
+
+	const char *it = buffer;
+	const bool negative = *it == '-';
+	if (negative)
+	{
+		++it;
+	}
+	char digits[20];
+	int count = 0;
+	for (; *it != 'e'; ++it)
+	{
+		if (*it != '.')
+		{
+			digits[count++] = *it;
+		}
+	}
+	const int exponent = atoi(it + 1);
+	while (count > 1 && digits[count - 1] == '0')
+	{
+		--count;
+	}
+
+	size_t length = 0;
+	if (negative)
+	{
+		out[length++] = '-';
+	}
+	if (exponent >= -5 && exponent < 17)
+	{
+		if (exponent >= 0)
+		{
+			for (int i = 0; i <= exponent; ++i)
+			{
+				out[length++] = i < count ? digits[i] : '0';
+			}
+			out[length++] = '.';
+			if (count > exponent + 1)
+			{
+				memcpy(out + length, digits + exponent + 1, count - exponent - 1);
+				length += count - exponent - 1;
+			}
+			else
+			{
+				out[length++] = '0';
+			}
+		}
+		else
+		{
+			out[length++] = '0';
+			out[length++] = '.';
+			for (int i = 0; i < -exponent - 1; ++i)
+			{
+				out[length++] = '0';
+			}
+			memcpy(out + length, digits, count);
+			length += count;
+		}
+		return length;
+	}
+
+	out[length++] = digits[0];
+	out[length++] = '.';
+	if (count > 1)
+	{
+		memcpy(out + length, digits + 1, count - 1);
+		length += count - 1;
+	}
+	else
+	{
+		out[length++] = '0';
+	}
+	const size_t tail = strlen(it);
+	memcpy(out + length, it, tail); // the exponent as printed ("e-07")
+	return length + tail;
+}
+
+size_t NumberFormat::real(char *out, double value, bool single)
+{
+	return Config::s_preciseDoubles ? shortest(out, value, single) : fixed(out, value);
+}
+
+/* eof */
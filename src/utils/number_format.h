@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/number_format.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+/**
+ * @brief: Conversion of numbers to text used by the writers of the text formats.
+ *
+ * The kernels write into the buffer of the caller and return the count of written
+ * characters, no terminating null is appended. Integers are converted two digits at
+ * a time from the table, doubles in the fixed notation ("%f") are computed exactly from
+ * their bits, so the output is the same as of printf without parsing the format.
+ */
+class NumberFormat
+{
+public:
+	static const size_t MAX_INTEGER = 20;	// digits and sign of s64
+	static const size_t MAX_HEX = 9;		// FLT_FT
+	static const size_t MAX_FIXED = 320;	// "%f" of -DBL_MAX
+	static const size_t MAX_SHORTEST = 32;
+	static const size_t MAX_REAL = MAX_FIXED;
+
+	/**
+	 * @brief: Writes the integer as "%lli"
+	 */
+	static inline size_t integer(char *out, s64 value)
+	{
+		if (value < 0)
+		{
+			*out = '-';
+			return 1 + unsignedInteger(out + 1, 0 - static_cast<u64>(value));
+		}
+		return unsignedInteger(out, static_cast<u64>(value));
+	}
+
+	/**
+	 * @brief: Writes the integer as "%llu"
+	 */
+	static size_t unsignedInteger(char *out, u64 value);
+
+	/**
+	 * @brief: Writes the integer padded with spaces on the right ("%-5lli" for width 5)
+	 *
+	 * @param[out] out The buffer of at least max(MAX_INTEGER, width) characters
+	 */
+	static inline size_t left(char *out, s64 value, size_t width)
+	{
+		size_t length = integer(out, value);
+		for (; length < width; ++length)
+		{
+			out[length] = ' ';
+		}
+		return length;
+	}
+
+	/**
+	 * @brief: Writes the bits of the float as FLT_FT ("&%08x")
+	 */
+	static inline size_t hex(char *out, u32 bits)
+	{
+		static const char digits[] = "0123456789abcdef";
+		out[0] = '&';
+		out[1] = digits[(bits >> 28) & 0xF];
+		out[2] = digits[(bits >> 24) & 0xF];
+		out[3] = digits[(bits >> 20) & 0xF];
+		out[4] = digits[(bits >> 16) & 0xF];
+		out[5] = digits[(bits >> 12) & 0xF];
+		out[6] = digits[(bits >> 8) & 0xF];
+		out[7] = digits[(bits >> 4) & 0xF];
+		out[8] = digits[bits & 0xF];
+		return MAX_HEX;
+	}
+
+	/**
+	 * @brief: Writes the double as "%f", rounded to 6 decimals
+	 *
+	 * @param[out] out The buffer of at least MAX_FIXED characters
+	 */
+	static size_t fixed(char *out, double value);
+
+	/**
+	 * @brief: Writes the shortest text which is read back (strtod) as the same value
+	 *
+	 * The text always contains the dot or the exponent (ex. "1.0", "0.1", "1.5e-07"),
+	 * so it is parsed as real number again.
+	 *
+	 * @param[out] out The buffer of at least MAX_SHORTEST characters
+	 * @param[in] single True if the value is float, the text is then the shortest one read back as the same float
+	 */
+	static size_t shortest(char *out, double value, bool single = false);
+
+	/**
+	 * @brief: Writes the real number of the exported file, "%f" or shortest() when Config::s_preciseDoubles is set
+	 *
+	 * @param[out] out The buffer of at least MAX_REAL characters
+	 */
+	static size_t real(char *out, double value, bool single = false);
+};
+
+/* eof */
@@ -0,0 +1,188 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/path_table.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "path_table.h"
+
+namespace
+{
+	const size_t INITIAL_SLOTS = 4096;
+}
+
+PathTable *getPaths()
+{
+	static PathTable paths;
+	return &paths;
+}
+
+PathTable::PathTable()
+	: m_strings(Arena::MAX_BLOCK_SIZE)
+	, m_chunks(new UniquePtr<Record[]>[MAX_CHUNKS])
+	, m_slots(INITIAL_SLOTS, 0)
+{
+	// the record 0 is the empty path, so the default PathId reads as ""
+	m_chunks[0].reset(new Record[CHUNK_SIZE]);
+	m_chunks[0][0] = { "", 0, hash("", 0) };
+	m_count.store(1, std::memory_order_release);
+}
+
+PathTable::~PathTable()
+{
+}
+
+u64 PathTable::hash(const char *path, size_t length)
+{
+	return length > 0 ? prism::city_hash_64(path + 1, length - 1) : prism::city_hash_64("", 0);
+}
+
+PathId PathTable::intern(const char *path, size_t length)
+{
+	if (length == 0)
+	{
+		return PathId();
+	}
+
+	const u64 pathHash = hash(path, length);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t mask = m_slots.size() - 1;
+	size_t slot = static_cast<size_t>(pathHash) & mask;
+	for (; m_slots[slot] != 0; slot = (slot + 1) & mask)
+	{
+		const Record &entry = record(PathId(m_slots[slot]));
+		if (entry.m_hash == pathHash && entry.m_length == length && memcmp(entry.m_data, path, length) == 0)
+		{
+			return PathId(m_slots[slot]);
+		}
+	}
+
+	const u32 index = m_count.load(std::memory_order_relaxed);
+	if ((index >> CHUNK_BITS) >= MAX_CHUNKS)
+	{
+		error("paths", String(path, length), "Too many paths!");
+		return PathId();
+	}
+	auto &chunk = m_chunks[index >> CHUNK_BITS];
+	if (!chunk)
+	{
+		chunk.reset(new Record[CHUNK_SIZE]);
+	}
+
+	char *data = m_strings.allocate<char>(length + 1);
+	memcpy(data, path, length);
+	data[length] = '\0';
+	chunk[index & (CHUNK_SIZE - 1)] = { data, static_cast<u32>(length), pathHash };
+	m_slots[slot] = index;
+	m_count.store(index + 1, std::memory_order_release);
+
+	if ((index + 1) * 2 > m_slots.size())
+	{
+		grow();
+	}
+	return PathId(index);
+}
+
+void PathTable::grow()
+{
+	Array<u32> slots(m_slots.size() * 2, 0);
+	const size_t mask = slots.size() - 1;
+	for (const u32 index : m_slots)
+	{
+		if (index == 0)
+		{
+			continue;
+		}
+		size_t slot = static_cast<size_t>(record(PathId(index)).m_hash) & mask;
+		while (slots[slot] != 0)
+		{
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = index;
+	}
+	m_slots = std::move(slots);
+}
+
+const char *PathTable::name(PathId id) const
+{
+	const Record &entry = record(id);
+	for (const char *it = entry.m_data + entry.m_length; it != entry.m_data; --it)
+	{
+		if (*(it - 1) == '/')
+		{
+			return it;
+		}
+	}
+	return entry.m_data;
+}
+
+const char *PathTable::extension(PathId id) const
+{
+	const Record &entry = record(id);
+	const char *const fileName = name(id);
+	for (const char *it = entry.m_data + entry.m_length; it != fileName; --it)
+	{
+		if (*(it - 1) == '.')
+		{
+			return it - 1;
+		}
+	}
+	return entry.m_data + entry.m_length;
+}
+
+PathId PathTable::parent(PathId id)
+{
+	const Record &entry = record(id);
+	const char *const fileName = name(id);
+	if (fileName == entry.m_data)
+	{
+		return PathId();
+	}
+	const size_t length = static_cast<size_t>(fileName - entry.m_data) - 1;
+	return length == 0 ? intern("/", 1) : intern(entry.m_data, length);
+}
+
+PathId PathTable::join(PathId directory, const char *name, size_t length)
+{
+	const Record &entry = record(directory);
+	String path;
+	path.reserve(entry.m_length + length + 1);
+	path.append(entry.m_data, entry.m_length);
+	if (path.empty() || path.back() != '/')
+	{
+		path.push_back('/');
+	}
+	path.append(name, length);
+	return intern(path);
+}
+
+PathId PathTable::withSuffix(PathId id, const char *suffix)
+{
+	const Record &entry = record(id);
+	String path;
+	path.reserve(entry.m_length + strlen(suffix));
+	path.append(entry.m_data, entry.m_length);
+	path.append(suffix);
+	return intern(path);
+}
+
+/* eof */
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/path_table.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <utils/arena.h>
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * @brief: Handle of the path interned in the PathTable, compared and hashed as integer.
+ */
+class PathId
+{
+public:
+	PathId() = default;
+	explicit PathId(u32 index) : m_index(index) {}
+
+	inline u32 index() const { return m_index; }
+	inline bool valid() const { return m_index != 0; }
+
+	inline bool operator==(const PathId &rhs) const { return m_index == rhs.m_index; }
+	inline bool operator!=(const PathId &rhs) const { return m_index != rhs.m_index; }
+	inline bool operator<(const PathId &rhs) const { return m_index < rhs.m_index; }
+
+private:
+	u32 m_index = 0;	// 0 is the empty path
+};
+
+/**
+ * @brief: Process wide table of interned paths.
+ *
+ * Every distinct path is stored once, null terminated, in the arena of the table and never
+ * released. Its CityHash (the key under which the archives store their entries) is computed
+ * when the path is interned, so the file systems of all mounted layers look the path up
+ * without hashing it again. Reading the interned path does not lock.
+ */
+class PathTable
+{
+public:
+	PathTable();
+	PathTable(const PathTable &) = delete;
+	PathTable(PathTable &&) = delete;
+	~PathTable();
+
+	PathTable &operator=(const PathTable &) = delete;
+	PathTable &operator=(PathTable &&) = delete;
+
+	/**
+	 * @brief: Returns the handle of the path, the path is stored when seen for the first time
+	 *
+	 * @param[in] path The path (ex. "/vehicle/truck/share/glass.tobj")
+	 * @param[in] length The length of the path
+	 * @return @c The handle valid for the whole life of the process
+	 */
+	PathId intern(const char *path, size_t length);
+	inline PathId intern(const String &path) { return intern(path.data(), path.size()); }
+
+	/**
+	 * @brief: Returns the interned path, null terminated
+	 */
+	inline const char *str(PathId id) const { return record(id).m_data; }
+	inline size_t length(PathId id) const { return record(id).m_length; }
+	inline String string(PathId id) const { return String(str(id), length(id)); }
+
+	/**
+	 * @brief: Returns hash(path) computed when the path has been interned
+	 */
+	inline u64 hash(PathId id) const { return record(id).m_hash; }
+
+	/**
+	 * @brief: Returns the file name (ex. "glass.tobj"), the part after the last slash
+	 */
+	const char *name(PathId id) const;
+
+	/**
+	 * @brief: Returns the extension with the dot (ex. ".tobj"), or empty string
+	 */
+	const char *extension(PathId id) const;
+
+	/**
+	 * @brief: Returns the directory of the path (ex. "/vehicle/truck/share"), the parent of "/a" is "/"
+	 */
+	PathId parent(PathId id);
+
+	/**
+	 * @brief: Returns the path of the entry in the directory (ex. join("/a", "b.pmg") is "/a/b.pmg")
+	 */
+	PathId join(PathId directory, const char *name, size_t length);
+	inline PathId join(PathId directory, const String &name) { return join(directory, name.data(), name.size()); }
+
+	/**
+	 * @brief: Returns the path with the suffix appended (ex. withSuffix("/a/b", ".pmg") is "/a/b.pmg")
+	 */
+	PathId withSuffix(PathId id, const char *suffix);
+
+	inline size_t size() const { return m_count.load(std::memory_order_acquire); }
+
+	/**
+	 * @brief: Computes the hash of the path, CityHash of the path without the first (slash) character
+	 *
+	 * Equal to the hash used by ZipFileSystem and by HashFileSystem archives without salt.
+	 */
+	static u64 hash(const char *path, size_t length);
+
+private:
+	struct Record
+	{
+		const char *m_data;
+		u32 m_length;
+		u64 m_hash;
+	};
+
+	inline const Record &record(PathId id) const
+	{
+		return m_chunks[id.index() >> CHUNK_BITS][id.index() & (CHUNK_SIZE - 1)];
+	}
+
+	void grow();
+
+private:
+	static const u32 CHUNK_BITS = 12;
+	static const u32 CHUNK_SIZE = 1 << CHUNK_BITS;
+	static const u32 MAX_CHUNKS = 1 << 14;	// 64M paths
+
+	std::mutex m_mutex;
+	Arena m_strings;
+	UniquePtr<UniquePtr<Record[]>[]> m_chunks;	// never reallocated, so the records are read without lock
+	std::atomic<u32> m_count{ 0 };
+	Array<u32> m_slots;	// open addressing by hash, 0 is empty slot
+};
+
+/**
+ * @brief: Returns the path table shared by the file systems
+ */
+PathTable *getPaths();
+
+/* eof */
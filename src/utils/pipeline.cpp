@@ -0,0 +1,187 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/pipeline.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "pipeline.h"
+#include "thread_pool.h"
+#include "metrics.h"
+
+#include <chrono>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	u64 elapsed(Clock::time_point since)
+	{
+		return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count());
+	}
+} // namespace
+
+Pipeline::Pipeline()
+{
+}
+
+Pipeline::~Pipeline()
+{
+}
+
+void Pipeline::addStage(const String &name, size_t workers, const Stage &stage, size_t capacity)
+{
+	auto state = std::make_unique<StageState>();
+	state->m_name = name;
+	state->m_workers = workers == 0 ? ThreadPool::defaultThreadCount() : workers;
+	state->m_stage = stage;
+	if (!m_stages.empty())
+	{
+		state->m_queue = std::make_unique<MpmcQueue<size_t>>(capacity == 0 ? 2 * state->m_workers : capacity);
+	}
+	m_stages.push_back(std::move(state));
+}
+
+void Pipeline::run(size_t count)
+{
+	size_t threads = 0;
+	for (auto &stage : m_stages)
+	{
+		stage->m_running = stage->m_workers;
+		threads += stage->m_workers;
+	}
+	m_next = 0;
+
+	ThreadPool pool(threads);
+	for (size_t i = 0; i < m_stages.size(); ++i)
+	{
+		for (size_t worker = 0; worker < m_stages[i]->m_workers; ++worker)
+		{
+			pool.submit([this, i, count]() { work(i, count); });
+		}
+	}
+	pool.wait();
+}
+
+void Pipeline::work(size_t stage, size_t count)
+{
+	StageState &state = *m_stages[stage];
+	StageState *const previous = stage > 0 ? m_stages[stage - 1].get() : nullptr;
+	StageState *const next = stage + 1 < m_stages.size() ? m_stages[stage + 1].get() : nullptr;
+
+	for (;;)
+	{
+		size_t index;
+		if (!previous)
+		{
+			index = m_next++;
+			if (index >= count)
+			{
+				break;
+			}
+		}
+		else
+		{
+			// the queue is empty for good when it is empty after all of the previous workers have finished
+			const Clock::time_point start = Clock::now();
+			bool received = false;
+			for (unsigned attempt = 0; ; wait(attempt))
+			{
+				const bool finished = previous->m_running.load(std::memory_order_acquire) == 0;
+				if (state.m_queue->tryPop(index))
+				{
+					received = true;
+					break;
+				}
+				if (finished)
+				{
+					break;
+				}
+			}
+			state.m_idle += elapsed(start);
+			if (!received)
+			{
+				break;
+			}
+		}
+
+		const Clock::time_point start = Clock::now();
+		const bool pass = state.m_stage(index);
+		state.m_busy += elapsed(start);
+		++state.m_items;
+
+		if (pass && next)
+		{
+			const Clock::time_point blocked = Clock::now();
+			for (unsigned attempt = 0; !next->m_queue->tryPush(index); wait(attempt))
+			{
+			}
+			state.m_blocked += elapsed(blocked);
+
+			const size_t depth = next->m_queue->size();
+			next->m_depthSum += depth;
+			++next->m_depthSamples;
+			size_t peak = next->m_peak.load(std::memory_order_relaxed);
+			while (depth > peak && !next->m_peak.compare_exchange_weak(peak, depth, std::memory_order_relaxed))
+			{
+			}
+		}
+	}
+	state.m_running.fetch_sub(1, std::memory_order_release);
+}
+
+void Pipeline::wait(unsigned &attempt)
+{
+	// the items take milliseconds, sleeping a bit costs nothing and leaves the cores to the busy stages
+	if (attempt++ < 16)
+	{
+		std::this_thread::yield();
+	}
+	else
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+void Pipeline::report(Metrics *metrics) const
+{
+	if (!metrics)
+	{
+		return;
+	}
+	for (const auto &stage : m_stages)
+	{
+		const String prefix = "pipeline_" + stage->m_name + "_";
+		metrics->set(prefix + "workers", static_cast<u64>(stage->m_workers));
+		metrics->set(prefix + "items", static_cast<u64>(stage->m_items));
+		metrics->set(prefix + "busy", static_cast<double>(stage->m_busy) / 1e9);
+		metrics->set(prefix + "idle", static_cast<double>(stage->m_idle) / 1e9);
+		metrics->set(prefix + "blocked", static_cast<double>(stage->m_blocked) / 1e9);
+		if (stage->m_queue)
+		{
+			const u64 samples = stage->m_depthSamples;
+			metrics->set(prefix + "queue_capacity", static_cast<u64>(stage->m_queue->capacity()));
+			metrics->set(prefix + "queue_peak", static_cast<u64>(stage->m_peak));
+			metrics->set(prefix + "queue_mean", samples ? static_cast<double>(stage->m_depthSum) / samples : 0.0);
+		}
+	}
+}
+
+/* eof */
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/pipeline.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include "mpmc_queue.h"
+
+#include <functional>
+
+class Metrics;
+
+/**
+ * @brief: Stages of the processing, each with its own threads, connected by bounded queues.
+ *
+ * The items are identified by their indices. The first stage takes the indices in order,
+ * every next one receives the indices passed by the previous stage through the lock-free
+ * queue. A stage waits when its queue is empty (idle) or when the queue of the next stage
+ * is full (blocked), so the slowest stage sets the pace and its statistics show it.
+ */
+class Pipeline
+{
+public:
+	/**
+	 * @brief: Processes the item in the stage
+	 *
+	 * @return @c True to pass the item to the next stage, false if the item is finished
+	 */
+	using Stage = std::function<bool(size_t index)>;
+
+public:
+	Pipeline();
+	Pipeline(const Pipeline &) = delete;
+	Pipeline(Pipeline &&) = delete;
+	~Pipeline();
+
+	Pipeline &operator=(const Pipeline &) = delete;
+	Pipeline &operator=(Pipeline &&) = delete;
+
+	/**
+	 * @brief: Appends the stage to the end of the pipeline
+	 *
+	 * @param[in] name The name of the stage in the metrics
+	 * @param[in] workers The number of threads of the stage, 0 means ThreadPool::defaultThreadCount()
+	 * @param[in] stage The function processing the items
+	 * @param[in] capacity The capacity of the queue in front of the stage, 0 means twice the workers
+	 */
+	void addStage(const String &name, size_t workers, const Stage &stage, size_t capacity = 0);
+
+	/**
+	 * @brief: Passes items [0, count) through all of the stages and waits for them
+	 */
+	void run(size_t count);
+
+	/**
+	 * @brief: Sets the statistics of the last run as pipeline_<stage>_<value>
+	 *
+	 * The values are workers, busy/idle/blocked (seconds summed over the workers),
+	 * items, and the peak and mean depth of the queue in front of the stage.
+	 */
+	void report(Metrics *metrics) const;
+
+private:
+	struct StageState
+	{
+		String m_name;
+		size_t m_workers;
+		Stage m_stage;
+		UniquePtr<MpmcQueue<size_t>> m_queue;	// items waiting for the stage, none in the first one
+
+		std::atomic<size_t> m_running{ 0 };	// workers not finished yet
+		std::atomic<u64> m_items{ 0 };
+		std::atomic<u64> m_busy{ 0 };			// nanoseconds
+		std::atomic<u64> m_idle{ 0 };
+		std::atomic<u64> m_blocked{ 0 };
+		std::atomic<size_t> m_peak{ 0 };
+		std::atomic<u64> m_depthSum{ 0 };		// depth of the queue after every push
+		std::atomic<u64> m_depthSamples{ 0 };
+	};
+
+	void work(size_t stage, size_t count);
+	void wait(unsigned &attempt);
+
+private:
+	Array<UniquePtr<StageState>> m_stages;
+	std::atomic<size_t> m_next{ 0 };
+};
+
+/* eof */
@@ -0,0 +1,376 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/process_pool.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "process_pool.h"
+#include "thread_pool.h"
+
+#ifndef _WIN32
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+namespace
+{
+	bool writeAll(int fd, const void *data, size_t size)
+	{
+		const char *it = static_cast<const char *>(data);
+		while (size > 0)
+		{
+			const ssize_t written = ::write(fd, it, size);
+			if (written < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			it += written;
+			size -= static_cast<size_t>(written);
+		}
+		return true;
+	}
+
+	bool readAll(int fd, void *data, size_t size)
+	{
+		char *it = static_cast<char *>(data);
+		while (size > 0)
+		{
+			const ssize_t count = ::read(fd, it, size);
+			if (count < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			if (count == 0)
+			{
+				return false; // the other side has been closed
+			}
+			it += count;
+			size -= static_cast<size_t>(count);
+		}
+		return true;
+	}
+} // namespace
+#endif
+
+ProcessPool::ProcessPool(size_t workers)
+	: m_size(workers == 0 ? ThreadPool::defaultThreadCount() : workers)
+{
+}
+
+ProcessPool::~ProcessPool()
+{
+	for (Worker &worker : m_workers)
+	{
+		close(worker);
+	}
+}
+
+bool ProcessPool::supported()
+{
+#ifdef _WIN32
+	return false;
+#else
+	return true;
+#endif
+}
+
+#ifdef _WIN32
+
+bool ProcessPool::run(size_t count, const Task &task, const Result &result, const Crash &crash)
+{
+	error("system", "", "Worker processes are not supported on this system!");
+	return false;
+}
+
+bool ProcessPool::spawn(size_t slot, const Task &task)
+{
+	return false;
+}
+
+void ProcessPool::close(Worker &worker)
+{
+}
+
+void ProcessPool::serve(int tasks, int results, const Task &task)
+{
+}
+
+#else
+
+bool ProcessPool::run(size_t count, const Task &task, const Result &result, const Crash &crash)
+{
+	if (count == 0)
+	{
+		return true;
+	}
+
+	// the crashed worker is noticed on its results, writing the next task to it must not kill the supervisor
+	struct sigaction ignore = {};
+	ignore.sa_handler = SIG_IGN;
+	struct sigaction previous;
+	sigaction(SIGPIPE, &ignore, &previous);
+
+	m_workers.clear();
+	m_workers.resize(std::min(m_size, count));
+
+	size_t next = 0;
+	size_t done = 0;
+	std::deque<size_t> retry;	// tasks queued for the crashed workers, not started yet
+	auto take = [&](size_t &index)
+	{
+		if (!retry.empty())
+		{
+			index = retry.front();
+			retry.pop_front();
+			return true;
+		}
+		if (next < count)
+		{
+			index = next++;
+			return true;
+		}
+		return false;
+	};
+	auto feed = [&](Worker &worker)
+	{
+		size_t index;
+		while (worker.m_pending.size() < PIPELINE && take(index))
+		{
+			const u64 message = index;
+			if (!writeAll(worker.m_tasks, &message, sizeof(message)))
+			{
+				retry.push_front(index);
+				break;
+			}
+			worker.m_pending.push_back(index);
+		}
+	};
+
+	bool started = true;
+	for (size_t slot = 0; slot < m_workers.size() && started; ++slot)
+	{
+		started = spawn(slot, task);
+	}
+	for (size_t slot = 0; slot < m_workers.size() && started; ++slot)
+	{
+		feed(m_workers[slot]);
+	}
+
+	Array<pollfd> fds;
+	while (started && done < count)
+	{
+		fds.clear();
+		for (const Worker &worker : m_workers)
+		{
+			fds.push_back({ worker.m_results, POLLIN, 0 }); // the closed slots (-1) are ignored
+		}
+		if (::poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			error_f("system", "", "Unable to wait for the worker processes (%s)!", strerror(errno));
+			started = false;
+			break;
+		}
+
+		for (size_t slot = 0; slot < m_workers.size(); ++slot)
+		{
+			if (fds[slot].revents == 0)
+			{
+				continue;
+			}
+
+			Worker &worker = m_workers[slot];
+			u64 header[2]; // index and size of the result
+			String text;
+			bool received = readAll(worker.m_results, header, sizeof(header));
+			if (received)
+			{
+				text.resize(static_cast<size_t>(header[1]));
+				received = readAll(worker.m_results, &text[0], text.size());
+			}
+			if (received && !worker.m_pending.empty() && worker.m_pending.front() == header[0])
+			{
+				worker.m_pending.pop_front();
+				++done;
+				result(static_cast<size_t>(header[0]), text);
+				feed(worker);
+				continue;
+			}
+
+			// the worker has been terminated, the task it was executing caused it
+			const int pid = worker.m_pid;
+			int status = 0;
+			worker.m_pid = -1;
+			close(worker);
+			waitpid(pid, &status, 0);
+			const String reason = WIFSIGNALED(status)
+				? String(strsignal(WTERMSIG(status)))
+				: fmt::sprintf("exit code %i", WIFEXITED(status) ? WEXITSTATUS(status) : status);
+
+			if (!worker.m_pending.empty())
+			{
+				const size_t index = worker.m_pending.front();
+				worker.m_pending.pop_front();
+				++done;
+				crash(index, reason);
+			}
+			for (auto it = worker.m_pending.rbegin(); it != worker.m_pending.rend(); ++it)
+			{
+				retry.push_front(*it);
+			}
+			worker.m_pending.clear();
+
+			if (!retry.empty() || next < count)
+			{
+				if (!spawn(slot, task))
+				{
+					started = false;
+					break;
+				}
+				feed(worker);
+			}
+		}
+	}
+
+	// the workers exit when their pipes of tasks are closed
+	for (Worker &worker : m_workers)
+	{
+		close(worker);
+	}
+	m_workers.clear();
+	sigaction(SIGPIPE, &previous, nullptr);
+	return started;
+}
+
+bool ProcessPool::spawn(size_t slot, const Task &task)
+{
+	int tasks[2];
+	int results[2];
+	if (::pipe(tasks) != 0)
+	{
+		error_f("system", "", "Unable to create pipe for the worker process (%s)!", strerror(errno));
+		return false;
+	}
+	if (::pipe(results) != 0)
+	{
+		error_f("system", "", "Unable to create pipe for the worker process (%s)!", strerror(errno));
+		::close(tasks[0]);
+		::close(tasks[1]);
+		return false;
+	}
+
+	// the text buffered by the supervisor would be printed again by the worker
+	fflush(stdout);
+	fflush(stderr);
+
+	const pid_t pid = ::fork();
+	if (pid < 0)
+	{
+		error_f("system", "", "Unable to start the worker process (%s)!", strerror(errno));
+		::close(tasks[0]);
+		::close(tasks[1]);
+		::close(results[0]);
+		::close(results[1]);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		// only the supervisor may keep the pipes of the other workers, otherwise they never see the end of their tasks
+		for (const Worker &other : m_workers)
+		{
+			if (other.m_tasks >= 0)
+			{
+				::close(other.m_tasks);
+			}
+			if (other.m_results >= 0)
+			{
+				::close(other.m_results);
+			}
+		}
+		::close(tasks[1]);
+		::close(results[0]);
+		serve(tasks[0], results[1], task);
+	}
+
+	::close(tasks[0]);
+	::close(results[1]);
+
+	Worker &worker = m_workers[slot];
+	worker.m_pid = pid;
+	worker.m_tasks = tasks[1];
+	worker.m_results = results[0];
+	worker.m_pending.clear();
+	return true;
+}
+
+void ProcessPool::close(Worker &worker)
+{
+	if (worker.m_tasks >= 0)
+	{
+		::close(worker.m_tasks);
+		worker.m_tasks = -1;
+	}
+	if (worker.m_results >= 0)
+	{
+		::close(worker.m_results);
+		worker.m_results = -1;
+	}
+	if (worker.m_pid > 0)
+	{
+		waitpid(worker.m_pid, nullptr, 0);
+		worker.m_pid = -1;
+	}
+}
+
+void ProcessPool::serve(int tasks, int results, const Task &task)
+{
+	u64 index;
+	while (readAll(tasks, &index, sizeof(index)))
+	{
+		const String text = task(static_cast<size_t>(index));
+		fflush(stdout);
+		fflush(stderr);
+		const u64 header[2] = { index, text.size() };
+		if (!writeAll(results, header, sizeof(header)) || !writeAll(results, text.data(), text.size()))
+		{
+			break;
+		}
+	}
+	fflush(stdout);
+	fflush(stderr);
+	_exit(0); // the state inherited from the supervisor is not destroyed by the worker
+}
+
+#endif
+
+/* eof */
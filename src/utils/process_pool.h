@@ -0,0 +1,111 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/process_pool.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <deque>
+
+/**
+ * @brief: Supervisor of the worker processes executing the tasks in isolation.
+ *
+ * The workers are forked when run() starts, so they inherit the state of the supervisor
+ * (mounted archives, caches) by copy-on-write and the cost of preparing it is paid once.
+ * The indices of the tasks are sent to the workers over pipes and every worker sends back
+ * the result of each task. A worker terminated by a crash is replaced by a new fork,
+ * the task it was executing is reported as crashed and the remaining tasks continue.
+ *
+ * Available on POSIX systems only, see supported().
+ */
+class ProcessPool
+{
+public:
+	/**
+	 * @brief: Executes the task in the worker process, the returned text is sent to the supervisor
+	 */
+	using Task = std::function<String(size_t index)>;
+
+	/**
+	 * @brief: Receives the result of the task in the supervisor
+	 */
+	using Result = std::function<void(size_t index, const String &result)>;
+
+	/**
+	 * @brief: Receives the task whose worker has been terminated, with the reason (ex. "Segmentation fault")
+	 */
+	using Crash = std::function<void(size_t index, const String &reason)>;
+
+public:
+	/**
+	 * @param[in] workers The number of worker processes, 0 means ThreadPool::defaultThreadCount()
+	 */
+	ProcessPool(size_t workers = 0);
+	ProcessPool(const ProcessPool &) = delete;
+	ProcessPool(ProcessPool &&) = delete;
+	~ProcessPool();
+
+	ProcessPool &operator=(const ProcessPool &) = delete;
+	ProcessPool &operator=(ProcessPool &&) = delete;
+
+	/**
+	 * @brief: Executes task(i) for every i in [0, count) in the worker processes and waits for them
+	 *
+	 * Must be called when no other thread is running, as only the calling thread is forked.
+	 * The callbacks are called by the calling thread.
+	 *
+	 * @param[in] count The number of tasks
+	 * @param[in] task The task executed by the workers
+	 * @param[in] result The receiver of the results
+	 * @param[in] crash The receiver of the crashed tasks
+	 * @return @c False if the worker processes could not be started
+	 */
+	bool run(size_t count, const Task &task, const Result &result, const Crash &crash);
+
+	inline size_t size() const { return m_size; }
+
+	/**
+	 * @brief: Returns true if the worker processes are available on this system
+	 */
+	static bool supported();
+
+private:
+	struct Worker
+	{
+		int m_pid = -1;
+		int m_tasks = -1;			// write end of the pipe of the task indices
+		int m_results = -1;			// read end of the pipe of the results
+		std::deque<size_t> m_pending;	// sent tasks, the first one is being executed
+	};
+
+	bool spawn(size_t slot, const Task &task);
+	void close(Worker &worker);
+
+	static void serve(int tasks, int results, const Task &task);
+
+private:
+	static const size_t PIPELINE = 2;	// tasks queued for each worker, the next one is ready when the worker finishes
+
+	size_t m_size;
+	Array<Worker> m_workers;
+};
+
+/* eof */
@@ -0,0 +1,105 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/thread_pool.cpp
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#include <prerequisites.h>
+
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if (threads == 0)
+	{
+		threads = defaultThreadCount();
+	}
+
+	m_threads.reserve(threads);
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_threads.emplace_back(&ThreadPool::worker, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_taskAvailable.notify_all();
+
+	for (std::thread &thread : m_threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finished.wait(lock, [this] { return m_tasks.empty() && m_running == 0; });
+}
+
+size_t ThreadPool::defaultThreadCount()
+{
+	return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::enqueue(std::function<void()> &&task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_taskAvailable.notify_one();
+}
+
+void ThreadPool::worker()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskAvailable.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+			if (m_tasks.empty())
+			{
+				return; // stopped and drained
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+			++m_running;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			--m_running;
+			if (m_tasks.empty() && m_running == 0)
+			{
+				m_finished.notify_all();
+			}
+		}
+	}
+}
+
+/* eof */
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *
+ *  Project:	ConverterPIX @ Core
+ *  File:		/utils/thread_pool.h
+ *
+ *		  _____                          _            _____ _______   __
+ *		 / ____|                        | |          |  __ \_   _\ \ / /
+ *		| |     ___  _ ____   _____ _ __| |_ ___ _ __| |__) || |  \ V /
+ *		| |    / _ \| '_ \ \ / / _ \ '__| __/ _ \ '__|  ___/ | |   > <
+ *		| |___| (_) | | | \ V /  __/ |  | ||  __/ |  | |    _| |_ / . \
+ *		 \_____\___/|_| |_|\_/ \___|_|   \__\___|_|  |_|   |_____/_/ \_\
+ *
+ *
+ *  Copyright (C) 2017 Michal Wojtowicz.
+ *  All rights reserved.
+ *
+ *   This software is ditributed WITHOUT ANY WARRANTY; without even
+ *   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *   PURPOSE. See the copyright file for more information.
+ *
+ *****************************************************************************/
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+
+/**
+ * @brief: Fixed size pool of worker threads executing queued tasks in FIFO order.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @param[in] threads The number of worker threads, 0 means ThreadPool::defaultThreadCount()
+	 */
+	ThreadPool(size_t threads = 0);
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool(ThreadPool &&) = delete;
+	~ThreadPool();
+
+	ThreadPool &operator=(const ThreadPool &) = delete;
+	ThreadPool &operator=(ThreadPool &&) = delete;
+
+	/**
+	 * @brief: Queues the task for execution
+	 *
+	 * @param[in] task The callable object without parameters
+	 * @return @c The future which receives result of the task
+	 */
+	template < typename F >
+	auto submit(F &&task) -> std::future<decltype(task())>;
+
+	/**
+	 * @brief: Blocks until all of the queued tasks have been executed
+	 */
+	void wait();
+
+	/**
+	 * @brief: Executes task(i) for every i in [0, count) and waits for these tasks only
+	 *
+	 * The pool may be shared by several callers, but it must not be called from the pool workers.
+	 *
+	 * @param[in] count The number of tasks
+	 * @param[in] task The callable object taking the task index
+	 */
+	template < typename F >
+	void parallelFor(size_t count, const F &task);
+
+	inline size_t size() const { return m_threads.size(); }
+
+	/**
+	 * @brief: Returns the number of hardware threads (at least 1)
+	 */
+	static size_t defaultThreadCount();
+
+private:
+	void enqueue(std::function<void()> &&task);
+	void worker();
+
+private:
+	Array<std::thread> m_threads;
+	std::deque<std::function<void()>> m_tasks;
+
+	std::mutex m_mutex;
+	std::condition_variable m_taskAvailable;
+	std::condition_variable m_finished;
+	size_t m_running = 0;
+	bool m_stop = false;
+};
+
+template < typename F >
+auto ThreadPool::submit(F &&task) -> std::future<decltype(task())>
+{
+	using Result = decltype(task());
+	auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+	std::future<Result> result = packaged->get_future();
+	enqueue([packaged]() { (*packaged)(); });
+	return result;
+}
+
+template < typename F >
+void ThreadPool::parallelFor(size_t count, const F &task)
+{
+	Array<std::future<void>> results;
+	results.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		results.push_back(submit([&task, i]() { task(i); }));
+	}
+	for (auto &result : results)
+	{
+		result.get();
+	}
+}
+
+/* eof */